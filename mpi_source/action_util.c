@@ -26,6 +26,7 @@
 #include "binarystr.h"
 #include "binary.h"
 #include "moindex.h"
+#include "moslab.h"
 #include "action_util.h"
 #include <ga.h>
 #include <macdecls.h>
@@ -256,6 +257,68 @@ double hmatels_2xab(int *aio, int *afo, int api, int *bio, int *bfo, int bpi,
     val = api * bpi * m2[i1 - 1];
     return val;
 }
+
+/*
+ * hmatels_0x_slab: compute diagonal matrix elements from per-pair
+ * integral slabs.
+ */
+double hmatels_0x_slab(int *istr1, int ne1, int *istr2, int ne2,
+                       double *m1, struct moslab *mslab)
+{
+    double val = 0.0;
+    double *row = NULL;
+    int norb = mslab->norb;
+    int i, j;
+    /* alpha contribution */
+    for (i = 0; i < ne1; i++) {
+        row = &(mslab->data[(index1e(istr1[i], istr1[i]) - 1) * 2 * norb]);
+        val = val + m1[index1e(istr1[i], istr1[i]) - 1];
+        for (j = 0; j < i; j++) {
+            val = val + row[istr1[j] - 1];
+        }
+    }
+    /* beta contribution and alpha-beta contribution */
+    for (i = 0; i < ne2; i++) {
+        row = &(mslab->data[(index1e(istr2[i], istr2[i]) - 1) * 2 * norb]);
+        val = val + m1[index1e(istr2[i], istr2[i]) - 1];
+        for (j = 0; j < i; j++) {
+            val = val + row[istr2[j] - 1];
+        }
+        for (j = 0; j < ne1; j++) {
+            val = val + row[norb + istr1[j] - 1];
+        }
+    }
+    return val;
+}
+
+/*
+ * hmatels_1x_slab: compute single replacement matrix elements from
+ * per-pair integral slabs. The same-spin slab entry for k = io[0]
+ * vanishes, so no test is needed inside the loops.
+ */
+double hmatels_1x_slab(int *istr1, int *io, int *fo, int pi, int ne1,
+                       int *istr2, int ne2, double *m1,
+                       struct moslab *mslab)
+{
+    double val = 0.0;
+    double *row = NULL;
+    int norb = mslab->norb;
+    int ij;
+    int i;
+    ij = index1e(io[0], fo[0]) - 1;
+    row = &(mslab->data[ij * 2 * norb]);
+    /* 1-e contribution */
+    val = m1[ij];
+    /* 2-e contribution */
+    for (i = 0; i < ne1; i++) {
+        val = val + row[istr1[i] - 1];
+    }
+    row = row + norb;
+    for (i = 0; i < ne2; i++) {
+        val = val + row[istr2[i] - 1];
+    }
+    return pi * val;
+}
   
 
 /* 
@@ -955,13 +1018,9 @@ double eval2_ncas_c0cv2v0(long long int xi, long long int xf, int *vxi,
 	int ifo[4] = {0};      /* initial, final orbitals */
 	long long int t = 0x0; /* pseudo-excitation byte */
         long long int s = 0x0; /* scratch string to keep track of excitations*/
-	int tmp;
         /* use pseudo-excitation byte to find number of bytes between
 	 * cas orbital in excitation and virtuals. */
 	cas_to_virt_replacements(2, 0, 0, xi, xf, vxi, vxf, ifo, ninto);  
-	tmp = ifo[0];
-	ifo[0] = ifo[1];
-	ifo[1] = tmp;
         s = str;
         for (i1 = 1; i1 >= 0; i1--) {
 		t = ((long long int) 1) << (ifo[i1] - 1);
@@ -972,10 +1031,8 @@ double eval2_ncas_c0cv2v0(long long int xi, long long int xf, int *vxi,
 
         }
 
-	i1 = index2e(ifo[1], ifo[2], ifo[0], ifo[3]);
-	i2 = index2e(ifo[1], ifo[3], ifo[0], ifo[2]);
-	//i1 = index2e(ifo[0], ifo[3], ifo[1], ifo[2]);
-	//i2 = index2e(ifo[0], ifo[2], ifo[1], ifo[3]);
+        i1 = index2e(ifo[0], ifo[2], ifo[1], ifo[3]);
+	i2 = index2e(ifo[0], ifo[3], ifo[1], ifo[2]);
         val = pindx * (moints2[i1 - 1] - moints2[i2 - 1]);
 	return val;
 }
@@ -1089,8 +1146,8 @@ double eval2_ncas_c00cv10v10(long long int xi, long long int xf,
                 pindx = pindex_single_rep_cas2virt(strj.byte1, xf, ninto);
                 pindx = pindx * pindex_single_rep_virt(ifo[2], stri.virtx);
         }
-	i1 = index2e(ifo[0], ifo[3], ifo[1], ifo[2]);
-	i2 = index2e(ifo[0], ifo[2], ifo[1], ifo[3]);
+	i1 = index2e(ifo[0], ifo[2], ifo[1], ifo[3]);
+	i2 = index2e(ifo[0], ifo[3], ifo[1], ifo[2]);
 	val = pindx * (moints2[i1 - 1] - moints2[i2 - 1]);
 	return val;
 }
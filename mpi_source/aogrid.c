@@ -0,0 +1,390 @@
+// File: aogrid.c
+/*
+ * Evaluate atomic and molecular orbitals on grids of points.
+ *
+ * Points are handled in blocks of AOGRID_BLOCK. For each block the
+ * distances to every center are formed once, each orbital is skipped if
+ * no point of the block lies within its screening radius, and the
+ * radial part is accumulated over primitives in loops over points with
+ * no branches. Orbitals in the AO basis are then formed with DGEMM.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "buildao.h"
+#include "atomic_orbitals.h"
+#include "mathutil.h"
+#include "aogrid.h"
+
+/* -- OpenMP options -- */
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+/* -------------------- */
+
+/*
+ * aogrid_init: build the grid basis from the atomic orbital set.
+ */
+int aogrid_init(struct ao_basisfunc *aob, int nao, struct ao_gridbasis *gb)
+{
+    double nrm = 0.0, amin = 0.0, cmax = 0.0, r2 = 0.0;
+    int lval = 0;
+    int i, j, k;
+
+    gb->nao   = nao;
+    gb->nprim = 0;
+    gb->ncntr = 0;
+    for (i = 0; i < nao; i++) {
+        gb->nprim += aob[i].ugaus;
+        if (aob[i].atom > gb->ncntr) gb->ncntr = aob[i].atom;
+    }
+    gb->type   = malloc(sizeof(int) * nao);
+    gb->cntr   = malloc(sizeof(int) * nao);
+    gb->pstart = malloc(sizeof(int) * (nao + 1));
+    gb->rcut2  = malloc(sizeof(double) * nao);
+    gb->expn   = malloc(sizeof(double) * gb->nprim);
+    gb->coef   = malloc(sizeof(double) * gb->nprim);
+    gb->xyz    = calloc(3 * gb->ncntr, sizeof(double));
+    gb->chrg   = calloc(gb->ncntr, sizeof(double));
+    if (gb->type == NULL || gb->cntr == NULL || gb->pstart == NULL ||
+        gb->rcut2 == NULL || gb->expn == NULL || gb->coef == NULL ||
+        gb->xyz == NULL || gb->chrg == NULL) {
+        aogrid_free(gb);
+        return 1;
+    }
+
+    k = 0;
+    for (i = 0; i < nao; i++) {
+        gb->type[i] = aob[i].type;
+        gb->cntr[i] = aob[i].atom - 1;
+        gb->xyz[(3 * gb->cntr[i])]     = aob[i].geom[0];
+        gb->xyz[(3 * gb->cntr[i] + 1)] = aob[i].geom[1];
+        gb->xyz[(3 * gb->cntr[i] + 2)] = aob[i].geom[2];
+        gb->chrg[(gb->cntr[i])] = aob[i].nucchrg;
+        gb->pstart[i] = k;
+        lval = ao_get_lvalue_from_type(aob[i].type);
+        if (lval < 0 || lval > 3) {
+            aogrid_free(gb);
+            return 2;
+        }
+        amin = 0.0;
+        cmax = 0.0;
+        for (j = 0; j < aob[i].ugaus; j++) {
+            switch (lval) {
+            case 0:
+                nrm = compute_s_normconst(aob[i].alpha[j]);
+                break;
+            case 1:
+                nrm = compute_p_normconst(aob[i].alpha[j]);
+                break;
+            case 2:
+                nrm = compute_d_normconst(aob[i].alpha[j]);
+                break;
+            default:
+                nrm = compute_f_normconst(aob[i].alpha[j]);
+                break;
+            }
+            gb->expn[k] = aob[i].alpha[j];
+            gb->coef[k] = aob[i].gscale * aob[i].ccoef[j] * nrm;
+            if (j == 0 || gb->expn[k] < amin) amin = gb->expn[k];
+            if (fabs(gb->coef[k]) > cmax) cmax = fabs(gb->coef[k]);
+            k++;
+        }
+        /* Bound |sum_k c_k exp(-a_k r^2)| by (nprim cmax) exp(-amin r^2),
+         * then allow for the angular factor, which is at most 4 r^l. */
+        r2 = log(aob[i].ugaus * cmax / AOGRID_SCREEN) / amin;
+        if (r2 < 0.0) r2 = 0.0;
+        if (lval > 0) {
+            r2 = log(4.0 * aob[i].ugaus * cmax * pow(sqrt(r2) + 1.0, lval) /
+                     AOGRID_SCREEN) / amin;
+        }
+        gb->rcut2[i] = r2;
+    }
+    gb->pstart[nao] = k;
+    return 0;
+}
+
+/*
+ * aogrid_free: free grid basis arrays.
+ */
+void aogrid_free(struct ao_gridbasis *gb)
+{
+    free(gb->type);
+    free(gb->cntr);
+    free(gb->pstart);
+    free(gb->rcut2);
+    free(gb->expn);
+    free(gb->coef);
+    free(gb->xyz);
+    free(gb->chrg);
+    gb->type   = NULL;
+    gb->cntr   = NULL;
+    gb->pstart = NULL;
+    gb->rcut2  = NULL;
+    gb->expn   = NULL;
+    gb->coef   = NULL;
+    gb->xyz    = NULL;
+    gb->chrg   = NULL;
+    return;
+}
+
+/*
+ * aogrid_scratch_size: number of doubles of scratch aogrid_evaluate
+ * needs for npts points.
+ */
+int aogrid_scratch_size(struct ao_gridbasis *gb, int npts)
+{
+    return ((4 * gb->ncntr + 1) * npts + gb->ncntr);
+}
+
+/*
+ * aogrid_evaluate: evaluate all atomic orbitals on a block of points.
+ */
+void aogrid_evaluate(struct ao_gridbasis *gb, double *x, double *y,
+                     double *z, int npts, double *scr, double *aoval)
+{
+    double *dx, *dy, *dz, *r2; /* Displacements from center */
+    double *rad = &(scr[(4 * gb->ncntr * npts)]);   /* Radial part */
+    double *rmin2 = &(rad[npts]); /* Closest approach to each center */
+    double *val = NULL;
+    double a, c;
+    int i, k, p;
+
+    /* Distances of all points to each center */
+    for (i = 0; i < gb->ncntr; i++) {
+        dx = &(scr[(4 * i * npts)]);
+        dy = &(dx[npts]);
+        dz = &(dy[npts]);
+        r2 = &(dz[npts]);
+        for (p = 0; p < npts; p++) {
+            dx[p] = x[p] - gb->xyz[(3 * i)];
+            dy[p] = y[p] - gb->xyz[(3 * i + 1)];
+            dz[p] = z[p] - gb->xyz[(3 * i + 2)];
+            r2[p] = dx[p] * dx[p] + dy[p] * dy[p] + dz[p] * dz[p];
+        }
+        rmin2[i] = r2[0];
+        for (p = 1; p < npts; p++) {
+            if (r2[p] < rmin2[i]) rmin2[i] = r2[p];
+        }
+    }
+
+    for (i = 0; i < gb->nao; i++) {
+        val = &(aoval[(i * npts)]);
+        dx = &(scr[(4 * gb->cntr[i] * npts)]);
+        dy = &(dx[npts]);
+        dz = &(dy[npts]);
+        r2 = &(dz[npts]);
+
+        /* Screen the whole block */
+        if (rmin2[(gb->cntr[i])] > gb->rcut2[i]) {
+            for (p = 0; p < npts; p++) val[p] = 0.0;
+            continue;
+        }
+
+        /* Radial part */
+        for (p = 0; p < npts; p++) rad[p] = 0.0;
+        for (k = gb->pstart[i]; k < gb->pstart[(i + 1)]; k++) {
+            a = gb->expn[k];
+            c = gb->coef[k];
+            for (p = 0; p < npts; p++) {
+                rad[p] += c * exp(-a * r2[p]);
+            }
+        }
+        for (p = 0; p < npts; p++) {
+            if (r2[p] > gb->rcut2[i]) rad[p] = 0.0;
+        }
+
+        /* Angular part */
+        switch (gb->type[i]) {
+        case 1:
+            for (p = 0; p < npts; p++) val[p] = rad[p];
+            break;
+        case 2:
+            for (p = 0; p < npts; p++) val[p] = dx[p] * rad[p];
+            break;
+        case 3:
+            for (p = 0; p < npts; p++) val[p] = dy[p] * rad[p];
+            break;
+        case 4:
+            for (p = 0; p < npts; p++) val[p] = dz[p] * rad[p];
+            break;
+        case 5: /* xy */
+            for (p = 0; p < npts; p++) val[p] = dx[p] * dy[p] * rad[p];
+            break;
+        case 6: /* xz */
+            for (p = 0; p < npts; p++) val[p] = dx[p] * dz[p] * rad[p];
+            break;
+        case 7: /* 2zz - xx - yy */
+            for (p = 0; p < npts; p++) {
+                val[p] = (2.0 * dz[p] * dz[p] - dx[p] * dx[p] -
+                          dy[p] * dy[p]) * rad[p];
+            }
+            break;
+        case 8: /* yz */
+            for (p = 0; p < npts; p++) val[p] = dy[p] * dz[p] * rad[p];
+            break;
+        case 9: /* xx - yy */
+            for (p = 0; p < npts; p++) {
+                val[p] = (dx[p] * dx[p] - dy[p] * dy[p]) * rad[p];
+            }
+            break;
+        case 10: /* xxy - yyy */
+            for (p = 0; p < npts; p++) {
+                val[p] = (dx[p] * dx[p] - dy[p] * dy[p]) * dy[p] * rad[p];
+            }
+            break;
+        case 11: /* xyz */
+            for (p = 0; p < npts; p++) {
+                val[p] = dx[p] * dy[p] * dz[p] * rad[p];
+            }
+            break;
+        case 12: /* 4yzz - 3yyy - xxy */
+            for (p = 0; p < npts; p++) {
+                val[p] = (4.0 * dz[p] * dz[p] - 3.0 * dy[p] * dy[p] -
+                          dx[p] * dx[p]) * dy[p] * rad[p];
+            }
+            break;
+        case 13: /* xxz + yyz - 2zzz */
+            for (p = 0; p < npts; p++) {
+                val[p] = (dx[p] * dx[p] + dy[p] * dy[p] -
+                          2.0 * dz[p] * dz[p]) * dz[p] * rad[p];
+            }
+            break;
+        case 14: /* 4xzz - 3xxx - xyy */
+            for (p = 0; p < npts; p++) {
+                val[p] = (4.0 * dz[p] * dz[p] - 3.0 * dx[p] * dx[p] -
+                          dy[p] * dy[p]) * dx[p] * rad[p];
+            }
+            break;
+        case 15: /* xxz - yyz */
+            for (p = 0; p < npts; p++) {
+                val[p] = (dx[p] * dx[p] - dy[p] * dy[p]) * dz[p] * rad[p];
+            }
+            break;
+        case 16: /* xyy - xxx */
+            for (p = 0; p < npts; p++) {
+                val[p] = (dy[p] * dy[p] - dx[p] * dx[p]) * dx[p] * rad[p];
+            }
+            break;
+        default:
+            for (p = 0; p < npts; p++) val[p] = 0.0;
+            break;
+        }
+    }
+    return;
+}
+
+/*
+ * aogrid_box: set a cube grid around all centers.
+ */
+void aogrid_box(struct ao_gridbasis *gb, double pad, int nmax,
+                double *origin, int *npts, double *step)
+{
+    double lo[3], hi[3];
+    double len = 0.0, h = 0.0;
+    int i, j;
+
+    for (j = 0; j < 3; j++) {
+        lo[j] = gb->xyz[j];
+        hi[j] = gb->xyz[j];
+    }
+    for (i = 1; i < gb->ncntr; i++) {
+        for (j = 0; j < 3; j++) {
+            if (gb->xyz[(3 * i + j)] < lo[j]) lo[j] = gb->xyz[(3 * i + j)];
+            if (gb->xyz[(3 * i + j)] > hi[j]) hi[j] = gb->xyz[(3 * i + j)];
+        }
+    }
+    for (j = 0; j < 3; j++) {
+        lo[j] -= pad;
+        hi[j] += pad;
+        if ((hi[j] - lo[j]) > len) len = hi[j] - lo[j];
+    }
+    h = len / (nmax - 1);
+    for (j = 0; j < 3; j++) {
+        npts[j] = (int) ceil((hi[j] - lo[j]) / h) + 1;
+        origin[j] = 0.5 * (lo[j] + hi[j]) - 0.5 * h * (npts[j] - 1);
+        step[j] = h;
+    }
+    return;
+}
+
+/*
+ * aogrid_evaluate_orbitals: evaluate orbitals given by their atomic
+ * orbital coefficients on a cube grid.
+ */
+void aogrid_evaluate_orbitals(struct ao_gridbasis *gb, double *orbao,
+                              int norb, double *origin, int *npts,
+                              double *step, double *vals)
+{
+    int ntot = npts[0] * npts[1] * npts[2];
+    int nyz  = npts[1] * npts[2];
+    int nscr = aogrid_scratch_size(gb, AOGRID_BLOCK);
+
+#pragma omp parallel default(shared)
+    {
+        double *x = malloc(sizeof(double) * 3 * AOGRID_BLOCK);
+        double *y = &(x[AOGRID_BLOCK]);
+        double *z = &(y[AOGRID_BLOCK]);
+        double *scr = malloc(sizeof(double) * nscr);
+        double *aoval = malloc(sizeof(double) * gb->nao * AOGRID_BLOCK);
+        int b, nb, p, pt;
+
+#pragma omp for schedule(dynamic)
+        for (b = 0; b < ntot; b += AOGRID_BLOCK) {
+            nb = (ntot - b < AOGRID_BLOCK ? ntot - b : AOGRID_BLOCK);
+            for (p = 0; p < nb; p++) {
+                pt = b + p;
+                x[p] = origin[0] + step[0] * (pt / nyz);
+                y[p] = origin[1] + step[1] * ((pt % nyz) / npts[2]);
+                z[p] = origin[2] + step[2] * (pt % npts[2]);
+            }
+            aogrid_evaluate(gb, x, y, z, nb, scr, aoval);
+            /* vals(b:b+nb, :) = aoval(nb x nao) orbao(nao x norb) */
+            matmul_dgemm(aoval, nb, gb->nao, orbao, gb->nao, norb,
+                         &(vals[b]), ntot, norb);
+        }
+        free(x);
+        free(scr);
+        free(aoval);
+    }
+    return;
+}
+
+/*
+ * aogrid_write_cube: write a Gaussian cube file.
+ */
+int aogrid_write_cube(char *filename, char *comment,
+                      struct ao_gridbasis *gb, double *origin, int *npts,
+                      double *step, double *vals)
+{
+    FILE *fptr = NULL;
+    int i, j, k, n;
+
+    fptr = fopen(filename, "w");
+    if (fptr == NULL) return 1;
+    fprintf(fptr, "%s\n", filename);
+    fprintf(fptr, "%s\n", comment);
+    fprintf(fptr, "%5d %12.6f %12.6f %12.6f\n", gb->ncntr,
+            origin[0], origin[1], origin[2]);
+    fprintf(fptr, "%5d %12.6f %12.6f %12.6f\n", npts[0], step[0], 0.0, 0.0);
+    fprintf(fptr, "%5d %12.6f %12.6f %12.6f\n", npts[1], 0.0, step[1], 0.0);
+    fprintf(fptr, "%5d %12.6f %12.6f %12.6f\n", npts[2], 0.0, 0.0, step[2]);
+    for (i = 0; i < gb->ncntr; i++) {
+        fprintf(fptr, "%5d %12.6f %12.6f %12.6f %12.6f\n",
+                (int) gb->chrg[i], gb->chrg[i], gb->xyz[(3 * i)],
+                gb->xyz[(3 * i + 1)], gb->xyz[(3 * i + 2)]);
+    }
+    n = 0;
+    for (i = 0; i < npts[0]; i++) {
+        for (j = 0; j < npts[1]; j++) {
+            for (k = 0; k < npts[2]; k++) {
+                fprintf(fptr, " %12.5E", vals[n]);
+                n++;
+                if (k % 6 == 5) fprintf(fptr, "\n");
+            }
+            if (npts[2] % 6 != 0) fprintf(fptr, "\n");
+        }
+    }
+    fclose(fptr);
+    return 0;
+}
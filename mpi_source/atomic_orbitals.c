@@ -201,7 +201,7 @@ double evaluate_f(double *pos, double *alphac, double *ccoef, int ng,
         break;
     case 13:
         /* m=0, xxz + yyz - 2*zzz */
-        fcmpnt =  pow(scr[0], 2);
+        fcmpnt =  pow(scr[0], 2) * scr[2];
         fcmpnt += pow(scr[1], 2) * scr[2];
         fcmpnt -= 2 * pow(scr[2], 3);
         break;
@@ -299,9 +299,6 @@ double evaluate_s(double *pos, double *alphac, double *ccoef, int ng,
     double nrmcnst;
     int i;
     rval = compute_3d_distance(atompos, pos);
-    printf("%lf %lf %lf\n", pos[0], pos[1], pos[2]);
-    printf("%lf %lf %lf\n", atompos[0], atompos[1], atompos[2]);
-    printf("rval = %lf\n", rval);
     for (i = 0; i < ng; i++) {
         nrmcnst = compute_s_normconst(alphac[i]);
         value = value + (gscale * ccoef[i] *
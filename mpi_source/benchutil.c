@@ -0,0 +1,149 @@
+// File: benchutil.c
+/*
+ * Synthetic CI expansions and integrals for the benchmark programs.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "pjayci_global.h"
+#include "errorlib.h"
+#include "allocate_mem.h"
+#include "mpi_utilities.h"
+#include "abecalc.h"
+#include "moindex.h"
+#include "moslab.h"
+#include "binarystr.h"
+#include "citruncate.h"
+#include "detaddress.h"
+#include "benchutil.h"
+
+/*
+ * benchci_random: reproducible pseudo-random number in [-0.5, 0.5)
+ * for element i of a stream (splitmix64).
+ */
+double benchci_random(unsigned long long int seed, long long int i)
+{
+    unsigned long long int z;
+
+    z = seed + (unsigned long long int) (i + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return ((z >> 11) * (1.0 / 9007199254740992.0)) - 0.5;
+}
+
+/*
+ * benchci_integrals: generate synthetic 1-e and 2-e integrals.
+ */
+void benchci_integrals(int norb, double *m1, double *m2)
+{
+    int m1len = index1e(norb, norb);
+    int m2len = index2e(norb, norb, norb, norb);
+    int i, j;
+
+    for (i = 0; i < m1len; i++) {
+        m1[i] = 0.3 * benchci_random(BENCHCI_SEED, i);
+    }
+    for (i = 0; i < m2len; i++) {
+        m2[i] = 0.1 * benchci_random((BENCHCI_SEED + 1), i);
+    }
+    /* h(i,i) increasing with i, and (ii|jj) > 0 */
+    for (i = 1; i <= norb; i++) {
+        m1[(index1e(i, i) - 1)] += -2.0 + 0.6 * i;
+        for (j = 1; j <= i; j++) {
+            m2[(index2e(i, i, j, j) - 1)] += 0.3;
+        }
+    }
+    return;
+}
+
+/*
+ * benchci_setup: build the CI expansion, synthetic integrals, integral
+ * slabs and implicit determinant list.
+ */
+int benchci_setup(struct benchci *ci, int electrons, int ndocc, int nactv,
+                  int orbitals, int xlvl)
+{
+    int error = 0;
+    int aelec = 0, belec = 0;
+
+    if (xlvl < 0 || xlvl > 2 || ndocc < 0 || nactv < 0 ||
+        (ndocc + nactv) > 64 || (ndocc + nactv) > orbitals) {
+        if (mpi_proc_rank == mpi_root) {
+            error_message(mpi_proc_rank, "Invalid expansion.",
+                          "benchci_setup");
+        }
+        return 1;
+    }
+    abecalc(electrons, &aelec, &belec);
+    compute_ci_elecs_and_orbitals(aelec, belec, orbitals, 0, 0,
+                                  &(ci->ci_aelec), &(ci->ci_belec),
+                                  &(ci->ci_orbs));
+    if (ci->ci_aelec > 20 || ci->ci_belec > 20 || ci->ci_orbs > 200) {
+        if (mpi_proc_rank == mpi_root) {
+            error_message(mpi_proc_rank, "Expansion too large.",
+                          "benchci_setup");
+        }
+        return 1;
+    }
+    ci->ndocc  = ndocc;
+    ci->nactv  = nactv;
+    ci->intorb = ndocc + nactv;
+
+    /* Generate strings and (p,q) blocks as in execute_pjayci. */
+    ci->pstr_len = compute_stringnum(ci->ci_orbs, ci->ci_aelec, ndocc,
+                                     nactv, xlvl);
+    ci->qstr_len = compute_stringnum(ci->ci_orbs, ci->ci_belec, ndocc,
+                                     nactv, xlvl);
+    ci->pstr = allocate_occstr_arrays(ci->pstr_len);
+    ci->qstr = allocate_occstr_arrays(ci->qstr_len);
+    ci->peosp = allocate_eospace_array(ci->ci_aelec, ci->ci_orbs, ndocc,
+                                       nactv, xlvl, &(ci->pegrps));
+    ci->qeosp = allocate_eospace_array(ci->ci_belec, ci->ci_orbs, ndocc,
+                                       nactv, xlvl, &(ci->qegrps));
+    ci->npq = ci->pegrps * ci->qegrps;
+    ci->pqdata = allocate_mem_int_cont(&(ci->pq), 2, ci->npq);
+    error = citrunc(aelec, belec, orbitals, 0, ndocc, nactv, 0, xlvl,
+                    ci->pstr, ci->pstr_len, ci->qstr, ci->qstr_len,
+                    ci->peosp, ci->pegrps, ci->qeosp, ci->qegrps,
+                    &(ci->ndets), ci->pq, &(ci->npq));
+    if (error != 0) return error;
+    if (mpi_proc_rank == mpi_root) {
+        printf("Determinants   = %15d\n", ci->ndets);
+        printf(" Alpha strings = %15d\n", ci->pstr_len);
+        printf(" Beta  strings = %15d\n", ci->qstr_len);
+        printf(" (p,q) blocks  = %15d\n", ci->npq);
+        fflush(stdout);
+    }
+
+    /* Integrals are generated identically on every process. */
+    ci->m1 = malloc(sizeof(double) * index1e(orbitals, orbitals));
+    ci->m2 = malloc(sizeof(double) *
+                    index2e(orbitals, orbitals, orbitals, orbitals));
+    if (ci->m1 == NULL || ci->m2 == NULL) return 1;
+    benchci_integrals(orbitals, ci->m1, ci->m2);
+    total_core_e = 0.0;
+    error = build_moslab(ci->m2, ci->ci_orbs, &(ci->mslab));
+    if (error != 0) return error;
+
+    ci->wdet = create_detaddress(ci->pq, ci->npq, ci->peosp, ci->pegrps,
+                                 ci->qeosp, ci->qegrps);
+    if (ci->wdet == NULL) return 1;
+    return error;
+}
+
+/*
+ * benchci_free: deallocate expansion and integrals.
+ */
+void benchci_free(struct benchci *ci)
+{
+    free_detaddress(ci->wdet);
+    free_moslab(&(ci->mslab));
+    free(ci->m1);
+    free(ci->m2);
+    free(ci->pstr);
+    free(ci->qstr);
+    free(ci->peosp);
+    free(ci->qeosp);
+    deallocate_mem_cont_int(&(ci->pq), ci->pqdata);
+    return;
+}
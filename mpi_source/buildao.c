@@ -1,6 +1,11 @@
 // File: buildao.c
 /*
  * Build atomic orbitals
+ *
+ * daltaoin and soinfo.dat are each read with a single fread into a
+ * buffer which is split into lines; all parsing is then done on the
+ * lines in memory. The basis is built on the root process only and sent
+ * to the other processes as a contiguous grid basis (see aogrid.h).
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,61 +16,115 @@
 #include "arrayutil.h"
 #include "ioutil.h"
 #include "mathutil.h"
+#include "mpi_utilities.h"
+#include "aogrid.h"
 #include "buildao.h"
+#include <mpi.h>
 
 /*
  * ao_buildao: build atomic orbitals
  */
-int ao_buildao(struct ao_basisfunc *aobasis)
+int ao_buildao(struct ao_basisfunc **aobasis, int *norbs)
 {
     int error = 0;
-    int natoms = 0;       /* Number of atoms */
-    FILE *daltin = NULL;  /* Dalton input file */
+    char *dbuf = NULL;    /* daltaoin buffer */
+    char **dline = NULL;  /* daltaoin lines */
+    int ndline = 0;       /* Number of daltaoin lines */
+    int ln = 0;           /* Current line */
     char crt[2]; /* Spherical or cartesian functions test*/
     int atypes = 0; /* Atom types */
     int molchg = 0; /* Molecular charge */
-    char symtxt[2]; /* sym operations test */
+    char symtxt[3]; /* sym operations test */
     double thrs = 0.0; /* Integral threshold */
     char id3[2];
-    int norbs = 0; /* Numer of orbitals */
     struct ao_atomdata *adata = NULL; /* Atom basis data */
-    //struct ao_basisfunc *aobasis = NULL; /* Atomic orbital basis */
     int i = 0;
-    
-    /* Check for daltaoin file. Open the file and read the first
-     * three lines. The ao_read_dalton_title subroutine ensures
-     * the file is of the correct form. */
-    error = ao_check_for_daltaoin();
-    if (error != 0) return error;
-    daltin = ao_open_daltonfile(daltin);
-    if (daltin == NULL) {
-        error++;
-        return error;
-    }
-    error = ao_read_daltontitle(daltin);
+
+    /* Read the daltaoin file. The ao_read_dalton_title subroutine
+     * ensures the file is of the correct form. */
+    dbuf = ao_read_textfile("daltaoin", &dline, &ndline);
+    if (dbuf == NULL) return 1;
+    error = ao_read_daltontitle(dline, ndline, &ln);
     if (error != 0) return error;
-    
+
     /* Read the first line of basis set information. */
-    error = ao_read_dalton_basisinfo1(daltin, crt, &atypes, &molchg,
-                                      symtxt, &thrs, id3);
+    error = ao_read_dalton_basisinfo1(dline, ndline, &ln, crt, &atypes,
+                                      &molchg, symtxt, &thrs, id3);
     if (error != 0) return error;
     ao_print_dalton_basisinfo1(crt, atypes, molchg, symtxt, thrs);
-    
-    
+
     /* Allocate atomdata structure type. Read in basis set information
      * for each atom type. */
     adata = (struct ao_atomdata *)
         malloc(sizeof(struct ao_atomdata) * atypes);
     for (i = 0; i < atypes; i++) {
-        error = ao_read_dalton_atombasis1(daltin, &adata[i]);
+        error = ao_read_dalton_atombasis1(dline, ndline, &ln, &adata[i]);
         if (error != 0) return error;
         ao_print_dalton_atombasis1(adata[i]);
-        error = ao_read_dalton_atombasis2(daltin, &adata[i]);
+        error = ao_read_dalton_atombasis2(dline, ndline, &ln, &adata[i]);
+        if (error != 0) return error;
     }
-    
+    free(dline);
+    free(dbuf);
+
     /* Process the basis set information and construct the atomic
      * orbital basis. */
-    error = ao_build_atomic_orbitalset(adata, aobasis, atypes, &norbs);
+    error = ao_build_atomic_orbitalset(adata, aobasis, atypes, norbs);
+    for (i = 0; i < atypes; i++) {
+        ao_free_atomdata(&adata[i]);
+    }
+    free(adata);
+    return error;
+}
+
+/*
+ * ao_buildao_gridbasis: build the atomic orbital basis on the root
+ * process and broadcast it to all processes as a grid basis. This is
+ * executed on all processes.
+ */
+int ao_buildao_gridbasis(struct ao_gridbasis *gb)
+{
+    int error = 0;
+    struct ao_basisfunc *aobasis = NULL; /* Atomic orbital basis */
+    int norbs = 0;
+    int dims[3];
+
+    if (mpi_proc_rank == mpi_root) {
+        error = ao_buildao(&aobasis, &norbs);
+        if (error == 0) error = aogrid_init(aobasis, norbs, gb);
+        if (aobasis != NULL) ao_free_atomic_orbital_set(aobasis, norbs);
+    }
+    MPI_Bcast(&error, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+    if (error != 0) return error;
+
+    if (mpi_proc_rank == mpi_root) {
+        dims[0] = gb->nao;
+        dims[1] = gb->nprim;
+        dims[2] = gb->ncntr;
+    }
+    MPI_Bcast(dims, 3, MPI_INT, mpi_root, MPI_COMM_WORLD);
+    if (mpi_proc_rank != mpi_root) {
+        gb->nao   = dims[0];
+        gb->nprim = dims[1];
+        gb->ncntr = dims[2];
+        gb->type   = malloc(sizeof(int) * gb->nao);
+        gb->cntr   = malloc(sizeof(int) * gb->nao);
+        gb->pstart = malloc(sizeof(int) * (gb->nao + 1));
+        gb->rcut2  = malloc(sizeof(double) * gb->nao);
+        gb->expn   = malloc(sizeof(double) * gb->nprim);
+        gb->coef   = malloc(sizeof(double) * gb->nprim);
+        gb->xyz    = malloc(sizeof(double) * 3 * gb->ncntr);
+        gb->chrg   = malloc(sizeof(double) * gb->ncntr);
+    }
+    MPI_Bcast(gb->type,   gb->nao,       MPI_INT,    mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(gb->cntr,   gb->nao,       MPI_INT,    mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(gb->pstart, (gb->nao + 1), MPI_INT,    mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(gb->rcut2,  gb->nao,       MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(gb->expn,   gb->nprim,     MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(gb->coef,   gb->nprim,     MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(gb->xyz,    (3 * gb->ncntr), MPI_DOUBLE, mpi_root,
+              MPI_COMM_WORLD);
+    MPI_Bcast(gb->chrg,   gb->ncntr,     MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
     return error;
 }
 
@@ -76,73 +135,45 @@ int ao_buildao(struct ao_basisfunc *aobasis)
  * routine requires the soinfo.dat generated by DALTON.
  */
 int ao_build_atomic_orbitalset(struct ao_atomdata *adata,
-                               struct ao_basisfunc *aobasis,
+                               struct ao_basisfunc **aobasis,
                                int atypes, int *norbs)
 {
     int error = 0;        /* Error flag */
-    FILE *soinfo  = NULL; /* soinfo.dat file pointer */
+    char *sbuf = NULL;    /* soinfo.dat buffer */
+    char **sline = NULL;  /* soinfo.dat lines */
+    int nsline = 0;       /* Number of soinfo.dat lines */
+    char **caoinfo = NULL;/* CAOINFO lines */
     double *gscal = NULL; /* Gaussian scalings */
     int ngaus = 0;        /* Number of gaussians to scale */
-    char **ainfo = NULL;  /* Atom info array [natom][MAX_LINE_SIZE] */
-    int natoms = 0;       /* Number of atoms */
     int i = 0;
-    
-    /* Check for soinfo.dat file. Get number of atomic orbitals for
-     * the molecule from the soinfo.dat file. Allocate the aobasis
-     * array to hold each atomic orbital. */
-    error = ao_check_for_soinfodat();
-    if (error != 0) return error;
-    soinfo = ao_open_soinfodat(soinfo);
-    if (soinfo == NULL) {
-        error++;
-        return error;
-    }
-    error = ao_get_orbitalnum(soinfo, norbs);
+
+    /* Read soinfo.dat. Get number of atomic orbitals for the molecule
+     * and the gaussian scalings in one pass over the lines. Allocate
+     * the aobasis array to hold each atomic orbital. */
+    sbuf = ao_read_textfile("soinfo.dat", &sline, &nsline);
+    if (sbuf == NULL) return 1;
+    caoinfo = malloc(sizeof(char *) * nsline);
+    gscal = malloc(sizeof(double) * nsline);
+    error = ao_scan_soinfo(sline, nsline, caoinfo, norbs, gscal, &ngaus);
     if (error != 0) return error;
     printf("Atomic orbital number: %d\n", *norbs);
-//        aobasis = (struct ao_basisfunc *)
-//                malloc(*norbs * sizeof(struct ao_basisfunc));
-//        for (i = 0; i < *norbs; i++) {
-//                aobasis[i].geom = (double *) malloc(3 * sizeof(double));
-//        }
-    /* Get gaussian scaling information */
-    error = ao_get_gscalings(soinfo, &gscal, &ngaus);
     printf("Gaussian scalings:\n");
     for (i = 0; i < ngaus; i++) {
         printf(" %4d %16.10lf\n", (i + 1), gscal[i]);
     }
-    /* Get atominfo. This will be used to assign basis functions */
-    error = ao_get_atominfo(soinfo, &ainfo, &natoms);
-    for (i = 0; i < natoms; i++) {
-        printf("%s", ainfo[i]);
-    }
-    error = ao_process_orbitaldata(adata, aobasis, soinfo, *norbs, gscal,
-                                   ngaus, ainfo, atypes);
-    for (i = 0; i < *norbs; i++) {
+    *aobasis = ao_initialize_atomic_orbital_set(*norbs);
+    if (*aobasis == NULL) return 1;
+    error = ao_process_orbitaldata(adata, *aobasis, caoinfo, *norbs, gscal,
+                                   ngaus, atypes);
+    for (i = 0; i < *norbs && error == 0; i++) {
         printf(" --- Orbital #%3d ---\n", (i + 1));
-        ao_print_orbital_information(aobasis[i]);
+        ao_print_orbital_information((*aobasis)[i]);
     }
-    
-    return error;
-}
-
-/*
- * ao_check_for_daltaoin: Check for daltaoin file.
- */
-int ao_check_for_daltaoin()
-{
-    int error = 0;
-    error = check_for_file("daltaoin","r");
-    return error;
-}
 
-/*
- * ao_check_for_soinfodat: Check for soinfo.dat file.
- */
-int ao_check_for_soinfodat()
-{
-    int error = 0;
-    error = check_for_file("soinfo.dat","r");
+    free(caoinfo);
+    free(gscal);
+    free(sline);
+    free(sbuf);
     return error;
 }
 
@@ -169,9 +200,9 @@ void ao_cp_gaussian_scaling(struct ao_basisfunc *bas, double *gscal,
 {
     int gaussn = 0;
     int i = 0;
-    
+
     for (i = 0; i <= lval; i++) {
-        gaussn = gaussn + norb_per_l[i]; 
+        gaussn = gaussn + norb_per_l[i];
     }
     gaussn = gaussn - 1;
     bas->gscale = gscal[gaussn];
@@ -179,21 +210,55 @@ void ao_cp_gaussian_scaling(struct ao_basisfunc *bas, double *gscal,
 }
 
 /*
- * ao_get_atominfo: get atominfo character arrays from soinfo.dat file.
+ * ao_field: copy the fixed-width field line[pos:pos+len] into fld
+ * (len + 1 characters). Stops at the end of the line.
  */
-int ao_get_atominfo(FILE *soinfo, char ***ainfo, int *natoms)
+char *ao_field(char *line, int pos, int len, char *fld)
 {
-    int error = 0; /* Error flag */
-    char line[MAX_LINE_SIZE];
     int i = 0;
-    
-    *natoms = find_str_count_in_file("ATOMINFO", soinfo);
-    error = allocate_mem_char(ainfo, MAX_LINE_SIZE, *natoms);
-    soinfo = find_str_line("ATOMINFO", soinfo);
-    for (i = 0; i < *natoms; i++) {
-        fgets((*ainfo)[i], MAX_LINE_SIZE, soinfo);
+
+    if ((int) strlen(line) > pos) {
+        for (i = 0; i < len && line[(pos + i)] != '\0'; i++) {
+            fld[i] = line[(pos + i)];
+        }
     }
-    return error;
+    fld[i] = '\0';
+    return fld;
+}
+
+/*
+ * ao_free_atomdata: free atom basis data.
+ */
+void ao_free_atomdata(struct ao_atomdata *adata)
+{
+    int i = 0;
+
+    for (i = 0; i < adata->totblk; i++) {
+        free(adata->basis[i].alpha);
+        deallocate_mem_cont(&(adata->basis[i].ccoef),
+                            adata->basis[i].ccoef1d);
+    }
+    free(adata->basis);
+    free(adata->lval);
+    free(adata->naob);
+    deallocate_mem_cont(&(adata->geom), adata->geom1d);
+    return;
+}
+
+/*
+ * ao_free_atomic_orbital_set: free atomic orbital array.
+ */
+void ao_free_atomic_orbital_set(struct ao_basisfunc *aobasis, int norbs)
+{
+    int i = 0;
+
+    for (i = 0; i < norbs; i++) {
+        free(aobasis[i].geom);
+        free(aobasis[i].ccoef);
+        free(aobasis[i].alpha);
+    }
+    free(aobasis);
+    return;
 }
 
 /*
@@ -203,9 +268,9 @@ int ao_get_atominfo(FILE *soinfo, char ***ainfo, int *natoms)
 int ao_get_lvalue_from_type(int oindex)
 {
     int lvalue = 0; /* Block index */
-    
+
     switch (oindex) {
-    case 1: 
+    case 1:
         lvalue = 0; /* s orbital */
         break;
     case 2: case 3: case 4:
@@ -223,57 +288,8 @@ int ao_get_lvalue_from_type(int oindex)
                       "ao_get_block_index_from_type");
         break;
     }
-    
-    return lvalue;
-}
-
-/*
- * ao_get_gscalings: get gaussian scalings from soinfo.dat file.
- */
-int ao_get_gscalings(FILE *soinfo, double **gptr, int *ngaus)
-{
-    int error = 0;              /* Error flag */
-    char line[MAX_LINE_SIZE];   /* Scratch line */
-    char *lnptr;                /* Line pointer */
-    double *gscal;              /* Gaussian scalings */
-    int i = 0;
-    
-    /* Get the total number of gaussians and read in each scaling. */
-    *ngaus = find_str_count_in_file("GTOSCALE", soinfo);
-    if (*ngaus <= 0) {
-        error_message(0, "GTOSCALE not found in soinfo.dat",
-                      "ao_build_atomic_orbitalset");
-        error++;
-        return error;
-    }
-    gscal = (double *) malloc(sizeof(double) * (*ngaus));
-    
-    /* Find gaussian scalings in soinfo.dat file. These lines start
-     * with 'GTOSCALE'. The format is '(A10,16.10)' */
-    soinfo = find_str_line("GTOSCALE", soinfo);
-    for (i = 0; i < *ngaus; i++) {
-        fgets(line, MAX_LINE_SIZE, soinfo);
-        lnptr = substring(line, 10, 16);
-        sscanf(lnptr, "%lf", &gscal[i]);
-    }
-    *gptr = gscal; /* Set pointer to allocated array and return. */ 
-    return error;
-}
 
-/*
- * ao_get_orbitalnum: get orbital number of soinfo.dat file.
- */
-int ao_get_orbitalnum(FILE *soinfo, int *norbs)
-{
-    int error = 0; /* Error flag */
-    
-    *norbs = find_str_count_in_file("CAOINFO", soinfo);
-    if (*norbs <= 0) {
-        error_message(0, "CAOINFO not found in soinfo.dat",
-                      "ao_get_orbitalnum");
-        error++;
-    }
-    return error;
+    return lvalue;
 }
 
 /*
@@ -286,13 +302,13 @@ void ao_get_block_and_gauss_number(int *norbpl, struct ao_atomdata adata,
     int minblock = 0; /* Lowest block number for l value */
     int count = 0;
     int i = 0;
-    
+
     /* Get lowest block for l value */
     for (i = 0; i < adata.totblk; i++) {
         if (lvalue == adata.lval[i]) break;
     }
     minblock = i;
-    
+
     /* Count gaussians through l-value blocks */
     for (i = minblock; i < minblock + adata.naob[lvalue]; i++) {
         count = count + adata.basis[i].cgaus;
@@ -326,9 +342,8 @@ void ao_increment_norb_per_l(int *nopl, int oindex)
 struct ao_basisfunc *ao_initialize_atomic_orbital_set(int norbs)
 {
     struct ao_basisfunc *ptr; /* Return value */
-    int error = 0; /* Error flag */
     int i = 0;
-    
+
     ptr = (struct ao_basisfunc *)
         malloc(sizeof(struct ao_basisfunc) * norbs);
     if (ptr == NULL) {
@@ -338,34 +353,12 @@ struct ao_basisfunc *ao_initialize_atomic_orbital_set(int norbs)
     }
     for (i = 0; i < norbs; i++) {
         ptr[i].geom = (double *) malloc(3 * sizeof(double));
+        ptr[i].ccoef = NULL;
+        ptr[i].alpha = NULL;
     }
     return ptr;
 }
 
-/*
- * ao_open_daltonfile: open dalton file returing file stream.
- */
-FILE *ao_open_daltonfile(FILE *daltin)
-{
-    daltin = fopen("daltaoin", "r");
-    if (daltin == NULL) {
-        error_message(0, "Cannot open daltaoin!", "ao_open_daltonfile");
-    }
-    return daltin;
-}
-
-/*
- * ao_open_soinfodat: open soinfo.dat file, returning file stream.
- */
-FILE *ao_open_soinfodat(FILE *soinfo)
-{
-    soinfo = fopen("soinfo.dat", "r");
-    if (soinfo == NULL) {
-        error_message(0, "Cannot open soinfo.dat!", "ao_open_soinfodat");
-    }
-    return soinfo;
-}
-
 /*
  * ao_print_dalton_atombasis1(adata)
  */
@@ -401,7 +394,7 @@ void ao_print_dalton_basisinfo1(char *crt, int atypes, int molchg,
     printf("Molecular charge =    %d\n", molchg);
     printf("Symm ops to perform = %s\n", symtxt);
     printf("\nIntegral threshold = %8.2e\n", thrs);
-    
+
     return;
 }
 
@@ -417,7 +410,7 @@ void ao_print_orbital_information(struct ao_basisfunc aobasis)
     printf(" Atomic center index:    %10d\n", aobasis.atom);
     printf(" Geometry:\n");
     printf(" %15.8lf %15.8lf %15.8lf\n",
-           aobasis.geom[0], aobasis.geom[1], aobasis.geom[3]);
+           aobasis.geom[0], aobasis.geom[1], aobasis.geom[2]);
     printf(" Gaussian scaling:       %10.8lf\n", aobasis.gscale);
     printf(" Alpha & contraction coeffs: \n");
     for (i = 0; i < aobasis.ugaus; i++) {
@@ -436,30 +429,22 @@ void ao_process_aorbital_dataline(char *line, int *anum, char *atom,
                                   int *atype_anum, int *onum, char *ao_desc,
                                   int *oindex, char *atom_desc)
 {
-    char *lnptr = NULL; /* Line pointer */
-    
+    char fld[MAX_LINE_SIZE]; /* Field */
+
     /* Format: (A8,I3,A1,I3,I2,A5,I3)
      * "CAOINFO: [atom number][atom][atom number w/in type][num of orbital]
      *           [orbital name desc.][orbital index] */
-    lnptr = substring(line, 8, 3);
-    sscanf(lnptr, "%d", anum);
-    
+    sscanf(ao_field(line, 8, 3, fld), "%d", anum);
+
     /* Read in atom description as character array to compare with ATOMINFO
      * arrays. This will help to switch appropriate geometry information */
-    lnptr = substring(line,11, 4);
-    sscanf(lnptr, "%s", atom_desc);
-    
-    lnptr = substring(line,11, 1);
-    sscanf(lnptr, "%s", atom);
-    lnptr = substring(line,12, 3);
-    sscanf(lnptr, "%d", atype_anum);
-    lnptr = substring(line,15, 2);
-    sscanf(lnptr, "%d", onum);
-    lnptr = substring(line,17, 5);
-    sscanf(lnptr, "%s", ao_desc);
-    lnptr = substring(line,22, 3);
-    sscanf(lnptr, "%d", oindex);
-    
+    sscanf(ao_field(line, 11, 4, fld), "%s", atom_desc);
+    sscanf(ao_field(line, 11, 1, fld), "%s", atom);
+    sscanf(ao_field(line, 12, 3, fld), "%d", atype_anum);
+    sscanf(ao_field(line, 15, 2, fld), "%d", onum);
+    sscanf(ao_field(line, 17, 5, fld), "%s", ao_desc);
+    sscanf(ao_field(line, 22, 3, fld), "%d", oindex);
+
     return;
 }
 
@@ -469,12 +454,10 @@ void ao_process_aorbital_dataline(char *line, int *anum, char *atom,
  */
 int ao_process_orbitaldata(struct ao_atomdata *adata,
                            struct ao_basisfunc *aobasis,
-                           FILE *soinfo, int norbs, double *gscal,
-                           int ngaus, char **ainfo, int atypes)
+                           char **caoinfo, int norbs, double *gscal,
+                           int ngaus, int atypes)
 {
     int error = 0;            /* Error flag */
-    char line[MAX_LINE_SIZE]; /* Scratch line array */
-    char *lnptr = NULL;       /* Line pointer */
     int anum = 0;             /* Atom number */
     int old_anum = 0;         /* New atom check. */
     char atom[2];             /* Atom name */
@@ -483,18 +466,13 @@ int ao_process_orbitaldata(struct ao_atomdata *adata,
     int onum = 0;             /* Orbital number */
     char ao_desc[6];          /* Atomic orbital description */
     int oindex = 0;           /* Orbital index s=1,px=2,py=3,etc. */
-    int ocnt = 0;             /* Orbital counter */
     int atyp = 0;             /* Atom type. */
-    int block_index = 0;      /* AO Basis block index */
     int lvalue = 0;           /* Orbital lvalue */
     int norb_per_l[10];       /* Number of orbitals per l value */
     int blockn = 0;           /* Block number of new orbital */
     int gaussn = 0;           /* Gaussian number of new orbital */
-    int i = 0, j = 0;        
-    
-    /* Locate 'CAOINFO' in soinfo.dat file. */
-    soinfo = find_str_line("CAOINFO", soinfo);
-    
+    int i = 0;
+
     /* Read over each atomic orbital and enter its basis set data.
      * Format: (A8,I3,A1,I3,I2,A5,I3)
      * "CAOINFO: [atom number][atom][atom number w/in type][num of orbital]
@@ -502,8 +480,7 @@ int ao_process_orbitaldata(struct ao_atomdata *adata,
     old_anum = 1;
     init_int_array_0(norb_per_l, 10);
     for (i = 0; i < norbs; i++) {
-        fgets(line, MAX_LINE_SIZE, soinfo);
-        ao_process_aorbital_dataline(line, &anum, atom, &atype_anum,
+        ao_process_aorbital_dataline(caoinfo[i], &anum, atom, &atype_anum,
                                      &onum, ao_desc, &oindex, atom_desc);
         /* Zero out the l value array for a new atom */
         if (old_anum != anum) {
@@ -511,7 +488,7 @@ int ao_process_orbitaldata(struct ao_atomdata *adata,
             old_anum = anum;
         }
         /* Find matching atom type */
-        for (atyp = 0; atyp <= atypes; atyp++) {
+        for (atyp = 0; atyp < atypes; atyp++) {
             if (strstr(atom,adata[atyp].name) != NULL) {
                 break;
             }
@@ -522,6 +499,7 @@ int ao_process_orbitaldata(struct ao_atomdata *adata,
                      aobasis[i].geom, 3);
         aobasis[i].type = oindex;
         aobasis[i].atom = anum;
+        aobasis[i].nucchrg = adata[atyp].nucchrg;
         /* Get l value. Increment orbital type if necessary, and
          * get orbital block & gaussian information */
         lvalue = ao_get_lvalue_from_type(aobasis[i].type);
@@ -539,62 +517,57 @@ int ao_process_orbitaldata(struct ao_atomdata *adata,
         ao_cp_alphavals_ccoefs(blockn, gaussn, adata[atyp], &aobasis[i]);
         /* Copy gaussian scaling */
         ao_cp_gaussian_scaling(&aobasis[i], gscal, norb_per_l, lvalue);
-        
+
     }
-    
+
     return error;
 }
 
 /*
  * ao_read_dalton_aoblock: read am atomic orbital basis block from daltaoin
  */
-int ao_read_dalton_aoblock(FILE *daltin, struct ao_basis *basis)
+int ao_read_dalton_aoblock(char **line, int nlines, int *ln,
+                           struct ao_basis *basis)
 {
     int error = 0;              /* Error flag */
-    char line[MAX_LINE_SIZE];   /* scratch line */
-    char *lnptr = NULL;         /* Line pointer */
+    char fld[MAX_LINE_SIZE];    /* Field */
     char cscr[2];               /* Single character scratch */
-    double dscr = 0.0;          /* Single double scratch */
-    int newg = 0;               /* New gaussian switch */
     int i = 0, j = 0;
-    fpos_t ptr;    /* File position pointer */
-    int pos = 0;   /* position */
-    int cnt = 0;   /* counter */
     int cclns = 0; /* contraction coefficient lines per gaussian */
-    
+
     /* Read first line of block. This line contains:
      * '(A1,i5,i5)' H   [uncontracted]   [contracted] */
-    fgets(line, MAX_LINE_SIZE, daltin);
-    lnptr = substring(line, 0, 1);
-    sscanf(lnptr, "%s", cscr);
+    if (*ln >= nlines) return 1;
+    cscr[0] = '\0';
+    sscanf(ao_field(line[*ln], 0, 1, fld), "%1s", cscr);
     if ((strstr(cscr,"H")) == NULL) {
         error++;
         return error;
     }
-    lnptr = substring(line, 1, 5);
-    sscanf(lnptr, "%d", &basis->ugaus);
-    lnptr = substring(line, 6, 5);
-    sscanf(lnptr, "%d", &basis->cgaus);
+    basis->ugaus = 0;
+    basis->cgaus = 0;
+    sscanf(ao_field(line[*ln], 1, 5, fld), "%d", &basis->ugaus);
+    sscanf(ao_field(line[*ln], 6, 5, fld), "%d", &basis->cgaus);
+    (*ln)++;
     if ((basis->ugaus == 0) || (basis->cgaus == 0)) {
         error++;
         return error;
     }
     basis->alpha = (double *) malloc(sizeof(double) * basis->ugaus);
-    error = allocate_mem_double(&basis->ccoef, basis->cgaus, basis->ugaus);
-    
-    /* Get number of lines per contraction. Dalton output prints 3 
-     * coefficients per line, so the number of lines to read must be 
-     * computed. Read in alpha and contraction values for block */
+    basis->ccoef1d = allocate_mem_double_cont(&basis->ccoef, basis->ugaus,
+                                              basis->cgaus);
+
+    /* Get number of lines per contraction. Dalton output prints 3
+     * coefficients per line, so the number of lines to read must be
+     * computed. Read in alpha and contraction values for block. The
+     * alpha value is on the first line of each uncontracted gaussian. */
     cclns = basis->cgaus / 3;
     if ((basis->cgaus % 3) != 0) cclns++;
+    if ((*ln + basis->ugaus * cclns) > nlines) return 1;
     for (i = 0; i < basis->ugaus; i++) {
-        fgetpos(daltin, &ptr); // Get position for first line read
-        fgets(line, MAX_LINE_SIZE, daltin);
-        lnptr = substring(line, 0, 20);
-        sscanf(lnptr, "%lf", &basis->alpha[i]);
-        fsetpos(daltin, &ptr); // Reset position
+        sscanf(ao_field(line[*ln], 0, 20, fld), "%lf", &basis->alpha[i]);
         /* Read in contraction values */
-        error = ao_read_dalton_contractionvals(daltin, basis, i);
+        error = ao_read_dalton_contractionvals(line, ln, basis, i);
     }
     for (i = 0; i < basis->ugaus; i++) {
         printf("%20.8lf", basis->alpha[i]);
@@ -603,58 +576,54 @@ int ao_read_dalton_aoblock(FILE *daltin, struct ao_basis *basis)
         }
         printf("\n");
     }
-    return error; 
+    return error;
 }
 
 /*
  * ao_read_dalton_atombasis1: read first line of atom basis set iformation.
  * (Reads in: nuclear charge, number of atoms, max L value, blocks per L value
  */
-int ao_read_dalton_atombasis1(FILE *daltin, struct ao_atomdata *adata)
+int ao_read_dalton_atombasis1(char **line, int nlines, int *ln,
+                              struct ao_atomdata *adata)
 {
     int error = 0;            /* Error flag */
-    char line[MAX_LINE_SIZE]; /* scratch line */
-    char *lnptr = NULL;       /* line pointer */
+    char fld[MAX_LINE_SIZE];  /* Field */
     char scr[2];
     int i = 0, pos = 0;
-    
-    fgets(line, MAX_LINE_SIZE, daltin);
-    
-    /* Read in values according to the following format: 
+
+    if (*ln >= nlines) return 1;
+
+    /* Read in values according to the following format:
      * '(BN,6x,F4.0,I5,24I5)' */
-    lnptr = substring(line, 5, 4);
-    sscanf(lnptr, "%lf", &adata->nucchrg);
-    lnptr = substring(line, 10, 5);
-    sscanf(lnptr, "%d", &adata->natm);
-    lnptr = substring(line, 15, 5);
-    sscanf(lnptr, "%d", &adata->maxlval);
+    sscanf(ao_field(line[*ln], 5, 4, fld), "%lf", &adata->nucchrg);
+    sscanf(ao_field(line[*ln], 10, 5, fld), "%d", &adata->natm);
+    sscanf(ao_field(line[*ln], 15, 5, fld), "%d", &adata->maxlval);
     adata->naob = (int *) malloc(sizeof(int) * adata->maxlval);
     for (i = 0; i < adata->maxlval; i++) {
         pos = 20 + i*5;
-        lnptr = substring(line, pos, 5);
-        sscanf(lnptr, "%d", &adata->naob[i]);
+        sscanf(ao_field(line[*ln], pos, 5, fld), "%d", &adata->naob[i]);
     }
-    
+    (*ln)++;
+
     /* Read in geometries */
-    error = allocate_mem_double(&adata->geom, 3, adata->natm);
-    if (error != 0) {
+    if ((*ln + adata->natm) > nlines) return 1;
+    adata->geom1d = allocate_mem_double_cont(&adata->geom, 3, adata->natm);
+    if (adata->geom1d == NULL) {
         error_message(0, "*** Error allocating data.geom!",
                       "ao_read_dalton_atombasis1");
-        return error;
+        return 1;
     }
     for (i = 0; i < adata->natm; i++) {
-        fgets(line, MAX_LINE_SIZE, daltin);
-        lnptr = substring(line, 0, 1);
-        sscanf(lnptr, "%s", scr);
+        sscanf(ao_field(line[*ln], 0, 1, fld), "%1s", scr);
         strcpy(adata->name, scr);
-        lnptr = substring(line, 4, 60);
-        sscanf(lnptr, "%lf %lf %lf", &adata->geom[i][0],
-               &adata->geom[i][1], &adata->geom[i][2]);
+        sscanf(ao_field(line[*ln], 4, 60, fld), "%lf %lf %lf",
+               &adata->geom[i][0], &adata->geom[i][1], &adata->geom[i][2]);
+        (*ln)++;
     }
-    
+
     /* Adjust adata->maxlval to read l value: s=0, p=1, d=2, ... */
     adata->maxlval--;
-    
+
     return error;
 };
 
@@ -662,12 +631,13 @@ int ao_read_dalton_atombasis1(FILE *daltin, struct ao_atomdata *adata)
  * ao_read_dalton_atombasis2: read atomic orbital basis blocks from daltaoin
  * file into the AO_ATOMDATA.AO_ABASIS type.
  */
-int ao_read_dalton_atombasis2(FILE *daltin, struct ao_atomdata *adata)
+int ao_read_dalton_atombasis2(char **line, int nlines, int *ln,
+                              struct ao_atomdata *adata)
 {
     int error = 0;            /* Error flag */
     int i = 0, j = 0;
     int count = 0;
-    
+
     /* Get total number of blocks. Then loop over each block reading in
      * the AO basis definition. */
     adata->totblk = 0;
@@ -686,7 +656,13 @@ int ao_read_dalton_atombasis2(FILE *daltin, struct ao_atomdata *adata)
     printf("Total blocks to read: %d\n", adata->totblk);
     for (i = 0; i < adata->totblk; i++) {
         printf("Block %d: l=%d\n", (i+1), adata->lval[i]);
-        error = ao_read_dalton_aoblock(daltin, &adata->basis[i]);
+        error = ao_read_dalton_aoblock(line, nlines, ln, &adata->basis[i]);
+        if (error != 0) {
+            error_message(0, "Error reading basis block",
+                          "ao_read_dalton_atombasis2");
+            adata->totblk = i;
+            return error;
+        }
     }
     return error;
 }
@@ -695,7 +671,9 @@ int ao_read_dalton_atombasis2(FILE *daltin, struct ao_atomdata *adata)
  * ao_read_dalton_basisinfo1: read first line of basis set information in
  * dalton file.
  * Input:
- *  daltin = dalton input file file stream.
+ *  line   = daltaoin lines
+ *  nlines = number of lines
+ *  ln     = current line
  * Output:
  *  crt = slpherical harmonics flag
  *  atypes = atom types
@@ -704,32 +682,30 @@ int ao_read_dalton_atombasis2(FILE *daltin, struct ao_atomdata *adata)
  *  thrs  = integral threshold
  *  id3 = not referenced
  */
-int ao_read_dalton_basisinfo1(FILE *daltin, char *crt, int *atypes,
-                              int *molchg, char *symtxt,
+int ao_read_dalton_basisinfo1(char **line, int nlines, int *ln, char *crt,
+                              int *atypes, int *molchg, char *symtxt,
                               double *thrs, char *id3)
 {
     int error = 0; /* error flag */
-    char line[MAX_LINE_SIZE];
-    char *lnptr = NULL; /* Line pointer */
-    
-    fgets(line, MAX_LINE_SIZE, daltin);
-    
+    char fld[MAX_LINE_SIZE]; /* Field */
+
+    if (*ln >= nlines) return 1;
+
     /* Read in values according to the following format:
      * '(BN,A1,I4,I3,A2,10A1,D10.2,6I5)  */
-    lnptr = substring(line, 0, 1);
-    sscanf(lnptr, "%s", crt);
-    lnptr = substring(line, 1, 4);
-    sscanf(lnptr, "%d", atypes);
-    lnptr = substring(line, 5, 3);
-    sscanf(lnptr, "%d", molchg);
-    lnptr = substring(line, 8, 2);
-    sscanf(lnptr, "%s", symtxt);
-    lnptr = substring(line, 19, 1);
-    sscanf(lnptr, "%s", id3);
-    
+    crt[0] = '\0';
+    symtxt[0] = '\0';
+    id3[0] = '\0';
+    sscanf(ao_field(line[*ln], 0, 1, fld), "%1s", crt);
+    sscanf(ao_field(line[*ln], 1, 4, fld), "%d", atypes);
+    sscanf(ao_field(line[*ln], 5, 3, fld), "%d", molchg);
+    sscanf(ao_field(line[*ln], 8, 2, fld), "%2s", symtxt);
+    sscanf(ao_field(line[*ln], 19, 1, fld), "%1s", id3);
+    (*ln)++;
+
     /* Set threshold. */
     *thrs = pow(10,-15);
-    
+
     /* Check results. */
     if ((strstr(crt,"s")) == NULL) {
         error++;
@@ -750,31 +726,31 @@ int ao_read_dalton_basisinfo1(FILE *daltin, char *crt, int *atypes,
  * ao_read_dalton_contractionvals: read contraction values for a uncontracted
  * gaussian.
  */
-int ao_read_dalton_contractionvals(FILE *daltin, struct ao_basis *basis, int ug)
+int ao_read_dalton_contractionvals(char **line, int *ln,
+                                   struct ao_basis *basis, int ug)
 {
     int error = 0; /* Error flag */
     int cclns = 0; /* Contraction coefficients line to read in */
-    char line[MAX_LINE_SIZE];
+    char fld[MAX_LINE_SIZE]; /* Field */
     int i = 0, j = 0;
     int cnt = 0; /* Counter */
-    int pos = 0; /* stream position */
-    char *lnptr = NULL;
-    
+    int pos = 0; /* line position */
+
     cclns = basis->cgaus / 3;
     if ((basis->cgaus % 3) != 0) cclns++;
     /* Loop over contraction coeffcients */
     cnt = 0;
     for (i = 0; i < cclns; i++) {
-        fgets(line, MAX_LINE_SIZE, daltin);
         for (j = 0; j < 3; j++) {
             pos = 20 + j * 20;
-            lnptr = substring(line, pos, 20);
-            sscanf(lnptr, "%lf", &(basis->ccoef[cnt][ug]));
+            sscanf(ao_field(line[*ln], pos, 20, fld), "%lf",
+                   &(basis->ccoef[cnt][ug]));
             cnt++;
             if (cnt == basis->cgaus) break;
         }
+        (*ln)++;
     }
-    
+
     return error;
 }
 
@@ -785,22 +761,104 @@ int ao_read_dalton_contractionvals(FILE *daltin, struct ao_basis *basis, int ug)
  * X
  * X
  */
-int ao_read_daltontitle(FILE *daltin)
+int ao_read_daltontitle(char **line, int nlines, int *ln)
 {
     int error = 0;
-    char firstline[MAX_LINE_SIZE];
-    char str[MAX_LINE_SIZE];
-    
-    sprintf(firstline,"INTGRL");
-    fgets(str, MAX_LINE_SIZE, daltin);
-    if ((strstr(str,firstline)) == NULL) {
+
+    if (nlines < 3 || (strstr(line[0], "INTGRL")) == NULL) {
         error++;
         error_message(0, "Error reading daltaoin", "ao_read_daltontitle");
         return error;
     }
     /* Skip next two lines. (They are empty.) */
-    fgets(str, MAX_LINE_SIZE, daltin);
-    fgets(str, MAX_LINE_SIZE, daltin);
-    
+    *ln = 3;
+
+    return error;
+}
+
+/*
+ * ao_read_textfile: read a text file with one fread and split it into
+ * lines. The newlines are replaced by '\0'.
+ */
+char *ao_read_textfile(char *filename, char ***lines, int *nlines)
+{
+    FILE *fptr = NULL;
+    char *buf = NULL;
+    long len = 0;
+    long i = 0;
+    int n = 0;
+
+    fptr = fopen(filename, "r");
+    if (fptr == NULL) {
+        error_message(0, "Cannot open file!", "ao_read_textfile");
+        printf(" file = %s\n", filename);
+        return NULL;
+    }
+    fseek(fptr, 0, SEEK_END);
+    len = ftell(fptr);
+    rewind(fptr);
+    buf = malloc(sizeof(char) * (len + 1));
+    if (buf == NULL || (long) fread(buf, 1, len, fptr) != len) {
+        error_message(0, "Error reading file!", "ao_read_textfile");
+        printf(" file = %s\n", filename);
+        fclose(fptr);
+        free(buf);
+        return NULL;
+    }
+    fclose(fptr);
+    buf[len] = '\0';
+
+    /* Count lines (the last may not end in a newline) */
+    *nlines = 0;
+    for (i = 0; i < len; i++) {
+        if (buf[i] == '\n') (*nlines)++;
+    }
+    if (len > 0 && buf[(len - 1)] != '\n') (*nlines)++;
+    *lines = malloc(sizeof(char *) * (*nlines + 1));
+    n = 0;
+    if (len > 0) (*lines)[n++] = buf;
+    for (i = 0; i < len; i++) {
+        if (buf[i] == '\n' || buf[i] == '\r') {
+            if (buf[i] == '\n' && (i + 1) < len) (*lines)[n++] = &buf[(i + 1)];
+            buf[i] = '\0';
+        }
+    }
+    return buf;
+}
+
+/*
+ * ao_scan_soinfo: collect the CAOINFO lines and GTOSCALE values of
+ * soinfo.dat in one pass.
+ */
+int ao_scan_soinfo(char **line, int nlines, char **caoinfo, int *norbs,
+                   double *gscal, int *ngaus)
+{
+    int error = 0;
+    char fld[MAX_LINE_SIZE]; /* Field */
+    int i = 0;
+
+    *norbs = 0;
+    *ngaus = 0;
+    for (i = 0; i < nlines; i++) {
+        if (strstr(line[i], "CAOINFO") != NULL) {
+            caoinfo[(*norbs)] = line[i];
+            (*norbs)++;
+        } else if (strstr(line[i], "GTOSCALE") != NULL) {
+            /* Format is '(A10,16.10)' */
+            sscanf(ao_field(line[i], 10, 16, fld), "%lf",
+                   &gscal[(*ngaus)]);
+            (*ngaus)++;
+        }
+    }
+    if (*norbs <= 0) {
+        error_message(0, "CAOINFO not found in soinfo.dat",
+                      "ao_scan_soinfo");
+        error++;
+    }
+    if (*ngaus <= 0) {
+        error_message(0, "GTOSCALE not found in soinfo.dat",
+                      "ao_scan_soinfo");
+        error++;
+    }
     return error;
 }
@@ -17,6 +17,7 @@
 #include "combinatorial.h"
 #include "straddress.h"
 #include "binarystr.h"
+#include "moslab.h"
 #include "action_util.h"
 #include "citruncate.h"
 #include <mpi.h>
@@ -174,14 +175,24 @@ struct occstr *allocate_occstr_arrays(int nstr)
 {
         struct occstr *ptr = NULL;
         ptr = (struct occstr *) malloc(sizeof(struct occstr) * nstr);
+        init_occstr_array(ptr, nstr);
+        return ptr;
+}                
+
+/*
+ * init_occstr_array: initialize binary electron orbital occupation
+ * string array.
+ */
+void init_occstr_array(struct occstr *ptr, int nstr)
+{
         for (int i = 0; i < nstr; i++) {
                 ptr[i].byte1 = 0x0;
                 ptr[i].virtx[0] = 0;
                 ptr[i].virtx[1] = 0;
                 ptr[i].nvrtx = 0;
         }
-        return ptr;
-}                
+        return;
+}
 
 /*
  * allocate_strings_array: allocate the strings array.
@@ -271,10 +282,20 @@ void compute_yij_lists(int nstr, int elec, int orbs, int ndocc, int nactv,
     int p;
     int spind;
     int nvirt = orbs - ndocc - nactv;
+    struct strgraph *sgraph = NULL; /* DOCC/ACTV/VIRT graphs per space */
     nvo = orbs - elec;
 
 
     orbsx = malloc(sizeof(int) * nvo);
+
+    /* Build the lexical addressing graphs of each electron space once,
+     * so that occstr2address is a sum of table entries. */
+    sgraph = malloc(sizeof(struct strgraph) * 3 * ngrps);
+    for (s = 0; s < ngrps; s++) {
+        init_strgraph(eosp[s].docc, ndocc, &(sgraph[3 * s]));
+        init_strgraph(eosp[s].actv, nactv, &(sgraph[3 * s + 1]));
+        init_strgraph(eosp[s].virt, nvirt, &(sgraph[3 * s + 2]));
+    }
     for (s = 0; s < nstr; s++) {
         
         /* Make available orbitals list */
@@ -330,12 +351,17 @@ void compute_yij_lists(int nstr, int elec, int orbs, int ndocc, int nactv,
                 /* Get eospace info for new string */
                 spind = get_string_eospace(&newstr, ndocc, nactv, eosp, ngrps);
                 neosp = eosp[spind];
-                binstr[s].cij[i][orbsx[j]] = occstr2address(&newstr, neosp, ndocc,
-                                                            nactv, nvirt, elec,
+                binstr[s].cij[i][orbsx[j]] = occstr2address(&newstr, neosp,
+                                                            &(sgraph[3 * spind]),
+                                                            ndocc, nactv, elec,
                                                             escr);
             }
         }
     }
+    for (s = 0; s < 3 * ngrps; s++) {
+        free_strgraph(&(sgraph[s]));
+    }
+    free(sgraph);
     free(orbsx);
     
     return;
@@ -477,8 +503,7 @@ int compute_detnum(struct eospace *peosp, int pegrps, struct eospace *qeosp,
  */
 void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                        int ndocc, int nactv, int docc_elec, int actv_elec,
-                       int virt_elec, int *docc, int *actv, int *virt,
-                       int *doccscr, int *actvscr, int *virtscr)
+                       int virt_elec, int *docc, int *actv, int *virt)
 {
         int i, j, k, l;
         int virt_orbs;
@@ -511,7 +536,7 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                 strlist[ptr].doccx = ndocc - docc_elec;
                 strlist[ptr].actvx = virt_elec;
 
-                str_adr2str(i, doccscr, elecs[0], orbs[0], docc);
+                str_adr2str(i, elecs[0], orbs[0], docc);
                 for (j = 0; j < elecs[0]; j++) {
                         strlist[ptr].string[j] = docc[j] + pegs[0];
                 }
@@ -524,7 +549,7 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                 }
                 /* Loop over second space's strings */
                 for (j = 1; j <= nstr[1]; j++) {
-                        str_adr2str(j, actvscr, elecs[1], orbs[1], actv);
+                        str_adr2str(j, elecs[1], orbs[1], actv);
                         for (k = 0; k < elecs[0]; k++) {
                                 strlist[ptr].string[k] = docc[k] + pegs[0];
                         }
@@ -542,7 +567,7 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                         }
                         /* Loop over third space's strings */
                         for (k = 1; k <= nstr[2]; k++) {
-                                str_adr2str(k, virtscr, elecs[2], orbs[2], virt);
+                                str_adr2str(k, elecs[2], orbs[2], virt);
                                 for (l = 0; l < elecs[0]; l++) {
                                         strlist[ptr].string[l] = docc[l] + pegs[0];
                                 }
@@ -3974,27 +3999,19 @@ void generate_string_list(struct eostring *strlist, int nstr, int orbs,
 {
 
         int count = 0; /* String counter */
-        int *docc = NULL, *doccscr = NULL;
-        int *actv = NULL, *actvscr = NULL;
-        int *virt = NULL, *virtscr = NULL;
+        int *docc = NULL;
+        int *actv = NULL;
+        int *virt = NULL;
         int max_space_size = 20;
         int i;
         //docc = (int *) malloc(sizeof(int) * max_space_size);
-        //doccscr = (int *) malloc(sizeof(int) * max_space_size);
         docc =  malloc(sizeof(int) * max_space_size);
-        doccscr =  malloc(sizeof(int) * max_space_size);
         init_int_array_0(docc, max_space_size);
-        init_int_array_0(doccscr, max_space_size);
         //actv = (int *) malloc(sizeof(int) * max_space_size);
-        //actvscr = (int *) malloc(sizeof(int) * max_space_size);
         actv =  malloc(sizeof(int) * max_space_size);
-        actvscr =  malloc(sizeof(int) * max_space_size);
         init_int_array_0(actv, max_space_size);
-        init_int_array_0(actvscr, max_space_size);
         virt =  malloc(sizeof(int) * max_space_size);
-        virtscr = malloc(sizeof(int) * max_space_size);
         init_int_array_0(virt, max_space_size);
-        init_int_array_0(virtscr, max_space_size);
 
         /* Loop over electron groupings */
         for (i = 0; i < egrps; i++) {
@@ -4002,15 +4019,12 @@ void generate_string_list(struct eostring *strlist, int nstr, int orbs,
                 eosp[i].start = count;
                 compute_eostrings(strlist, &count, orbs, ndocc, nactv,
                                   eosp[i].docc, eosp[i].actv, eosp[i].virt,
-                                  docc, actv, virt, doccscr, actvscr, virtscr);
+                                  docc, actv, virt);
                 eosp[i].nstr = count - eosp[i].nstr;
         }
         free(actv);
-        free(actvscr);
         free(virt);
-        free(virtscr);
         free(docc);
-        free(doccscr);
         return;
 }
 
@@ -4089,12 +4103,14 @@ int get_string_eospace(struct occstr *str, int ndocc, int nactv,
     
 /*
  * occstr2address: compute the string index of given an occupation string.
+ * sg holds the DOCC, ACTV and VIRT addressing graphs of space eosp.
  */
-int occstr2address(struct occstr *str, struct eospace eosp, int ndocc, int nactv,
-                   int nvirt, int nelec, int *elecs)
+int occstr2address(struct occstr *str, struct eospace eosp,
+                   struct strgraph *sg, int ndocc, int nactv,
+                   int nelec, int *elecs)
 {
     int i, j;
-    int dstr = 0, astr = 0, vstr = 0;
+    int astr = 0, vstr = 0;
     int daddr = 0, aaddr = 0, vaddr = 0;
     int addr = 0;
     
@@ -4127,67 +4143,14 @@ int occstr2address(struct occstr *str, struct eospace eosp, int ndocc, int nactv
     }
 #endif
     
-    if ((eosp.docc * eosp.actv * eosp.virt) != 0) {
-        /* Electrons present in all spaces */
-//            dstr = binomial_coef2(ndocc, eosp.docc);
-        astr = binomial_coef3(nactv, eosp.actv);
-        vstr = binomial_coef3(nvirt, eosp.virt);
-        
-        daddr = str_adrfind_fast(&(elecs[0]),eosp.docc,ndocc);
-        aaddr = str_adrfind_fast(&(elecs[eosp.docc]),eosp.actv,nactv);
-        vaddr = str_adrfind_fast(&(elecs[eosp.docc + eosp.actv]),eosp.virt,nvirt);
-        
-        addr = (daddr - 1) * astr * vstr + (aaddr - 1) * vstr + vaddr;
-        
-    } else if (eosp.actv != 0 && eosp.virt != 0) {
-        /* (0, 1, 1) */
-        astr = binomial_coef3(nactv, eosp.actv);
-        vstr = binomial_coef3(nvirt, eosp.virt);
-        
-        aaddr = str_adrfind_fast(&(elecs[eosp.docc]),eosp.actv,nactv);
-        vaddr = str_adrfind_fast(&(elecs[eosp.docc + eosp.actv]),eosp.virt,nvirt);
-        
-        addr = (aaddr - 1) * vstr + vaddr;
-        
-    } else if (eosp.docc != 0 && eosp.virt != 0) {
-        /* (1, 0, 1) */
-//            dstr = binomial_coef2(ndocc, eosp.docc);
-        vstr = binomial_coef3(nvirt, eosp.virt);
-        
-        daddr = str_adrfind_fast(&(elecs[0]),eosp.docc,ndocc);
-        vaddr = str_adrfind_fast(&(elecs[eosp.docc + eosp.actv]),eosp.virt,nvirt);
-        
-        addr = (daddr - 1) * vstr + vaddr;
-        
-    } else if (eosp.docc != 0 && eosp.actv != 0) {
-        /* (1, 1, 0) */
-//            dstr = binomial_coef2(ndocc, eosp.docc);
-        astr = binomial_coef3(nactv, eosp.actv);
-        
-        daddr = str_adrfind_fast(&(elecs[0]),eosp.docc,ndocc);
-        aaddr = str_adrfind_fast(&(elecs[eosp.docc]),eosp.actv,nactv);
-        
-        addr = (daddr - 1) * astr + aaddr;
-        
-    } else if (eosp.docc != 0) {
-        /* (1, 0, 0) */
-        dstr = binomial_coef3(ndocc, eosp.docc);
-        
-        addr = str_adrfind_fast(&(elecs[0]),eosp.docc,ndocc);
-        
-    } else if (eosp.actv != 0) {
-        /* (0, 1, 0) */
-        astr = binomial_coef3(nactv, eosp.actv);
-        
-        addr = str_adrfind_fast(&(elecs[eosp.docc]),eosp.actv,nactv);
-        
-    } else if (eosp.virt != 0) {
-        /* (0, 0, 1) */
-        vstr = binomial_coef3(nvirt, eosp.virt);
-        
-        addr = str_adrfind_fast(&(elecs[eosp.docc + eosp.actv]),eosp.virt,nvirt);
-        
-    }
+    /* Spaces without electrons have a single string, address 1. */
+    daddr = str_adrfind_graph(&(elecs[0]), &(sg[0]));
+    aaddr = str_adrfind_graph(&(elecs[eosp.docc]), &(sg[1]));
+    vaddr = str_adrfind_graph(&(elecs[eosp.docc + eosp.actv]), &(sg[2]));
+    astr = sg[1].nstr;
+    vstr = sg[2].nstr;
+    
+    addr = (daddr - 1) * astr * vstr + (aaddr - 1) * vstr + vaddr;
     
     addr = addr + eosp.start - 1;
     if (addr > (eosp.start + eosp.nstr)) {
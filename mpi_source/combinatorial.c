@@ -105,8 +105,8 @@ int fact_product(int m, int n)
 void initialize_binom_coef()
 {
         int i, j;
-        for (i = 0; i <= MAX_N; i++) {
-                for (j = 0; j <= int_min(i, MAX_K); j++) {
+        for (i = 0; i < MAX_N; i++) {
+                for (j = 0; j <= int_min(i, (MAX_K - 1)); j++) {
                         if (j == 0 || j == i) {
                                 binom_data[i][j] = 1;
                         } else {
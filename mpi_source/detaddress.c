@@ -0,0 +1,211 @@
+// FILE: detaddress.c
+/*********************************************************************
+ * detaddress.c
+ * ------------
+ * Implicit determinant list.
+ *
+ * Every determinant in the expansion is |(pq block, p, q)>, and the
+ * blocks are contiguous in the determinant index. Keeping only the
+ * first determinant of each block, an index is mapped to its strings
+ * by a binary search over the blocks and a division, and a run of
+ * indices by stepping q, then p, then the block. This replaces an
+ * explicit (p, q, cas) list of 12 bytes per determinant. The reverse
+ * map, |p,q> to its index, needs only the (p,q)-space of each string.
+ ********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "binarystr.h"
+#include "citruncate.h"
+#include "detaddress.h"
+
+/*
+ * create_detaddress: build the implicit determinant list for the
+ * (p,q)-space pairings pq.
+ * Input:
+ *  pq     = (p,q)-space pairings
+ *  npq    = number of (p,q)-space pairings
+ *  peosp  = alpha electron orbital spaces
+ *  pegrps = number of alpha electron orbital spaces
+ *  qeosp  = beta  electron orbital spaces
+ *  qegrps = number of beta  electron orbital spaces
+ * Returns:
+ *  da = implicit determinant list, NULL on allocation failure
+ */
+struct detaddress *create_detaddress(int **pq, int npq,
+                                     struct eospace *peosp, int pegrps,
+                                     struct eospace *qeosp, int qegrps)
+{
+    struct detaddress *da = NULL;
+    int i;
+
+    da = calloc(1, sizeof(struct detaddress));
+    if (da == NULL) return NULL;
+    da->npq = npq;
+    da->npe = pegrps;
+    da->nqe = qegrps;
+    da->first   = malloc(sizeof(int) * (npq + 1));
+    da->pstart  = malloc(sizeof(int) * npq);
+    da->qstart  = malloc(sizeof(int) * npq);
+    da->qnstr   = malloc(sizeof(int) * npq);
+    da->cas     = malloc(sizeof(int) * npq);
+    da->pestart = malloc(sizeof(int) * (pegrps + 1));
+    da->qestart = malloc(sizeof(int) * (qegrps + 1));
+    da->pqblk   = malloc(sizeof(int) * pegrps * qegrps);
+    if (da->first == NULL || da->pstart == NULL || da->qstart == NULL ||
+        da->qnstr == NULL || da->cas == NULL || da->pestart == NULL ||
+        da->qestart == NULL || da->pqblk == NULL) {
+        free_detaddress(da);
+        return NULL;
+    }
+
+    for (i = 0; i < pegrps; i++) da->pestart[i] = peosp[i].start;
+    da->pestart[pegrps] = peosp[pegrps - 1].start + peosp[pegrps - 1].nstr;
+    for (i = 0; i < qegrps; i++) da->qestart[i] = qeosp[i].start;
+    da->qestart[qegrps] = qeosp[qegrps - 1].start + qeosp[qegrps - 1].nstr;
+    for (i = 0; i < (pegrps * qegrps); i++) da->pqblk[i] = -1;
+    for (i = 0; i < npq; i++) {
+        da->pqblk[(pq[i][0] * qegrps + pq[i][1])] = i;
+    }
+
+    da->first[0] = 0;
+    for (i = 0; i < npq; i++) {
+        da->pstart[i] = peosp[(pq[i][0])].start;
+        da->qstart[i] = qeosp[(pq[i][1])].start;
+        da->qnstr[i]  = qeosp[(pq[i][1])].nstr;
+        da->cas[i]    = ((peosp[(pq[i][0])].virt +
+                          qeosp[(pq[i][1])].virt) == 0 ? 1 : 0);
+        da->first[i + 1] = da->first[i] +
+            peosp[(pq[i][0])].nstr * qeosp[(pq[i][1])].nstr;
+    }
+    da->ndets = da->first[npq];
+    return da;
+}
+
+/*
+ * free_detaddress: deallocate implicit determinant list.
+ */
+void free_detaddress(struct detaddress *da)
+{
+    if (da == NULL) return;
+    free(da->first);
+    free(da->pstart);
+    free(da->qstart);
+    free(da->qnstr);
+    free(da->cas);
+    free(da->pestart);
+    free(da->qestart);
+    free(da->pqblk);
+    free(da);
+    return;
+}
+
+/*
+ * detaddress_block: return the (p,q)-space pairing of determinant det.
+ */
+int detaddress_block(struct detaddress *da, int det)
+{
+    int lo = 0, hi = da->npq - 1, mid;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (da->first[mid] <= det) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+/*
+ * detaddress_index: return the index of determinant |p,q> in block ipq.
+ */
+int detaddress_index(struct detaddress *da, int ipq, int p, int q)
+{
+    return (da->first[ipq] + (p - da->pstart[ipq]) * da->qnstr[ipq] +
+            (q - da->qstart[ipq]));
+}
+
+/*
+ * detaddress_lookup: return the index of determinant |p,q>, or -1 if
+ * the (p,q)-space pairing of p and q is not in the expansion.
+ */
+int detaddress_lookup(struct detaddress *da, int p, int q)
+{
+    int ip, iq, ipq;
+    ip  = detaddress_space(da->pestart, da->npe, p);
+    iq  = detaddress_space(da->qestart, da->nqe, q);
+    ipq = da->pqblk[(ip * da->nqe + iq)];
+    if (ipq < 0) return -1;
+    return detaddress_index(da, ipq, p, q);
+}
+
+/*
+ * detaddress_space: return the electron orbital space of string str,
+ * given the first string of each space, start[nesp + 1].
+ */
+int detaddress_space(int *start, int nesp, int str)
+{
+    int lo = 0, hi = nesp - 1, mid;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (start[mid] <= str) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+/*
+ * get_det_triple: get (p, q, cas) of determinant det.
+ */
+void get_det_triple(struct detaddress *da, int det, int *trpl)
+{
+    int ipq, off;
+    ipq = detaddress_block(da, det);
+    off = det - da->first[ipq];
+    trpl[0] = da->pstart[ipq] + off / da->qnstr[ipq];
+    trpl[1] = da->qstart[ipq] + off % da->qnstr[ipq];
+    trpl[2] = da->cas[ipq];
+    return;
+}
+
+/*
+ * get_det_triples: get (p, q, cas) of determinants lo, ..., hi.
+ * Input:
+ *  da = implicit determinant list
+ *  lo = first determinant
+ *  hi = last determinant
+ * Output:
+ *  w1d = (p, q, cas) of each determinant, [hi - lo + 1][3]
+ */
+void get_det_triples(struct detaddress *da, int lo, int hi, int *w1d)
+{
+    int ipq, p, q, qmax;
+    int i;
+
+    if (hi < lo) return;
+    get_det_triple(da, lo, w1d);
+    ipq  = detaddress_block(da, lo);
+    p    = w1d[0];
+    q    = w1d[1];
+    qmax = da->qstart[ipq] + da->qnstr[ipq];
+    for (i = lo + 1; i <= hi; i++) {
+        q++;
+        if (i == da->first[ipq + 1]) {
+            while (i == da->first[ipq + 1]) ipq++;
+            p = da->pstart[ipq];
+            q = da->qstart[ipq];
+            qmax = q + da->qnstr[ipq];
+        } else if (q == qmax) {
+            p++;
+            q = da->qstart[ipq];
+        }
+        w1d[3 * (i - lo)]     = p;
+        w1d[3 * (i - lo) + 1] = q;
+        w1d[3 * (i - lo) + 2] = da->cas[ipq];
+    }
+    return;
+}
@@ -14,8 +14,12 @@
 #include "bitutil.h"
 #include "binarystr.h"
 #include "citruncate.h"
+#include "straddress.h"
+#include "detaddress.h"
+#include "moslab.h"
 #include "action_util.h"
 #include "iminmax.h"
+#include "mathutil.h"
 #include "dysoncomp.h"
 
 #include <ga.h>
@@ -28,9 +32,13 @@
 #include <omp.h>
 #else
 #define omp_get_thread_num() 0
+#define omp_get_max_threads() 1
 #endif
 /* -------------------- */
 
+/* Maximum number of N electron partners gathered from V1 at once */
+#define MAXBUFFER 10000
+
 /*
  * build_ppo_triples: build (p0, p1, o) triples for dyson evaluation.
  */
@@ -100,7 +108,9 @@ int comparestrings_dyson(struct occstr str0, struct occstr str1, int ninto)
  * Input:
  *
  */
-void compute_dyson_orbital_a(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
+void compute_dyson_orbital_a(int v0_hndl, int v1_hndl,
+                             struct detaddress *w0det,
+                             struct detaddress *w1det,
                              struct occstr *pstr0, struct eospace *peosp0, int npe0,
                              struct occstr *qstr0, struct eospace *qeosp0, int nqe0,
                              struct occstr *pstr1, struct eospace *peosp1, int npe1,
@@ -111,102 +121,9 @@ void compute_dyson_orbital_a(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
                              int ndets1, int **strcont, int **orbcont, int naelec0,
                              double **dyorb)
 {
-#define MAXBUFFER 10000
-    /* (N+1) and (N) Vector arrays */
-    double **v0 = NULL,  *v01d = NULL; 
-    double **v1 = NULL,  *v11d = NULL; 
-    int v0_lo[2], v0_hi[2], v0_ld[1];
-    int v1_lo[2], v1_hi[2], v1_ld[1];
-    int v0_rows, v0_cols;
-    int v1_rows, v1_cols;
-    /* (N+1) and (N) wavefunction arrays */
-    int **w0 = NULL, *w01d = NULL;
-    int **w1 = NULL, *w11d = NULL;
-    int w0_lo[2], w0_hi[2], w0_ld[1];
-    int w1_lo[2], w1_hi[2], w1_ld[1];
-    /* Local variables */
-    int p0, q0; /* w0 values */
-    int p1, q1; /* w1 values */
-    int *j0indx = NULL;  /* Determinant index of |p0,q0> */
-    int *j1indx = NULL;  /* Determinant index of |p1,q1> */
-    int *o1indx = NULL;  /* Orbital difference of <p0,q0|p1,q1> */
-    int nj1 = 0;
-    int **vindx = NULL, *vindx1d = NULL;
-    int i, j, k;
-    int cnt;
-    
-    /* Get local distribution of V0. Allocate array and read in values. */
-    NGA_Distribution(v0_hndl, mpi_proc_rank, v0_lo, v0_hi);
-    v0_rows = v0_hi[1] - v0_lo[1] + 1;
-    v0_cols = v0_hi[0] - v0_lo[0] + 1;
-    v0_ld[0]= v0_rows;
-    v01d = allocate_mem_double_cont(&v0, v0_rows, v0_cols);
-    NGA_Get(v0_hndl, v0_lo, v0_hi, v01d, v0_ld);
-    /* Get corresponding wavefunction information */
-    w01d = allocate_mem_int_cont(&w0, 3, v0_rows);
-    w0_lo[0] = v0_lo[1];
-    w0_lo[1] = 0;
-    w0_hi[0] = v0_hi[1];
-    w0_hi[1] = 2;
-    w0_ld[0] = 3;
-    NGA_Get(w0_hndl, w0_lo, w0_hi, w01d, w0_ld); 
-
-    /* Allocate J index array and j-index array to grab V1 values from
-     * global array. */
-    nj1 = v0_rows * naelec0;
-    j0indx = malloc(sizeof(int) * nj1);
-    j1indx = malloc(sizeof(int) * nj1);
-    o1indx = malloc(sizeof(int) * nj1);
-    vindx1d = allocate_mem_int_cont(&vindx, 2, (ndyst1 * nj1));
-
-    /* Allocate local buffer of V1 */
-    v11d = allocate_mem_double_cont(&v1, nj1, ndyst1);
-    
-    /* Loop over w0 = (p,q), finding q'/p' in w1 */
-    cnt = 0;
-    for (i = 0; i < v0_rows; i++) {
-        p0 = w0[i][0];
-        q0 = w0[i][1];
-        /* Loop over p' */
-        for (j = 1; j < strcont[p0][0]; j++) {
-            p1 = strcont[p0][j]; /* New string */
-            q1 = q0; 
-            j1indx[cnt] = string_info_to_determinant(p1, q1, peosp1, npe1,
-                                                     qeosp1, nqe1, pq1, npq1);
-	    if (j1indx[cnt] < 0) continue; // No increment of cnt
-	    o1indx[cnt] = orbcont[p0][j] - 1;
-            j0indx[cnt] = i;
-
-            cnt++;
-        }
-    }
-
-    /* Get indexes for all columns of J that we need */
-    set_ga_det_indexes_spec(j1indx, cnt, ndyst1, dysnst1, vindx);
-
-    /* Get V1 elements */
-    NGA_Gather(v1_hndl, v11d, vindx, (cnt * ndyst1));
-
-    /* Loop over contributions */
-    for (i = 0; i < cnt; i++) {
-
-        for (j = 0; j < ndyst0; j++) {
-            for (k = 0; k < ndyst1; k++) {
-                dyorb[j * ndyst1 + k][o1indx[i]] += v0[j][j0indx[i]] *
-                    v1[k][i];
-            }
-        }
-    }
-    
-               
-    /* Deallocate arrays */
-    deallocate_mem_cont(&v0, v01d);
-    deallocate_mem_cont(&v1, v11d);
-    deallocate_mem_cont_int(&w0, w01d);
-    deallocate_mem_cont_int(&vindx, vindx1d);
-    free(j0indx);
-    free(j1indx);
-    free(o1indx);
+    compute_dyson_contractions(v0_hndl, v1_hndl, w0det, w1det, 0, norbs,
+                               ndyst0, dysnst0, ndyst1, dysnst1, strcont,
+                               orbcont, naelec0, dyorb);
     return;
 }
 
@@ -217,7 +134,9 @@ void compute_dyson_orbital_a(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
  * Input:
  *
  */
-void compute_dyson_orbital_b(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
+void compute_dyson_orbital_b(int v0_hndl, int v1_hndl,
+                             struct detaddress *w0det,
+                             struct detaddress *w1det,
                              struct occstr *pstr0, struct eospace *peosp0, int npe0,
                              struct occstr *qstr0, struct eospace *qeosp0, int nqe0,
                              struct occstr *pstr1, struct eospace *peosp1, int npe1,
@@ -228,178 +147,178 @@ void compute_dyson_orbital_b(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
                              int ndets1, int **strcont, int **orbcont, int nbelec0,
                              double **dyorb)
 {
-#define MAXBUFFER 10000
-    /* (N+1) and (N) Vector arrays */
-    double **v0 = NULL,  *v01d = NULL; 
-    double **v1 = NULL,  *v11d = NULL; 
+    compute_dyson_contractions(v0_hndl, v1_hndl, w0det, w1det, 1, norbs,
+                               ndyst0, dysnst0, ndyst1, dysnst1, strcont,
+                               orbcont, nbelec0, dyorb);
+    return;
+}
+
+/*
+ * compute_dyson_contractions: contract the locally owned N+1 electron
+ * determinants with their N electron partners. Each |p0,q0> is mapped
+ * to the |p1,q0> (sp = 0) or |p0,q1> (sp = 1) determinants reached by
+ * one annihilation through strcont/orbcont, so the cost is linear in
+ * the number of determinants. Partners are sorted by the annihilated
+ * orbital o, and V1 is gathered MAXBUFFER partners at a time. Within a
+ * batch, the partners of orbital o give
+ *   dyorb[j * ndyst1 + k][o] += sum_c V0[c][j] V1[c][k]
+ * as one (ndyst0 x ndyst1) GEMM, so additional state pairs cost little.
+ * Threads work on distinct orbitals.
+ * Input:
+ *  v0_hndl = GA handle for N+1 electron CI vectors
+ *  v1_hndl = GA handle for N   electron CI vectors
+ *  w0det   = N+1 electron determinant addressing
+ *  w1det   = N   electron determinant addressing
+ *  sp      = spin of annihilated electron (0 = alpha, 1 = beta)
+ *  norbs   = number of orbitals
+ *  ndyst0  = number of dyson orbital N+1 electron states
+ *  dysnst0 = dyson orbital N+1 electron states
+ *  ndyst1  = number of dyson orbital N electron states
+ *  dysnst1 = dyson orbital N electron states
+ *  strcont = N electron strings of each N+1 electron string
+ *  orbcont = orbital annihilated for each entry of strcont
+ *  nelec0  = number of N+1 electron sp electrons
+ * Output:
+ *  dyorb   = dyson orbitals (contributions are added)
+ */
+void compute_dyson_contractions(int v0_hndl, int v1_hndl,
+                                struct detaddress *w0det,
+                                struct detaddress *w1det, int sp, int norbs,
+                                int ndyst0, int *dysnst0, int ndyst1,
+                                int *dysnst1, int **strcont, int **orbcont,
+                                int nelec0, double **dyorb)
+{
+    /* N+1 electron vectors and determinants */
+    double **v0 = NULL, *v01d = NULL;
+    int **w0 = NULL, *w01d = NULL;
     int v0_lo[2], v0_hi[2], v0_ld[1];
-    int v1_lo[2], v1_hi[2], v1_ld[1];
     int v0_rows, v0_cols;
-    int v1_rows, v1_cols;
-    /* (N+1) and (N) wavefunction arrays */
-    int **w0 = NULL, *w01d = NULL;
-    int **w1 = NULL, *w11d = NULL;
-    int w0_lo[2], w0_hi[2], w0_ld[1];
-    int w1_lo[2], w1_hi[2], w1_ld[1];
-    /* Local variables */
-    int p0, q0; /* w0 values */
-    int p1, q1; /* w1 values */
-    int *j0indx = NULL;  /* Determinant index of |p0,q0> */
-    int *j1indx = NULL;  /* Determinant index of |p1,q1> */
-    int *o1indx = NULL;  /* Orbital difference of <p0,q0|p1,q1> */
-    int nj1 = 0;
+    /* Batch of V0 rows, [ndyst0][nb], and gathered V1, [ndyst1][nb] */
+    double *v0buf = NULL, *v1buf = NULL;
     int **vindx = NULL, *vindx1d = NULL;
-    int i, j, k;
-    int cnt;
-    
-    /* Get local distribution of V0. Allocate array and read in values. */
+    /* Partner slots, then partners sorted by orbital */
+    int *j1slot = NULL;  /* Determinant index of |p1,q1> */
+    int *o1slot = NULL;  /* Orbital annihilated from |p0,q0> */
+    int *j0indx = NULL;  /* Local row of |p0,q0> */
+    int *j1indx = NULL;  /* Determinant index of |p1,q1> */
+    int *ostart = NULL;  /* First partner of each orbital, [norbs + 1] */
+    int nslot = 0, cnt = 0;
+    /* Per-thread (ndyst0 x ndyst1) block */
+    double *cblk = NULL;
+    int nthrd = 1;
+    int s0, p1, q1, nb, c0, c1;
+    int i, j, k, m, b, o;
+
+    /* Get local distribution of V0. GA returns lo < 0 if this process
+     * holds no patch. */
     NGA_Distribution(v0_hndl, mpi_proc_rank, v0_lo, v0_hi);
+    if (v0_lo[0] < 0 || v0_lo[1] < 0) return;
     v0_rows = v0_hi[1] - v0_lo[1] + 1;
     v0_cols = v0_hi[0] - v0_lo[0] + 1;
     v0_ld[0]= v0_rows;
     v01d = allocate_mem_double_cont(&v0, v0_rows, v0_cols);
     NGA_Get(v0_hndl, v0_lo, v0_hi, v01d, v0_ld);
-    /* Get corresponding wavefunction information */
     w01d = allocate_mem_int_cont(&w0, 3, v0_rows);
-    w0_lo[0] = v0_lo[1];
-    w0_lo[1] = 0;
-    w0_hi[0] = v0_hi[1];
-    w0_hi[1] = 2;
-    w0_ld[0] = 3;
-    NGA_Get(w0_hndl, w0_lo, w0_hi, w01d, w0_ld); 
+    get_det_triples(w0det, v0_lo[1], v0_hi[1], w01d);
 
-    /* Allocate J index array and j-index array to grab V1 values from
-     * global array. */
-    nj1 = v0_rows * nbelec0;
-    j0indx = malloc(sizeof(int) * nj1);
-    j1indx = malloc(sizeof(int) * nj1);
-    o1indx = malloc(sizeof(int) * nj1);
-    vindx1d = allocate_mem_int_cont(&vindx, 2, (ndyst1 * nj1));
+    /* Each N+1 electron string has at most nelec0 N electron partners.
+     * Slot i * nelec0 + m holds the m'th partner of row i. */
+    nslot  = v0_rows * nelec0;
+    j1slot = malloc(sizeof(int) * nslot);
+    o1slot = malloc(sizeof(int) * nslot);
 
-    /* Allocate local buffer of V1 */
-    v11d = allocate_mem_double_cont(&v1, nj1, ndyst1);
-    
-    /* Loop over w0 = (p,q), finding q'/p' in w1 */
-    cnt = 0;
+#pragma omp parallel for schedule(static) default(shared) \
+    private(i, j, m, s0, p1, q1)
     for (i = 0; i < v0_rows; i++) {
-        p0 = w0[i][0];
-        q0 = w0[i][1];
-        /* Loop over q' */
-        for (j = 1; j < strcont[q0][0]; j++) {
-            p1 = p0;
-            q1 = strcont[q0][j]; /* New string */
-            j1indx[cnt] = string_info_to_determinant(p1, q1, peosp1, npe1,
-                                                     qeosp1, nqe1, pq1, npq1);
-	    if (j1indx[cnt] < 0) continue; // No increment of cnt
-            o1indx[cnt] = orbcont[q0][j] - 1;
-            j0indx[cnt] = i;
-
-            cnt++;
+        s0 = w0[i][sp];
+        for (m = 0; m < nelec0; m++) {
+            j1slot[i * nelec0 + m] = -1;
+        }
+        for (j = 1; j < strcont[s0][0]; j++) {
+            if (sp == 0) {
+                p1 = strcont[s0][j];
+                q1 = w0[i][1];
+            } else {
+                p1 = w0[i][0];
+                q1 = strcont[s0][j];
+            }
+            m = i * nelec0 + j - 1;
+            j1slot[m] = detaddress_lookup(w1det, p1, q1);
+            o1slot[m] = orbcont[s0][j] - 1;
         }
     }
 
-    /* Get indexes for all columns of J that we need */
-    set_ga_det_indexes_spec(j1indx, cnt, ndyst1, dysnst1, vindx);
+    /* Sort the partners by orbital */
+    ostart = calloc((norbs + 1), sizeof(int));
+    for (i = 0; i < nslot; i++) {
+        if (j1slot[i] < 0) continue;
+        ostart[(o1slot[i] + 1)]++;
+    }
+    for (o = 0; o < norbs; o++) {
+        ostart[(o + 1)] += ostart[o];
+    }
+    cnt = ostart[norbs];
+    j0indx = malloc(sizeof(int) * (cnt + 1));
+    j1indx = malloc(sizeof(int) * (cnt + 1));
+    for (i = 0; i < nslot; i++) {
+        if (j1slot[i] < 0) continue;
+        m = ostart[(o1slot[i])]++;
+        j0indx[m] = i / nelec0;
+        j1indx[m] = j1slot[i];
+    }
+    for (o = norbs; o > 0; o--) {
+        ostart[o] = ostart[(o - 1)];
+    }
+    ostart[0] = 0;
+    free(j1slot);
+    free(o1slot);
+
+    nthrd = omp_get_max_threads();
+    cblk  = malloc(sizeof(double) * nthrd * ndyst0 * ndyst1);
+    v0buf = malloc(sizeof(double) * MAXBUFFER * ndyst0);
+    v1buf = malloc(sizeof(double) * MAXBUFFER * ndyst1);
+    vindx1d = allocate_mem_int_cont(&vindx, 2, (MAXBUFFER * ndyst1));
 
-    /* Get V1 elements */
-    NGA_Gather(v1_hndl, v11d, vindx, (cnt * ndyst1));
+    for (b = 0; b < cnt; b += MAXBUFFER) {
+        nb = int_min(MAXBUFFER, (cnt - b));
 
-    /* Loop over contributions */
-    for (i = 0; i < cnt; i++) {
+        /* Gather V1[dysnst1[k]][j1indx[b + i]] into v1buf[k * nb + i] */
+        set_ga_det_indexes_spec(&(j1indx[b]), nb, ndyst1, dysnst1, vindx);
+        NGA_Gather(v1_hndl, v1buf, vindx, (nb * ndyst1));
 
         for (j = 0; j < ndyst0; j++) {
-            for (k = 0; k < ndyst1; k++) {
-                dyorb[j * ndyst1 + k][o1indx[i]] += v0[j][j0indx[i]] *
-                    v11d[k * cnt + i];
+            for (i = 0; i < nb; i++) {
+                v0buf[(j * nb + i)] = v0[(dysnst0[j])][(j0indx[(b + i)])];
+            }
+        }
+
+#pragma omp parallel for schedule(dynamic) default(shared) \
+    private(o, c0, c1, j, k, m)
+        for (o = 0; o < norbs; o++) {
+            c0 = int_max(ostart[o], b);
+            c1 = int_min(ostart[(o + 1)], (b + nb));
+            if (c1 <= c0) continue;
+            m = omp_get_thread_num() * ndyst0 * ndyst1;
+            matmul_dgemm_tn(&(v0buf[(c0 - b)]), nb, &(v1buf[(c0 - b)]), nb,
+                            ndyst0, ndyst1, (c1 - c0), 0.0, &(cblk[m]),
+                            ndyst0);
+            for (j = 0; j < ndyst0; j++) {
+                for (k = 0; k < ndyst1; k++) {
+                    dyorb[(j * ndyst1 + k)][o] += cblk[(m + k * ndyst0 + j)];
+                }
             }
         }
     }
-    
-               
-    /* Deallocate arrays */
+
     deallocate_mem_cont(&v0, v01d);
-    deallocate_mem_cont(&v1, v11d);
     deallocate_mem_cont_int(&w0, w01d);
     deallocate_mem_cont_int(&vindx, vindx1d);
+    free(v0buf);
+    free(v1buf);
+    free(cblk);
+    free(ostart);
     free(j0indx);
     free(j1indx);
-    free(o1indx);
-    return;
-}
-
-/*
- * compute_det_contributions: compute determinant contributions to dyson
- * orbitals.
- * Input:
- *  w0      = p, q, CAS
- *  v0      = CI vectors
- *  v0_rows = rows of CI vectors
- *  v0_cols = columns of CI vectors
- *  w1      = p, q, CAS
- *  v1      = CI vectors
- *  v1_rows = rows of CI vectors
- *  v1_cols = columns of CI vectors
- *  sp      = spin index (0 = alpha, 1 = beta)
- *  spx     = opposite spin index (1 = beta, 0 = alpha)
- *  str0    = p/q strings
- *  str1    = p/q strings
- *  dyst0   = dyson orbital N+1 electron states
- *  ndyst0  = number of dyson orbital N+1 electron states
- *  dyst1   = dyson orbital N electron states
- *  ndyst1  = number of dyson orbital N electron states
- *  ninto   = number of internal orbitals
- * Output:
- *  dyorb   = dyson orbitals
- */
-void compute_det_contributions(int **w0, double **v0, int v0_rows, int v0_cols,
-                               int **w1, double **v1, int v1_rows, int v1_cols,
-                               int sp, int spx,
-                               struct occstr *str0, struct occstr *str1,
-                               int *dyst0, int ndyst0, int *dyst1, int ndyst1,
-                               double **dyorb, int ninto)
-{
-    int i = 0, j = 0;
-    int k = 0, l = 0;
-    int dyind = 0;      /* dyson orbital index */
-    int ndiff = 0;      /* number of differences */
-    int orbindx = 0;    /* orbital index of contribution */
-    
-    /* Loop over determinants. N electrons must be in the same slots for
-     * both determinants. The N+1 electron, in a unique slot, is the MO
-     * index to which the matrix element contributes to the dyson orbital. */
-    
-#pragma omp parallel					      \
-    default(none)					      \
-    shared(w0,v0,v0_rows,v0_cols,			      \
-	   w1,v1,v1_rows,v1_cols,			      \
-	   sp, spx, str0, str1, dyst0, ndyst0, dyst1, ndyst1, \
-	   dyorb,ninto)					      \
-    private(i, j, orbindx, ndiff, dyind, k, l)
-    {
-#pragma omp for schedule(runtime)
-	for (i = 0; i < v0_rows; i++) {
-	    for (j = 0; j < v1_rows; j++) {
-		/* If the other spin strings are different, skip. */
-		if (w0[i][spx] != w1[j][spx]) continue;
-		orbindx = comparestrings_dyson(str0[w0[i][sp]],
-					       str1[w1[j][sp]], ninto);
-		if (orbindx == 0) continue;
-		
-		/* Compute contributions to orbital (orbindx) for all
-		 * CI vectors involved in dyson orbitals */
-		dyind = 0;
-		for (k = 0; k < ndyst0; k++) {
-		    for (l = 0; l < ndyst1; l++) {
-			dyorb[dyind][(orbindx - 1)] =
-			    dyorb[dyind][(orbindx - 1)] +
-			    v0[dyst0[k]][i]*
-			    v1[dyst1[l]][j];
-			dyind++;
-		    }
-		}
-	    }
-        }
-    }
     return;
 }
 
@@ -432,9 +351,18 @@ void generate_strcontlist(struct occstr *str, int nstr, struct eospace *eosp0,
     int nelec0 = 0;          /* N + 1 electrons */
     int cnt = 0;             
     int i, j;
+    struct strgraph *sgraph = NULL; /* DOCC/ACTV/VIRT graphs of eosp1 */
     
     nelec0 = nelec1 + 1;
 
+    /* Build the N-electron addressing graphs once. */
+    sgraph = malloc(sizeof(struct strgraph) * 3 * ne1);
+    for (i = 0; i < ne1; i++) {
+        init_strgraph(eosp1[i].docc, ndocc, &(sgraph[3 * i]));
+        init_strgraph(eosp1[i].actv, nactv, &(sgraph[3 * i + 1]));
+        init_strgraph(eosp1[i].virt, nvirt, &(sgraph[3 * i + 2]));
+    }
+
     /* Loop over strings */
     for (i = 0; i < nstr; i++) {
 	cnt = 1; // Counter for new strings
@@ -453,8 +381,9 @@ void generate_strcontlist(struct occstr *str, int nstr, struct eospace *eosp0,
 #endif
 	    neospx = get_string_eospace(&newstr, ndocc, nactv, eosp1, ne1);
             if (neospx < 0) continue;
-	    strcont[i][cnt] = occstr2address(&newstr, eosp1[neospx], ndocc,
-					     nactv, nvirt, nelec1, elecx);
+	    strcont[i][cnt] = occstr2address(&newstr, eosp1[neospx],
+					     &(sgraph[3 * neospx]), ndocc,
+					     nactv, nelec1, elecx);
             orbcont[i][cnt] = str[i].istr[j];
 	    cnt++;
 	}
@@ -477,8 +406,9 @@ void generate_strcontlist(struct occstr *str, int nstr, struct eospace *eosp0,
 #endif
 	    neospx = get_string_eospace(&newstr, ndocc, nactv, eosp1, ne1);
             if (neospx < 0) continue;
-            strcont[i][cnt] = occstr2address(&newstr, eosp1[neospx], ndocc,
-					     nactv, nvirt, nelec1, elecx);
+            strcont[i][cnt] = occstr2address(&newstr, eosp1[neospx],
+					     &(sgraph[3 * neospx]), ndocc,
+					     nactv, nelec1, elecx);
             orbcont[i][cnt] = str[i].virtx[j];
             cnt++;
             
@@ -487,6 +417,10 @@ void generate_strcontlist(struct occstr *str, int nstr, struct eospace *eosp0,
         orbcont[i][0] = cnt;
         //printf("Count: %d\n", cnt);
     }
+    for (i = 0; i < 3 * ne1; i++) {
+        free_strgraph(&(sgraph[i]));
+    }
+    free(sgraph);
     return;
 }
 
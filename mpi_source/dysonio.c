@@ -31,6 +31,25 @@ void print_dysonorbital_info(int num_dyo, int ndyst0, int ndyst1, int norbs,
 }
 
 
+/*
+ * read_dysonorbital_number: read the number of dyson orbitals and
+ * states from the first line of a dyson orbital file.
+ */
+int read_dysonorbital_number(char *filename, int *num_dyo, int *ndyst0,
+                             int *ndyst1)
+{
+    FILE* fptr = NULL; /* dyson orbital file */
+
+    fptr = fopen(filename, "r");
+    if (fptr == NULL) {
+	printf("Could not open file: %s\n", filename);
+	return -1;
+    }
+    fscanf(fptr, " %d %d %d\n", num_dyo, ndyst0, ndyst1);
+    fclose(fptr);
+    return 0;
+}
+
 /*
  * read_dysonorbital_info: read dyson orbital information
  */
@@ -92,5 +111,6 @@ int read_dysonorbitals_from_file(char *filename, int num_dyo, int norbs,
 	}
 	fscanf(fptr, "\n");
     }
+    fclose(fptr);
     return error;
 }
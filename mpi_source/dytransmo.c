@@ -4,11 +4,27 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include "mpi_utilities.h"
 #include "run_dytransmo.h"
+#include <mpi.h>
+#include <ga.h>
 
-int main ( )
+const int mpi_root = 0; /* MPI: Root rank is always 0 */
+
+int main (int argc, char **argv)
 {
     int error = 0;
+
+    MPI_Init(&argc, &argv);
+    GA_Initialize();
+
+    set_ga_process_number_and_rank();
+
     error = run_dytransmo();
+    mpi_error_check_msg(error, "run_dytransmo", "Error occured!");
+
+    GA_Terminate();
+    MPI_Finalize();
+
     return error;
 }
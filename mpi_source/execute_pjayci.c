@@ -12,6 +12,7 @@
 #include "ioutil.h"
 #include "combinatorial.h"
 #include "moindex.h"
+#include "moslab.h"
 #include "abecalc.h"
 #include "mpi_utilities.h"
 #include "binarystr.h"
@@ -19,6 +20,8 @@
 #include "iminmax.h"
 #include "action_util.h"
 #include "pdavidson.h"
+#include "memsize.h"
+#include "topology.h"
 #include "execute_pjayci.h"
 #include <mpi.h>
 #include <ga.h>
@@ -50,6 +53,7 @@ int execute_pjayci ()
 
         struct occstr  *pstrings;    /* Alpha electron strings */
         struct occstr  *qstrings;    /* Beta  electron strings */
+        MPI_Win pstr_win, qstr_win;  /* Shared memory windows of strings */
         struct eospace *peospace;    /* Alpha electron string spaces */
         struct eospace *qeospace;    /* Beta  electron string spaces */
         int **pq_space_pairs = NULL; /* Valid (p,q) space pairs. */
@@ -65,6 +69,8 @@ int execute_pjayci ()
         int m2len = 0;                  /* Number of 2-e integrals */
         double *moints1 = NULL;         /* 1-e integrals */
         double *moints2 = NULL;         /* 2-e integrals */
+        MPI_Win m1_win, m2_win;         /* Shared memory windows of moints */
+        struct moslab mslab;            /* Per-pair integral slabs */
         double frzcore_e = 0.0;         /* Frozen core energy */
         double nucrep_e  = 0.0;         /* Nuclear repulsion energy */
         char moflname[FLNMSIZE] = {""}; /* SIFS integral filename */
@@ -77,8 +83,18 @@ int execute_pjayci ()
 	int prediag_routine = 0; /* prediagonalization routine */
 	int refdim = 0; /* prediagonalization reference space */
 	double restol = 0.0; /* residual norm converegence tolerance */
+	double sigscreen = 0.0; /* sigma screening factor (0 = off) */
+	int spinsym = 0; /* Ms=0 spin-flip symmetry (1, -1; 0 = off) */
+	int precond = 0; /* correction vector preconditioner */
+	double pcshift = 0.0; /* preconditioner level shift */
         int ga_buffer_len = 0; /* Length of GA buffers. */
-	double memusage = 0.0; /* Estimated memory usage */
+        int memnode = 0; /* Memory per node (MB), 0 = physical memory */
+        int numarank = 0; /* Processes per NUMA domain, 0 = no binding */
+        int nthread = 0;  /* Threads per process, 0 = default */
+        int nodeshare = 0; /* 1 = strings and integrals shared per node */
+        int sigaccum = 0;  /* Sigma C(j,k) accumulation, SIGACC_* */
+        struct memsize msize;  /* Memory estimate */
+        struct topology tplace; /* Process placement */
 
         /* Read in the &general namelist. Ensure that the expansion's
          * CAS space is not greater than 64 orbitals. */
@@ -120,12 +136,31 @@ int execute_pjayci ()
         if (mpi_proc_rank == mpi_root) {
                 readdaiinput(&maxiter, &krymin, &krymax, &nroots,
                              &prediag_routine, &refdim, &restol, &ga_buffer_len,
-                             &error);
+                             &sigscreen, &spinsym, &precond, &pcshift,
+                             &memnode, &numarank, &nthread, &nodeshare,
+                             &sigaccum, &error);
                 if (error != 0) {
                         error_flag(0, error, "execute_ci_calculation");
                 }
 	}
         mpi_error_check_msg(error, "execute_pjayci", "Error!");
+        if (mpi_proc_rank == mpi_root) {
+                if (spinsym != 0 && spinsym != 1 && spinsym != -1) {
+                        error = spinsym;
+                        error_flag(mpi_proc_rank, error, "execute_pjayci");
+                        error_message(mpi_proc_rank,
+                                      "spinsym must be 1, -1 or 0.\n",
+                                      "execute_pjayci");
+                }
+                if (sigaccum != SIGACC_BINS && sigaccum != SIGACC_COPIES) {
+                        error = sigaccum;
+                        error_flag(mpi_proc_rank, error, "execute_pjayci");
+                        error_message(mpi_proc_rank,
+                                      "sigaccum must be 0 or 1.\n",
+                                      "execute_pjayci");
+                }
+        }
+        mpi_error_check_msg(error, "execute_pjayci", "Error!");
         
         /* Broadcast values */
         MPI_Bcast(&maxiter, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
@@ -134,7 +169,23 @@ int execute_pjayci ()
         MPI_Bcast(&nroots,  1, MPI_INT, mpi_root, MPI_COMM_WORLD);
         MPI_Bcast(&prediag_routine, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
         MPI_Bcast(&restol,  1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&refdim,  1, MPI_INT, mpi_root, MPI_COMM_WORLD);
         MPI_Bcast(&ga_buffer_len, 1,MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&sigscreen, 1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&spinsym, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&precond, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&pcshift, 1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&memnode, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&numarank, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&nthread, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&nodeshare, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&sigaccum, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+
+        /* Bind processes and threads before anything large is allocated,
+         * so that pages are placed in the NUMA domain that touches them
+         * first. */
+        topology_place(numarank, nthread, &tplace);
+        topology_print(&tplace, numarank);
 
         /* Get number of alpha/beta electrons */
         abecalc(electrons, &aelec, &belec);
@@ -154,20 +205,85 @@ int execute_pjayci ()
             }
             return;
         }
+        if (spinsym != 0 && ci_aelec != ci_belec) {
+            if (mpi_proc_rank == mpi_root) {
+                printf(" spinsym requires Ms = 0. Ignoring.\n");
+            }
+            spinsym = 0;
+        }
         pstr_len = compute_stringnum(ci_orbs, ci_aelec, ndocc, nactv, xlvl);
         qstr_len = compute_stringnum(ci_orbs, ci_belec, ndocc, nactv, xlvl);
-        pstrings = allocate_occstr_arrays(pstr_len);
-        qstrings = allocate_occstr_arrays(qstr_len);
         peospace = allocate_eospace_array(ci_aelec, ci_orbs, ndocc, nactv, xlvl,
 					  &pegrps);
         qeospace = allocate_eospace_array(ci_belec, ci_orbs, ndocc, nactv, xlvl,
 					  &qegrps);
         num_pq = pegrps * qegrps;
         pqdata = allocate_mem_int_cont(&pq_space_pairs, 2, num_pq);
-        error = citrunc(aelec, belec, orbitals, nfrzc, ndocc, nactv, nfrzv,
-                        xlvl, pstrings, pstr_len, qstrings, qstr_len,
-                        peospace, pegrps, qeospace, qegrps, &dtrm_len,
-                        pq_space_pairs, &num_pq);
+
+        /* Size the calculation from the string counts and (p,q) pairs
+         * before the strings are generated, and stop if it cannot fit
+         * in the memory of a node. */
+        memsize_count_strings(peospace, pegrps, ci_orbs, ci_aelec, ndocc,
+                              nactv);
+        memsize_count_strings(qeospace, qegrps, ci_orbs, ci_belec, ndocc,
+                              nactv);
+        compute_detnum(peospace, pegrps, qeospace, qegrps, ndocc, nactv, xlvl,
+                       pq_space_pairs, &num_pq, ci_aelec, ci_belec);
+        memsize_init(&msize, peospace, pegrps, qeospace, qegrps,
+                     pq_space_pairs, num_pq, ci_aelec, ci_belec, ci_orbs,
+                     orbitals);
+        memsize_estimate(&msize, mpi_num_procs, tplace.nthrd,
+                         krymin, krymax, refdim, prediag_routine, precond,
+                         nodeshare, sigaccum);
+        error = memsize_check(&msize, memnode, ga_buffer_len);
+        mpi_error_check_msg(error, "execute_pjayci",
+                            "Insufficient memory for this calculation.");
+
+        if (nodeshare) {
+                /* The strings are read-only after citrunc() and are
+                 * shared by the processes of a node. The first process of
+                 * each node generates them and the expansion is cast to
+                 * the rest. */
+                pstrings = mpi_node_shared_alloc(
+                        ((long long int) sizeof(struct occstr) * pstr_len),
+                        &pstr_win);
+                qstrings = mpi_node_shared_alloc(
+                        ((long long int) sizeof(struct occstr) * qstr_len),
+                        &qstr_win);
+                if (pstrings == NULL || qstrings == NULL) error = 1;
+                mpi_error_check_msg(error, "execute_pjayci",
+                                    "Could not allocate string arrays.");
+                if (mpi_node_rank == 0) {
+                        init_occstr_array(pstrings, pstr_len);
+                        init_occstr_array(qstrings, qstr_len);
+                        error = citrunc(aelec, belec, orbitals, nfrzc, ndocc,
+                                        nactv, nfrzv, xlvl, pstrings,
+                                        pstr_len, qstrings, qstr_len,
+                                        peospace, pegrps, qeospace, qegrps,
+                                        &dtrm_len, pq_space_pairs, &num_pq);
+                }
+                mpi_error_check_msg(error, "execute_pjayci",
+                                    "Error generating strings.");
+                MPI_Bcast(peospace, (sizeof(struct eospace) * pegrps),
+                          MPI_BYTE, 0, mpi_node_comm);
+                MPI_Bcast(qeospace, (sizeof(struct eospace) * qegrps),
+                          MPI_BYTE, 0, mpi_node_comm);
+                MPI_Bcast(pqdata, (2 * pegrps * qegrps), MPI_INT, 0,
+                          mpi_node_comm);
+                MPI_Bcast(&num_pq,   1, MPI_INT, 0, mpi_node_comm);
+                MPI_Bcast(&dtrm_len, 1, MPI_INT, 0, mpi_node_comm);
+                mpi_node_shared_sync(pstr_win);
+                mpi_node_shared_sync(qstr_win);
+        } else {
+                pstrings = allocate_occstr_arrays(pstr_len);
+                qstrings = allocate_occstr_arrays(qstr_len);
+                error = citrunc(aelec, belec, orbitals, nfrzc, ndocc, nactv,
+                                nfrzv, xlvl, pstrings, pstr_len, qstrings,
+                                qstr_len, peospace, pegrps, qeospace, qegrps,
+                                &dtrm_len, pq_space_pairs, &num_pq);
+                mpi_error_check_msg(error, "execute_pjayci",
+                                    "Error generating strings.");
+        }
         intorb = ndocc + nactv;
 
 	GA_Sync();
@@ -175,58 +291,93 @@ int execute_pjayci ()
                 printf("Determinants   = %15d\n", dtrm_len);
                 printf(" Alpha strings = %15d\n", pstr_len);
                 printf(" Beta  strings = %15d\n", qstr_len);
-		memusage = ((pstr_len + qstr_len) *
-                            (8 + 4 + 4 + 4 + (20 * 4) + 8000) + 
-                            (pegrps * qegrps) * 2 * 4 +
-                            (pegrps + qegrps) *
-                            (4 + 4 + 4 + 4 + 4 + 4 + (20 * 4)))
-			/ 1048576;
 	}
         
         /* Read the molecular orbitals */
         m1len = index1e(orbitals, orbitals);
         m2len = index2e(orbitals, orbitals, orbitals, orbitals);
         strncpy(moflname, "moints", FLNMSIZE);
-        moints1 = malloc(sizeof(double) * m1len);
-        moints2 = malloc(sizeof(double) * m2len);
-	memusage = memusage + ((m1len + m2len) * 8) / 1048576;
-        init_dbl_array_0(moints1, m1len);
-        init_dbl_array_0(moints2, m2len);
+        if (nodeshare) {
+                moints1 = mpi_node_shared_alloc(
+                        ((long long int) sizeof(double) * m1len), &m1_win);
+                moints2 = mpi_node_shared_alloc(
+                        ((long long int) sizeof(double) * m2len), &m2_win);
+        } else {
+                moints1 = malloc(sizeof(double) * m1len);
+                moints2 = malloc(sizeof(double) * m2len);
+        }
+        if (moints1 == NULL || moints2 == NULL) error = 1;
+        mpi_error_check_msg(error, "execute_pjayci",
+                            "Could not allocate integral arrays.");
+        if (!nodeshare || mpi_node_rank == 0) {
+                init_dbl_array_0(moints1, m1len);
+                init_dbl_array_0(moints2, m2len);
+        }
         if (mpi_proc_rank == mpi_root) {
                 readmointegrals(moints1, moints2, itype, ci_orbs, moflname,
                                 m1len, m2len, &nucrep_e, &frzcore_e);
         }
 	if (mpi_proc_rank == mpi_root) printf("Casting moints...\n");
 	GA_Sync();
-        MPI_Bcast(moints1, m1len, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
-        MPI_Bcast(moints2, m2len, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+        if (nodeshare) {
+                /* One copy of the integrals per node: cast between the
+                 * first processes of the nodes. mpi_root is first on its
+                 * node. */
+                if (mpi_lead_comm != MPI_COMM_NULL) {
+                        MPI_Bcast(moints1, m1len, MPI_DOUBLE, 0,
+                                  mpi_lead_comm);
+                        MPI_Bcast(moints2, m2len, MPI_DOUBLE, 0,
+                                  mpi_lead_comm);
+                }
+                mpi_node_shared_sync(m1_win);
+                mpi_node_shared_sync(m2_win);
+        } else {
+                MPI_Bcast(moints1, m1len, MPI_DOUBLE, mpi_root,
+                          MPI_COMM_WORLD);
+                MPI_Bcast(moints2, m2len, MPI_DOUBLE, mpi_root,
+                          MPI_COMM_WORLD);
+        }
         MPI_Bcast(&nucrep_e, 1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
         MPI_Bcast(&frzcore_e,1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
         nuc_rep_e = nucrep_e;
         total_core_e = nucrep_e + frzcore_e;
-	if (printlvl > 0 && mpi_proc_rank == mpi_root) {
-		printf("\nLocal memory usage: ");
-		printf(" %10.2lf MB\n", memusage);
-		printf("Global memory usage: ");
-		printf(" %10.2lf MB\n\n", (memusage * mpi_num_procs));
-		fflush(stdout);
-	}
+
+        /* Build per-pair integral slabs for the sigma kernels. These are
+         * built locally from the broadcast integrals on every process. */
+        error = build_moslab(moints2, ci_orbs, &mslab);
+        if (error != 0) {
+                error_message(mpi_proc_rank,
+                              "Could not allocate integral slabs.\n",
+                              "execute_pjayci");
+        }
+        mpi_error_check_msg(error, "execute_pjayci", "Error!");
 	GA_Sync();
 
         /* Execute davidson procedure. */
         error = pdavidson(pstrings, peospace, pegrps, qstrings, qeospace,
                           qegrps, pq_space_pairs, num_pq, moints1, moints2,
+                          &mslab,
                           ci_aelec, ci_belec, intorb, dtrm_len, nucrep_e,
 	                  frzcore_e, printlvl, maxiter, krymin, krymax,
                           nroots, prediag_routine, refdim, restol,
-                          ga_buffer_len, ci_orbs, ndocc, nactv);
+                          sigscreen, spinsym, ga_buffer_len, ci_orbs, ndocc,
+                          nactv, precond, pcshift, sigaccum);
         
         GA_Sync();
-        free(moints1);
-        free(moints2);
-        /* Deallocate pstrings and qstrings */
-        free(pstrings);
-        free(qstrings);
+        free_moslab(&mslab);
+        if (nodeshare) {
+                mpi_node_shared_free(&m1_win);
+                mpi_node_shared_free(&m2_win);
+                /* Deallocate pstrings and qstrings */
+                mpi_node_shared_free(&pstr_win);
+                mpi_node_shared_free(&qstr_win);
+        } else {
+                free(moints1);
+                free(moints2);
+                /* Deallocate pstrings and qstrings */
+                free(pstrings);
+                free(qstrings);
+        }
         /* Deallocate peospace and qeospace */
         free(peospace);
         free(qeospace);
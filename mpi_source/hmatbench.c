@@ -0,0 +1,842 @@
+// File: hmatbench.c
+/*
+ * Microbenchmarks of the matrix element and excitation primitives.
+ *
+ * Cases are sampled from a CI expansion built from the command line with
+ * synthetic integrals (see benchutil.c). Each primitive is timed over all
+ * cases, repeated for at least HMATBENCH_MINTIME seconds, and reported in
+ * ns/call and time stamp counter cycles/call. The specialized routines
+ * (hmatels_0x/1x/2xaa/2xab, the slab routines, pindex_single_rep_cas)
+ * are checked against the general routines as the reference, and all
+ * matrix elements are also checked against a direct evaluation of the
+ * Slater-Condon rules. A case fails if it disagrees with the rules,
+ * including a case where hmatels() itself does.
+ *
+ * Usage: hmatbench electrons ndocc nactv orbitals xlvl
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "mpi_utilities.h"
+#include "moslab.h"
+#include "binarystr.h"
+#include "citruncate.h"
+#include "action_util.h"
+#include "moindex.h"
+#include "detaddress.h"
+#include "perftimer.h"
+#include "benchutil.h"
+#include "hmatbench.h"
+#include <mpi.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+const int mpi_root = 0; /* MPI: Root rank is always 0 */
+
+static volatile double hmatbench_sink = 0.0; /* Keeps results live */
+
+/*
+ * Main driver.
+ */
+int main (int argc, char **argv)
+{
+    int error = 0;
+    int nfail = 0;
+    struct benchci ci;
+    struct hmatbench_set s0, sa1, sb1, sa2, sab;
+    struct hmatbench_xcase *xa = NULL;
+    int nxa = 0;
+    int electrons = 0, ndocc = 0, nactv = 0, orbitals = 0, xlvl = 0;
+
+    MPI_Init(&argc, &argv);
+    set_mpi_process_number_and_rank();
+
+    /* The primitives are serial. Only the root process runs. */
+    if (mpi_proc_rank != mpi_root) {
+        MPI_Finalize();
+        return 0;
+    }
+    if (argc < 6) {
+        printf("Usage: %s electrons ndocc nactv orbitals xlvl\n", argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+    electrons = atoi(argv[1]);
+    ndocc     = atoi(argv[2]);
+    nactv     = atoi(argv[3]);
+    orbitals  = atoi(argv[4]);
+    xlvl      = atoi(argv[5]);
+
+    printf("Matrix element benchmark: %d electrons, %d orbitals,", electrons,
+           orbitals);
+    printf(" CAS(%d docc, %d actv), xlvl = %d\n", ndocc, nactv, xlvl);
+    error = benchci_setup(&ci, electrons, ndocc, nactv, orbitals, xlvl);
+    if (error != 0) {
+        MPI_Finalize();
+        return 1;
+    }
+    xa = malloc(sizeof(struct hmatbench_xcase) * HMATBENCH_NCASE);
+    hmatbench_build_cases(&ci, &s0, &sa1, &sb1, &sa2, &sab, xa, &nxa);
+    printf(" Cases: 0x %d, alpha 1x %d, beta 1x %d, alpha 2x %d,",
+           s0.n, sa1.n, sb1.n, sa2.n);
+    printf(" alpha-beta %d\n", sab.n);
+    if (hmatbench_cycles() == 0) {
+        printf(" Time stamp counter not available: cycles not reported.\n");
+    }
+
+    printf("\n %-30s %10s %12s %12s %12s\n", "Primitive", "ns/call",
+           "cycles/call", "vs ref", "vs rules");
+    nfail += hmatbench_hmatels(&ci, &s0,  0);
+    nfail += hmatbench_hmatels(&ci, &sa1, 1);
+    nfail += hmatbench_hmatels(&ci, &sb1, 2);
+    nfail += hmatbench_hmatels(&ci, &sa2, 3);
+    nfail += hmatbench_hmatels(&ci, &sab, 4);
+    nfail += hmatbench_comparedets(&ci, &sa1, 1, "comparedets_ncas (1x)");
+    nfail += hmatbench_comparedets(&ci, &sa2, 2, "comparedets_ncas (2x)");
+    nfail += hmatbench_comparedets(&ci, &sab, 2, "comparedets_ncas (ab)");
+    nfail += hmatbench_pindex(&ci, &sa1);
+    hmatbench_xgen(&ci, xa, nxa);
+
+    if (nfail == 0) {
+        printf("\n All reference checks passed.\n");
+    } else {
+        printf("\n %d reference checks FAILED.\n", nfail);
+    }
+
+    hmatbench_free_set(&s0);
+    hmatbench_free_set(&sa1);
+    hmatbench_free_set(&sb1);
+    hmatbench_free_set(&sa2);
+    hmatbench_free_set(&sab);
+    free(xa);
+    benchci_free(&ci);
+    MPI_Finalize();
+    return (nfail == 0 ? 0 : 1);
+}
+
+/*
+ * hmatbench_cycles: time stamp counter, 0 if unavailable.
+ */
+unsigned long long int hmatbench_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/*
+ * hmatbench_build_cases: sample determinants of the expansion and their
+ * single and double replacements into random (p,q) blocks.
+ */
+void hmatbench_build_cases(struct benchci *ci, struct hmatbench_set *s0,
+                           struct hmatbench_set *sa1,
+                           struct hmatbench_set *sb1,
+                           struct hmatbench_set *sa2,
+                           struct hmatbench_set *sab,
+                           struct hmatbench_xcase *xa, int *nxa)
+{
+    struct hmatbench_set *set[5] = {s0, sa1, sb1, sa2, sab};
+    struct hmatbench_pair *c = NULL;
+    struct xstr *pxl = NULL, *qxl = NULL;
+    int *elecx = NULL, *orbsx = NULL;
+    int xlistmax = 0;
+    int vorbs = ci->ci_orbs - ci->intorb;
+    int trpl[3];
+    int ip, iq, jps, jqs, npx, nqx, rp, rq;
+    int full = 0;
+    long long int t;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        set[i]->n = 0;
+        set[i]->c = malloc(sizeof(struct hmatbench_pair) * HMATBENCH_NCASE);
+    }
+    *nxa = 0;
+    for (i = 0; i < ci->pegrps; i++) {
+        if (ci->peosp[i].nstr > xlistmax) xlistmax = ci->peosp[i].nstr;
+    }
+    for (i = 0; i < ci->qegrps; i++) {
+        if (ci->qeosp[i].nstr > xlistmax) xlistmax = ci->qeosp[i].nstr;
+    }
+    pxl = malloc(sizeof(struct xstr) * xlistmax);
+    qxl = malloc(sizeof(struct xstr) * xlistmax);
+    elecx = malloc(sizeof(int) * (ci->ci_aelec + ci->ci_belec + 1));
+    orbsx = malloc(sizeof(int) * ci->ci_orbs);
+
+    for (t = 0; t < 64 * HMATBENCH_NCASE && full == 0; t++) {
+        /* |i> and a target (p,q) block */
+        i = (int) ((benchci_random((BENCHCI_SEED + 3), t) + 0.5) * ci->ndets);
+        if (i >= ci->ndets) i = ci->ndets - 1;
+        get_det_triple(ci->wdet, i, trpl);
+        ip = trpl[0];
+        iq = trpl[1];
+        i = (int) ((benchci_random((BENCHCI_SEED + 4), t) + 0.5) * ci->npq);
+        if (i >= ci->npq) i = ci->npq - 1;
+        jps = ci->pq[i][0];
+        jqs = ci->pq[i][1];
+
+        if (s0->n < HMATBENCH_NCASE) {
+            c = &(s0->c[s0->n++]);
+            c->ip = ip;
+            c->iq = iq;
+            c->jp = ip;
+            c->jq = iq;
+        }
+        if (*nxa < HMATBENCH_NCASE) {
+            xa[*nxa].istr = ip;
+            xa[*nxa].espc = jps;
+            (*nxa)++;
+        }
+
+        npx = generate_single_excitations(&(ci->pstr[ip]), ci->peosp[jps],
+                                          ci->ci_aelec, ci->ndocc, ci->nactv,
+                                          ci->intorb, vorbs, pxl, elecx,
+                                          orbsx, ci->pstr);
+        nqx = generate_single_excitations(&(ci->qstr[iq]), ci->qeosp[jqs],
+                                          ci->ci_belec, ci->ndocc, ci->nactv,
+                                          ci->intorb, vorbs, qxl, elecx,
+                                          orbsx, ci->qstr);
+        rp = (int) ((benchci_random((BENCHCI_SEED + 5), t) + 0.5) * npx);
+        rq = (int) ((benchci_random((BENCHCI_SEED + 6), t) + 0.5) * nqx);
+        if (rp >= npx) rp = npx - 1;
+        if (rq >= nqx) rq = nqx - 1;
+        if (npx > 0 && pxl[rp].index != ip && sa1->n < HMATBENCH_NCASE) {
+            c = &(sa1->c[sa1->n++]);
+            c->ip = ip;
+            c->iq = iq;
+            c->jp = pxl[rp].index;
+            c->jq = iq;
+            c->px = pxl[rp];
+        }
+        if (nqx > 0 && qxl[rq].index != iq && sb1->n < HMATBENCH_NCASE) {
+            c = &(sb1->c[sb1->n++]);
+            c->ip = ip;
+            c->iq = iq;
+            c->jp = ip;
+            c->jq = qxl[rq].index;
+            c->qx = qxl[rq];
+        }
+        if (npx > 0 && nqx > 0 && pxl[rp].index != ip &&
+            qxl[rq].index != iq && sab->n < HMATBENCH_NCASE) {
+            c = &(sab->c[sab->n++]);
+            c->ip = ip;
+            c->iq = iq;
+            c->jp = pxl[rp].index;
+            c->jq = qxl[rq].index;
+            c->px = pxl[rp];
+            c->qx = qxl[rq];
+        }
+
+        npx = generate_double_excitations(&(ci->pstr[ip]), ci->peosp[jps],
+                                          ci->ci_aelec, ci->ndocc, ci->nactv,
+                                          ci->intorb, vorbs, pxl, elecx,
+                                          orbsx, ci->pstr);
+        rp = (int) ((benchci_random((BENCHCI_SEED + 7), t) + 0.5) * npx);
+        if (rp >= npx) rp = npx - 1;
+        if (npx > 0 && pxl[rp].index != ip && sa2->n < HMATBENCH_NCASE) {
+            c = &(sa2->c[sa2->n++]);
+            c->ip = ip;
+            c->iq = iq;
+            c->jp = pxl[rp].index;
+            c->jq = iq;
+            c->px = pxl[rp];
+        }
+
+        full = 1;
+        for (i = 0; i < 5; i++) {
+            if (set[i]->n < HMATBENCH_NCASE) full = 0;
+        }
+    }
+
+    free(pxl);
+    free(qxl);
+    free(elecx);
+    free(orbsx);
+    return;
+}
+
+/*
+ * hmatbench_make_det: determinant from alpha and beta strings.
+ */
+struct det hmatbench_make_det(struct benchci *ci, int ip, int iq)
+{
+    struct det d;
+
+    d.astr = ci->pstr[ip];
+    d.bstr = ci->qstr[iq];
+    d.cas = ((d.astr.nvrtx + d.bstr.nvrtx) == 0 ? 1 : 0);
+    return d;
+}
+
+/*
+ * hmatbench_eval: evaluate <i|H|j> of a case.
+ */
+double hmatbench_eval(struct benchci *ci, struct hmatbench_pair *p, int xcls,
+                      int variant)
+{
+    struct occstr *pi = &(ci->pstr[p->ip]);
+    struct occstr *qi = &(ci->qstr[p->iq]);
+
+    if (variant == 0) {
+        return hmatels(hmatbench_make_det(ci, p->ip, p->iq),
+                       hmatbench_make_det(ci, p->jp, p->jq), ci->m1, ci->m2,
+                       ci->ci_aelec, ci->ci_belec, ci->intorb);
+    }
+    switch (xcls) {
+    case 0:
+        if (variant == 2) {
+            return hmatels_0x_slab(pi->istr, ci->ci_aelec, qi->istr,
+                                   ci->ci_belec, ci->m1, &(ci->mslab));
+        }
+        return hmatels_0x(pi->istr, ci->ci_aelec, qi->istr, ci->ci_belec,
+                          ci->m1, ci->m2);
+    case 1:
+        if (variant == 2) {
+            return hmatels_1x_slab(pi->istr, p->px.io, p->px.fo,
+                                   p->px.permx, ci->ci_aelec, qi->istr,
+                                   ci->ci_belec, ci->m1, &(ci->mslab));
+        }
+        return hmatels_1x(pi->istr, p->px.io, p->px.fo, p->px.permx,
+                          ci->ci_aelec, qi->istr, ci->ci_belec, ci->m1,
+                          ci->m2);
+    case 2:
+        if (variant == 2) {
+            return hmatels_1x_slab(qi->istr, p->qx.io, p->qx.fo,
+                                   p->qx.permx, ci->ci_belec, pi->istr,
+                                   ci->ci_aelec, ci->m1, &(ci->mslab));
+        }
+        return hmatels_1x(qi->istr, p->qx.io, p->qx.fo, p->qx.permx,
+                          ci->ci_belec, pi->istr, ci->ci_aelec, ci->m1,
+                          ci->m2);
+    case 3:
+        return hmatels_2xaa(p->px.io, p->px.fo, p->px.permx, ci->m2);
+    default:
+        return hmatels_2xab(p->px.io, p->px.fo, p->px.permx, p->qx.io,
+                            p->qx.fo, p->qx.permx, ci->m2);
+    }
+}
+
+/*
+ * hmatbench_string_diff: orbitals of string a (n) not in string b (n).
+ * At most 3 are stored.
+ */
+static int hmatbench_string_diff(int *a, int *b, int n, int *d)
+{
+    int nd = 0;
+    int i, j, found;
+
+    for (i = 0; i < n; i++) {
+        found = 0;
+        for (j = 0; j < n; j++) {
+            if (a[i] == b[j]) {
+                found = 1;
+                break;
+            }
+        }
+        if (found == 0) {
+            if (nd < 3) d[nd] = a[i];
+            nd++;
+        }
+    }
+    return nd;
+}
+
+/*
+ * hmatbench_replace: apply a+(p) a(h) to the ordered string s (n) in
+ * place, returning the phase (-1)^(occupied orbitals between h and p).
+ */
+static int hmatbench_replace(int *s, int n, int h, int p)
+{
+    int lo = (h < p ? h : p);
+    int hi = (h < p ? p : h);
+    int cnt = 0;
+    int i, t;
+
+    for (i = 0; i < n; i++) {
+        if (s[i] > lo && s[i] < hi) cnt++;
+        if (s[i] == h) s[i] = p;
+    }
+    /* Restore ascending order */
+    for (i = 1; i < n; i++) {
+        t = i;
+        while (t > 0 && s[t - 1] > s[t]) {
+            h = s[t];
+            s[t] = s[t - 1];
+            s[t - 1] = h;
+            t--;
+        }
+    }
+    return ((cnt % 2) == 0 ? 1 : -1);
+}
+
+/*
+ * hmatbench_slater_condon: <i|H|j> of a case from the Slater-Condon rules,
+ * independent of the CI kernels.
+ */
+double hmatbench_slater_condon(struct benchci *ci, struct hmatbench_pair *p)
+{
+    int *ai = ci->pstr[p->ip].istr, *aj = ci->pstr[p->jp].istr;
+    int *bi = ci->qstr[p->iq].istr, *bj = ci->qstr[p->jq].istr;
+    int na = ci->ci_aelec, nb = ci->ci_belec;
+    double *m1 = ci->m1, *m2 = ci->m2;
+    int ah[3], ap[3], bh[3], bp[3]; /* holes (in i) and particles (in j) */
+    int nax, nbx;
+    int s[20];
+    int *si, *so, ns, no;          /* excited and other string of |i> */
+    int *h, *x;
+    int phase = 1;
+    double val = 0.0;
+    int i, j;
+
+    nax = hmatbench_string_diff(ai, aj, na, ah);
+    hmatbench_string_diff(aj, ai, na, ap);
+    nbx = hmatbench_string_diff(bi, bj, nb, bh);
+    hmatbench_string_diff(bj, bi, nb, bp);
+    if ((nax + nbx) > 2) return 0.0;
+
+    if (nax + nbx == 0) {
+        for (i = 0; i < na; i++) {
+            val += m1[(index1e(ai[i], ai[i]) - 1)];
+            for (j = 0; j < i; j++) {
+                val += m2[(index2e(ai[i], ai[i], ai[j], ai[j]) - 1)] -
+                    m2[(index2e(ai[i], ai[j], ai[j], ai[i]) - 1)];
+            }
+            for (j = 0; j < nb; j++) {
+                val += m2[(index2e(ai[i], ai[i], bi[j], bi[j]) - 1)];
+            }
+        }
+        for (i = 0; i < nb; i++) {
+            val += m1[(index1e(bi[i], bi[i]) - 1)];
+            for (j = 0; j < i; j++) {
+                val += m2[(index2e(bi[i], bi[i], bi[j], bi[j]) - 1)] -
+                    m2[(index2e(bi[i], bi[j], bi[j], bi[i]) - 1)];
+            }
+        }
+        return val;
+    }
+
+    if (nax + nbx == 1) {
+        if (nax == 1) {
+            si = ai; ns = na; so = bi; no = nb; h = ah; x = ap;
+        } else {
+            si = bi; ns = nb; so = ai; no = na; h = bh; x = bp;
+        }
+        for (i = 0; i < ns; i++) s[i] = si[i];
+        phase = hmatbench_replace(s, ns, h[0], x[0]);
+        val = m1[(index1e(h[0], x[0]) - 1)];
+        for (i = 0; i < ns; i++) {
+            if (si[i] == h[0]) continue;
+            val += m2[(index2e(h[0], x[0], si[i], si[i]) - 1)] -
+                m2[(index2e(h[0], si[i], si[i], x[0]) - 1)];
+        }
+        for (i = 0; i < no; i++) {
+            val += m2[(index2e(h[0], x[0], so[i], so[i]) - 1)];
+        }
+        return phase * val;
+    }
+
+    if (nax == 1 && nbx == 1) {
+        for (i = 0; i < na; i++) s[i] = ai[i];
+        phase = hmatbench_replace(s, na, ah[0], ap[0]);
+        for (i = 0; i < nb; i++) s[i] = bi[i];
+        phase = phase * hmatbench_replace(s, nb, bh[0], bp[0]);
+        return phase * m2[(index2e(ah[0], ap[0], bh[0], bp[0]) - 1)];
+    }
+
+    if (nax == 2) {
+        si = ai; ns = na; h = ah; x = ap;
+    } else {
+        si = bi; ns = nb; h = bh; x = bp;
+    }
+    for (i = 0; i < ns; i++) s[i] = si[i];
+    phase = hmatbench_replace(s, ns, h[0], x[0]);
+    phase = phase * hmatbench_replace(s, ns, h[1], x[1]);
+    return phase * (m2[(index2e(h[0], x[0], h[1], x[1]) - 1)] -
+                    m2[(index2e(h[0], x[1], h[1], x[0]) - 1)]);
+}
+
+/*
+ * hmatbench_time_eval: time hmatbench_eval over a set, returning the
+ * values of the first pass in val.
+ */
+static void hmatbench_time_eval(struct benchci *ci, struct hmatbench_set *s,
+                                int xcls, int variant, double *val,
+                                double *sec, unsigned long long int *cyc,
+                                long long int *ncall)
+{
+    double t0 = 0.0, sum = 0.0;
+    unsigned long long int c0 = 0;
+    int nrep = 1;
+    int r, c;
+
+    /* Calibration pass */
+    t0 = perftimer_wtime();
+    for (c = 0; c < s->n; c++) {
+        val[c] = hmatbench_eval(ci, &(s->c[c]), xcls, variant);
+    }
+    *sec = perftimer_wtime() - t0;
+    if (*sec > 0.0) nrep = (int) (HMATBENCH_MINTIME / (*sec)) + 1;
+
+    t0 = perftimer_wtime();
+    c0 = hmatbench_cycles();
+    for (r = 0; r < nrep; r++) {
+        for (c = 0; c < s->n; c++) {
+            sum += hmatbench_eval(ci, &(s->c[c]), xcls, variant);
+        }
+    }
+    *cyc = hmatbench_cycles() - c0;
+    *sec = perftimer_wtime() - t0;
+    *ncall = (long long int) nrep * s->n;
+    hmatbench_sink = sum;
+    return;
+}
+
+/*
+ * hmatbench_maxdiff: largest |val - ref|, counting values outside the
+ * relative tolerance.
+ */
+static double hmatbench_maxdiff(double *val, double *ref, int n, int *nbad)
+{
+    double d = 0.0, dmax = 0.0;
+    int i;
+
+    *nbad = 0;
+    for (i = 0; i < n; i++) {
+        d = fabs(val[i] - ref[i]);
+        if (d > dmax) dmax = d;
+        if (d > HMATBENCH_TOL * (1.0 + fabs(ref[i]))) (*nbad)++;
+    }
+    return dmax;
+}
+
+/*
+ * hmatbench_hmatels: time hmatels() and the class-specific routines on a
+ * set, and check the class-specific routines against hmatels().
+ */
+int hmatbench_hmatels(struct benchci *ci, struct hmatbench_set *s, int xcls)
+{
+    static char *rname[5] = {"hmatels (0x)", "hmatels (alpha 1x)",
+                             "hmatels (beta 1x)", "hmatels (alpha 2x)",
+                             "hmatels (alpha-beta)"};
+    static char *fname[5] = {"hmatels_0x", "hmatels_1x (alpha)",
+                             "hmatels_1x (beta)", "hmatels_2xaa",
+                             "hmatels_2xab"};
+    static char *sname[5] = {"hmatels_0x_slab", "hmatels_1x_slab (alpha)",
+                             "hmatels_1x_slab (beta)", "", ""};
+    double *ref = NULL, *val = NULL, *rules = NULL;
+    double sec = 0.0, dref = 0.0, drules = 0.0;
+    unsigned long long int cyc = 0;
+    long long int ncall = 0;
+    int nbad = 0, nfail = 0;
+    int variant, c;
+
+    if (s->n == 0) {
+        printf(" %-30s %10s\n", rname[xcls], "no cases");
+        return 0;
+    }
+    ref = malloc(sizeof(double) * s->n);
+    val = malloc(sizeof(double) * s->n);
+    rules = malloc(sizeof(double) * s->n);
+    for (c = 0; c < s->n; c++) {
+        rules[c] = hmatbench_slater_condon(ci, &(s->c[c]));
+    }
+
+    /* hmatels() is the reference for the specialized routines, and is
+     * itself checked against the rules. */
+    hmatbench_time_eval(ci, s, xcls, 0, ref, &sec, &cyc, &ncall);
+    drules = hmatbench_maxdiff(ref, rules, s->n, &nbad);
+    nfail += nbad;
+    hmatbench_print(rname[xcls], sec, cyc, ncall, -1.0, drules);
+    if (nbad != 0) {
+        printf("  FAILED: hmatels() disagrees with the rules in %d of %d"
+               " cases\n", nbad, s->n);
+    }
+    for (variant = 1; variant <= (xcls <= 2 ? 2 : 1); variant++) {
+        hmatbench_time_eval(ci, s, xcls, variant, val, &sec, &cyc, &ncall);
+        dref = hmatbench_maxdiff(val, ref, s->n, &nbad);
+        drules = hmatbench_maxdiff(val, rules, s->n, &nbad);
+        nfail += nbad;
+        hmatbench_print((variant == 1 ? fname[xcls] : sname[xcls]), sec, cyc,
+                        ncall, dref, drules);
+    }
+
+    free(ref);
+    free(val);
+    free(rules);
+    return nfail;
+}
+
+/*
+ * hmatbench_comparedets: time comparedets_ncas() on a set and check the
+ * number of differences.
+ */
+int hmatbench_comparedets(struct benchci *ci, struct hmatbench_set *s,
+                          int ndiff, char *label)
+{
+    struct det di, dj;
+    int numaxc, numbxc, numaxv, numbxv, numaxcv, numbxcv;
+    long long int axi, axf, bxi, bxf;
+    double t0 = 0.0, sec = 0.0;
+    unsigned long long int c0 = 0, cyc = 0;
+    long long int sum = 0;
+    int nrep = 1, nfail = 0;
+    int r, c, n;
+
+    if (s->n == 0) return 0;
+    t0 = perftimer_wtime();
+    for (c = 0; c < s->n; c++) {
+        di = hmatbench_make_det(ci, s->c[c].ip, s->c[c].iq);
+        dj = hmatbench_make_det(ci, s->c[c].jp, s->c[c].jq);
+        n = comparedets_ncas(di, dj, &numaxc, &numbxc, &numaxv, &numbxv,
+                             &numaxcv, &numbxcv, &axi, &axf, &bxi, &bxf,
+                             ci->intorb);
+        if (n != ndiff) nfail++;
+    }
+    sec = perftimer_wtime() - t0;
+    if (sec > 0.0) nrep = (int) (HMATBENCH_MINTIME / sec) + 1;
+
+    t0 = perftimer_wtime();
+    c0 = hmatbench_cycles();
+    for (r = 0; r < nrep; r++) {
+        for (c = 0; c < s->n; c++) {
+            di = hmatbench_make_det(ci, s->c[c].ip, s->c[c].iq);
+            dj = hmatbench_make_det(ci, s->c[c].jp, s->c[c].jq);
+            sum += comparedets_ncas(di, dj, &numaxc, &numbxc, &numaxv,
+                                    &numbxv, &numaxcv, &numbxcv, &axi, &axf,
+                                    &bxi, &bxf, ci->intorb);
+        }
+    }
+    cyc = hmatbench_cycles() - c0;
+    sec = perftimer_wtime() - t0;
+    hmatbench_sink = (double) sum;
+    hmatbench_print(label, sec, cyc, ((long long int) nrep * s->n), -1.0,
+                    (double) nfail);
+    return nfail;
+}
+
+/*
+ * hmatbench_pindex: time pindex_single_rep() on alpha single
+ * replacements.
+ */
+int hmatbench_pindex(struct benchci *ci, struct hmatbench_set *s)
+{
+    struct hmatbench_pair *p = NULL;
+    long long int *xi = NULL, *xf = NULL;
+    int *cas = NULL, *ref = NULL, *rules = NULL;
+    int str[20];
+    int ncas = 0, nref = 0, nrules = 0, nfail = 0;
+    double t0 = 0.0, sec = 0.0;
+    unsigned long long int c0 = 0, cyc = 0;
+    long long int sum = 0;
+    int nrep = 1;
+    int r, c, v;
+
+    if (s->n == 0) return 0;
+    cas   = malloc(sizeof(int) * s->n);
+    ref   = malloc(sizeof(int) * s->n);
+    rules = malloc(sizeof(int) * s->n);
+    xi    = malloc(sizeof(long long int) * s->n);
+    xf    = malloc(sizeof(long long int) * s->n);
+    for (c = 0; c < s->n; c++) {
+        p = &(s->c[c]);
+        for (v = 0; v < ci->ci_aelec; v++) str[v] = ci->pstr[p->ip].istr[v];
+        rules[c] = hmatbench_replace(str, ci->ci_aelec, p->px.io[0],
+                                     p->px.fo[0]);
+        ref[c] = pindex_single_rep(ci->pstr[p->ip].istr, p->px.io[0],
+                                   p->px.fo[0], ci->ci_aelec);
+        if (ref[c] != rules[c]) nrules++;
+        /* CAS replacements and their orbital bit masks */
+        if (p->px.io[0] <= ci->intorb && p->px.fo[0] <= ci->intorb) {
+            cas[ncas] = c;
+            xi[ncas] = ((long long int) 1) << (p->px.io[0] - 1);
+            xf[ncas] = ((long long int) 1) << (p->px.fo[0] - 1);
+            ncas++;
+        }
+    }
+    nfail = nrules;
+
+    t0 = perftimer_wtime();
+    for (c = 0; c < s->n; c++) {
+        p = &(s->c[c]);
+        sum += pindex_single_rep(ci->pstr[p->ip].istr, p->px.io[0],
+                                 p->px.fo[0], ci->ci_aelec);
+    }
+    sec = perftimer_wtime() - t0;
+    if (sec > 0.0) nrep = (int) (HMATBENCH_MINTIME / sec) + 1;
+    t0 = perftimer_wtime();
+    c0 = hmatbench_cycles();
+    for (r = 0; r < nrep; r++) {
+        for (c = 0; c < s->n; c++) {
+            p = &(s->c[c]);
+            sum += pindex_single_rep(ci->pstr[p->ip].istr, p->px.io[0],
+                                     p->px.fo[0], ci->ci_aelec);
+        }
+    }
+    cyc = hmatbench_cycles() - c0;
+    sec = perftimer_wtime() - t0;
+    hmatbench_print("pindex_single_rep", sec, cyc,
+                    ((long long int) nrep * s->n), -1.0, (double) nrules);
+
+    if (ncas > 0) {
+        nrules = 0;
+        for (c = 0; c < ncas; c++) {
+            v = pindex_single_rep_cas(ci->pstr[s->c[cas[c]].ip].byte1,
+                                      xi[c], xf[c], ci->intorb);
+            if (v != ref[cas[c]]) nref++;
+            if (v != rules[cas[c]]) nrules++;
+        }
+        nfail += nrules;
+        nrep = 1;
+        t0 = perftimer_wtime();
+        for (c = 0; c < ncas; c++) {
+            sum += pindex_single_rep_cas(ci->pstr[s->c[cas[c]].ip].byte1,
+                                         xi[c], xf[c], ci->intorb);
+        }
+        sec = perftimer_wtime() - t0;
+        if (sec > 0.0) nrep = (int) (HMATBENCH_MINTIME / sec) + 1;
+        t0 = perftimer_wtime();
+        c0 = hmatbench_cycles();
+        for (r = 0; r < nrep; r++) {
+            for (c = 0; c < ncas; c++) {
+                sum += pindex_single_rep_cas(ci->pstr[s->c[cas[c]].ip].byte1,
+                                             xi[c], xf[c], ci->intorb);
+            }
+        }
+        cyc = hmatbench_cycles() - c0;
+        sec = perftimer_wtime() - t0;
+        hmatbench_print("pindex_single_rep_cas", sec, cyc,
+                        ((long long int) nrep * ncas), (double) nref,
+                        (double) nrules);
+    }
+    hmatbench_sink = (double) sum;
+
+    free(cas);
+    free(ref);
+    free(rules);
+    free(xi);
+    free(xf);
+    return nfail;
+}
+
+/*
+ * hmatbench_xgen: time generate_single_excitations() and
+ * generate_double_excitations() on alpha strings.
+ */
+void hmatbench_xgen(struct benchci *ci, struct hmatbench_xcase *xa, int nxa)
+{
+    struct xstr *xl = NULL;
+    int *elecx = NULL, *orbsx = NULL;
+    int xlistmax = 0;
+    int vorbs = ci->ci_orbs - ci->intorb;
+    double t0 = 0.0, sec = 0.0;
+    unsigned long long int c0 = 0, cyc = 0;
+    long long int nx = 0;
+    int nrep = 1;
+    int x, r, c;
+
+    if (nxa == 0) return;
+    for (c = 0; c < ci->pegrps; c++) {
+        if (ci->peosp[c].nstr > xlistmax) xlistmax = ci->peosp[c].nstr;
+    }
+    xl = malloc(sizeof(struct xstr) * xlistmax);
+    elecx = malloc(sizeof(int) * (ci->ci_aelec + 1));
+    orbsx = malloc(sizeof(int) * ci->ci_orbs);
+
+    for (x = 1; x <= 2; x++) {
+        nrep = 1;
+        t0 = perftimer_wtime();
+        for (c = 0; c < nxa; c++) {
+            if (x == 1) {
+                generate_single_excitations(&(ci->pstr[xa[c].istr]),
+                                            ci->peosp[xa[c].espc],
+                                            ci->ci_aelec, ci->ndocc,
+                                            ci->nactv, ci->intorb, vorbs, xl,
+                                            elecx, orbsx, ci->pstr);
+            } else {
+                generate_double_excitations(&(ci->pstr[xa[c].istr]),
+                                            ci->peosp[xa[c].espc],
+                                            ci->ci_aelec, ci->ndocc,
+                                            ci->nactv, ci->intorb, vorbs, xl,
+                                            elecx, orbsx, ci->pstr);
+            }
+        }
+        sec = perftimer_wtime() - t0;
+        if (sec > 0.0) nrep = (int) (HMATBENCH_MINTIME / sec) + 1;
+        nx = 0;
+        t0 = perftimer_wtime();
+        c0 = hmatbench_cycles();
+        for (r = 0; r < nrep; r++) {
+            for (c = 0; c < nxa; c++) {
+                if (x == 1) {
+                    nx += generate_single_excitations(
+                        &(ci->pstr[xa[c].istr]), ci->peosp[xa[c].espc],
+                        ci->ci_aelec, ci->ndocc, ci->nactv, ci->intorb,
+                        vorbs, xl, elecx, orbsx, ci->pstr);
+                } else {
+                    nx += generate_double_excitations(
+                        &(ci->pstr[xa[c].istr]), ci->peosp[xa[c].espc],
+                        ci->ci_aelec, ci->ndocc, ci->nactv, ci->intorb,
+                        vorbs, xl, elecx, orbsx, ci->pstr);
+                }
+            }
+        }
+        cyc = hmatbench_cycles() - c0;
+        sec = perftimer_wtime() - t0;
+        hmatbench_print((x == 1 ? "generate_single_excitations" :
+                         "generate_double_excitations"), sec, cyc,
+                        ((long long int) nrep * nxa), -1.0, -1.0);
+        if (nx > 0) {
+            printf(" %-30s %10.1lf %12.1lf\n", "  per excitation",
+                   (sec * 1.0e9 / nx), ((double) cyc / nx));
+        }
+    }
+
+    free(xl);
+    free(elecx);
+    free(orbsx);
+    return;
+}
+
+/*
+ * hmatbench_print: print ns/call and cycles/call of a timed loop, with the
+ * largest deviation from the reference routine and from the Slater-Condon
+ * rules (number of mismatches for integer results; negative = not
+ * checked).
+ */
+void hmatbench_print(char *label, double sec, unsigned long long int cyc,
+                     long long int ncall, double dref, double drules)
+{
+    printf(" %-30s %10.1lf", label, (sec * 1.0e9 / ncall));
+    if (cyc != 0) {
+        printf(" %12.1lf", ((double) cyc / ncall));
+    } else {
+        printf(" %12s", "-");
+    }
+    if (dref >= 0.0) {
+        printf(" %12.3E", dref);
+    } else {
+        printf(" %12s", "-");
+    }
+    if (drules >= 0.0) {
+        printf(" %12.3E\n", drules);
+    } else {
+        printf(" %12s\n", "-");
+    }
+    fflush(stdout);
+    return;
+}
+
+/*
+ * hmatbench_free_set: deallocate a set of cases.
+ */
+void hmatbench_free_set(struct hmatbench_set *s)
+{
+    free(s->c);
+    s->c = NULL;
+    s->n = 0;
+    return;
+}
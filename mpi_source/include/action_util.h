@@ -319,6 +319,21 @@ double hmatels_0x(int *istr1, int ne1, int *istr2, int ne2,
 double hmatels_1x(int *istr1, int *io, int *fo, int pi, int ne1,
                   int *istr2, int ne2, double *m1, double *m2);
 
+/*
+ * hmatels_0x_slab: compute diagonal matrix elements from per-pair
+ * integral slabs.
+ */
+double hmatels_0x_slab(int *istr1, int ne1, int *istr2, int ne2,
+                       double *m1, struct moslab *mslab);
+
+/*
+ * hmatels_1x_slab: compute single replacement matrix elements from
+ * per-pair integral slabs.
+ */
+double hmatels_1x_slab(int *istr1, int *io, int *fo, int pi, int ne1,
+                       int *istr2, int ne2, double *m1,
+                       struct moslab *mslab);
+
 /*
  * hmatels_2xaa: compute double replacements in one string matrix elements.
  */
@@ -0,0 +1,114 @@
+// File: aogrid.h
+
+#ifndef aogrid_h
+#define aogrid_h
+
+struct ao_basisfunc;
+
+/* Points evaluated together by one thread */
+#define AOGRID_BLOCK 128
+
+/* Neglect primitives smaller than this when screening by distance */
+#define AOGRID_SCREEN 1.0e-12
+
+/*
+ * struct ao_gridbasis: atomic orbital basis laid out for evaluation on
+ * blocks of points. Normalization and gaussian scaling are folded into
+ * the primitive coefficients.
+ */
+struct ao_gridbasis {
+        int nao;        /* Number of atomic orbitals */
+        int nprim;      /* Number of primitives */
+        int ncntr;      /* Number of centers */
+        int *type;      /* Orbital type (see struct ao_basisfunc), [nao] */
+        int *cntr;      /* Center of orbital, [nao] */
+        int *pstart;    /* First primitive of orbital, [nao + 1] */
+        double *rcut2;  /* Squared screening radius of orbital, [nao] */
+        double *expn;   /* Primitive exponents, [nprim] */
+        double *coef;   /* Primitive coefficients, [nprim] */
+        double *xyz;    /* Center coordinates, [ncntr][3] */
+        double *chrg;   /* Center nuclear charges, [ncntr] */
+};
+
+/*
+ * aogrid_init: build the grid basis from the atomic orbital set.
+ * Input:
+ *  aob = atomic orbitals
+ *  nao = number of atomic orbitals
+ * Output:
+ *  gb  = grid basis
+ * Returns 1 on allocation failure, 2 on an unknown orbital type.
+ */
+int aogrid_init(struct ao_basisfunc *aob, int nao, struct ao_gridbasis *gb);
+
+/*
+ * aogrid_free: free grid basis arrays.
+ */
+void aogrid_free(struct ao_gridbasis *gb);
+
+/*
+ * aogrid_scratch_size: number of doubles of scratch aogrid_evaluate
+ * needs for npts points.
+ */
+int aogrid_scratch_size(struct ao_gridbasis *gb, int npts);
+
+/*
+ * aogrid_evaluate: evaluate all atomic orbitals on a block of points.
+ * Input:
+ *  gb    = grid basis
+ *  x,y,z = point coordinates, [npts]
+ *  npts  = number of points
+ *  scr   = scratch, aogrid_scratch_size() doubles
+ * Output:
+ *  aoval = orbital values, [nao][npts]
+ */
+void aogrid_evaluate(struct ao_gridbasis *gb, double *x, double *y,
+                     double *z, int npts, double *scr, double *aoval);
+
+/*
+ * aogrid_box: set a cube grid around all centers.
+ * Input:
+ *  gb     = grid basis
+ *  pad    = distance added to each side of the box of centers
+ *  nmax   = points along the longest side
+ * Output:
+ *  origin = first grid point
+ *  npts   = points along x, y, z
+ *  step   = spacing along x, y, z
+ */
+void aogrid_box(struct ao_gridbasis *gb, double pad, int nmax,
+                double *origin, int *npts, double *step);
+
+/*
+ * aogrid_evaluate_orbitals: evaluate orbitals given by their atomic
+ * orbital coefficients on a cube grid.
+ * Input:
+ *  gb     = grid basis
+ *  orbao  = orbital coefficients, [norb][nao]
+ *  norb   = number of orbitals
+ *  origin = first grid point
+ *  npts   = points along x, y, z
+ *  step   = spacing along x, y, z
+ * Output:
+ *  vals   = orbital values in cube order (z fastest), [norb][ntot]
+ */
+void aogrid_evaluate_orbitals(struct ao_gridbasis *gb, double *orbao,
+                              int norb, double *origin, int *npts,
+                              double *step, double *vals);
+
+/*
+ * aogrid_write_cube: write a Gaussian cube file.
+ * Input:
+ *  filename = name of file
+ *  comment  = second comment line
+ *  gb       = grid basis (atoms)
+ *  origin   = first grid point
+ *  npts     = points along x, y, z
+ *  step     = spacing along x, y, z
+ *  vals     = values in cube order (z fastest)
+ */
+int aogrid_write_cube(char *filename, char *comment,
+                      struct ao_gridbasis *gb, double *origin, int *npts,
+                      double *step, double *vals);
+
+#endif
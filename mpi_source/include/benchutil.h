@@ -0,0 +1,86 @@
+// File: benchutil.h
+/*
+ * Synthetic CI expansions and integrals for the benchmark programs.
+ */
+
+#ifndef benchutil_h
+#define benchutil_h
+
+#include "moslab.h"
+
+struct occstr;
+struct eospace;
+struct detaddress;
+
+/* Seed of the synthetic integrals and vectors */
+#define BENCHCI_SEED 20200724ULL
+
+/*
+ * struct benchci: CI expansion and synthetic integrals.
+ */
+struct benchci {
+    int ci_aelec;              /* CI alpha electrons */
+    int ci_belec;              /* CI beta  electrons */
+    int ci_orbs;               /* CI orbitals */
+    int ndocc;                 /* CAS doubly-occupied orbitals */
+    int nactv;                 /* CAS active orbitals */
+    int intorb;                /* CI internal orbitals: ndocc + nactv */
+    struct occstr *pstr;       /* Alpha strings */
+    struct occstr *qstr;       /* Beta  strings */
+    struct eospace *peosp;     /* Alpha electron string spaces */
+    struct eospace *qeosp;     /* Beta  electron string spaces */
+    int pegrps;
+    int qegrps;
+    int **pq;                  /* Valid (p,q) space pairs */
+    int *pqdata;
+    int npq;
+    int pstr_len;
+    int qstr_len;
+    int ndets;
+    double *m1;                /* 1-e integrals */
+    double *m2;                /* 2-e integrals */
+    struct moslab mslab;       /* Per-pair integral slabs */
+    struct detaddress *wdet;   /* Implicit determinant list */
+};
+
+/*
+ * benchci_random: reproducible pseudo-random number in [-0.5, 0.5)
+ * for element i of a stream. Independent of the number of processes.
+ */
+double benchci_random(unsigned long long int seed, long long int i);
+
+/*
+ * benchci_integrals: generate synthetic 1-e and 2-e integrals. Values
+ * are stored in the canonical (index1e/index2e) lower triangles, so
+ * h(i,j) = h(j,i) and (ij|kl) has full 8-fold permutational symmetry.
+ * A diagonal shift gives an aufbau-like orbital ordering.
+ * Input:
+ *  norb = number of orbitals
+ * Output:
+ *  m1   = 1-e integrals
+ *  m2   = 2-e integrals
+ */
+void benchci_integrals(int norb, double *m1, double *m2);
+
+/*
+ * benchci_setup: build the CI expansion, synthetic integrals, integral
+ * slabs and implicit determinant list. No frozen orbitals.
+ * Input:
+ *  electrons = total electrons
+ *  ndocc     = CAS doubly-occupied orbitals
+ *  nactv     = CAS active orbitals
+ *  orbitals  = total orbitals
+ *  xlvl      = excitation level
+ * Output:
+ *  ci        = expansion and integrals
+ * Returns 0 on success.
+ */
+int benchci_setup(struct benchci *ci, int electrons, int ndocc, int nactv,
+                  int orbitals, int xlvl);
+
+/*
+ * benchci_free: deallocate expansion and integrals.
+ */
+void benchci_free(struct benchci *ci);
+
+#endif
@@ -6,6 +6,8 @@
 /* Pi^3 (From mathematica) */
 #define M_PI_3 31.0062766802998201
 
+struct ao_gridbasis;
+
 /*
  * ao_basisfunc: an atomic orbital basis function
  */
@@ -20,6 +22,7 @@ struct ao_basisfunc {
         int atom;       /* Center index */
         double *geom;   /* Center geometry */
         double gscale;  /* Gaussian scaling */
+        double nucchrg; /* Nuclear charge of center */
 };
 
 
@@ -30,7 +33,8 @@ struct ao_basis {
         int ugaus;      /* uncontracted gaussians */
         int cgaus;      /* contracted gaussians */
         double *alpha;  /* alpha values */
-        double **ccoef; /* contraction coefficients. Stored: M[cgaus][ugaus] */      
+        double **ccoef; /* contraction coefficients. Stored: M[cgaus][ugaus] */
+        double *ccoef1d;/* contiguous storage of ccoef */
 };
         
 /*
@@ -43,15 +47,29 @@ struct ao_atomdata {
         int maxlval;            /* Maximum l value */
         int *naob;              /* Number of aoblocks per l value */
         double **geom;          /* atom geometries */
+        double *geom1d;         /* contiguous storage of geom */
         int totblk;             /* total number of ao blocks */
         int *lval;              /* lvalues for each block: s = 0, p = 1, etc */
         struct ao_basis *basis; /* Basis information for each block */
 };
 
 /*
- * ao_buildao: build atomic orbitals.
+ * ao_buildao: build atomic orbitals from daltaoin and soinfo.dat.
+ * Output:
+ *  aobasis = atomic orbital basis (allocated here)
+ *  norbs   = number of atomic orbitals
+ */
+int ao_buildao(
+        struct ao_basisfunc **aobasis,
+        int *norbs);
+
+/*
+ * ao_buildao_gridbasis: build the atomic orbital basis on the root
+ * process and broadcast it to all processes as a grid basis. This is
+ * executed on all processes.
  */
-int ao_buildao();
+int ao_buildao_gridbasis(
+        struct ao_gridbasis *gb);
 
 /*
  * ao_build_atomic_orbitalset: build atomic orbital basis set from adata.
@@ -61,20 +79,10 @@ int ao_buildao();
  */
 int ao_build_atomic_orbitalset(
         struct ao_atomdata *adata,
-        struct ao_basisfunc *aobasis,
+        struct ao_basisfunc **aobasis,
         int atypes,
         int *norbs);
 
-/*
- * ao_check_for_daltaoin: Check for daltaoin file.
- */
-int ao_check_for_daltaoin();
-
-/*
- * ao_check_for_soinfodat: Check for soinfo.dat file.
- */
-int ao_check_for_soinfodat();
-
 /*
  * ao_cp_alphavals_ccoefs: copy alpha values and contraction coefficients for
  * ao block and contracted gaussian.
@@ -96,20 +104,27 @@ void ao_cp_gaussian_scaling(
         int lval);
 
 /*
- * ao_get_gscalings: get gaussian scalings from soinfo.dat file.
+ * ao_field: copy the fixed-width field line[pos:pos+len] into fld
+ * (len + 1 characters). Stops at the end of the line.
  */
-int ao_get_gscalings(
-        FILE *soinfo,
-        double **gscal,
-        int *ngaus);
+char *ao_field(
+        char *line,
+        int pos,
+        int len,
+        char *fld);
+
+/*
+ * ao_free_atomdata: free atom basis data.
+ */
+void ao_free_atomdata(
+        struct ao_atomdata *adata);
 
 /*
- * ao_get_atominfo: get atominfo character arrays from soinfo.dat file.
+ * ao_free_atomic_orbital_set: free atomic orbital array.
  */
-int ao_get_atominfo(
-        FILE *soinfo,
-        char ***ainfo,
-        int *natoms);
+void ao_free_atomic_orbital_set(
+        struct ao_basisfunc *aobasis,
+        int norbs);
 
 /*
  * ao_get_block_and_gauss_number: get block number and contracted gaussian
@@ -130,14 +145,6 @@ void ao_get_block_and_gauss_number(
 int ao_get_lvalue_from_type(
         int oindex);
 
-
-/*
- * ao_get_orbitalnum: get orbital number of soinfo.dat file.
- */
-int ao_get_orbitalnum(
-        FILE *soinfo,
-        int *norbs);
-
 /*
  * ao_increment_norb_per_l: increment number of orbital per l value if
  * px, d2-, etc.
@@ -152,18 +159,6 @@ void ao_increment_norb_per_l(
 struct ao_basisfunc *ao_initialize_atomic_orbital_set(
         int norbs);
 
-/*
- * ao_open_daltonfile: open dalton file returing file stream.
- */
-FILE *ao_open_daltonfile(
-        FILE *daltin); /* Dalton input file stream */
-
-/*
- * ao_open_soinfodat: open soinfo.dat file, returning file stream.
- */
-FILE *ao_open_soinfodat(
-        FILE *soinfo);
-
 /*
  * ao_read_daltontitle: read first three lines of daltaoin file.
  * INTGRL
@@ -171,14 +166,27 @@ FILE *ao_open_soinfodat(
  * X
  */
 int ao_read_daltontitle(
-        FILE *daltin); /* Dalton input file stream */
+        char **line,    /* daltaoin lines */
+        int nlines,     /* number of lines */
+        int *ln);       /* current line */
+
+/*
+ * ao_read_dalton_aoblock: read am atomic orbital basis block from daltaoin
+ */
+int ao_read_dalton_aoblock(
+        char **line,
+        int nlines,
+        int *ln,
+        struct ao_basis *basis);
 
 /*
  * ao_read_dalton_atombasis1: read first line of atom basis set iformation.
  * (Reads in: nuclear charge, number of atoms, max L value, blocks per L value
  */
 int ao_read_dalton_atombasis1(
-        FILE *daltin,
+        char **line,
+        int nlines,
+        int *ln,
         struct ao_atomdata *adata);
 
 /*
@@ -186,7 +194,9 @@ int ao_read_dalton_atombasis1(
  * file into the AO_ATOMDATA.AO_ABASIS type.
  */
 int ao_read_dalton_atombasis2(
-        FILE *daltin,
+        char **line,
+        int nlines,
+        int *ln,
         struct ao_atomdata *adata);
 
 /*
@@ -227,11 +237,10 @@ void ao_process_aorbital_dataline(char *line, int *anum, char *atom,
 int ao_process_orbitaldata(
         struct ao_atomdata *adata,
         struct ao_basisfunc *aobasis,
-        FILE *soinfo,
+        char **caoinfo,         /* CAOINFO lines of soinfo.dat */
         int norbs,
         double *gscal,
         int ngaus,
-        char **atominfo,
         int atypes);
 
 
@@ -240,7 +249,9 @@ int ao_process_orbitaldata(
  * dalton file.
  */
 int ao_read_dalton_basisinfo1(
-        FILE *daltin, 
+        char **line,
+        int nlines,
+        int *ln,
         char    *crt,
         int  *atypes,
         int  *molchg,
@@ -252,8 +263,34 @@ int ao_read_dalton_basisinfo1(
  * gaussian.
  */
 int ao_read_dalton_contractionvals(
-        FILE *daltin,
+        char **line,
+        int *ln,
         struct ao_basis *basis,
         int ug);
 
+/*
+ * ao_read_textfile: read a text file with one fread and split it into
+ * lines. The newlines are replaced by '\0'.
+ * Output:
+ *  lines  = pointers to the start of each line (free after use)
+ *  nlines = number of lines
+ * Returns the file buffer (free after use), NULL on error.
+ */
+char *ao_read_textfile(
+        char *filename,
+        char ***lines,
+        int *nlines);
+
+/*
+ * ao_scan_soinfo: collect the CAOINFO lines and GTOSCALE values of
+ * soinfo.dat in one pass.
+ */
+int ao_scan_soinfo(
+        char **line,
+        int nlines,
+        char **caoinfo,
+        int *norbs,
+        double *gscal,
+        int *ngaus);
+
 #endif
@@ -2,6 +2,8 @@
 #ifndef citruncate_h
 #define citruncate_h
 
+struct strgraph;
+
 /*
  * struct eospace: electron numbers in a space making
  * a valid determinant.
@@ -97,6 +99,12 @@ struct eostring *allocate_strings_array(
  */
 struct occstr *allocate_occstr_arrays(int nstr);
 
+/*
+ * init_occstr_array: initialize binary electron orbital occupation
+ * string array.
+ */
+void init_occstr_array(struct occstr *ptr, int nstr);
+
 /*
  * allocate_xmap: allocate 2d excitation map.
  */
@@ -463,9 +471,11 @@ int get_string_eospace(struct occstr *str, int ndocc, int nactv,
 
 /*
  * occstr2address: compute the string index of given an occupation string.
+ * sg holds the DOCC, ACTV and VIRT addressing graphs of space eosp.
  */
-int occstr2address(struct occstr *str, struct eospace eosp, int ndocc, int nactv,
-                   int nvirt, int nelec, int *elecs);
+int occstr2address(struct occstr *str, struct eospace eosp,
+                   struct strgraph *sg, int ndocc, int nactv,
+                   int nelec, int *elecs);
 
 /*
  * remove_grt_xstr: remove replacements with indices greater than
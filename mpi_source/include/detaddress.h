@@ -0,0 +1,75 @@
+// FILE: detaddress.h
+#ifndef detaddress_h
+#define detaddress_h
+
+struct eospace;
+
+/*
+ * detaddress: implicit determinant list.
+ * Determinants are ordered by (p,q)-space pairing, then p string, then
+ * q string. Block i holds |p,q> for p in peosp[pq[i][0]] and q in
+ * qeosp[pq[i][1]], so |i> = |(block, p offset, q offset)> is found
+ * from the block offsets alone and no (p, q, cas) list is stored.
+ */
+struct detaddress {
+    int npq;       /* number of (p,q)-space pairings */
+    int ndets;     /* number of determinants */
+    int *first;    /* first determinant of each block, [npq + 1] */
+    int *pstart;   /* first p string of each block */
+    int *qstart;   /* first q string of each block */
+    int *qnstr;    /* number of q strings of each block */
+    int *cas;      /* 1 if block has no virtual occupations */
+    int npe;       /* number of alpha electron orbital spaces */
+    int nqe;       /* number of beta  electron orbital spaces */
+    int *pestart;  /* first p string of each alpha space, [npe + 1] */
+    int *qestart;  /* first q string of each beta  space, [nqe + 1] */
+    int *pqblk;    /* block of (p space, q space), -1 if none, [npe][nqe] */
+};
+
+/*
+ * create_detaddress: build the implicit determinant list for the
+ * (p,q)-space pairings pq. Returns NULL on allocation failure.
+ */
+struct detaddress *create_detaddress(int **pq, int npq,
+                                     struct eospace *peosp, int pegrps,
+                                     struct eospace *qeosp, int qegrps);
+
+/*
+ * free_detaddress: deallocate implicit determinant list.
+ */
+void free_detaddress(struct detaddress *da);
+
+/*
+ * detaddress_block: return the (p,q)-space pairing of determinant det.
+ */
+int detaddress_block(struct detaddress *da, int det);
+
+/*
+ * detaddress_index: return the index of determinant |p,q> in block ipq.
+ */
+int detaddress_index(struct detaddress *da, int ipq, int p, int q);
+
+/*
+ * detaddress_lookup: return the index of determinant |p,q>, or -1 if
+ * the (p,q)-space pairing of p and q is not in the expansion.
+ */
+int detaddress_lookup(struct detaddress *da, int p, int q);
+
+/*
+ * detaddress_space: return the electron orbital space of string str,
+ * given the first string of each space, start[nesp + 1].
+ */
+int detaddress_space(int *start, int nesp, int str);
+
+/*
+ * get_det_triple: get (p, q, cas) of determinant det.
+ */
+void get_det_triple(struct detaddress *da, int det, int *trpl);
+
+/*
+ * get_det_triples: get (p, q, cas) of determinants lo, ..., hi.
+ * w1d is a [hi-lo+1][3] array: w1d[3*(i-lo) + k].
+ */
+void get_det_triples(struct detaddress *da, int lo, int hi, int *w1d);
+
+#endif
@@ -3,6 +3,8 @@
 #ifndef dysoncomp_h
 #define dysoncomp_h
 
+struct detaddress;
+
 /*
  * build_ppo_triples: build (p0, p1, o) triples for dyson evaluation.
  */
@@ -21,7 +23,9 @@ int comparestrings_dyson(struct occstr str0, struct occstr str1, int ninto);
  * Input:
  *
  */
-void compute_dyson_orbital_a(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
+void compute_dyson_orbital_a(int v0_hndl, int v1_hndl,
+                             struct detaddress *w0det,
+                             struct detaddress *w1det,
                              struct occstr *pstr0, struct eospace *peosp0, int npe0,
                              struct occstr *qstr0, struct eospace *qeosp0, int nqe0,
                              struct occstr *pstr1, struct eospace *peosp1, int npe1,
@@ -38,7 +42,9 @@ void compute_dyson_orbital_a(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
  * Input:
  *
  */
-void compute_dyson_orbital_b(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
+void compute_dyson_orbital_b(int v0_hndl, int v1_hndl,
+                             struct detaddress *w0det,
+                             struct detaddress *w1det,
                              struct occstr *pstr0, struct eospace *peosp0, int npe0,
                              struct occstr *qstr0, struct eospace *qeosp0, int nqe0,
                              struct occstr *pstr1, struct eospace *peosp1, int npe1,
@@ -50,35 +56,31 @@ void compute_dyson_orbital_b(int v0_hndl, int v1_hndl, int w0_hndl, int w1_hndl,
                              double **dyorb);
 
 /*
- * compute_det_contributions: compute determinant contributions to dyson
- * orbitals.
+ * compute_dyson_contractions: contract the locally owned N+1 electron
+ * determinants with their N electron partners.
  * Input:
- *  w0      = p, q, CAS
- *  v0      = CI vectors
- *  v0_rows = rows of CI vectors
- *  v0_cols = columns of CI vectors
- *  w1      = p, q, CAS
- *  v1      = CI vectors
- *  v1_rows = rows of CI vectors
- *  v1_cols = columns of CI vectors
- *  sp      = spin index (0 = alpha, 1 = beta)
- *  spx     = opposite spin index (1 = beta, 0 = alpha)
- *  str0    = p/q strings
- *  str1    = p/q strings
- *  dyst0   = dyson orbital N+1 electron states
+ *  v0_hndl = GA handle for N+1 electron CI vectors
+ *  v1_hndl = GA handle for N   electron CI vectors
+ *  w0det   = N+1 electron determinant addressing
+ *  w1det   = N   electron determinant addressing
+ *  sp      = spin of annihilated electron (0 = alpha, 1 = beta)
+ *  norbs   = number of orbitals
  *  ndyst0  = number of dyson orbital N+1 electron states
- *  dyst1   = dyson orbital N electron states
+ *  dysnst0 = dyson orbital N+1 electron states
  *  ndyst1  = number of dyson orbital N electron states
- *  ninto   = number of internal orbitals
+ *  dysnst1 = dyson orbital N electron states
+ *  strcont = N electron strings of each N+1 electron string
+ *  orbcont = orbital annihilated for each entry of strcont
+ *  nelec0  = number of N+1 electron sp electrons
  * Output:
- *  dyorb   = dyson orbitals
+ *  dyorb   = dyson orbitals (contributions are added)
  */
-void compute_det_contributions(int **w0, double **v0, int v0_rows, int v0_cols,
-                               int **w1, double **v1, int v1_rows, int v1_cols,
-                               int sp, int spx,
-                               struct occstr *str0, struct occstr *str1,
-                               int *dyst0, int ndyst0, int *dyst1, int ndyst1,
-                               double **dyorb, int ninto);
+void compute_dyson_contractions(int v0_hndl, int v1_hndl,
+                                struct detaddress *w0det,
+                                struct detaddress *w1det, int sp, int norbs,
+                                int ndyst0, int *dysnst0, int ndyst1,
+                                int *dysnst1, int **strcont, int **orbcont,
+                                int nelec0, double **dyorb);
 
 /*
  * generate_strcontlist: generate contribution list for each string.
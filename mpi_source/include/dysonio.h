@@ -10,6 +10,13 @@ void print_dysonorbital_info(int num_dyo, int ndyst0, int ndyst1, int norbs,
 			     int *dyst0, int *dyst1);
 
 
+/*
+ * read_dysonorbital_number: read the number of dyson orbitals and
+ * states from the first line of a dyson orbital file.
+ */
+int read_dysonorbital_number(char *filename, int *num_dyo, int *ndyst0,
+                             int *ndyst1);
+
 /*
  * read_dysonorbital_info: read dyson orbital information
  */
@@ -0,0 +1,148 @@
+// File: hmatbench.h
+/*
+ * Microbenchmarks of the matrix element and excitation primitives.
+ */
+
+#ifndef hmatbench_h
+#define hmatbench_h
+
+#include "binarystr.h"
+#include "citruncate.h"
+#include "benchutil.h"
+
+/* Maximum cases per primitive */
+#define HMATBENCH_NCASE  2048
+
+/* Minimum timed interval per primitive (s) */
+#define HMATBENCH_MINTIME 0.2
+
+/* Relative tolerance of the reference checks */
+#define HMATBENCH_TOL 1.0e-10
+
+/*
+ * struct hmatbench_pair: determinants |i> and |j> = X|i> differing by the
+ * replacements px (alpha) and/or qx (beta).
+ */
+struct hmatbench_pair {
+    int ip, iq;       /* |i> alpha, beta strings */
+    int jp, jq;       /* |j> alpha, beta strings */
+    struct xstr px;   /* alpha replacement */
+    struct xstr qx;   /* beta  replacement */
+};
+
+/*
+ * struct hmatbench_set: cases of one excitation class.
+ */
+struct hmatbench_set {
+    int n;
+    struct hmatbench_pair *c;
+};
+
+/*
+ * struct hmatbench_xcase: input string and target occupation space of an
+ * excitation generator call.
+ */
+struct hmatbench_xcase {
+    int istr;         /* string */
+    int espc;         /* target electron occupation space */
+};
+
+/*
+ * hmatbench_cycles: time stamp counter, 0 if unavailable.
+ */
+unsigned long long int hmatbench_cycles();
+
+/*
+ * hmatbench_build_cases: sample determinants of the expansion and their
+ * single and double replacements into random (p,q) blocks.
+ * Input:
+ *  ci   = expansion
+ * Output:
+ *  s0   = |i> = |j>
+ *  sa1  = alpha single replacements
+ *  sb1  = beta  single replacements
+ *  sa2  = alpha double replacements
+ *  sab  = alpha and beta single replacements
+ *  xa   = alpha excitation generator inputs
+ *  nxa  = number of generator inputs
+ */
+void hmatbench_build_cases(struct benchci *ci, struct hmatbench_set *s0,
+                           struct hmatbench_set *sa1,
+                           struct hmatbench_set *sb1,
+                           struct hmatbench_set *sa2,
+                           struct hmatbench_set *sab,
+                           struct hmatbench_xcase *xa, int *nxa);
+
+/*
+ * hmatbench_make_det: determinant from alpha and beta strings.
+ */
+struct det hmatbench_make_det(struct benchci *ci, int ip, int iq);
+
+/*
+ * hmatbench_eval: evaluate <i|H|j> of a case.
+ * Input:
+ *  ci      = expansion
+ *  p       = case
+ *  xcls    = class: 0 = diagonal, 1 = alpha 1x, 2 = beta 1x, 3 = alpha 2x,
+ *            4 = alpha-beta
+ *  variant = 0: hmatels(), 1: hmatels_0x/1x/2xaa/2xab, 2: slab routines
+ */
+double hmatbench_eval(struct benchci *ci, struct hmatbench_pair *p, int xcls,
+                      int variant);
+
+/*
+ * hmatbench_slater_condon: <i|H|j> of a case evaluated directly from the
+ * Slater-Condon rules on the orbital lists, independent of the CI kernels.
+ */
+double hmatbench_slater_condon(struct benchci *ci, struct hmatbench_pair *p);
+
+/*
+ * hmatbench_hmatels: time hmatels() and the class-specific routines on a
+ * set, and check them against hmatels() and the Slater-Condon rules.
+ * Input:
+ *  ci    = expansion
+ *  s     = cases
+ *  xcls  = class: 0 = diagonal, 1 = alpha 1x, 2 = beta 1x, 3 = alpha 2x,
+ *          4 = alpha-beta
+ * Returns number of cases where a class-specific routine disagrees with
+ * the rules.
+ */
+int hmatbench_hmatels(struct benchci *ci, struct hmatbench_set *s, int xcls);
+
+/*
+ * hmatbench_comparedets: time comparedets_ncas() on a set and check the
+ * number of differences.
+ * Returns number of failed checks.
+ */
+int hmatbench_comparedets(struct benchci *ci, struct hmatbench_set *s,
+                          int ndiff, char *label);
+
+/*
+ * hmatbench_pindex: time pindex_single_rep() and, on CAS replacements,
+ * pindex_single_rep_cas() on alpha single replacements. Both are checked
+ * against the phase of the replacement on the orbital list.
+ * Returns number of failed checks.
+ */
+int hmatbench_pindex(struct benchci *ci, struct hmatbench_set *s);
+
+/*
+ * hmatbench_xgen: time generate_single_excitations() and
+ * generate_double_excitations() on alpha strings.
+ */
+void hmatbench_xgen(struct benchci *ci, struct hmatbench_xcase *xa, int nxa);
+
+/*
+ * hmatbench_print: print ns/call and cycles/call of a timed loop, with the
+ * largest deviation from the reference routine and from the Slater-Condon
+ * rules (number of mismatches for integer results; negative = not
+ * checked).
+ */
+void hmatbench_print(char *label, double sec, unsigned long long int cyc,
+                     long long int ncall, double dref, double drules);
+
+/*
+ * hmatbench_free_set: deallocate a set of cases.
+ */
+void hmatbench_free_set(struct hmatbench_set *s);
+
+#endif
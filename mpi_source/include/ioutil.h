@@ -10,6 +10,7 @@
 #define FLNMSIZE           30
 #define MAX_LINE_SIZE     300
 #define MAX_NAMELIST_SIZE  30
+#define MAX_DYSON_STATES  100 /* maxdyst in readnamelist.f90 */
 
 /* check_for_file
  * --------------
@@ -57,19 +58,41 @@ void print_wavefunction_info(char *wfname, int nelecs, int norbs, int nfrzc,
                              int ndocc, int nactv, int nfrzv, int xlvl,
                              int nstates);
 
+/*
+ * read_nth_int: return the n'th (from 0) integer of a line, or 0.
+ */
+int read_nth_int(char *line, int n);
+
 /*
  * readdysoninput: read &dysonorbital namelist.
  * Input:
- *  maxst = maximum number of states
- *  nst0  = number of anion states
- *  nst1  = number of neutral states
+ *  maxst = maximum number of states (<= MAX_DYSON_STATES)
  * Output:
  *  states0 = states of anion to compute dyson orbitals
  *  states1 = states of neutral to compute dyson orbitals
+ *  nst0    = number of anion states
+ *  nst1    = number of neutral states
+ *  cubes   = write cube files of dyson orbitals (0: no; 1: yes)
+ *  cubepts = cube grid points along longest side
  *  error   = error flag
+ * A first state of -1 means every state of that wavefunction.
  */
 void readdysoninput(int *states0, int *states1, int maxst, int *nst0, int *nst1,
-                    int *error);
+                    int *cubes, int *cubepts, int *error);
+
+/*
+ * readtransmoinput: read &transmo namelist.
+ * Output:
+ *  emin    = lowest photoelectron energy (eV)
+ *  emax    = highest photoelectron energy (eV)
+ *  nenergy = number of photoelectron energies
+ *  ionpot  = ionization energy (eV)
+ *  ntheta  = photoelectron directions in theta
+ *  nphi    = photoelectron directions in phi
+ *  error   = error flag
+ */
+void readtransmoinput(double *emin, double *emax, int *nenergy,
+                      double *ionpot, int *ntheta, int *nphi, int *error);
 
 /*
  * readwf0input: read wavefunction input for anion (0)
@@ -96,6 +119,15 @@ void readwf1input(int *elec,     int *orbs,   int *nfrozen,  int *ndocc,
  *  nmlstr[5] = refdim
  *  nmlstr[6] = restol
  *  nmlstr[7] = buflen
+ *  nmlstr[8] = sigscreen
+ *  nmlstr[9] = spinsym
+ *  nmlstr[10]= precond
+ *  nmlstr[11]= pcshift
+ *  nmlstr[12]= memnode
+ *  nmlstr[13]= numarank
+ *  nmlstr[14]= nthread
+ *  nmlstr[15]= nodeshare
+ *  nmlstr[16]= sigaccum
  *
  * Output:
  *  maxiter = maximum iterations of davidson algorithm
@@ -106,10 +138,36 @@ void readwf1input(int *elec,     int *orbs,   int *nfrozen,  int *ndocc,
  *  refdim  = intitial reference-space dimension (prediagonalization)
  *  restol  = convergence tolerance of residual
  *  buflen  = GA buffer length during Hv=c
+ *  sigscreen = sigma screening factor. Block pairs whose |H|*|v| bound
+ *              is below sigscreen*restol are skipped. 0 disables
+ *              (default). Converged energies stayed within restol of
+ *              the unscreened ones up to 1e4; 1e5 gave a spurious root.
+ *  spinsym = Ms=0 spin-flip symmetry C(p,q) = spinsym*C(q,p):
+ *            1 = even S, -1 = odd S, 0 = off. Only the beta-only
+ *            sigma work is skipped; V and C are stored in full
+ *            (no p>=q half-vector storage).
+ *  precond = correction vector preconditioner: 0 = diagonal,
+ *            1 = shifted diagonal, 2 = Olsen, 3 = block inverse
+ *  pcshift = preconditioner level shift
+ *  memnode = memory per node (MB) for the startup memory check. An
+ *            estimate above it stops the run. 0 = warn only, against
+ *            90% of the physical memory of the node (default)
+ *  numarank= processes per NUMA domain; 0 = no binding (default)
+ *  nthread = threads per process; 0 = OMP_NUM_THREADS, or the CPUs of
+ *            the process when numarank > 0
+ *            numarank and nthread have only been run on a single
+ *            core and NUMA domain; placement is not validated at scale.
+ *  nodeshare = 1: one copy of the strings and integrals per node, in
+ *              MPI-3 shared memory windows; 0 = one copy per process
+ *              (default). Not measured with several processes.
+ *  sigaccum = sigma C(j,k) accumulation over threads: 0 = bins by row
+ *             owner (default), 1 = per-thread copies of C(j,k)
  *  err     = error handling: n = missing variable n */
 void readdaiinput(int *maxiter,  int *krymin, int *krymax, int *nroots,
 		  int *prediagr, int *refdim, double *restol, int *buflen,
-                  int *err);
+                  double *sigscreen, int *spinsym, int *precond,
+                  double *pcshift, int *memnode, int *numarank,
+                  int *nthread, int *nodeshare, int *sigaccum, int *err);
 
 /* readgeninput: read general wavefunction input.
  * -------------------------------------------------------------------
@@ -139,6 +197,16 @@ void readgeninput(int *elec,     int *orbs,   int *nfrozen,  int *ndocc,
 	          int *nactive,  int *xlevel, int *nfrzvirt, int *printlvl,
                   int *printwvf, int *err);
 
+/* readmocoeffs: subroutine to read molecular coefficient file.
+ * -------------------------------------------------------------------
+ * Calls fortran subroutine readmocoef()
+ *
+ * Input:
+ *  clen = length of c
+ * Output:
+ *  c    = orbital coefficients, [nmo][nbf] */
+void readmocoeffs(double *c, int clen);
+
 /* readmointegrals: Subroutine to read 1 and 2 electron integrals.
  * -------------------------------------------------------------------
  * Calls fortran subroutine readmoints()
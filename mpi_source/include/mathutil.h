@@ -10,6 +10,7 @@
  * dot_product:         computes dot product of two vectors.
  * gauss_fcn:           gaussian function evaluated at x.
  * matmul_dgemm:        matrix multiplication with dgemm.  
+ * matmul_dgemm_tn:     matrix multiplication C = A^T B + beta C with dgemm.
  * orthonormalize_vector: orthonormalize a vector to a space.
  */
 #ifndef mathutil_h
@@ -72,6 +73,22 @@ int matmul_dgemm(
     int col_c
     );
 
+/*
+ * matmul_dgemm_tn: C = A^T B + beta C via DGEMM (column-major).
+ */
+int matmul_dgemm_tn(
+    double *mata,
+    int lda,
+    double *matb,
+    int ldb,
+    int m,
+    int n,
+    int k,
+    double beta,
+    double *matc,
+    int ldc
+    );
+
 /*
  * orthonormalize_vector: orthogonalize and normalize new vector to space
  * of basis vectors.
@@ -0,0 +1,156 @@
+// File: memsize.h
+/*
+ * Memory sizing for pjayci. The memory of the string lists, integrals,
+ * global arrays and per-thread scratch is computed from the expansion
+ * before any of it is allocated, so that a calculation that cannot fit
+ * is reported at startup instead of being killed mid-run.
+ */
+
+#ifndef memsize_h
+#define memsize_h
+
+#include "citruncate.h"
+
+/* Components (bytes per process; MS_STRINGS, MS_INTEGRALS and MS_SETUP
+ * per node when the strings and integrals are node-shared) */
+#define MS_STRINGS    0   /* Alpha/beta occupation strings */
+#define MS_SPACES     1   /* Electron spaces, (p,q) pairs, determinant map */
+#define MS_INTEGRALS  2   /* 1-e and 2-e integrals */
+#define MS_MOSLAB     3   /* Per-pair integral slabs */
+#define MS_GA_VC      4   /* Local patch of V and C (GLOBAL) */
+#define MS_GA_1D      5   /* Local patch of N, R, X and D (GLOBAL) */
+#define MS_DAVIDSON   6   /* <i|H|i>, v.Hv, eigenvectors, preconditioner */
+#define MS_SIGMA      7   /* Hv=c local C, V(i), V(j)/C(j) buffers */
+#define MS_SCRATCH    8   /* Per-thread sigma scratch */
+#define MS_SETUP      9   /* citrunc() string lists (transient) */
+#define MS_ROOT      10   /* Guess/preconditioner build on root (transient) */
+#define MS_NCOMP     11
+
+/* Usable fraction of node memory when &dalginfo memnode = 0 */
+#define MEMSIZE_PHYSFRAC 0.90
+
+/* Largest krymax considered for the recommendation */
+#define MEMSIZE_MAXKRY 100
+
+/*
+ * struct memsize: expansion and run parameters, and the memory estimate
+ * for them.
+ */
+struct memsize {
+    long long int ndets;  /* Determinants */
+    int pstr_len;         /* Alpha strings */
+    int qstr_len;         /* Beta  strings */
+    int pegrps;           /* Alpha electron spaces */
+    int qegrps;           /* Beta  electron spaces */
+    int npq;              /* (p,q) space pairs */
+    long long int maxblk; /* Largest (p,q) block */
+    int xlistmax;         /* Largest electron space */
+    int aelec;            /* CI alpha electrons */
+    int belec;            /* CI beta  electrons */
+    int ci_orbs;          /* CI orbitals */
+    int orbitals;         /* Orbitals of the integral file */
+    int krymin;
+    int krymax;
+    int refdim;
+    int prediagr;
+    int precond;
+    int nproc;            /* Processes */
+    int nthrd;            /* Threads per process */
+    int nodeshare;        /* Strings and integrals shared by a node */
+    int sigaccum;         /* Sigma C(j,k) accumulation, SIGACC_* */
+    double comp[MS_NCOMP];/* Components, bytes */
+    double proc;          /* Peak per process, bytes */
+    double shared;        /* Shared by the processes of a node, bytes */
+    double setup;         /* Peak of one citrunc() call, bytes */
+    double root;          /* Additional peak on root, bytes */
+};
+
+/*
+ * memsize_count_strings: set the number of strings of each electron
+ * space. This is what generate_string_list() sets, without generating
+ * the strings.
+ * Input:
+ *  eosp  = electron spaces
+ *  ngrps = number of electron spaces
+ *  orbs  = CI orbitals
+ *  elecs = CI electrons
+ *  ndocc = DOCC orbitals
+ *  nactv = ACTV orbitals
+ */
+void memsize_count_strings(struct eospace *eosp, int ngrps, int orbs,
+                           int elecs, int ndocc, int nactv);
+
+/*
+ * memsize_init: set the expansion of the estimate. Electron space
+ * string counts must be set and the (p,q) pairs computed.
+ * Input:
+ *  peosp  = alpha electron spaces
+ *  pegrps = number of alpha electron spaces
+ *  qeosp  = beta  electron spaces
+ *  qegrps = number of beta  electron spaces
+ *  pq     = (p,q) space pairs
+ *  npq    = number of (p,q) space pairs
+ *  aelec  = CI alpha electrons
+ *  belec  = CI beta  electrons
+ *  ci_orbs  = CI orbitals
+ *  orbitals = orbitals of the integral file
+ * Output:
+ *  ms = estimate (run parameters are set by memsize_estimate())
+ */
+void memsize_init(struct memsize *ms, struct eospace *peosp, int pegrps,
+                  struct eospace *qeosp, int qegrps, int **pq, int npq,
+                  int aelec, int belec, int ci_orbs, int orbitals);
+
+/*
+ * memsize_estimate: compute the memory per process of a run.
+ * Input:
+ *  ms       = estimate from memsize_init()
+ *  nproc    = processes
+ *  nthrd    = threads per process
+ *  krymin   = minimum Krylov space dimension
+ *  krymax   = maximum Krylov space dimension
+ *  refdim   = reference space dimension
+ *  prediagr = initial guess routine
+ *  precond  = preconditioner
+ *  nodeshare = 1 if the strings and integrals are held once per node
+ *  sigaccum  = sigma C(j,k) accumulation, SIGACC_*
+ * Output:
+ *  ms = comp, proc, shared, setup and root set
+ */
+void memsize_estimate(struct memsize *ms, int nproc, int nthrd, int krymin,
+                      int krymax, int refdim, int prediagr, int precond,
+                      int nodeshare, int sigaccum);
+
+/*
+ * memsize_node: peak memory of a node with rpn processes, bytes.
+ */
+double memsize_node(struct memsize *ms, int rpn);
+
+/*
+ * memsize_node_layout: number of nodes and largest number of processes
+ * on a node (processes sharing memory), and the smallest physical
+ * memory of a node in MB. This is executed on all processes after
+ * set_mpi_node_comm().
+ */
+void memsize_node_layout(int *nnodes, int *rpn, double *physmb);
+
+/*
+ * memsize_check: print the estimate of a run and recommendations of
+ * ga_buffer_len, processes per node and krymax for the memory available
+ * per node. This is executed on all processes.
+ * Input:
+ *  ms      = estimate from memsize_estimate()
+ *  memnode = memory per node (MB); 0 = MEMSIZE_PHYSFRAC of physical memory
+ *  buflen  = ga_buffer_len input
+ * Returns 1 if the determinants exceed INT_MAX, or if memnode > 0 and
+ * the estimate exceeds it; 0 otherwise. With memnode = 0 an estimate
+ * above physical memory only prints a warning.
+ */
+int memsize_check(struct memsize *ms, int memnode, int buflen);
+
+/*
+ * memsize_print: print the components of an estimate.
+ */
+void memsize_print(struct memsize *ms);
+
+#endif
@@ -0,0 +1,35 @@
+// FILE: moslab.h
+#ifndef moslab_h
+#define moslab_h
+
+/*
+ * moslab: per-pair integral slabs for the sigma kernels.
+ * Row ij = index1e(i,j)-1 holds 2*norb contiguous values:
+ *  [0,norb)      (kk|ij) - (ki|kj), k = 1, ..., norb  (same-spin)
+ *  [norb,2*norb) (kk|ij),           k = 1, ..., norb  (opposite-spin)
+ * Rows are in index1e order, so all internal-internal pairs form the
+ * leading ntri(intorb) rows of the store.
+ */
+struct moslab {
+    int norb;      /* number of orbitals in slab rows */
+    int npair;     /* number of (ij) pairs: index1e(norb, norb) */
+    double *data;  /* slab data [npair][2*norb] */
+};
+
+/*
+ * build_moslab: build per-pair integral slabs from lower-triangular
+ * 2-e integrals.
+ */
+int build_moslab(double *m2, int norb, struct moslab *mslab);
+
+/*
+ * free_moslab: deallocate per-pair integral slabs.
+ */
+void free_moslab(struct moslab *mslab);
+
+/*
+ * moslab_size_mb: return the size of the slab store in MB.
+ */
+double moslab_size_mb(int norb);
+
+#endif
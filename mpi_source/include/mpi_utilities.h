@@ -8,9 +8,18 @@
 #ifndef mpi_utilities_h
 #define mpi_utilities_h
 
+#include <mpi.h>
+
 int mpi_num_procs;          /* MPI: Number of mpi processes */
 int mpi_proc_rank;          /* MPI: Processor rank */
 
+MPI_Comm mpi_node_comm;     /* MPI: Processes sharing memory (node) */
+MPI_Comm mpi_lead_comm;     /* MPI: First process of each node, else
+                             * MPI_COMM_NULL */
+int mpi_node_procs;         /* MPI: Number of processes on this node */
+int mpi_node_rank;          /* MPI: Rank on this node */
+int mpi_num_nodes;          /* MPI: Number of nodes */
+
 extern const int mpi_root;  /* MPI: Root process is always 0. */
 
 /*
@@ -28,6 +37,30 @@ void mpi_end_program ();
  */
 void mpi_error_check_msg (int error, char *fcn_name, char *message);
 
+/*
+ * mpi_node_shared_alloc: allocate memory shared by the processes of a
+ * node. The first process of the node holds all of it. Collective over
+ * mpi_node_comm.
+ * Input:
+ *  size = bytes
+ * Output:
+ *  win  = shared memory window
+ * Returns pointer to the shared memory, NULL on failure.
+ */
+void *mpi_node_shared_alloc (long long int size, MPI_Win *win);
+
+/*
+ * mpi_node_shared_free: free memory from mpi_node_shared_alloc.
+ * Collective over mpi_node_comm.
+ */
+void mpi_node_shared_free (MPI_Win *win);
+
+/*
+ * mpi_node_shared_sync: make writes to node shared memory visible to
+ * all processes of the node. Collective over mpi_node_comm.
+ */
+void mpi_node_shared_sync (MPI_Win win);
+
 /*
  * mpi_split_work_array_1d: get first and last elements for partitioning
  * a 1d array amongst work processes.
@@ -111,4 +144,11 @@ void set_mpi_process_number_and_rank ();
  */
 void set_ga_process_number_and_rank ();
 
+/*
+ * set_mpi_node_comm: set global variables $mpi_node_comm, $mpi_lead_comm,
+ * $mpi_node_procs, $mpi_node_rank and $mpi_num_nodes. Processes of a
+ * node are those that can share memory.
+ */
+void set_mpi_node_comm ();
+
 #endif
@@ -3,22 +3,125 @@
 #ifndef pdavidson_h
 #define pdavidson_h
 
+struct detaddress;
+
+/* Rows |i> per thread between C(j,k) reductions in compute_hij_eosp */
+#define SIGMA_ROWBLK 64
+
+/* C(j,k) accumulation in compute_hij_eosp (&dalginfo sigaccum). */
+#define SIGACC_BINS   0  /* bins by row owner, reduced every SIGMA_ROWBLK */
+#define SIGACC_COPIES 1  /* per-thread copies of C(j,k), reduced per block */
+
+/*
+ * cj_entry: contribution C(j,k) += <i|H|j>V(i,k), k = 0, ..., vcols-1.
+ */
+struct cj_entry {
+    int j;      /* |j> index in the C(j,k) buffer */
+    int i;      /* |i> row of V(i,k) */
+    double hij; /* <i|H|j> */
+};
+
+/*
+ * cj_scatter: one thread's C(j,k) contributions, binned by the thread
+ * that owns row j of the C(j,k) buffer. Each thread sums its own rows
+ * from every thread's bin, so C(j,k) is written by one thread only.
+ * With SIGACC_COPIES the contributions are instead added to cjk, this
+ * thread's copy of C(j,k), and the owners sum the copies.
+ */
+struct cj_scatter {
+    int nbin;             /* bins (threads) */
+    int jrows;            /* rows j of the C(j,k) buffer */
+    int *n;               /* entries per bin */
+    int *nmax;            /* allocated entries per bin */
+    struct cj_entry **e;  /* entries per bin */
+    double *cjk;          /* copy of C(j,k) (SIGACC_COPIES), else NULL */
+    double *vik;          /* V(i,k) of the current block (SIGACC_COPIES) */
+    int vcols;            /* columns k */
+    int error;            /* allocation failure */
+};
+
+/*
+ * sigma_scratch: per-thread scratch arrays for compute_hij_eosp. One of
+ * these is allocated for each OpenMP thread, sized once from the largest
+ * blocks of the expansion, and reused for every block of every Hv=c.
+ */
+struct sigma_scratch {
+    struct xstr *pxlist;  /* alpha replacement list */
+    struct xstr *qxlist;  /* beta  replacement list */
+    struct xstr *xstrscr; /* replacement list scratch */
+    int *elecx;           /* electron scratch */
+    int *orbsx;           /* orbital scratch */
+    int *jindx;           /* |j> buffer indices */
+    double *cik;          /* c(i,k) */
+    double *hijval;       /* <i|H|j> values */
+    struct cj_scatter cjs;/* C(j,k) contributions */
+};
+
+/* Correction vector preconditioners (&dalginfo precond). */
+#define PRECOND_DIAG  0       /* -r(i)/(H(i,i) - E) */
+#define PRECOND_SHIFT 1       /* shifted diagonal with denominator floor */
+#define PRECOND_OLSEN 2       /* Olsen's correction */
+#define PRECOND_BLOCK 3       /* exact inverse on lowest-H(i,i) block */
+#define PRECOND_FLOOR 1.0e-4  /* smallest |H(i,i) - E + shift| */
+
+/*
+ * precond: correction vector preconditioner. The block arrays are
+ * replicated on every process.
+ */
+struct precond {
+    int type;             /* preconditioner, PRECOND_* */
+    double shift;         /* level shift of H(i,i) - E */
+    int dim;              /* dimension of exact-inverse block */
+    int *bidx;            /* block determinant indices */
+    double *bvec;         /* eigenvectors of H(P,P), bvec[k*dim + j] */
+    double *bval;         /* eigenvalues of H(P,P) */
+    double *bscr;         /* block scratch */
+};
+
 /*
  * pdavidson: parallel implementation of davidson algorithm.
  */
 int pdavidson (struct occstr *pstrings, struct eospace *peospace, int pegrps,
                struct occstr *qstrings, struct eospace *qeospace, int qegrps,
                int **pq_space_pairs, int num_pq, double *moints1, double *moints2,
+               struct moslab *mslab,
                int aelec, int belec, int intorb, int ndets, double nucrep_e,
                double frzcore_e, int printlvl, int maxiter, int krymin,
                int krymax, int nroots, int prediagr, int refdim, double restol,
-               int ga_buffer_len, int nmos, int ndocc, int nactv);
+               double sigscreen, int spinsym, int ga_buffer_len, int nmos,
+               int ndocc, int nactv, int precond, double pcshift,
+               int sigaccum);
 
 /*
  * add_new_vector: add a new vector to basis space.
  */
 void add_new_vector(int v_hndl, int cdim, int len, int n_hndl);
 
+/*
+ * allocate_sigma_scratch: allocate per-thread scratch arrays for the
+ * sigma kernels.
+ * Input:
+ *  nthrd  = number of threads
+ *  peosp  = alpha electron occupation spaces
+ *  pegrps = number of alpha electron occupation spaces
+ *  qeosp  = beta  electron occupation spaces
+ *  qegrps = number of beta  electron occupation spaces
+ *  pq     = valid (p,q) space pairings
+ *  npq    = number of valid (p,q) space pairings
+ *  mdim   = maximum number of vectors in a Hv=c product
+ *  aelec  = alpha electrons
+ *  belec  = beta  electrons
+ *  nmos   = number of CI orbitals
+ *  sigaccum = C(j,k) accumulation, SIGACC_BINS or SIGACC_COPIES
+ * Returns:
+ *  scr = array of nthrd scratch structures (NULL on failure)
+ */
+struct sigma_scratch *allocate_sigma_scratch(int nthrd, struct eospace *peosp,
+                                             int pegrps, struct eospace *qeosp,
+                                             int qegrps, int **pq, int npq,
+                                             int mdim, int aelec, int belec,
+                                             int nmos, int sigaccum);
+
 
 /*
  * build_init_guess_vectors: build initial guess basis vectors for davidson
@@ -35,7 +138,8 @@ void build_init_guess_vectors(int n, int v, int dim, int kmin, int ndets,
                               int pegrps, struct occstr *qstr,
                               struct eospace *qeosp, int qegrps,
                               int **pqs, int num_pq, double *m1, double *m2,
-                              int aelec, int belec, int intorb, int w);
+                              int aelec, int belec, int intorb,
+                              struct detaddress *wdet);
 
 /*
  * compute_cblock_H: compute values for a block from the vectors, C.
@@ -44,7 +148,7 @@ void build_init_guess_vectors(int n, int v, int dim, int kmin, int ndets,
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -66,7 +170,8 @@ void build_init_guess_vectors(int n, int v, int dim, int kmin, int ndets,
  *  ndocc  = DOCC orbitals
  *  nactv  = active orbitals
  */
-void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_H(double **c, int ccols, int crows, int **wi,
+                      struct detaddress *wdet,
                       int v_hndl, int d_hndl, int buflen, struct occstr *pstr,
                       struct eospace *peosp, int pegrps,  struct occstr *qstr,
                       struct eospace *qeosp, int qegrps, int **pq, int npq,
@@ -80,7 +185,7 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -100,7 +205,8 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
  *  ndets  = total number of determinants
  *  nmos   = total number of molecular orbitals
  */
-void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi,
+                          struct detaddress *wdet,
                           int v_hndl, int d_hndl, int buflen,struct occstr *pstr,
                           struct eospace *peosp, int pegrps, struct occstr *qstr,
                           struct eospace *qeosp, int qegrps, int **pq, int npq,
@@ -115,7 +221,7 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -135,7 +241,8 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
  *  ndets  = total number of determinants
  *  nmos   = total number of molecular orbitals
  */
-void compute_cblock_Hfaster(double *c, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_Hfaster(double *c, int ccols, int crows, int **wi,
+                            struct detaddress *wdet,
                           int v_hndl, int d_hndl, int buflen,struct occstr *pstr,
                           struct eospace *peosp, int pegrps, struct occstr *qstr,
                           struct eospace *qeosp, int qegrps, int **pq, int npq,
@@ -155,7 +262,7 @@ void compute_cblock_Hfaster(double *c, int ccols, int crows, int **wi, int w_hnd
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -169,6 +276,7 @@ void compute_cblock_Hfaster(double *c, int ccols, int crows, int **wi, int w_hnd
  *  npq    = number of valid elec-occupation spaces of expansion
  *  m1     = 1-e integrals
  *  m2     = 2-e integrals
+ *  mslab  = per-pair integral slabs
  *  aelec  = alpha electrons
  *  belec  = beta  electrons
  *  intorb = internal orbitals (DOCC + ACTV)
@@ -180,14 +288,49 @@ void compute_cblock_Hfaster(double *c, int ccols, int crows, int **wi, int w_hnd
  *  cstep  = first row index in block
  *  cmax   = last  row index in block
  *  colnums= indices of C_i to evaluate Hv_i=c_i 
+ *  scr    = per-thread sigma scratch arrays
+ *  vtol   = |v| screening threshold (0 = off)
+ *  spinsym= Ms=0 spin-flip symmetry of v (1, -1; 0 = off)
  */
-void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi,
+                             struct detaddress *wdet,
                              int v_hndl, int d_hndl, int buflen,struct occstr *pstr,
                              struct eospace *peosp, int pegrps, struct occstr *qstr,
                              struct eospace *qeosp, int qegrps, int **pq, int npq,
-                             double *m1, double *m2, int aelec,int belec,int intorb,
+                             double *m1, double *m2, struct moslab *mslab,
+                             int aelec,int belec,int intorb,
                              int ndets, int nmos, int ndocc, int nactv, int c_hndl,
-                             int cstep, int cmax, int *colnums);
+                             int cstep, int cmax, int *colnums,
+                             struct sigma_scratch *scr, double vtol,
+                             int spinsym);
+
+/*
+ * cj_scatter_add: bin C(j,k) contributions of row |i> by owner of j, or
+ * add them to this thread's copy of C(j,k) (SIGACC_COPIES).
+ * Input:
+ *  cjs    = this thread's contributions
+ *  irow   = row of |i> in V(i,k)
+ *  jindx  = |j> indices in the C(j,k) buffer
+ *  hijval = <i|H|j> values, indexed by jindx
+ *  n      = number of |j>
+ */
+void cj_scatter_add(struct cj_scatter *cjs, int irow, int *jindx,
+                    double *hijval, int n);
+
+/*
+ * cj_scatter_reduce: add all threads' contributions to the rows of
+ * C(j,k) owned by thread owner, and empty those bins (or zero those
+ * rows of the copies).
+ * Input:
+ *  scr   = per-thread sigma scratch
+ *  owner = thread
+ *  vik   = V(i,k), [i][k]
+ *  vcols = number of columns k
+ * Output:
+ *  cj    = C(j,k), [k][j]
+ */
+void cj_scatter_reduce(struct sigma_scratch *scr, int owner, double *vik,
+                       int vcols, double *cj);
 
 /*
  * compute_cimat_chunks: compute chunksize of bounds of H for evaluation.
@@ -242,14 +385,15 @@ void compute_diagonal_matrix_elements(double *hdgls, int start, int final,
  *  final   = final determinant index
  *  mo1     = 1-e integrals
  *  mo2     = 2-e integrals
+ *  mslab   = per-pair integral slabs
  *  aelec   = CI alpha electrons
  *  belec   = CI beta  electrons
  *  intorb  = internal orbitals (DOCC + CAS)
- *  w_hndl  = global array handle for wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  */
 void compute_diagonal_iHi(double *hdgls, int start, int final,
-			  double *mo1, double *mo2, int aelec,
-			  int belec, int intorb, int w_hndl,
+			  double *mo1, double *mo2, struct moslab *mslab,
+			  int aelec, int belec, int intorb, struct detaddress *wdet,
 			  struct occstr *pstr, struct occstr *qstr);
 
 
@@ -264,7 +408,8 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
                           struct eospace *peosp, int pegrps, struct occstr *qstr,
                           struct eospace *qeosp, int qegrps, int **pqs,
                           int num_pq, double *m1, double *m2, int aelec,
-                          int belec, int intorb, int ndets, int kmax, int w_hndl,
+                          int belec, int intorb, int ndets, int kmax,
+                          struct detaddress *wdet,
                           int ga_buffer_len);
 
 /*
@@ -273,15 +418,22 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
  *  v_hndl = GA handle for basis vectors (ckdim is new vector)
  *  c_hndl = GA handle for Hv=c vectors
  *  ckdim  = current dimension of space
- *  w_hndl = wavefunction list (deteriminant triplets)
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ *  scr    = per-thread sigma scratch arrays
+ *  vtol   = |v| screening threshold (0 = off)
+ *  spinsym= Ms=0 spin-flip symmetry of v (1, -1; 0 = off)
  */
 void compute_hv_newvectorfaster(struct occstr *pstr, struct eospace *peosp, int pegrps,
                                 struct occstr *qstr, struct eospace *qeosp, int qegrps,
                                 int **pqs, int num_pq, double *m1, double *m2,
+                                struct moslab *mslab,
                                 int aelec, int belec, int intorb, int ndets,
                                 double core_e, int ckdim, int mdim, int v_hndl,
-                                int d_hndl, int c_hndl, int w_hndl, int ga_buffer_len,
-                                int nmo, int ndocc, int nactv);
+                                int d_hndl, int c_hndl,
+                                struct detaddress *wdet, int ga_buffer_len,
+                                int nmo, int ndocc, int nactv,
+                                struct sigma_scratch *scr, double vtol,
+                                int spinsym);
 
 /*
  * compute_hij_eosp: compute hij for an electron-occupation space.
@@ -291,12 +443,91 @@ void compute_hv_newvectorfaster(struct occstr *pstr, struct eospace *peosp, int
 void compute_hij_eosp(double *ci, int ccols, int crows, int **wi,
                       struct occstr *pstr, struct eospace *peosp, int pegrps,
                       struct occstr *qstr, struct eospace *qeosp, int qegrps,
-                      int **pq, int npq, double *m1, double *m2, int aelec,
-                      int belec, int intorb,
+                      int **pq, int npq, double *m1, double *m2,
+                      struct moslab *mslab, int aelec, int belec, int intorb,
                       int nmos, int ndocc, int nactv, int cstep, int *cnums,
                       int jstart, int jmax, int jstartp, int jstartq,
                       int jfinalp, int jfinalq, int *jpair, double *vj,
-                      double *vi, double *cj, int jpq);
+                      double *vik, double *cj, int jpq,
+                      struct sigma_scratch *scr, double *vmax, int *pqdet,
+                      double vtol, long long int *nskip, int spinsym);
+
+/*
+ * compute_hij_bound: compute an upper bound on |<i|H|j>| for i != j.
+ * Input:
+ *  m1    = 1-e integrals
+ *  m2    = 2-e integrals
+ *  nmos  = number of molecular orbitals
+ *  aelec = alpha electrons
+ *  belec = beta  electrons
+ */
+double compute_hij_bound(double *m1, double *m2, int nmos, int aelec,
+                         int belec);
+
+/*
+ * compute_pqblock_vmax: compute max|v(i,k)| over each pq block of
+ * determinants for columns k = klo, ..., khi.
+ * Input:
+ *  v_hndl = GA handle for basis vectors V
+ *  klo    = first column k
+ *  khi    = last  column k
+ *  pq     = alpha/beta eospace pairings
+ *  npq    = number of pairings
+ * Output:
+ *  pqdet  = first determinant of each pq block; pqdet[npq] = ndets
+ *  vmax   = max|v| for each pq block
+ */
+void compute_pqblock_vmax(int v_hndl, int klo, int khi, int **pq, int npq,
+                          struct eospace *peosp, int pegrps,
+                          struct eospace *qeosp, int qegrps, int *pqdet,
+                          double *vmax);
+
+/*
+ * get_pqblock_of_det: return the pq block containing determinant det.
+ * Input:
+ *  det   = determinant index
+ *  pqdet = first determinant of each pq block; pqdet[npq] = ndets
+ *  npq   = number of pq blocks
+ */
+int get_pqblock_of_det(int det, int *pqdet, int npq);
+
+/*
+ * apply_spinflip_ga: combine a global array with its spin-flipped image,
+ *  G(k,i) = alpha*G(k,i) + beta*G(k,T(i)),  T|p,q> = |q,p>,
+ * for columns k = klo, ..., khi. For a 1-D array klo and khi are ignored.
+ * Requires identical alpha and beta strings (Ms = 0).
+ * Input:
+ *  g_hndl = GA handle ([cols, rows] or [rows])
+ *  klo    = first column
+ *  khi    = last  column
+ *  alpha  = factor on G(k,i)
+ *  beta   = factor on G(k,T(i))
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ */
+void apply_spinflip_ga(int g_hndl, int klo, int khi, double alpha,
+                       double beta,
+                       struct detaddress *wdet, struct occstr *pstr,
+                       struct eospace *peosp, int pegrps, struct occstr *qstr,
+                       struct eospace *qeosp, int qegrps, int **pq, int npq,
+                       int ndocc, int nactv);
+
+/*
+ * project_spinflip_basis: project basis vectors v_k, k = 0, ..., nvecs-1,
+ * onto the spin-flip symmetry spinsym and reorthonormalize them.
+ * Input:
+ *  v_hndl  = GA handle for basis vectors V
+ *  n_hndl  = GA handle for 1-D scratch vector
+ *  nvecs   = number of basis vectors
+ *  ndets   = number of determinants
+ *  spinsym = spin-flip symmetry (1, -1)
+ */
+void project_spinflip_basis(int v_hndl, int n_hndl, int nvecs, int ndets,
+                            int spinsym,
+                            struct detaddress *wdet, struct occstr *pstr,
+                            struct eospace *peosp, int pegrps,
+                            struct occstr *qstr, struct eospace *qeosp,
+                            int qegrps, int **pq, int npq, int ndocc,
+                            int nactv);
 
 /*
  * compute_hvc_diagonal_ga: compute <i|H|i>*v(i,j)=c(i,j) using global arrays.
@@ -326,7 +557,7 @@ void compute_hvc_diagonal_ga(int c_hndl, int v_hndl, int d_hndl, int start,
  *  dim   = number of basis vectors
  *  mdim  = maximum size of krylov space
  *  v_hndl= (GLOBAL ARRAY HANDLE) basis vectors
- *  w_hndl= (GLOBAL ARRAY HANDLE) wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  * Output:
  *  c_hndl= (GLOBAL ARRAY HANDLE) Hv=c vectors
  */
@@ -335,7 +566,8 @@ void compute_hvnewvecfast(struct occstr *pstr, struct eospace *peosp, int pegrps
                           int **pqs, int num_pq, double *m1, double *m2,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl,
-                          int c_hndl, int w_hndl, int d_hndl, int ga_buffer_len,
+                          int c_hndl,
+                          struct detaddress *wdet, int d_hndl, int ga_buffer_len,
                           int nmo, int ndocc, int nactv);
 
 /*
@@ -343,6 +575,17 @@ void compute_hvnewvecfast(struct occstr *pstr, struct eospace *peosp, int pegrps
  */
 void compute_GA_norm (int r_hndl,  double *norm);
 
+/*
+ * deallocate_sigma_scratch: free per-thread scratch arrays for the sigma
+ * kernels.
+ */
+void deallocate_sigma_scratch(struct sigma_scratch *scr, int nthrd);
+
+/*
+ * free_precond: deallocate preconditioner arrays.
+ */
+void free_precond(struct precond *pc);
+
 /*
  * determinant_string_info: compute string information given
  * a determinant.
@@ -520,7 +763,8 @@ void evaluate_hij_pxlist1x(struct det deti, struct xstr *pxlist, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl);
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl);
 /*
  * evaluate_hij_pxlist1x_ut: evaluate hij for single replacements in alpha
  * strings. Only upper triangle is computed.
@@ -533,7 +777,8 @@ void evaluate_hij_pxlist1x_ut(struct det deti, struct xstr *pxlist, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums);
 
@@ -556,6 +801,7 @@ void evaluate_hij_pxlist1x_ut(struct det deti, struct xstr *pxlist, int npx,
  *  npq    = number of p,q space pairings
  *  m1     = 1-e integrals
  *  m2     = 2-e integrals
+ *  mslab  = per-pair integral slabs
  *  aelec  = alpha electrons
  *  belec  = beta  electrons
  *  intorb = internal orbitals
@@ -564,8 +810,8 @@ void evaluate_hij_pxlist1x_ut(struct det deti, struct xstr *pxlist, int npx,
  *  jstep  = index in wavefunction of first determinant in this buffer j
  *  cik    = C(i,k)
  *  vjk    = V(j,k)
- *  vik    = V(i,k)
- *  cjk    = C(j,k)
+ *  irow   = row of |i> in V(i,k)
+ *  cjs    = this thread's C(j,k) contributions
  *  hijval = <i|H|j> values
  *  jindx  = array for determinant indices
  *  jpq    = pq[i] index of p,q
@@ -574,10 +820,12 @@ void evaluate_hij_pxlist1x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                int qindx, int nqx,
                                struct occstr *pstr, struct eospace *peosp, int npe,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
-                               int **pq, int npq, double *m1, double *m2, int aelec,
-                               int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq);
+                               int **pq, int npq, double *m1, double *m2,
+                               struct moslab *mslab, int aelec, int belec,
+                               int intorb, int vrows, int vcols,
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq);
 
 /*
  * evaluate_hij_pxlist2x: evaluate hij for double replacements in alpha strings.
@@ -590,7 +838,8 @@ void evaluate_hij_pxlist2x(struct det deti, struct xstr *pxlist, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl);
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl);
 
 /*
  * evaluate_hij_pxlist2x_ut: evaluate hij for double replacements in alpha
@@ -604,7 +853,8 @@ void evaluate_hij_pxlist2x_ut(struct det deti, struct xstr *pxlist, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums);
 
@@ -620,7 +870,8 @@ void evaluate_hij_pxqxlist2x(struct det deti, struct xstr *pxlist, int npx,
                              int aelec, int belec, int intorb, double *c,
                              int vrows, int vcols, int **vindx, int **windx,
                              int *jindx, double **v, double *v1d, int **w,
-                             int *w1d, double *hijval, int w_hndl, int v_hndl);
+                             int *w1d, double *hijval,
+                             struct detaddress *wdet, int v_hndl);
 
 /*
  * evaluate_hij_pxqxlist2x_ut: evaluate hij for single replacements in alpha
@@ -634,7 +885,8 @@ void evaluate_hij_pxqxlist2x_ut(struct det deti, struct xstr *pxlist, int npx,
                                 int aelec, int belec, int intorb, double *c,
                                 int vrows, int vcols, int **vindx, int **windx,
                                 int *jindx, double **v, double *v1d, int **w,
-                                int *w1d, double *hijval, int w_hndl, int v_hndl,
+                                int *w1d, double *hijval,
+                                struct detaddress *wdet, int v_hndl,
                                 int c_hndl, int cindx, double *vik, double *cjk,
                                 int **vx2, int *cnums);
 
@@ -648,12 +900,13 @@ void evaluate_hij_pxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
                                int **pq, int npq, double *m1, double *m2, int aelec,
                                int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq);
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq);
 
 /*
  * evaluate_hij_pxqxlist2x_ut2: evaluate hij for single replacements in alpha
- * and beta strings. Upper triangle only.
+ * and beta strings. Upper triangle only. Each hij is scaled by hfac.
  */
 void evaluate_hij_pxqxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                  struct xstr *qxlist, int nqx,
@@ -661,8 +914,10 @@ void evaluate_hij_pxqxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                  struct occstr *qstr, struct eospace *qeosp, int nqe,
                                  int **pq, int npq, double *m1, double *m2, int aelec,
                                  int belec, int intorb, int vrows, int vcols,
-                                 int jstep, double *cik, double *vjk, double *vik,
-                                 double *cjk, double *hijval, int *jindx, int jpq);
+                                 int jstep, double *cik, double *vjk, int irow,
+                                 struct cj_scatter *cjs, double *hijval,
+                                 int *jindx, int jpq,
+                                 double hfac);
 /*
  * evaluate_hij_qxlist1x: evaluate hij for single replacements in alpha strings.
  */
@@ -674,7 +929,8 @@ void evaluate_hij_qxlist1x(struct det deti, int pindx, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl);
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl);
 
 /*
  * evaluate_hij_qxlist1x_ut: evaluate hij for single replacements in alpha
@@ -688,7 +944,8 @@ void evaluate_hij_qxlist1x_ut(struct det deti, int pindx, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums);
 
@@ -711,6 +968,7 @@ void evaluate_hij_qxlist1x_ut(struct det deti, int pindx, int npx,
  *  npq    = number of p,q space pairings
  *  m1     = 1-e integrals
  *  m2     = 2-e integrals
+ *  mslab  = per-pair integral slabs
  *  aelec  = alpha electrons
  *  belec  = beta  electrons
  *  intorb = internal orbitals
@@ -719,8 +977,8 @@ void evaluate_hij_qxlist1x_ut(struct det deti, int pindx, int npx,
  *  jstep  = index in wavefunction of first determinant in this buffer j
  *  cik    = C(i,k)
  *  vjk    = V(j,k)
- *  vik    = V(i,k)
- *  cjk    = C(j,k)
+ *  irow   = row of |i> in V(i,k)
+ *  cjs    = this thread's C(j,k) contributions
  *  hijval = <i|H|j> values
  *  jindx  = array for determinant indices
  */
@@ -728,10 +986,12 @@ void evaluate_hij_qxlist1x_ut2(struct det deti, int pindx, int npx,
                                struct xstr *qxlist, int nqx,
                                struct occstr *pstr, struct eospace *peosp, int npe,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
-                               int **pq, int npq, double *m1, double *m2, int aelec,
-                               int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq);
+                               int **pq, int npq, double *m1, double *m2,
+                               struct moslab *mslab, int aelec, int belec,
+                               int intorb, int vrows, int vcols,
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq);
 
 /*
  * evaluate_hij_qxlist2x: evaluate hij for double replacements in beta strings.
@@ -744,7 +1004,8 @@ void evaluate_hij_qxlist2x(struct det deti, int pindx, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl);
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl);
 
 /*
  * evaluate_hij_qxlist2x_ut: evaluate hij for double replacements in alpha
@@ -758,7 +1019,8 @@ void evaluate_hij_qxlist2x_ut(struct det deti, int pindx, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums);
 
@@ -772,8 +1034,9 @@ void evaluate_hij_qxlist2x_ut2(struct det deti, int pindx, int npx,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
                                int **pq, int npq, double *m1, double *m2, int aelec,
                                int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq);
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq);
 
 
 /*
@@ -788,7 +1051,8 @@ void evaluate_hij_pxqxlist(struct det deti, struct xstr *pxlist, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d,int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl);
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl);
 
 /*
  * evaluate_hij_jindx_1d: evaluate hij given a determinant |i> and a list
@@ -802,7 +1066,8 @@ void evaluate_hij_pxqxlist_1d(struct det deti, int *pxlist, int npx, int *qxlist
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vvecx, int **vindx, int **windx,
                               int *jindx, double *v, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl);
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl);
 
 /*
  * generate_det_triples: generate list of triplets for each determinant:
@@ -816,15 +1081,26 @@ void generate_det_triples (int ndeti, int **d_triplet, int pq_start,
 
 /*
  * generate_newvector: generate new vector to be added to space.
- *  n = - r / (d - E)
+ *  PRECOND_DIAG:  n = - r / (d - E)
+ *  PRECOND_SHIFT: n = - r / (d - E + shift), floored
+ *  PRECOND_OLSEN: n = - D^-1 (r - eps x), x = Ritz vector
+ *  PRECOND_BLOCK: exact inverse on block P, shifted diagonal elsewhere
+ * All but PRECOND_DIAG act on the locally owned patch of N.
  * Input:
  *  r_hndl = GA handle for residual vector
  *  d_hndl = GA handle for diagonal elements
  *  n_hndl = GA handle for new vector
  *  x_hndl = GA handle for scratch array
+ *  v_hndl = GA handle for basis vectors
+ *  hevec  = eigenvectors of v.Hv
+ *  ckdim  = current dimension of krylov space
+ *  croot  = current root
+ *  pc     = preconditioner
+ * Returns the number of floored denominators (all processes).
  */
-void generate_newvector (int r_hndl, int d_hndl, double eval, int ndets,
-                         int n_hndl, int x_hndl);
+int generate_newvector (int r_hndl, int d_hndl, double eval, int ndets,
+                        int n_hndl, int x_hndl, int v_hndl, double **hevec,
+                        int ckdim, int croot, struct precond *pc);
 
 
 /*
@@ -845,23 +1121,6 @@ void generate_residual (int v_hndl, int c_hndl, int r_hndl, double **hevec,
                         double *heval, int ndets, int ckdim, int croot,
                         int rscr_hndl);
 
-/*
- * generate_wlist: generate the wavefunction list of triplets
- * Input:
- *  hndl     = handle of global array of W
- *  ndets    = number of determinants
- *  pq       = alpha/beta pairs
- *  npq      = number of alpha/beta pairs
- *  peospace = alpha string electron orbital space
- *  pegrps   = number of alpha string orbital spaces
- *  qeospace = beta  string electron orbital space
- *  qegrps   = number of beta  string orbital spaces
- */
-void generate_wlist(int hndl, int ndets, int **pq, int npq,
-                    struct eospace *peosp, int pegrps,
-                    struct eospace *qeosp, int qegrps);
-
-
 /*
  * get_upptri_element_index: get index of an element (i,j) in
  * list of elements in upper triangle of H matrix (n x n).
@@ -885,11 +1144,36 @@ int get_upptri_element_rownumber (long long int element, int n);
  */
 long long int get_upptri_size (int n);
 
+/*
+ * init_precond: set up the correction vector preconditioner. For
+ * PRECOND_BLOCK the root process diagonalizes H(P,P) for the dim
+ * determinants of lowest <i|H|i> and broadcasts it.
+ * Input:
+ *  pc     = preconditioner
+ *  type   = PRECOND_*
+ *  shift  = level shift
+ *  dim    = PRECOND_BLOCK block dimension
+ *  d_hndl = GA handle for diagonal elements
+ *  ndets  = number of determinants
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ *  pstr   = alpha strings
+ *  qstr   = beta  strings
+ *  m1     = 1-e integrals
+ *  m2     = 2-e integrals
+ *  aelec  = alpha electrons
+ *  belec  = beta  electrons
+ *  intorb = internal orbitals (DOCC + ACTV)
+ */
+int init_precond(struct precond *pc, int type, double shift, int dim,
+                 int d_hndl, int ndets, struct detaddress *wdet,
+                 struct occstr *pstr, struct occstr *qstr,
+                 double *m1, double *m2, int aelec, int belec, int intorb);
+
 /*
  * init_diag_H_subspace: generate reference vectors from diagonalization
  * of a subspace of Hij.
  */
-void init_diag_H_subspace(int w_hndl,
+void init_diag_H_subspace(struct detaddress *wdet,
                           struct occstr *pstr,// struct eospace *peosp, int pegrps,
                           struct occstr *qstr,// struct eospace *qeosp, int qegrps,
                           double *m1, double *m2,
@@ -943,7 +1227,7 @@ void orthonormalize_newvector (int v_hndl, int nvecs, int ndets, int n_hndl);
  *  mdim  = maximum size of krylov space
  *  v_hndl= (GLOBAL ARRAY HANDLE) basis vectors
  *  d_hndl= (GLOBAL ARRAY HANDLE) diagonal elements <i|H|i>
- *  w_hndl= (GLOBAL ARRAY HANDLE) wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  * Output:
  *  c_hndl= (GLOBAL ARRAY HANDLE) Hv=c vectors
  */
@@ -952,7 +1236,8 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
                           int **pqs, int num_pq, double *m1, double *m2,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl, int d_hndl,
-                          int c_hndl, int w_hndl, int ga_buffer_len);
+                          int c_hndl,
+                          struct detaddress *wdet, int ga_buffer_len);
 
 /*
  * peform_hvispacefast: perform Hv=c on basis vectors v_i, i = 1, .., n.
@@ -967,6 +1252,7 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
  *  num_pq= number of alpha and beta space pairs
  *  m1    = 1-e integrals
  *  m2    = 2-e integrals
+ *  mslab = per-pair integral slabs
  *  aelec = alpha electrons
  *  belec = beta  electrons
  *  intorb= internal orbitals
@@ -976,32 +1262,52 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
  *  mdim  = maximum size of krylov space
  *  v_hndl= (GLOBAL ARRAY HANDLE) basis vectors
  *  d_hndl= (GLOBAL ARRAY HANDLE) diagonal elements <i|H|i>
- *  w_hndl= (GLOBAL ARRAY HANDLE) wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ *  scr   = per-thread sigma scratch arrays
+ *  vtol  = |v| screening threshold (0 = off)
+ *  spinsym = Ms=0 spin-flip symmetry of v (1, -1; 0 = off)
  * Output:
  *  c_hndl= (GLOBAL ARRAY HANDLE) Hv=c vectors
  */
 void perform_hvispacefast(struct occstr *pstr, struct eospace *peosp, int pegrps,
                           struct occstr *qstr, struct eospace *qeosp, int qegrps,
                           int **pqs, int num_pq, double *m1, double *m2,
+                          struct moslab *mslab,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl,
-                          int d_hndl, int c_hndl, int w_hndl, int ga_buffer_len,
-                          int nmo, int ndocc, int nactv);
+                          int d_hndl, int c_hndl,
+                          struct detaddress *wdet, int ga_buffer_len,
+                          int nmo, int ndocc, int nactv,
+                          struct sigma_scratch *scr, double vtol,
+                          int spinsym);
 
 void perform_hvispacefast_debug(struct occstr *pstr, struct eospace *peosp, int pegrps,
                           struct occstr *qstr, struct eospace *qeosp, int qegrps,
                           int **pqs, int num_pq, double *m1, double *m2,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl,
-                          int d_hndl, int c_hndl, int w_hndl, int ga_buffer_len,
+                          int d_hndl, int c_hndl,
+                          struct detaddress *wdet, int ga_buffer_len,
                                 int nmo, int ndocc, int nactv);
 
+/*
+ * precond_denom: shifted denominator H(i,i) - E + shift, with its
+ * magnitude kept above PRECOND_FLOOR. nfloor (may be NULL) counts
+ * floored values.
+ */
+double precond_denom(double dgl, double eval, double shift, int *nfloor);
+
 /*
  * print_iter_info: print iteration information.
  */
 void print_iter_info(double *heval, int ckdim, int croot, double rnorm,
                      double totfrze);
 
+/*
+ * print_precond_info: print the correction vector preconditioner.
+ */
+void print_precond_info(struct precond *pc);
+
 /*
  * print_subspace_eigeninfo: print diagonalization information for krylov
  * space.
@@ -0,0 +1,107 @@
+// File: perftimer.h
+/*
+ * Phase timers and communication counters for pjayci. Each process
+ * accumulates wall time per phase and counts of GA traffic and matrix
+ * elements; perftimer_report gathers min/avg/max over processes.
+ */
+
+#ifndef perftimer_h
+#define perftimer_h
+
+/* Timers */
+#define PT_DAVIDSON    0   /* pdavidson() total */
+#define PT_DIAGONAL    1   /* <i|H|i> and preconditioner setup */
+#define PT_GUESS       2   /* Initial guess vectors */
+#define PT_SIGMA       3   /* Hv=c */
+#define PT_SIGMA_XGEN  4   /* Hv=c: excitation generation (see below) */
+#define PT_SIGMA_HIJ   5   /* Hv=c: <i|H|j> evaluation and contraction */
+#define PT_SIGMA_GA    6   /* Hv=c: NGA_Get/NGA_Acc */
+#define PT_SUBSPACE    7   /* v.Hv build, diagonalization, truncation */
+#define PT_RESIDUAL    8   /* Residual and correction vector */
+#define PT_ORTHO       9   /* Orthonormalization of new vector */
+#define PT_IO         10   /* Vector output */
+#define PT_GA         11   /* All NGA_Get/NGA_Acc */
+#define PT_NTIMERS    12
+
+/* PT_SIGMA_XGEN and PT_SIGMA_HIJ are averaged over threads and timed on
+ * one row |i> in PERFTIMER_SAMPLE, then scaled, to keep clock reads out
+ * of most of the innermost loop. */
+#define PERFTIMER_SAMPLE 16
+
+/* Counters */
+#define PC_GA_GET_BYTES 0  /* Bytes moved by NGA_Get */
+#define PC_GA_ACC_BYTES 1  /* Bytes moved by NGA_Acc */
+#define PC_GA_GET_CALLS 2
+#define PC_GA_ACC_CALLS 3
+#define PC_HIJ_A1X      4  /* <i|H|j>: alpha single replacements */
+#define PC_HIJ_A2X      5  /* <i|H|j>: alpha double replacements */
+#define PC_HIJ_B1X      6  /* <i|H|j>: beta single replacements */
+#define PC_HIJ_B2X      7  /* <i|H|j>: beta double replacements */
+#define PC_HIJ_AB       8  /* <i|H|j>: alpha-beta double replacements */
+#define PC_SIGMA_CALLS  9  /* Hv=c passes */
+#define PC_NCOUNTERS   10
+
+/*
+ * perftimer_init: zero all timers and counters.
+ */
+void perftimer_init();
+
+/*
+ * perftimer_wtime: wall clock time (s). Safe to call from threads.
+ */
+double perftimer_wtime();
+
+/*
+ * perftimer_start: start timer t.
+ */
+void perftimer_start(int t);
+
+/*
+ * perftimer_stop: stop timer t, adding the elapsed time.
+ */
+void perftimer_stop(int t);
+
+/*
+ * perftimer_add: add sec seconds to timer t.
+ */
+void perftimer_add(int t, double sec);
+
+/*
+ * perftimer_count: add n to counter c.
+ */
+void perftimer_count(int c, long long int n);
+
+/*
+ * perftimer_time: accumulated time (s) of timer t on this process.
+ */
+double perftimer_time(int t);
+
+/*
+ * perftimer_counter: value of counter c on this process.
+ */
+long long int perftimer_counter(int c);
+
+/*
+ * perftimer_nga_get: NGA_Get of a double array, timed and counted.
+ * Time is also charged to PT_SIGMA_GA while PT_SIGMA is running.
+ */
+void perftimer_nga_get(int g_a, int *lo, int *hi, double *buf, int *ld);
+
+/*
+ * perftimer_nga_acc: NGA_Acc of a double array, timed and counted.
+ * Time is also charged to PT_SIGMA_GA while PT_SIGMA is running.
+ */
+void perftimer_nga_acc(int g_a, int *lo, int *hi, double *buf, int *ld,
+                       double *alpha);
+
+/*
+ * perftimer_report: gather min/avg/max of each timer and counter over all
+ * processes, print a summary and write it to a JSON file. This is
+ * executed on all processes.
+ * Input:
+ *  filename = JSON file name
+ *  niter    = Davidson iterations
+ */
+void perftimer_report(char *filename, int niter);
+
+#endif
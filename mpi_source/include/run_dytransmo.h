@@ -8,5 +8,43 @@
  */
 int run_dytransmo();
 
+/*
+ * print_cross_sections: print cross sections (Mb) to file.
+ * Input:
+ *  filename = name of file
+ *  nener    = number of energies
+ *  ener     = photoelectron kinetic energies (hartree)
+ *  ionpot   = ionization energy (eV)
+ *  ndyo     = number of dyson orbitals
+ *  sigma    = cross sections (bohr^2), [nener][ndyo]
+ *  dyst0    = anion states
+ *  ndyst0   = number of anion states
+ *  dyst1    = neutral states
+ *  ndyst1   = number of neutral states
+ */
+void print_cross_sections(char *filename, int nener, double *ener,
+                          double ionpot, int ndyo, double *sigma, int *dyst0,
+                          int ndyst0, int *dyst1, int ndyst1);
+
+/*
+ * read_dyson_ao_orbitals: read the dyson orbitals and transform them to
+ * the atomic orbital basis. Requires dysonorb.dat and mocoef. The
+ * molecular orbitals must span the full atomic orbital basis (nbf = nmo,
+ * C1); otherwise 1 is returned.
+ * Input:
+ *  filename = dyson orbital file
+ *  nfrzc    = number of frozen core orbitals
+ *  nao      = number of atomic orbitals
+ * Output:
+ *  ndyo     = number of dyson orbitals
+ *  orbao    = dyson orbitals in AO basis, [ndyo][nao]
+ *  dyst0    = anion states
+ *  ndyst0   = number of anion states
+ *  dyst1    = neutral states
+ *  ndyst1   = number of neutral states
+ */
+int read_dyson_ao_orbitals(char *filename, int nfrzc, int nao, int *ndyo,
+                           double **orbao, int **dyst0, int *ndyst0,
+                           int **dyst1, int *ndyst1);
 
 #endif
@@ -3,6 +3,14 @@
 #ifndef run_pdycicalc_h
 #define run_pdycicalc_h
 
+struct ao_gridbasis;
+
+/* Dyson orbitals evaluated together on the cube grid */
+#define DYSON_CUBE_GROUP 16
+
+/* Distance (bohr) from outermost atoms to cube grid edge */
+#define DYSON_CUBE_PAD 6.0
+
 /*
  * run_pdycicalc: Execute CI dyson orbital calculation.
  */
@@ -16,6 +24,14 @@ int check_wavefunction_input(int nelecs0, int norbs0, int nfrzc0,  int ndocc0,
                              int nactv0,  int nfrzv0, int nelecs1, int norbs1,
                              int nfrzc1,  int ndocc1, int nactv1,  int nfrzv1);
 
+/*
+ * set_dyson_states: build the (0-indexed) list of states entering the
+ * dyson orbitals from the (1-indexed) input list. A first input state
+ * of -1 selects all nstates states. Returns NULL if a state is not in
+ * 1..nstates.
+ */
+int *set_dyson_states(int *instates, int nin, int nstates, int *nst);
+
 /*
  * determinant_string_info: compute string information given
  * a determinant.
@@ -47,20 +63,23 @@ void generate_det_triples (int ndeti, int **d_triplet, int pq_start,
                            struct eospace *qeosp, int qegrps);
 
 /*
- * generate_wlist: generate the wavefunction list of triplets
+ * write_dysonorbital_cubes: evaluate the dyson orbitals on a grid around
+ * the molecule and write one cube file per orbital, dyson.<s0>.<s1>.cube.
  * Input:
- *  hndl     = handle of global array of W
- *  ndets    = number of determinants
- *  pq       = alpha/beta pairs
- *  npq      = number of alpha/beta pairs
- *  peospace = alpha string electron orbital space
- *  pegrps   = number of alpha string orbital spaces
- *  qeospace = beta  string electron orbital space
- *  qegrps   = number of beta  string orbital spaces
+ *  ndyorbs = number of dyson orbitals
+ *  orbs    = number of molecular orbitals (= atomic orbitals)
+ *  nfrzc   = number of frozen core orbitals
+ *  dyorbs  = dyson orbitals, [ndyorbs][orbs]
+ *  dysnst0 = anion states
+ *  ndyst0  = number of anion states
+ *  dysnst1 = neutral states
+ *  ndyst1  = number of neutral states
+ *  cubepts = grid points along longest side
  */
-void generate_wlist(int hndl, int ndets, int **pq, int npq,
-                    struct eospace *peosp, int pegrps,
-                    struct eospace *qeosp, int qegrps);
+int write_dysonorbital_cubes(struct ao_gridbasis *gb, int ndyorbs, int orbs,
+                             int nfrzc, double **dyorbs, int *dysnst0,
+                             int ndyst0, int *dysnst1, int ndyst1,
+                             int cubepts);
 
 /*
  * print_dysonorbitals_to_file: print the compute dyson orbitals to file.
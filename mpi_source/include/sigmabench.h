@@ -0,0 +1,63 @@
+// File: sigmabench.h
+/*
+ * Synthetic-integral benchmark of the Hv=c (sigma) kernel.
+ */
+
+#ifndef sigmabench_h
+#define sigmabench_h
+
+#include "benchutil.h"
+
+struct sigma_scratch;
+
+/*
+ * struct sigmabench: CI expansion, integrals and global arrays of the
+ * benchmark.
+ */
+struct sigmabench {
+    struct benchci ci;         /* Expansion and integrals */
+    struct sigma_scratch *scr; /* Per-thread sigma scratch */
+    int nthrd;
+    int mdim;                  /* Vectors (columns of V and C) */
+    int buflen;                /* GA buffer length */
+    int v_hndl;                /* (GLOBAL ARRAY) vectors, V */
+    int c_hndl;                /* (GLOBAL ARRAY) Hv=c vectors, C */
+    int d_hndl;                /* (GLOBAL ARRAY) diagonal <i|H|i> */
+};
+
+/*
+ * sigmabench_setup: build the CI expansion, synthetic integrals and the
+ * global arrays V, C and D. This is executed on all processes.
+ * Input:
+ *  electrons = total electrons
+ *  ndocc     = CAS doubly-occupied orbitals
+ *  nactv     = CAS active orbitals
+ *  orbitals  = total orbitals
+ *  xlvl      = excitation level
+ *  nvec      = vectors for the multi-vector product
+ *  buflen    = GA buffer length
+ *  sigaccum  = C(j,k) accumulation, SIGACC_*
+ * Output:
+ *  sb        = benchmark data
+ * Returns 0 on success.
+ */
+int sigmabench_setup(struct sigmabench *sb, int electrons, int ndocc,
+                     int nactv, int orbitals, int xlvl, int nvec, int buflen,
+                     int sigaccum);
+
+/*
+ * sigmabench_run: time nrep Hv=c products on dim vectors and print
+ * throughput. This is executed on all processes.
+ * Input:
+ *  sb   = benchmark data
+ *  dim  = number of vectors
+ *  nrep = repetitions
+ */
+void sigmabench_run(struct sigmabench *sb, int dim, int nrep);
+
+/*
+ * sigmabench_free: deallocate benchmark data.
+ */
+void sigmabench_free(struct sigmabench *sb);
+
+#endif
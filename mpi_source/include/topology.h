@@ -0,0 +1,43 @@
+// File: topology.h
+/*
+ * Process and thread placement on the NUMA domains of a node. Processes
+ * of a node are spread over its domains, numarank per domain, and the
+ * threads of each process are bound to cores of its domain, so that
+ * memory a process touches first is local to the cores that use it.
+ */
+
+#ifndef topology_h
+#define topology_h
+
+/* Largest number of CPUs of a NUMA domain */
+#define TOPOLOGY_MAXCPU 1024
+
+/*
+ * struct topology: placement of a process.
+ */
+struct topology {
+    int ndom;    /* NUMA domains of the node */
+    int dom;     /* Domain of this process (-1 = not bound) */
+    int cpu0;    /* First CPU bound to this process */
+    int ncpu;    /* CPUs bound to this process */
+    int nthrd;   /* Threads of this process */
+};
+
+/*
+ * topology_place: bind this process and its threads to a NUMA domain.
+ * This is executed on all processes after set_mpi_node_comm().
+ * Input:
+ *  numarank = processes per NUMA domain (0 = no binding)
+ *  nthread  = threads per process (0 = OMP_NUM_THREADS, or the CPUs of
+ *             the process if bound)
+ * Output:
+ *  tp = placement
+ */
+void topology_place(int numarank, int nthread, struct topology *tp);
+
+/*
+ * topology_print: print the placement of the processes.
+ */
+void topology_print(struct topology *tp, int numarank);
+
+#endif
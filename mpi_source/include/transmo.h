@@ -3,11 +3,104 @@
 #ifndef transmo_h
 #define transmo_h
 
+#include <complex.h>
+
+struct ao_gridbasis;
+
+/* Pi (not defined by math.h under -std=c11) */
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Hartree to eV */
+#define AU2EV 27.211386245988
+
+/* Fine structure constant */
+#define FINE_STRUCT 7.2973525693e-3
+
+/* Bohr^2 to megabarn */
+#define AU2MB 28.00285205
+
+/* Highest power of x in a plane wave dipole integral (f functions) */
+#define TRANSMO_MAXN 4
+
+/* k-vectors evaluated together */
+#define TRANSMO_KBATCH 256
+
 /*
  * compute_k: compute the wavevector k of a free electron given
  * the kinetic energy. (Atomic units: hbar = 1, m_e = 1)
  */
 double compute_k(double e);
 
+/*
+ * transmo_gauss_ft_1d: compute the one-dimensional integrals
+ *   I_n = int x^n exp(-a x^2) exp(i k x) dx,  n = 0, ..., nmax
+ * from I_0 = sqrt(pi / a) exp(-k^2 / 4a) and
+ *   I_(n+1) = (i k I_n + n I_(n-1)) / 2a.
+ */
+void transmo_gauss_ft_1d(double a, double k, int nmax, double complex *ival);
+
+/*
+ * transmo_type_terms: cartesian monomials of an orbital type.
+ * Input:
+ *  type = orbital type (see struct ao_basisfunc)
+ * Output:
+ *  coef = monomial coefficients
+ *  lxyz = monomial powers, [nterms][3]
+ * Returns number of monomials, 0 for an unknown type.
+ */
+int transmo_type_terms(int type, double *coef, int *lxyz);
+
+/*
+ * transmo_ao_dipoles: compute the dipole matrix elements of each atomic
+ * orbital with plane waves,
+ *   <AO|r_c|k> = (2 pi)^(-3/2) int AO(r) r_c exp(i k.r) d^3r.
+ * Input:
+ *  gb   = grid basis
+ *  kvec = k-vectors, [nk][3]
+ *  nk   = number of k-vectors
+ * Output:
+ *  momr = real part, [nk][3][nao]
+ *  momi = imaginary part, [nk][3][nao]
+ */
+void transmo_ao_dipoles(struct ao_gridbasis *gb, double *kvec, int nk,
+                        double *momr, double *momi);
+
+/*
+ * transmo_orientation_grid: directions and weights for integrating over
+ * the unit sphere. Gauss-Legendre in cos(theta) and uniform in phi.
+ * Input:
+ *  nth  = theta points
+ *  nph  = phi points
+ * Output:
+ *  khat = unit vectors, [nth*nph][3]
+ *  wt   = weights (sum to 4 pi), [nth*nph]
+ */
+void transmo_orientation_grid(int nth, int nph, double *khat, double *wt);
+
+/*
+ * transmo_cross_sections: orientation averaged photoionization cross
+ * sections (bohr^2) of each dyson orbital in the length gauge with a
+ * plane wave photoelectron,
+ *   sigma(E) = (4 pi^2 alpha w k / 3) int |<D|r|k>|^2 dOmega_k,
+ * where w = E + ionpot.
+ * Input:
+ *  gb     = grid basis
+ *  orbao  = dyson orbitals in atomic orbital basis, [norb][nao]
+ *  norb   = number of dyson orbitals
+ *  ener   = photoelectron kinetic energies (hartree), [nener]
+ *  nener  = number of energies
+ *  ionpot = ionization energy (hartree)
+ *  khat   = directions, [ndir][3]
+ *  wt     = direction weights, [ndir]
+ *  ndir   = number of directions
+ * Output:
+ *  sigma  = cross sections, [nener][norb]
+ */
+void transmo_cross_sections(struct ao_gridbasis *gb, double *orbao, int norb,
+                            double *ener, int nener, double ionpot,
+                            double *khat, double *wt, int ndir,
+                            double *sigma);
 
 #endif
@@ -21,7 +21,7 @@ extern void _readnamelist_(long long int  nmlist,
 			   unsigned char *nmlstr,
                            long long int *err);
 
-extern void _readmocoef_(double *c, long long int clen);
+extern void readmocoef_(double *c, long long int *clen);
 /* ================================================================= */
 
 
@@ -150,34 +150,84 @@ void print_wavefunction_info(char *wfname, int nelecs, int norbs, int nfrzc,
         return;
 }
 
+/*
+ * read_nth_int: return the n'th (from 0) integer of a line, or 0.
+ */
+int read_nth_int(char *line, int n)
+{
+        int val = 0;
+        int pos = 0, len = 0;
+        int i;
+        for (i = 0; i <= n; i++) {
+                if (sscanf(&(line[pos]), "%d%n", &val, &len) != 1) return 0;
+                pos = pos + len;
+        }
+        return val;
+}
+
 /*
  * readdysoninput: read &dysonorbital namelist.
  * Output:
  *  states0 = states of anion to compute dyson orbitals
  *  states1 = states of neutral to compute dyson orbitals
+ *  cubes   = write cube files of dyson orbitals (0: no; 1: yes)
+ *  cubepts = cube grid points along longest side
  *  error   = error flag
  */
 void readdysoninput(int *states0, int *states1, int maxst, int *nst0,
-                    int *nst1, int *error)
+                    int *nst1, int *cubes, int *cubepts, int *error)
 {
         long long int dysonnml = 5; /* &dysonorbital namelist flag */
         char nmlstr[MAX_NAMELIST_SIZE][MAX_LINE_SIZE] = {{""},{""}};
-        int i, j;
+        int nlines = MAX_DYSON_STATES / 10; /* Ten states per line */
+        int i;
         *error = 0;
         /* Read namelist */
         readnamelist_(&dysonnml, nmlstr, &error);
         if (error != 0) return;
         /* Stream the input into the proper variables */
+        *nst0 = 0;
+        *nst1 = 0;
         for (i = 0; i < maxst; i++) {
-                j = i + maxst;
-                sscanf(nmlstr[i], "%d", &states0[i]);
-                sscanf(nmlstr[j], "%d", &states1[i]);
+                states0[i] = read_nth_int(nmlstr[(i / 10)], (i % 10));
+                states1[i] = read_nth_int(nmlstr[(nlines + i / 10)], (i % 10));
                 if (states0[i] != 0) *nst0 = (i + 1);
                 if (states1[i] != 0) *nst1 = (i + 1);
         }
+        sscanf(nmlstr[(2 * nlines)], "%d", cubes);
+        sscanf(nmlstr[(2 * nlines + 1)], "%d", cubepts);
         return;
 }
         
+/*
+ * readtransmoinput: read &transmo namelist.
+ * Output:
+ *  emin    = lowest photoelectron energy (eV)
+ *  emax    = highest photoelectron energy (eV)
+ *  nenergy = number of photoelectron energies
+ *  ionpot  = ionization energy (eV)
+ *  ntheta  = photoelectron directions in theta
+ *  nphi    = photoelectron directions in phi
+ *  error   = error flag
+ */
+void readtransmoinput(double *emin, double *emax, int *nenergy,
+                      double *ionpot, int *ntheta, int *nphi, int *error)
+{
+        long long int tmonml = 6; /* &transmo namelist flag */
+        long long int err8 = 0;   /* Fortran (integer*8) error flag */
+        char nmlstr[MAX_NAMELIST_SIZE][MAX_LINE_SIZE] = {{""},{""}};
+        readnamelist_(&tmonml, nmlstr, &err8);
+        *error = (int) err8;
+        if (*error != 0) return;
+        sscanf(nmlstr[0], "%lf", emin);
+        sscanf(nmlstr[1], "%lf", emax);
+        sscanf(nmlstr[2], "%d", nenergy);
+        sscanf(nmlstr[3], "%lf", ionpot);
+        sscanf(nmlstr[4], "%d", ntheta);
+        sscanf(nmlstr[5], "%d", nphi);
+        return;
+}
+
 /* readwf0input: read wavefunction input for anion (0)
  * -------------------------------------------------------------------
  * Calls readnamelist which returns a character array
@@ -299,6 +349,15 @@ void readwf1input(int *elec,     int *orbs,   int *nfrozen,  int *ndocc,
  *  nmlstr[5] = refdim
  *  nmlstr[6] = restol
  *  nmlstr[7] = ga_buflen
+ *  nmlstr[8] = sigscreen
+ *  nmlstr[9] = spinsym
+ *  nmlstr[10]= precond
+ *  nmlstr[11]= pcshift
+ *  nmlstr[12]= memnode
+ *  nmlstr[13]= numarank
+ *  nmlstr[14]= nthread
+ *  nmlstr[15]= nodeshare
+ *  nmlstr[16]= sigaccum
  *
  * Output:
  *  maxiter = maximum iterations of davidson algorithm
@@ -309,10 +368,36 @@ void readwf1input(int *elec,     int *orbs,   int *nfrozen,  int *ndocc,
  *  refdim  = intitial reference-space dimension (prediagonalization)
  *  restol  = convergence tolerance of residual
  *  buflen  = length of buffer in GA read of Hv=c
+ *  sigscreen = sigma screening factor. Block pairs whose |H|*|v| bound
+ *              is below sigscreen*restol are skipped. 0 disables
+ *              (default). Converged energies stayed within restol of
+ *              the unscreened ones up to 1e4; 1e5 gave a spurious root.
+ *  spinsym = Ms=0 spin-flip symmetry C(p,q) = spinsym*C(q,p):
+ *            1 = even S, -1 = odd S, 0 = off. Only the beta-only
+ *            sigma work is skipped; V and C are stored in full
+ *            (no p>=q half-vector storage).
+ *  precond = correction vector preconditioner: 0 = diagonal,
+ *            1 = shifted diagonal, 2 = Olsen, 3 = block inverse
+ *  pcshift = preconditioner level shift
+ *  memnode = memory per node (MB) for the startup memory check. An
+ *            estimate above it stops the run. 0 = warn only, against
+ *            90% of the physical memory of the node (default)
+ *  numarank= processes per NUMA domain; 0 = no binding (default)
+ *  nthread = threads per process; 0 = OMP_NUM_THREADS, or the CPUs of
+ *            the process when numarank > 0
+ *            numarank and nthread have only been run on a single
+ *            core and NUMA domain; placement is not validated at scale.
+ *  nodeshare = 1: one copy of the strings and integrals per node, in
+ *              MPI-3 shared memory windows; 0 = one copy per process
+ *              (default). Not measured with several processes.
+ *  sigaccum = sigma C(j,k) accumulation over threads: 0 = bins by row
+ *             owner (default), 1 = per-thread copies of C(j,k)
  *  err     = error handling: n = missing variable n */
 void readdaiinput(int *maxiter,  int *krymin, int *krymax, int *nroots,
 		  int *prediagr, int *refdim, double *restol, int *buflen,
-                  int *err)
+                  double *sigscreen, int *spinsym, int *precond,
+                  double *pcshift, int *memnode, int *numarank,
+                  int *nthread, int *nodeshare, int *sigaccum, int *err)
 {
     /* .. local scalars ..
      * gnml = namelist to read in */
@@ -336,6 +421,15 @@ void readdaiinput(int *maxiter,  int *krymin, int *krymax, int *nroots,
     sscanf(nmlstr[5], "%lf",  restol);
     sscanf(nmlstr[6], "%d",   refdim);
     sscanf(nmlstr[7], "%d",   buflen);
+    sscanf(nmlstr[8], "%lf", sigscreen);
+    sscanf(nmlstr[9], "%d",   spinsym);
+    sscanf(nmlstr[10], "%d",  precond);
+    sscanf(nmlstr[11], "%lf", pcshift);
+    sscanf(nmlstr[12], "%d",  memnode);
+    sscanf(nmlstr[13], "%d",  numarank);
+    sscanf(nmlstr[14], "%d",  nthread);
+    sscanf(nmlstr[15], "%d",  nodeshare);
+    sscanf(nmlstr[16], "%d",  sigaccum);
     
     return;
 }
@@ -398,6 +492,22 @@ void readgeninput(int *elec,     int *orbs,   int *nfrozen,  int *ndocc,
      
 }
 
+/* readmocoeffs: subroutine to read molecular coefficient file.
+ * -------------------------------------------------------------------
+ * Calls fortran subroutine readmocoef()
+ *
+ * Input:
+ *  clen = length of c
+ * Output:
+ *  c    = orbital coefficients, [nmo][nbf] */
+void readmocoeffs(double *c, int clen)
+{
+        long long int maxlen;
+        maxlen = (long long int) clen;
+        readmocoef_(c, &maxlen);
+        return;
+}
+
 /* readmointegrals: Subroutine to read 1 and 2 electron integrals.
  * -------------------------------------------------------------------
  * Calls fortran subroutine readmoints()
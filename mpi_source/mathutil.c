@@ -6,6 +6,7 @@
  * diagmat_dsyevr: diagonalizes a square matrix using dsyevr
  * dot_product: computes dot product of two vectors.
  * matmul_dgemm: perform A_ij B_jk = C_ik with dgemm
+ * matmul_dgemm_tn: perform A_ji B_jk + beta C_ik = C_ik with dgemm
  * orthonormalize_vector: orthonormalize vector to space
  *
  * By Christopher L Malbon
@@ -162,6 +163,32 @@ int matmul_dgemm(double *mata, int row_a, int col_a, double *matb, int row_b,
     return error;
 }
 
+/*
+ * matmul_dgemm_tn: C = A^T B + beta C with fortran routine DGEMM. A is
+ * k x m with leading dimension lda, B is k x n with leading dimension
+ * ldb and C is m x n with leading dimension ldc, all column-major.
+ */
+int matmul_dgemm_tn(double *mata, int lda, double *matb, int ldb, int m,
+                    int n, int k, double beta, double *matc, int ldc)
+{
+    int error = 0; /* error flag */
+    /* DGEMM variables */
+    unsigned char transa[1] = "t"; /* Use transpose of matrix A */
+    unsigned char transb[1] = "n"; /* Do not use transpose of matrix B */
+    long long int mm, nn, kk;
+    long long int llda, lldb, lldc;
+    double alpha = 1.0;
+    mm = (long long int) m;
+    nn = (long long int) n;
+    kk = (long long int) k;
+    llda = lda;
+    lldb = ldb;
+    lldc = ldc;
+    dgemm_(&transa, &transb, &mm, &nn, &kk, &alpha, mata, &llda, matb, &lldb,
+           &beta, matc, &lldc);
+    return error;
+}
+
 /*
  * orthonormalize_vector: orthogonalize and normalize new vector to space
  * of basis vectors.
@@ -0,0 +1,394 @@
+// File: memsize.c
+/*
+ * Memory sizing for pjayci.
+ *
+ * Each component mirrors the allocations of the routine that makes
+ * them (citrunc, create_detaddress, pdavidson, allocate_sigma_scratch,
+ * perform_hvispacefast and compute_cblock_Hfastest), using the same
+ * structure sizes and array dimensions. Memory of the MPI, GA and
+ * OpenMP runtimes is not included.
+ *
+ * The estimate has only been compared with the peak resident memory of
+ * one single-process run, linked against a serial stand-in for GA and
+ * with zeroed integrals. It has not been checked against a real GA
+ * build, with several processes or nodes, or with threads.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <limits.h>
+#include <unistd.h>
+#include "mpi_utilities.h"
+#include "iminmax.h"
+#include "moindex.h"
+#include "moslab.h"
+#include "binarystr.h"
+#include "citruncate.h"
+#include "detaddress.h"
+#include "pdavidson.h"
+#include "memsize.h"
+#include <mpi.h>
+
+static const char *ms_name[MS_NCOMP] = {
+    "Strings", "Spaces and determinant map", "Integrals",
+    "Integral slabs", "V and C (global, local patch)",
+    "N, R, X and D (global, local patch)", "Davidson local arrays",
+    "Hv=c buffers", "Sigma scratch (all threads)",
+    "citrunc() string lists", "Guess/preconditioner build (root)"
+};
+
+/*
+ * isqrt_ll: floor(sqrt(n)) for n >= 0.
+ */
+static long long int isqrt_ll(long long int n)
+{
+    long long int r = (long long int) sqrt((double) n);
+    while (r > 0 && r * r > n) r--;
+    while ((r + 1) * (r + 1) <= n) r++;
+    return r;
+}
+
+/*
+ * sigma_rows: largest number of rows |i> of C held by a process, as
+ * split by compute_cimat_chunks().
+ */
+static long long int sigma_rows(long long int ndets, int nproc)
+{
+    long long int utchunk = (ndets * ndets - ndets) / 2 / nproc;
+    long long int lo = 0, hi = 0, rows = 0;
+    int r;
+
+    for (r = 0; r < nproc; r++) {
+        lo = isqrt_ll(r * utchunk);
+        hi = isqrt_ll((r + 1) * utchunk);
+        if (lo > ndets) lo = ndets;
+        if (hi > ndets) hi = ndets;
+        if (r == (nproc - 1)) hi = ndets - 2;
+        if ((hi - lo + 1) > rows) rows = hi - lo + 1;
+    }
+    return rows;
+}
+
+/*
+ * memsize_count_strings: set the number of strings of each electron
+ * space.
+ */
+void memsize_count_strings(struct eospace *eosp, int ngrps, int orbs,
+                           int elecs, int ndocc, int nactv)
+{
+    int i;
+    for (i = 0; i < ngrps; i++) {
+        eosp[i].nstr = string_number(eosp[i].docc, eosp[i].actv,
+                                     eosp[i].virt, ndocc, nactv, orbs,
+                                     elecs);
+    }
+    return;
+}
+
+/*
+ * memsize_init: set the expansion of the estimate.
+ */
+void memsize_init(struct memsize *ms, struct eospace *peosp, int pegrps,
+                  struct eospace *qeosp, int qegrps, int **pq, int npq,
+                  int aelec, int belec, int ci_orbs, int orbitals)
+{
+    long long int blk = 0;
+    int i;
+
+    ms->ndets = 0;
+    ms->maxblk = 0;
+    ms->xlistmax = 0;
+    ms->pstr_len = 0;
+    ms->qstr_len = 0;
+    for (i = 0; i < pegrps; i++) {
+        ms->pstr_len = ms->pstr_len + peosp[i].nstr;
+        ms->xlistmax = int_max(ms->xlistmax, peosp[i].nstr);
+    }
+    for (i = 0; i < qegrps; i++) {
+        ms->qstr_len = ms->qstr_len + qeosp[i].nstr;
+        ms->xlistmax = int_max(ms->xlistmax, qeosp[i].nstr);
+    }
+    for (i = 0; i < npq; i++) {
+        blk = (long long int) peosp[pq[i][0]].nstr * qeosp[pq[i][1]].nstr;
+        ms->ndets = ms->ndets + blk;
+        if (blk > ms->maxblk) ms->maxblk = blk;
+    }
+    ms->pegrps = pegrps;
+    ms->qegrps = qegrps;
+    ms->npq = npq;
+    ms->aelec = aelec;
+    ms->belec = belec;
+    ms->ci_orbs = ci_orbs;
+    ms->orbitals = orbitals;
+    return;
+}
+
+/*
+ * memsize_estimate: compute the memory per process of a run.
+ */
+void memsize_estimate(struct memsize *ms, int nproc, int nthrd, int krymin,
+                      int krymax, int refdim, int prediagr, int precond,
+                      int nodeshare, int sigaccum)
+{
+    double *c = ms->comp;
+    double ngrp = 0.0;   /* pegrps * qegrps */
+    double nloc = 0.0;   /* Local columns of a distributed vector */
+    double rows = 0.0;   /* Local rows |i> of Hv=c */
+    double kmax = 0.0, kmin = 0.0, xmax = 0.0, blk = 0.0, dim = 0.0;
+    double guess = 0.0, pcbld = 0.0;
+    int i;
+
+    ms->nproc = nproc;
+    ms->nthrd = nthrd;
+    ms->nodeshare = nodeshare;
+    ms->sigaccum = sigaccum;
+    ms->krymin = krymin;
+    ms->krymax = krymax;
+    ms->refdim = refdim;
+    ms->prediagr = prediagr;
+    ms->precond = precond;
+    ngrp = (double) ms->pegrps * ms->qegrps;
+    nloc = (double) ((ms->ndets + nproc - 1) / nproc);
+    rows = (double) sigma_rows(ms->ndets, nproc);
+    kmax = (double) krymax;
+    kmin = (double) krymin;
+    xmax = (double) ms->xlistmax;
+    blk  = (double) ms->maxblk;
+    dim  = (double) (refdim < ms->ndets ? refdim : ms->ndets);
+
+    c[MS_STRINGS] = (double) (ms->pstr_len + ms->qstr_len) *
+        sizeof(struct occstr);
+    /* eospaces, (p,q) pairs allocated for every space pair, and the
+     * determinant address map */
+    c[MS_SPACES] = (double) (ms->pegrps + ms->qegrps) *
+        sizeof(struct eospace) + ngrp * (2 * sizeof(int) + sizeof(int *)) +
+        sizeof(struct detaddress) +
+        (5.0 * ms->npq + 1 + ms->pegrps + ms->qegrps + 2 + ngrp) *
+        sizeof(int);
+    c[MS_INTEGRALS] = ((double) index1e(ms->orbitals, ms->orbitals) +
+                       (double) index2e(ms->orbitals, ms->orbitals,
+                                        ms->orbitals, ms->orbitals)) *
+        sizeof(double);
+    c[MS_MOSLAB] = (double) index1e(ms->ci_orbs, ms->ci_orbs) * 2 *
+        ms->ci_orbs * sizeof(double);
+    c[MS_GA_VC] = 2 * kmax * nloc * sizeof(double);
+    c[MS_GA_1D] = 4 * nloc * sizeof(double);
+    /* d, v.Hv, eigenvectors and their scratch, eigenvalues */
+    c[MS_DAVIDSON] = ((double) (ms->ndets / nproc) + 10) * sizeof(double) +
+        4 * kmax * kmax * sizeof(double) + 2 * kmax * sizeof(double *) +
+        kmax * sizeof(double);
+    if (precond == PRECOND_BLOCK) {
+        c[MS_DAVIDSON] = c[MS_DAVIDSON] + dim * sizeof(int) +
+            (dim * dim + 2 * dim) * sizeof(double);
+    }
+    /* perform_hvispacefast: local C, (p,q,cas) triples, columns;
+     * compute_cblock_Hfastest: V(i), V(i) transposed, and V(j) and C(j)
+     * for the largest (p,q) block; screening block maxima */
+    c[MS_SIGMA] = rows * kmax * sizeof(double) + kmax * sizeof(double *) +
+        3 * rows * sizeof(int) + rows * sizeof(int *) + kmax * sizeof(int) +
+        2 * rows * kmax * sizeof(double) +
+        2 * blk * kmax * sizeof(double) +
+        ms->npq * sizeof(double) + (ms->npq + 1) * sizeof(int);
+    c[MS_SCRATCH] = nthrd * (sizeof(struct sigma_scratch) +
+                             3 * xmax * sizeof(struct xstr) +
+                             int_max(ms->aelec, ms->belec) * sizeof(int) +
+                             ms->ci_orbs * sizeof(int) +
+                             kmax * sizeof(double) +
+                             blk * (sizeof(int) + sizeof(double)));
+    if (sigaccum == SIGACC_COPIES) {
+        c[MS_SCRATCH] = c[MS_SCRATCH] + nthrd * kmax * blk * sizeof(double);
+    }
+    c[MS_SETUP] = (double) (ms->pstr_len + ms->qstr_len) *
+        sizeof(struct eostring) +
+        ((double) ms->pstr_len * ms->aelec +
+         (double) ms->qstr_len * ms->belec) * sizeof(int);
+
+    /* Root: guess vectors (build_init_guess_vectors and
+     * init_diag_H_subspace), or the PRECOND_BLOCK block (init_precond);
+     * these are not allocated at the same time. */
+    if (prediagr == 1 || prediagr == 2) {
+        guess = (dim * dim + (double) ms->ndets * kmin) * sizeof(double) +
+            (dim + kmin) * sizeof(double *);
+    }
+    if (prediagr == 1) {
+        guess = guess + (2 * dim * dim + dim) * sizeof(double) +
+            dim * sizeof(double *) + 3 * dim * sizeof(int);
+    }
+    if (precond == PRECOND_BLOCK) {
+        pcbld = ((double) ms->ndets + dim * dim) * sizeof(double) +
+            3 * dim * sizeof(int);
+    }
+    c[MS_ROOT] = (guess > pcbld ? guess : pcbld);
+
+    /* Peak: citrunc() runs before the integrals and Davidson arrays
+     * exist; everything else is resident during Hv=c. With nodeshare
+     * the strings and integrals are held, and citrunc() is run, once
+     * per node. */
+    ms->proc = 0.0;
+    for (i = MS_STRINGS; i <= MS_SCRATCH; i++) {
+        ms->proc = ms->proc + c[i];
+    }
+    ms->shared = 0.0;
+    if (nodeshare) {
+        ms->shared = c[MS_STRINGS] + c[MS_INTEGRALS];
+        ms->proc = ms->proc - ms->shared;
+    }
+    ms->setup = c[MS_STRINGS] + c[MS_SETUP];
+    ms->root = c[MS_ROOT];
+    return;
+}
+
+/*
+ * memsize_node: peak memory of a node with rpn processes, bytes.
+ */
+double memsize_node(struct memsize *ms, int rpn)
+{
+    double run = 0.0, setup = 0.0;
+
+    run = rpn * ms->proc + ms->shared + ms->root;
+    if (ms->nodeshare) {
+        setup = rpn * ms->comp[MS_SPACES] + ms->setup;
+    } else {
+        setup = rpn * (ms->comp[MS_SPACES] + ms->setup);
+    }
+    return (run > setup ? run : setup);
+}
+
+/*
+ * memsize_node_layout: number of nodes, largest number of processes on
+ * a node and smallest physical memory of a node in MB.
+ */
+void memsize_node_layout(int *nnodes, int *rpn, double *physmb)
+{
+    long pages = 0, pagesize = 0;
+    double mb = 0.0;
+
+    *nnodes = mpi_num_nodes;
+    MPI_Allreduce(&mpi_node_procs, rpn, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    pages = sysconf(_SC_PHYS_PAGES);
+    pagesize = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && pagesize > 0) {
+        mb = (double) pages * pagesize / 1048576;
+    }
+    MPI_Allreduce(&mb, physmb, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    return;
+}
+
+/*
+ * memsize_check: print the estimate of a run and recommendations for
+ * the memory available per node. Exceeding the limit is an error only
+ * when memnode is set.
+ */
+int memsize_check(struct memsize *ms, int memnode, int buflen)
+{
+    struct memsize trial;
+    int nnodes = 0, rpn = 0, ncore = 0;
+    int rbest = 0, kbest = 0;
+    double physmb = 0.0, limit = 0.0, node = 0.0;
+    int error = 0;
+    int r, k;
+
+    memsize_node_layout(&nnodes, &rpn, &physmb);
+    if (mpi_proc_rank != mpi_root) {
+        MPI_Bcast(&error, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        return error;
+    }
+
+    if (memnode > 0) {
+        limit = (double) memnode;
+    } else {
+        limit = physmb * MEMSIZE_PHYSFRAC;
+    }
+    /* Node memory: every process on a node at its peak, the shared
+     * strings and integrals (nodeshare), plus root */
+    node = memsize_node(ms, rpn) / 1048576;
+
+    memsize_print(ms);
+    if (ms->ndets > INT_MAX) {
+        printf(" Determinants exceed the largest index (%d).\n", INT_MAX);
+        error = 1;
+    }
+    printf(" %d node(s), up to %d process(es) per node\n", nnodes, rpn);
+    printf(" Memory per node:        %12.2lf MB\n", node);
+    printf(" Memory available:       %12.2lf MB", limit);
+    if (memnode > 0) {
+        printf(" (memnode)\n");
+    } else {
+        printf(" (%.0lf%% of %.2lf MB)\n", (MEMSIZE_PHYSFRAC * 100), physmb);
+    }
+
+    /* Processes per node on the cores in use, with threads filling the
+     * rest, and krymax at the current layout. */
+    ncore = rpn * ms->nthrd;
+    trial = *ms;
+    for (r = 1; r <= ncore; r++) {
+        memsize_estimate(&trial, (nnodes * r), int_max(1, (ncore / r)),
+                         ms->krymin, ms->krymax, ms->refdim, ms->prediagr,
+                         ms->precond, ms->nodeshare, ms->sigaccum);
+        if (memsize_node(&trial, r) / 1048576 <= limit) rbest = r;
+    }
+    for (k = ms->krymin + 1; k <= MEMSIZE_MAXKRY; k++) {
+        memsize_estimate(&trial, ms->nproc, ms->nthrd, ms->krymin, k,
+                         ms->refdim, ms->prediagr, ms->precond,
+                         ms->nodeshare, ms->sigaccum);
+        if (memsize_node(&trial, rpn) / 1048576 > limit) break;
+        kbest = k;
+    }
+
+    printf(" Recommendations:\n");
+    printf("  ga_buffer_len      = %lld", ms->maxblk);
+    printf(" (V(j)/C(j) buffers hold the largest (p,q) block;");
+    printf(" input = %d)\n", buflen);
+    if (rbest > 0) {
+        printf("  processes per node <= %d (x %d thread(s))\n", rbest,
+               int_max(1, (ncore / rbest)));
+    } else {
+        printf("  processes per node: none fits on %d core(s)\n", ncore);
+    }
+    if (kbest > 0) {
+        printf("  krymax             <= %d\n", kbest);
+    } else {
+        printf("  krymax: none > krymin fits\n");
+    }
+
+    if (node > limit) {
+        printf("\n Estimated memory per node (%.2lf MB) exceeds the", node);
+        printf(" memory available (%.2lf MB).\n", limit);
+        printf(" Reduce processes per node or krymax, or use more nodes.\n");
+        if (memnode > 0) {
+            error = 1;
+        } else {
+            /* The estimate is unvalidated at scale; only a limit set
+             * explicitly by memnode stops the run. */
+            printf(" WARNING: continuing. Set &dalginfo memnode to make");
+            printf(" this limit an error.\n");
+        }
+    }
+    printf("\n");
+    fflush(stdout);
+    MPI_Bcast(&error, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+    return error;
+}
+
+/*
+ * memsize_print: print the components of an estimate.
+ */
+void memsize_print(struct memsize *ms)
+{
+    int i;
+
+    printf("\nMemory estimate (%d process(es) x %d thread(s), krymax = %d)\n",
+           ms->nproc, ms->nthrd, ms->krymax);
+    printf(" Determinants = %lld, largest (p,q) block = %lld\n", ms->ndets,
+           ms->maxblk);
+    for (i = 0; i < MS_NCOMP; i++) {
+        printf("  %-38s %12.2lf MB\n", ms_name[i],
+               (ms->comp[i] / 1048576));
+    }
+    printf(" Peak per process:       %12.2lf MB\n", (ms->proc / 1048576));
+    printf(" Shared per node:        %12.2lf MB\n", (ms->shared / 1048576));
+    printf(" Additional on root:     %12.2lf MB\n", (ms->root / 1048576));
+    return;
+}
@@ -0,0 +1,72 @@
+// FILE: moslab.c
+/*********************************************************************
+ * moslab.c
+ * --------
+ * Per-pair integral slabs for the sigma kernels.
+ *
+ * For a fixed replacement i->j the single replacement matrix element
+ * needs (kk|ij) and (ki|kj) for every occupied k. In index2e order these
+ * are scattered across the full O(n^4/8) integral array. The slabs
+ * collect them, once, into a contiguous row per (ij) pair.
+ ********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "moindex.h"
+#include "moslab.h"
+
+/*
+ * build_moslab: build per-pair integral slabs from lower-triangular
+ * 2-e integrals.
+ * Input:
+ *  m2    = 2-e integrals (index2e order)
+ *  norb  = number of orbitals
+ * Output:
+ *  mslab = per-pair integral slabs
+ * Returns:
+ *  error = 0 on success, -1 on allocation failure
+ */
+int build_moslab(double *m2, int norb, struct moslab *mslab)
+{
+    double *row = NULL;
+    int ij, i, j, k;
+
+    mslab->norb = norb;
+    mslab->npair = index1e(norb, norb);
+    mslab->data = malloc(sizeof(double) * mslab->npair * 2 * norb);
+    if (mslab->data == NULL) {
+        mslab->npair = 0;
+        return -1;
+    }
+    for (i = 1; i <= norb; i++) {
+        for (j = 1; j <= i; j++) {
+            ij = index1e(i, j) - 1;
+            row = &(mslab->data[ij * 2 * norb]);
+            for (k = 1; k <= norb; k++) {
+                row[k - 1] = m2[index2e(k, k, i, j) - 1] -
+                    m2[index2e(k, i, k, j) - 1];
+                row[norb + k - 1] = m2[index2e(k, k, i, j) - 1];
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * free_moslab: deallocate per-pair integral slabs.
+ */
+void free_moslab(struct moslab *mslab)
+{
+    free(mslab->data);
+    mslab->data = NULL;
+    mslab->npair = 0;
+    return;
+}
+
+/*
+ * moslab_size_mb: return the size of the slab store in MB.
+ */
+double moslab_size_mb(int norb)
+{
+    return ((double) index1e(norb, norb) * 2 * norb * 8) / 1048576;
+}
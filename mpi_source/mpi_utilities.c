@@ -48,6 +48,55 @@ void mpi_error_check_msg (int error, char *fcn_name, char *message)
         }
 }
 
+/*
+ * mpi_node_shared_alloc: allocate memory shared by the processes of a
+ * node. The first process of the node holds all of it, so pages are
+ * placed in its NUMA domain when it first writes them.
+ * Input:
+ *  size = bytes
+ * Output:
+ *  win  = shared memory window
+ * Returns pointer to the shared memory, NULL on failure.
+ */
+void *mpi_node_shared_alloc (long long int size, MPI_Win *win)
+{
+        void *ptr = NULL;
+        MPI_Aint lsize = 0;
+        MPI_Aint qsize = 0;
+        int disp = 0;
+        int error = 0;
+
+        if (mpi_node_rank == 0) lsize = (MPI_Aint) size;
+        error = MPI_Win_allocate_shared(lsize, 1, MPI_INFO_NULL,
+                                        mpi_node_comm, &ptr, win);
+        if (error != MPI_SUCCESS) return NULL;
+        MPI_Win_shared_query(*win, 0, &qsize, &disp, &ptr);
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, *win);
+        return ptr;
+}
+
+/*
+ * mpi_node_shared_free: free memory from mpi_node_shared_alloc.
+ */
+void mpi_node_shared_free (MPI_Win *win)
+{
+        MPI_Win_unlock_all(*win);
+        MPI_Win_free(win);
+        return;
+}
+
+/*
+ * mpi_node_shared_sync: make writes to node shared memory visible to
+ * all processes of the node.
+ */
+void mpi_node_shared_sync (MPI_Win win)
+{
+        MPI_Win_sync(win);
+        MPI_Barrier(mpi_node_comm);
+        MPI_Win_sync(win);
+        return;
+}
+
 /*
  * mpi_split_work_array_1d: get first and last elements for partitioning
  * a 1d array amongst work processes.
@@ -549,3 +598,23 @@ void set_ga_process_number_and_rank ()
         mpi_proc_rank = GA_Nodeid();
         mpi_num_procs = GA_Nnodes();
 }
+
+/*
+ * set_mpi_node_comm: set global variables $mpi_node_comm, $mpi_lead_comm,
+ * $mpi_node_procs, $mpi_node_rank and $mpi_num_nodes. Node ranks follow
+ * world ranks, so mpi_root is the first process of its node.
+ */
+void set_mpi_node_comm ()
+{
+        int lead = 0;
+
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED,
+                            mpi_proc_rank, MPI_INFO_NULL, &mpi_node_comm);
+        MPI_Comm_size(mpi_node_comm, &mpi_node_procs);
+        MPI_Comm_rank(mpi_node_comm, &mpi_node_rank);
+        lead = (mpi_node_rank == 0 ? 1 : 0);
+        MPI_Comm_split(MPI_COMM_WORLD, (lead ? 0 : MPI_UNDEFINED),
+                       mpi_proc_rank, &mpi_lead_comm);
+        MPI_Allreduce(&lead, &mpi_num_nodes, 1, MPI_INT, MPI_SUM,
+                      MPI_COMM_WORLD);
+}
@@ -12,11 +12,15 @@
 #include "iminmax.h"
 #include "arrayutil.h"
 #include "mathutil.h"
+#include "moindex.h"
 #include "allocate_mem.h"
 #include "mpi_utilities.h"
 #include "binarystr.h"
 #include "citruncate.h"
+#include "detaddress.h"
+#include "moslab.h"
 #include "action_util.h"
+#include "perftimer.h"
 #include "pdavidson.h"
 
 #include <mpi.h>
@@ -28,6 +32,8 @@
 #include <omp.h>
 #else
 #define omp_get_thread_num() 0
+#define omp_get_num_threads() 1
+#define omp_get_max_threads() 1
 #endif
 /* -------------------- */
 
@@ -39,10 +45,13 @@
 int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
               struct occstr *qstrings, struct eospace *qeospace, int qegrps,
               int **pq_space_pairs, int num_pq, double *moints1, double *moints2,
+              struct moslab *mslab,
               int aelec, int belec, int intorb, int ndets, double nucrep_e,
               double frzcore_e, int printlvl, int maxiter, int krymin,
               int krymax, int nroots, int prediagr, int refdim, double restol,
-              int ga_buffer_len, int totalmo, int ndocc, int nactv)
+              double sigscreen, int spinsym, int ga_buffer_len, int totalmo,
+              int ndocc, int nactv, int precond, double pcshift,
+              int sigaccum)
 {
     int v_hndl = 0;           /* GLOBAL basis vectors, V */
     int v_dims[2]  = {0, 0};  /* GLOBAL basis vectors dimensions */
@@ -55,9 +64,7 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     int x_hndl = 0;           /* GLOBAL 1-D scratch array */
     int d_hndl = 0;           /* GLOBAL <i|H|i> vector, D */
     
-    int w_hndl = 0;           /* GLOBAL |i> = |(pq, p, q)> array */
-    int w_dims[2] = {0, 0};   /* GLOBAL |i> = |(pq, p, q)> array */
-    int w_chunk[2] = {0, 0};  /* GLOBAL |i> = |(pq, p, q)> chunk sizes */
+    struct detaddress *wdet = NULL; /* LOCAL |i> = |(p, q, cas)> map */
     
     double *d_local = NULL;   /* LOCAL <i|H|i> array. */
     
@@ -70,6 +77,12 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     double *heval = NULL;     /* LOCAL v.Hv eigenvalues */
     double *hevec_scr= NULL;  /* LOCAL v.Hv eigenvector scratch array */
     
+    struct sigma_scratch *sscr = NULL; /* LOCAL per-thread sigma scratch */
+    int nthrd = 0;            /* Number of OpenMP threads */
+    double vtol = 0.0;        /* |v| below which H(i,j)v(j) is skipped */
+    struct precond pc;        /* Correction vector preconditioner */
+    int nfloor = 0;           /* Floored preconditioner denominators */
+    
     double rnorm = 0.0;       /* ||r|| */
     double nnorm = 0.0;       /* ||n|| */
     
@@ -83,28 +96,17 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     int ld_1d[1] = {0};
     
     double totcore_e = 0.0;
-    double memusage = 0.0;  /* Estimated memory usage */
     int error = 0;
     
     totcore_e = nucrep_e + frzcore_e;
     ld_1d[0] = 1;
+
+    perftimer_init();
+    perftimer_start(PT_DAVIDSON);
     
     /* Allocate GLOBAL arrays: V, Hv=c, N, R, and D */
     if (mpi_proc_rank == mpi_root) {
         printf("Creating global arrays...\n");
-        memusage = krymax * ndets * 8 * 2; // C and V
-        memusage += ndets * 8 * 3; // N, R, X, D
-        memusage += ndets * 4 * 3; // W
-        memusage = memusage / 1048576;
-        printf(" Global Arrays memory usage: ");
-        printf("  %10.2lf MB\n", memusage);
-        memusage = ga_buffer_len * krymax * 8;
-        memusage = memusage + ga_buffer_len * 4 * 3;
-        memusage = memusage / 1048576;
-        memusage = memusage * mpi_num_procs;
-        printf(" Local buffer usage: ");
-        printf("  %10.2lf MB\n", memusage);
-        printf("  buflen = %d\n", ga_buffer_len);
         fflush(stdout);
     }
     GA_Sync();
@@ -126,26 +128,19 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     if (!x_hndl) GA_Error("Duplicate failed: Scratch 1-D vector", 1);
     d_hndl = NGA_Duplicate(n_hndl, "Diagonal vector");
     if (!d_hndl) GA_Error("Duplicate failed: Diagonal vectors", 1);
-    /* Set wavefunction global array */
-    w_dims[0] = ndets;
-    w_dims[1] = 3;
-    w_chunk[0] = -1; // Distribute evenly
-    w_chunk[1] =  3;
-    w_hndl = NGA_Create(C_INT, 2, w_dims, "Determinant Triples",w_chunk);
-    if (!w_hndl) GA_Error("Create failed: Determinant Triples", 2);
     
     if (mpi_proc_rank == mpi_root) {
         printf("Global arrays created.\n\n");
         fflush(stdout);
     }
 
-    /* Generate wavefunction list */
-    if (mpi_proc_rank == mpi_root) {
-        printf("Generating wlist...\n");
-        fflush(stdout);
-    }
-    generate_wlist(w_hndl, ndets, pq_space_pairs, num_pq, peospace, pegrps,
-                   qeospace, qegrps);
+    /* Determinants are addressed implicitly by (p,q) block; there is
+     * no global determinant list. */
+    wdet = create_detaddress(pq_space_pairs, num_pq, peospace, pegrps,
+                             qeospace, qegrps);
+    if (wdet == NULL) error = 1;
+    mpi_error_check_msg(error, "pdavidson",
+                        "Could not allocate determinant address map.");
 
     /* Allocate local arrays: d, vhv, hevec, heval */
     d_local = malloc(((ndets / mpi_num_procs) + 10) * sizeof(double));
@@ -155,24 +150,62 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     /* Allocate 1-d scratch arrays. */
     vhv_scr = malloc(krymax * krymax * sizeof(double));
     hevec_scr = malloc(krymax * krymax * sizeof(double));
+    /* Allocate per-thread sigma scratch once for all Hv=c products. */
+    nthrd = omp_get_max_threads();
+    sscr = allocate_sigma_scratch(nthrd, peospace, pegrps, qeospace, qegrps,
+                                  pq_space_pairs, num_pq, krymax, aelec,
+                                  belec, totalmo, sigaccum);
+    if (sscr == NULL) error = 1;
+    mpi_error_check_msg(error, "pdavidson",
+                        "Could not allocate sigma scratch arrays.");
+
+    if (spinsym != 0 && mpi_proc_rank == mpi_root) {
+        printf(" Ms=0 spin-flip symmetry: C(p,q) = %d*C(q,p)\n", spinsym);
+        printf("  beta-only sigma skipped; V and C stored in full\n");
+        fflush(stdout);
+    }
+
+    /* Coefficient screening: an error in c(i) of at most sigscreen*restol
+     * per skipped element, using the bound on |H(i,j)|. */
+    if (sigscreen > 0.0) {
+        vtol = sigscreen * restol /
+            compute_hij_bound(moints1, moints2, totalmo, aelec, belec);
+        if (mpi_proc_rank == mpi_root) {
+            printf(" Sigma screening: sigscreen = %e, |v| < %e skipped\n",
+                   sigscreen, vtol);
+            fflush(stdout);
+        }
+    }
     
     GA_Sync();
     
     /* Compute diagonal matrix elements <i|H|i> */
+    perftimer_start(PT_DIAGONAL);
     NGA_Zero(d_hndl);
     NGA_Distribution(d_hndl, mpi_proc_rank, lo, hi);
     if (mpi_proc_rank == mpi_root) {
         printf("Computing diagonal matrix elements...\n");
         fflush(stdout);
     }
-    compute_diagonal_iHi(d_local, lo[0], hi[0], moints1, moints2, aelec,
-			 belec, intorb, w_hndl, pstrings, qstrings);
+    compute_diagonal_iHi(d_local, lo[0], hi[0], moints1, moints2, mslab,
+			 aelec, belec, intorb, wdet, pstrings, qstrings);
     NGA_Put(d_hndl, lo, hi, d_local, ld_1d);
     if (printlvl > 0 && lo[0] == 0) {
         printf("<1|H|1> = ");
         printf("%lf\n", (d_local[0] + totcore_e));
 	fflush(stdout);
     }
+    GA_Sync();
+
+    /* Set up the correction vector preconditioner. The PRECOND_BLOCK
+     * block has the same dimension as the reference space. */
+    error = init_precond(&pc, precond, pcshift, refdim, d_hndl, ndets, wdet,
+                         pstrings, qstrings, moints1, moints2, aelec, belec,
+                         intorb);
+    mpi_error_check_msg(error, "pdavidson",
+                        "Could not set up preconditioner.");
+    print_precond_info(&pc);
+    perftimer_stop(PT_DIAGONAL);
 
     if (mpi_proc_rank == mpi_root) {
         printf("\nBeginning Davidson algorithm...\n");
@@ -180,10 +213,18 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     }
 
     /* Build initial guess basis vectors. */
+    perftimer_start(PT_GUESS);
     build_init_guess_vectors(prediagr, v_hndl, refdim, krymin, ndets,
                              pstrings, peospace, pegrps, qstrings,
                              qeospace, qegrps, pq_space_pairs, num_pq,
-                             moints1, moints2, aelec, belec, intorb, w_hndl);
+                             moints1, moints2, aelec, belec, intorb, wdet);
+    if (spinsym != 0) {
+        project_spinflip_basis(v_hndl, n_hndl, krymin, ndets, spinsym,
+                               wdet, pstrings, peospace, pegrps, qstrings,
+                               qeospace, qegrps, pq_space_pairs, num_pq,
+                               ndocc, nactv);
+    }
+    perftimer_stop(PT_GUESS);
     if (mpi_proc_rank == mpi_root) {
         printf(" Initial guess vectors set.\n");
         fflush(stdout);
@@ -218,12 +259,12 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
                              qeospace, qegrps, pq_space_pairs, num_pq,
                              moints1, moints2, aelec, belec, intorb,
                              ndets, totcore_e, ckdim, krymax, v_hndl, d_hndl,
-                             c_hndl, w_hndl, ga_buffer_len);
+                             c_hndl, wdet, ga_buffer_len);
         //perform_hvispacefast_debug(pstrings, peospace, pegrps, qstrings,
         //                     qeospace, qegrps, pq_space_pairs, num_pq,
         //                     moints1, moints2, aelec, belec, intorb,
         //                     ndets, totcore_e, ckdim, krymax, v_hndl, d_hndl,
-        //                     c_hndl, w_hndl, ga_buffer_len, totalmo,
+        //                     c_hndl, wdet, ga_buffer_len, totalmo,
         //                     ndocc, nactv);
 	
         print_gavectors2file_dbl_trans(c_hndl, ndets, ckdim, "c.old");
@@ -231,12 +272,15 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
         
 #endif
         
+        perftimer_start(PT_SIGMA);
+        perftimer_count(PC_SIGMA_CALLS, 1);
         perform_hvispacefast(pstrings, peospace, pegrps, qstrings,
                              qeospace, qegrps, pq_space_pairs, num_pq,
-                             moints1, moints2, aelec, belec, intorb,
+                             moints1, moints2, mslab, aelec, belec, intorb,
                              ndets, totcore_e, ckdim, krymax, v_hndl, d_hndl,
-                             c_hndl, w_hndl, ga_buffer_len, totalmo,
-                             ndocc, nactv);
+                             c_hndl, wdet, ga_buffer_len, totalmo,
+                             ndocc, nactv, sscr, vtol, spinsym);
+        perftimer_stop(PT_SIGMA);
 	//return 0;    
 #ifdef DEBUGGING
         print_gavectors2file_dbl_trans(c_hndl, ndets, ckdim, "c.new");
@@ -244,12 +288,14 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
 	return 0;
 #endif
 
+        perftimer_start(PT_SUBSPACE);
 	make_subspacehmat_ga(v_hndl, c_hndl, ndets, ckdim, vhv);
         print_subspacehmat(vhv, ckdim);
         error = diag_subspacehmat(vhv, hevec, heval, ckdim, krymax,
                                   vhv_scr, hevec_scr);
         if (error != 0)  return error;
         print_subspace_eigeninfo(hevec, heval, ckdim, totcore_e);
+        perftimer_stop(PT_SUBSPACE);
         
         GA_Sync();
         
@@ -257,9 +303,11 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
             
             GA_Sync();
             
+            perftimer_start(PT_RESIDUAL);
             generate_residual(v_hndl, c_hndl, r_hndl, hevec, heval,
                               ndets, ckdim, croot, x_hndl);
             compute_GA_norm(r_hndl, &rnorm);
+            perftimer_stop(PT_RESIDUAL);
             print_iter_info(heval, ckdim, croot, rnorm, totcore_e);
             
             GA_Sync();
@@ -287,13 +335,24 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
             
             GA_Sync();
             
-            generate_newvector(r_hndl, d_hndl, heval[croot - 1],
-                               ndets, n_hndl, x_hndl);
+            perftimer_start(PT_RESIDUAL);
+            nfloor = generate_newvector(r_hndl, d_hndl, heval[croot - 1],
+                                        ndets, n_hndl, x_hndl, v_hndl, hevec,
+                                        ckdim, croot, &pc);
+            /* Keep the Krylov space within the spin-flip symmetry */
+            if (spinsym != 0) {
+                apply_spinflip_ga(n_hndl, 0, 0, 0.5, (0.5 * spinsym), wdet,
+                                  pstrings, peospace, pegrps, qstrings,
+                                  qeospace, qegrps, pq_space_pairs, num_pq,
+                                  ndocc, nactv);
+            }
+            perftimer_stop(PT_RESIDUAL);
             
+            perftimer_start(PT_ORTHO);
             compute_GA_norm(n_hndl, &nnorm);
             if (mpi_proc_rank == mpi_root) {
-                printf("\n ||r|| = %12.8lf  ||n|| = %12.8lf\n",
-                       rnorm, nnorm);
+                printf("\n ||r|| = %12.8lf  ||n|| = %12.8lf  floored = %d\n",
+                       rnorm, nnorm, nfloor);
                 fflush(stdout);
             }
             
@@ -303,34 +362,43 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
             ckdim++;
             
             add_new_vector(v_hndl, ckdim, ndets, n_hndl);
+            perftimer_stop(PT_ORTHO);
+            perftimer_start(PT_SIGMA);
+            perftimer_count(PC_SIGMA_CALLS, 1);
             compute_hv_newvectorfaster(pstrings, peospace, pegrps, qstrings,
                                        qeospace, qegrps, pq_space_pairs, num_pq,
-                                       moints1, moints2, aelec, belec, intorb,
-                                       ndets, totcore_e, ckdim, krymax, v_hndl, d_hndl,
-                                       c_hndl, w_hndl, ga_buffer_len, totalmo,
-                                       ndocc, nactv);
+                                       moints1, moints2, mslab, aelec, belec,
+                                       intorb, ndets, totcore_e, ckdim, krymax,
+                                       v_hndl, d_hndl,
+                                       c_hndl, wdet, ga_buffer_len, totalmo,
+                                       ndocc, nactv, sscr, vtol, spinsym);
+            perftimer_stop(PT_SIGMA);
             //compute_hv_newvector(v_hndl, c_hndl, ckdim, pstrings,
             //                     peospace, pegrps, qstrings,
             //                     qeospace, qegrps, pq_space_pairs,
             //                     num_pq, moints1, moints2, aelec,
             //                     belec, intorb, ndets, krymax,
-            //                     w_hndl, ga_buffer_len);
+            //                     wdet, ga_buffer_len);
             
             
+            perftimer_start(PT_SUBSPACE);
             make_subspacehmat_ga(v_hndl, c_hndl, ndets, ckdim, vhv);
             print_subspacehmat(vhv, ckdim);
             error = diag_subspacehmat(vhv, hevec, heval, ckdim,
                                       krymax, vhv_scr, hevec_scr);
             if (error != 0)  return error;
             print_subspace_eigeninfo(hevec, heval, ckdim, totcore_e);
+            perftimer_stop(PT_SUBSPACE);
             citer++;
         }
         /* truncate the krylov space. Note: the Hv=c array is used
          * as a scratch buffer for this routine. */
+        perftimer_start(PT_SUBSPACE);
         truncate_krylov_space(v_hndl, ndets, krymin, krymax, croot,
                               hevec, c_hndl);
         ckdim = krymin;
         GA_Zero(c_hndl);
+        perftimer_stop(PT_SUBSPACE);
         /* Check if CI has converged. If it has, leave loop. */
         if (cflag == 2) {
             break;
@@ -338,13 +406,18 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     }
     if (mpi_proc_rank == mpi_root) {
         printf(" Davidson algorithm finished. \n");
+        printf(" Davidson iterations: %d\n", citer);
         fflush(stdout);
     }
+    perftimer_start(PT_IO);
     print_gavectors2file_dbl_ufmt(v_hndl, ndets, nroots,"civec");
     if (cflag != 2) {
 	print_gavectors2file_dbl_ufmt(v_hndl, ndets, krymin, "ci.restart");
         print_gavectors2file_dbl_ufmt(c_hndl, ndets, nroots, "hvvec");
     }
+    perftimer_stop(PT_IO);
+    perftimer_stop(PT_DAVIDSON);
+    perftimer_report("pjayci_timers.json", citer);
     /* Deallocate arrays */
     free(d_local);
     free(heval);
@@ -352,6 +425,9 @@ int pdavidson(struct occstr *pstrings, struct eospace *peospace, int pegrps,
     free(hevec_scr);
     deallocate_mem_cont(&vhv, vhv_data);
     deallocate_mem_cont(&hevec, hevec_data);
+    deallocate_sigma_scratch(sscr, nthrd);
+    free_detaddress(wdet);
+    free_precond(&pc);
     return error;
 }
 
@@ -372,6 +448,95 @@ void add_new_vector(int v_hndl, int cdim, int len, int n_hndl)
         return;
 }
 
+/*
+ * allocate_sigma_scratch: allocate per-thread scratch arrays for the
+ * sigma kernels. Sizes are the largest any block of the expansion needs.
+ * Input:
+ *  nthrd  = number of threads
+ *  peosp  = alpha electron occupation spaces
+ *  pegrps = number of alpha electron occupation spaces
+ *  qeosp  = beta  electron occupation spaces
+ *  qegrps = number of beta  electron occupation spaces
+ *  pq     = valid (p,q) space pairings
+ *  npq    = number of valid (p,q) space pairings
+ *  mdim   = maximum number of vectors in a Hv=c product
+ *  aelec  = alpha electrons
+ *  belec  = beta  electrons
+ *  nmos   = number of CI orbitals
+ *  sigaccum = C(j,k) accumulation, SIGACC_BINS or SIGACC_COPIES
+ * Returns:
+ *  scr = array of nthrd scratch structures (NULL on failure)
+ */
+struct sigma_scratch *allocate_sigma_scratch(int nthrd, struct eospace *peosp,
+                                             int pegrps, struct eospace *qeosp,
+                                             int qegrps, int **pq, int npq,
+                                             int mdim, int aelec, int belec,
+                                             int nmos, int sigaccum)
+{
+    struct sigma_scratch *scr = NULL;
+    int xlistmax = 0; /* Largest string space */
+    int buflen = 0;   /* Largest (p,q) block */
+    int error = 0;
+    int i;
+
+    for (i = 0; i < pegrps; i++) {
+        xlistmax = int_max(xlistmax, peosp[i].nstr);
+    }
+    for (i = 0; i < qegrps; i++) {
+        xlistmax = int_max(xlistmax, qeosp[i].nstr);
+    }
+    for (i = 0; i < npq; i++) {
+        buflen = int_max(buflen,
+                         peosp[pq[i][0]].nstr * qeosp[pq[i][1]].nstr);
+    }
+
+    scr = calloc(nthrd, sizeof(struct sigma_scratch));
+    if (scr == NULL) return scr;
+
+    /* Each thread allocates its own scratch, so that pages first touched
+     * here or by the thread's sigma kernels are placed in the memory of
+     * the thread's NUMA domain. jindx holds at most one (p,q) block. */
+#pragma omp parallel for schedule(static,1) num_threads(nthrd) \
+    reduction(+:error)
+    for (i = 0; i < nthrd; i++) {
+        scr[i].pxlist = malloc(sizeof(struct xstr) * xlistmax);
+        scr[i].qxlist = malloc(sizeof(struct xstr) * xlistmax);
+        scr[i].xstrscr= malloc(sizeof(struct xstr) * xlistmax);
+        scr[i].elecx  = malloc(sizeof(int) * int_max(aelec, belec));
+        scr[i].orbsx  = malloc(sizeof(int) * nmos);
+        scr[i].jindx  = malloc(sizeof(int) * buflen);
+        scr[i].cik    = malloc(sizeof(double) * mdim);
+        scr[i].hijval = malloc(sizeof(double) * buflen);
+        scr[i].cjs.nbin = nthrd;
+        scr[i].cjs.n    = calloc(nthrd, sizeof(int));
+        scr[i].cjs.nmax = calloc(nthrd, sizeof(int));
+        scr[i].cjs.e    = calloc(nthrd, sizeof(struct cj_entry *));
+        if (sigaccum == SIGACC_COPIES) {
+            scr[i].cjs.cjk = calloc(((size_t) mdim * buflen),
+                                    sizeof(double));
+            if (scr[i].cjs.cjk == NULL) {
+                error++;
+                continue;
+            }
+        }
+        if (scr[i].pxlist == NULL || scr[i].qxlist == NULL ||
+            scr[i].xstrscr == NULL || scr[i].elecx == NULL ||
+            scr[i].orbsx == NULL || scr[i].jindx == NULL ||
+            scr[i].cik == NULL || scr[i].hijval == NULL ||
+            scr[i].cjs.n == NULL || scr[i].cjs.nmax == NULL ||
+            scr[i].cjs.e == NULL) {
+            error++;
+            continue;
+        }
+        memset(scr[i].hijval, 0, (sizeof(double) * buflen));
+    }
+    if (error != 0) {
+        deallocate_sigma_scratch(scr, nthrd);
+        return NULL;
+    }
+    return scr;
+}
+
 /*
  * build_init_guess_vectors: build initial guess basis vectors for davidson
  * procedure.
@@ -387,7 +552,8 @@ void build_init_guess_vectors(int n, int v, int dim, int kmin, int ndets,
                               int pegrps, struct occstr *qstr,
                               struct eospace *qeosp, int qegrps,
                               int **pqs, int num_pq, double *m1, double *m2,
-                              int aelec, int belec, int intorb, int w_hndl)
+                              int aelec, int belec, int intorb,
+                              struct detaddress *wdet)
 {
         double **refspace = NULL; /* Reference space */
         double *rdata = NULL;     /* Reference space data */
@@ -412,7 +578,7 @@ void build_init_guess_vectors(int n, int v, int dim, int kmin, int ndets,
         
         if (mpi_proc_rank == mpi_root && n == 1) {
                 /* Diagonalize subspace of H */
-                init_diag_H_subspace(w_hndl,
+                init_diag_H_subspace(wdet,
                                      pstr, qstr, m1, m2, aelec, belec, intorb,
                                      ndets, dim, refspace);
                 
@@ -456,7 +622,7 @@ void build_init_guess_vectors(int n, int v, int dim, int kmin, int ndets,
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -476,7 +642,8 @@ void build_init_guess_vectors(int n, int v, int dim, int kmin, int ndets,
  *  ndets  = total number of determinants
  *  nmos   = total number of molecular orbitals
  */
-void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_H(double **c, int ccols, int crows, int **wi,
+                      struct detaddress *wdet,
                       int v_hndl, int d_hndl, int buflen, struct occstr *pstr,
                       struct eospace *peosp, int pegrps,  struct occstr *qstr,
                       struct eospace *qeosp, int qegrps, int **pq, int npq,
@@ -595,7 +762,7 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
             evaluate_hij_pxlist1x(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
                                   qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                   belec, intorb, cik, buflen, vcols, vindx, windx,
-                                  jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                  jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                   v_hndl);
 
             for (k = 0; k < ccols; k++) {
@@ -616,7 +783,7 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
             evaluate_hij_qxlist1x(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
                                   qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                   belec, intorb, cik, buflen, vcols, vindx, windx,
-                                  jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                  jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                   v_hndl);
 
             for (k = 0; k < ccols; k++) {
@@ -642,7 +809,7 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
                                     pegrps, qstr, qeosp, qegrps, pq, npq, m1, m2,
                                     aelec, belec, intorb, cik, buflen, vcols,
                                     vindx, windx, jindx, vlocal, vdata, wj, wjdata,
-                                    hijval, w_hndl, v_hndl);
+                                    hijval, wdet, v_hndl);
 
             for (k = 0; k < ccols; k++) {
                 c[k][i] = c[k][i] + cik[k];
@@ -664,7 +831,7 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
             evaluate_hij_pxlist2x(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
                                   qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                   belec, intorb, cik, buflen, vcols, vindx, windx,
-                                  jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                  jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                   v_hndl);
             for (k = 0; k < ccols; k++) {
                 c[k][i] = c[k][i] + cik[k];
@@ -685,7 +852,7 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
             evaluate_hij_qxlist2x(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
                                   qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                   belec, intorb, cik, buflen, vcols, vindx, windx,
-                                  jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                  jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                   v_hndl);
             for (k = 0; k < ccols; k++) {
                 c[k][i] = c[k][i] + cik[k];
@@ -706,7 +873,7 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -726,7 +893,8 @@ void compute_cblock_H(double **c, int ccols, int crows, int **wi, int w_hndl,
  *  ndets  = total number of determinants
  *  nmos   = total number of molecular orbitals
  */
-void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi,
+                          struct detaddress *wdet,
                           int v_hndl, int d_hndl, int buflen,struct occstr *pstr,
                           struct eospace *peosp, int pegrps, struct occstr *qstr,
                           struct eospace *qeosp, int qegrps, int **pq, int npq,
@@ -838,13 +1006,13 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
 //            evaluate_hij_pxlist1x_ut(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
 //                                     qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
 //                                     belec, intorb, cik, buflen, vcols, vindx, windx,
-//                                     jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+//                                     jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
 //                                     v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2);
             
             //evaluate_hij_pxlist1x(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
             //                      qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
             //                      belec, intorb, cik, buflen, vcols, vindx, windx,
-            //                      jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+            //                      jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
             //                      v_hndl);
 
             for (k = 0; k < ccols; k++) {
@@ -864,12 +1032,12 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
 //            evaluate_hij_qxlist1x_ut(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
 //                                     qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
 //                                     belec, intorb, cik, buflen, vcols, vindx, windx,
-//                                     jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+//                                     jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
 //                                     v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2);
             //evaluate_hij_qxlist1x(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
             //                     qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
             //                      belec, intorb, cik, buflen, vcols, vindx, windx,
-            //                      jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+            //                      jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
             //                      v_hndl);
             
             for (k = 0; k < ccols; k++) {
@@ -894,13 +1062,13 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
 //                                       pegrps, qstr, qeosp, qegrps, pq, npq, m1, m2,
 //                                       aelec, belec, intorb, cik, buflen, vcols,
 //                                       vindx, windx, jindx, vlocal, vdata, wj, wjdata,
-//                                       hijval, w_hndl, v_hndl, c_hndl, (cstep + i),
+//                                       hijval, wdet, v_hndl, c_hndl, (cstep + i),
 //                                       vik, cjk, vindx2);
             //evaluate_hij_pxqxlist2x(deti, pxlist, npx, qxlist, nqx, pstr, peosp,
             //                        pegrps, qstr, qeosp, qegrps, pq, npq, m1, m2,
             //                        aelec, belec, intorb, cik, buflen, vcols,
             //                        vindx, windx, jindx, vlocal, vdata, wj, wjdata,
-            //                        hijval, w_hndl, v_hndl);
+            //                        hijval, wdet, v_hndl);
 
             for (k = 0; k < ccols; k++) {
                 c[k][i] = c[k][i] + cik[k];
@@ -921,12 +1089,12 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
 //            evaluate_hij_pxlist2x_ut(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
 //                                     qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
 //                                     belec, intorb, cik, buflen, vcols, vindx, windx,
-//                                     jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+//                                     jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
 //                                     v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2);
             //evaluate_hij_pxlist2x(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
             //                      qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
             //                      belec, intorb, cik, buflen, vcols, vindx, windx,
-            //                      jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+            //                      jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
             //                      v_hndl);
             for (k = 0; k < ccols; k++) {
                 c[k][i] = c[k][i] + cik[k];
@@ -948,12 +1116,12 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
 //            evaluate_hij_qxlist2x_ut(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
 //                                     qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
 //                                     belec, intorb, cik, buflen, vcols, vindx, windx,
-//                                     jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+//                                     jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
 //                                     v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2);
             //evaluate_hij_qxlist2x(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
             //                      qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
             //                      belec, intorb, cik, buflen, vcols, vindx, windx,
-            //                      jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+            //                      jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
             //                      v_hndl);
 
             for (k = 0; k < ccols; k++) {
@@ -986,7 +1154,7 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -1011,7 +1179,8 @@ void compute_cblock_Hfast(double **c, int ccols, int crows, int **wi, int w_hndl
  *  cstep  = first row index in block
  *  colnums= indices of C_i to evaluate Hv_i=c_i 
  */
-void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi,
+                            struct detaddress *wdet,
                             int v_hndl, int d_hndl, int buflen,struct occstr *pstr,
                             struct eospace *peosp, int pegrps, struct occstr *qstr,
                             struct eospace *qeosp, int qegrps, int **pq, int npq,
@@ -1136,7 +1305,7 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
                     evaluate_hij_pxlist1x_ut(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
                                              qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                              belec, intorb, cik, buflen, vcols, vindx, windx,
-                                             jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                             jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                              v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2,
                                              colnums);
                     for (k = 0; k < ccols; k++) {
@@ -1160,7 +1329,7 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
                                                pegrps, qstr, qeosp, qegrps, pq, npq, m1, m2,
                                                aelec, belec, intorb, cik, buflen, vcols,
                                                vindx, windx, jindx, vlocal, vdata, wj, wjdata,
-                                               hijval, w_hndl, v_hndl, c_hndl, (cstep + i),
+                                               hijval, wdet, v_hndl, c_hndl, (cstep + i),
                                                vik, cjk, vindx2, colnums);
                     
                     for (k = 0; k < ccols; k++) {
@@ -1184,7 +1353,7 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
                     evaluate_hij_pxlist2x_ut(deti, pxlist, npx, iq, 1, pstr, peosp, pegrps,
                                              qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                              belec, intorb, cik, buflen, vcols, vindx, windx,
-                                             jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                             jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                              v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2,
                                              colnums);
                     for (k = 0; k < ccols; k++) {
@@ -1209,7 +1378,7 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
                 evaluate_hij_qxlist1x_ut(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
                                          qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                          belec, intorb, cik, buflen, vcols, vindx, windx,
-                                         jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                         jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                          v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2,
                                          colnums);
                 for (k = 0; k < ccols; k++) {
@@ -1229,7 +1398,7 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
                 evaluate_hij_qxlist2x_ut(deti, ip, 1, qxlist, nqx, pstr, peosp, pegrps,
                                          qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
                                          belec, intorb, cik, buflen, vcols, vindx, windx,
-                                         jindx, vlocal, vdata, wj, wjdata, hijval, w_hndl,
+                                         jindx, vlocal, vdata, wj, wjdata, hijval, wdet,
                                          v_hndl, c_hndl, (cstep + i), vik, cjk, vindx2,
                                          colnums);
                 for (k = 0; k < ccols; k++) {
@@ -1267,7 +1436,7 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
  *  ccols  = columns of c array
  *  crows  = rows of c array
  *  wi     = p, q, cas triples for c elements
- *  w_hndl = GA handle of wavefunction info
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  *  v_hndl = GA handle for vectors, V
  *  d_hndl = GA handle for diagonal vectors, D
  *  buflen = length of buffer (set by user during input)
@@ -1281,6 +1450,7 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
  *  npq    = number of valid elec-occupation spaces of expansion
  *  m1     = 1-e integrals
  *  m2     = 2-e integrals
+ *  mslab  = per-pair integral slabs
  *  aelec  = alpha electrons
  *  belec  = beta  electrons
  *  intorb = internal orbitals (DOCC + ACTV)
@@ -1292,14 +1462,21 @@ void compute_cblock_Hfaster(double *c1d, int ccols, int crows, int **wi, int w_h
  *  cstep  = first row index in block
  *  cmax   = last  row index in block
  *  colnums= indices of C_i to evaluate Hv_i=c_i 
+ *  scr    = per-thread sigma scratch arrays
+ *  vtol   = |v| screening threshold (0 = off)
+ *  spinsym= Ms=0 spin-flip symmetry of v (1, -1; 0 = off)
  */
-void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_hndl,
+void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi,
+                             struct detaddress *wdet,
                              int v_hndl, int d_hndl, int buflen,struct occstr *pstr,
                              struct eospace *peosp, int pegrps, struct occstr *qstr,
                              struct eospace *qeosp, int qegrps, int **pq, int npq,
-                             double *m1, double *m2, int aelec,int belec,int intorb,
+                             double *m1, double *m2, struct moslab *mslab,
+                             int aelec,int belec,int intorb,
                              int ndets, int nmos, int ndocc, int nactv, int c_hndl,
-                             int cstep, int cmax, int *colnums)
+                             int cstep, int cmax, int *colnums,
+                             struct sigma_scratch *scr, double vtol,
+                             int spinsym)
 {
     /* GA V(j) buffer and indices */
     double *vjdata = NULL;
@@ -1310,6 +1487,8 @@ void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_
     /* GA V(i) buffer */
     double *vidata = NULL;
     int vi_lo[2] = {0, 0}, vi_hi[2] = {0, 0}, vi_ld[1] = {0};
+    /* V(i) transposed to [i][k], shared by all blocks |j> */
+    double *vik = NULL;
     
     /* Starting, ending determinant indices for determinants |j> */
     int jstartdet = 0, jfinaldet = 0;
@@ -1317,10 +1496,15 @@ void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_
     int jmax = 0;
     int maxbuf = 0;
     int *wjscr = 0;
-    int w_lo[2] = {0, 0}, w_hi[2] = {0, 0}, w_ld[1] = {0};
 
     int ipspace = 0, iqspace = 0;
     int pqstart = 0;
+
+    /* Coefficient screening: block maxima of |v| and pq block starts */
+    double *vmax = NULL;
+    int *pqdet = NULL;
+    double ivmax = 0.0;
+    long long int nskip = 0, ntot = 0, nsum[2] = {0, 0};
     
     double alpha[1] = {1.0};
     int i, j;
@@ -1338,6 +1522,7 @@ void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_
     vjdata = malloc(sizeof(double) * buflen * ccols);
     cjdata = malloc(sizeof(double) * buflen * ccols);
     vidata = malloc(sizeof(double) * crows * ccols);
+    vik    = malloc(sizeof(double) * crows * ccols);
     wjscr = malloc(sizeof(int) * 3);
 
     /* Get V(i,k) buffers */
@@ -1346,7 +1531,25 @@ void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_
     vi_lo[1] = cstep;
     vi_hi[1] = cmax;
     vi_ld[0] = crows;
-    NGA_Get(v_hndl, vi_lo, vi_hi, vidata, vi_ld);
+    perftimer_nga_get(v_hndl, vi_lo, vi_hi, vidata, vi_ld);
+    /* Transpose once: vik[i][k] = vi[k][i] */
+    for (i = 0; i < crows; i++) {
+        for (j = 0; j < ccols; j++) {
+            vik[i * ccols + j] = vidata[j * crows + i];
+        }
+    }
+
+    /* Screening: |v| maxima per pq block, and largest over rows |i> */
+    if (vtol > 0.0) {
+        vmax  = malloc(sizeof(double) * npq);
+        pqdet = malloc(sizeof(int) * (npq + 1));
+        compute_pqblock_vmax(v_hndl, colnums[0], colnums[ccols - 1], pq,
+                             npq, peosp, pegrps, qeosp, qegrps, pqdet, vmax);
+        for (i = 0; i < npq; i++) {
+            if (pqdet[i + 1] <= cstep || pqdet[i] > cmax) continue;
+            if (vmax[i] > ivmax) ivmax = vmax[i];
+        }
+    }
 
     /* Get pq pairing of first determinant i */
     ipspace = get_string_eospace(&(pstr[wi[0][0]]), ndocc, nactv, peosp, pegrps);
@@ -1359,6 +1562,12 @@ void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_
     for (i = pqstart; i < npq; i++) {
         get_eospace_detrange(pq, npq, i, peosp, pegrps, qeosp, qegrps,
                              &jstartdet, &jfinaldet);
+        ntot = ntot + crows;
+        /* Neither c(i) += H(i,j)v(j) nor c(j) += H(i,j)v(i) can matter */
+        if (vtol > 0.0 && vmax[i] < vtol && ivmax < vtol) {
+            nskip = nskip + crows;
+            continue;
+        }
         for (j = jstartdet; j <= jfinaldet; j += buflen) {
             init_dbl_array_0(cjdata, (buflen * ccols));
             jmax = int_min((j + buflen - 1), jfinaldet);
@@ -1367,38 +1576,47 @@ void compute_cblock_Hfastest(double *c1d, int ccols, int crows, int **wi, int w_
             vj_hi[0] = colnums[ccols - 1];
             vj_hi[1] = jmax;
             vj_ld[0] = jmax - j + 1;
-            NGA_Get(v_hndl, vj_lo, vj_hi, vjdata, vj_ld);
+            perftimer_nga_get(v_hndl, vj_lo, vj_hi, vjdata, vj_ld);
             
-            w_lo[0] = j;
-            w_lo[1] = 0;
-            w_hi[0] = j;
-            w_hi[1] = 2;
-            w_ld[0] = 3;
-            NGA_Get(w_hndl, w_lo, w_hi, wjscr, w_ld);
+            get_det_triple(wdet, j, wjscr);
             jstartp = wjscr[0];
             jstartq = wjscr[1];
-            w_lo[0] = jmax;
-            w_hi[0] = jmax;
-            NGA_Get(w_hndl, w_lo, w_hi, wjscr, w_ld);
+            get_det_triple(wdet, jmax, wjscr);
             jfinalp = wjscr[0];
             jfinalq = wjscr[1];
             
             compute_hij_eosp(c1d, ccols, crows, wi, pstr, peosp, pegrps,
-                             qstr, qeosp, qegrps, pq, npq, m1, m2, aelec,
+                             qstr, qeosp, qegrps, pq, npq, m1, m2, mslab, aelec,
                              belec,
                              intorb, nmos, ndocc, nactv, cstep, colnums,
                              jstartdet, jmax, jstartp, jstartq, jfinalp,
-                             jfinalq, pq[i], vjdata, vidata, cjdata, i);
+                             jfinalq, pq[i], vjdata, vik, cjdata, i, scr,
+                             vmax, pqdet, vtol, &nskip, spinsym);
             
-            NGA_Acc(c_hndl, vj_lo, vj_hi, cjdata, vj_ld, alpha);
+            perftimer_nga_acc(c_hndl, vj_lo, vj_hi, cjdata, vj_ld, alpha);
 
         }
     }
+    /* Report screening. Row-block pairs are counted once per block |j>. */
+    if (vtol > 0.0) {
+        nsum[0] = nskip;
+        nsum[1] = ntot;
+        MPI_Allreduce(MPI_IN_PLACE, nsum, 2, MPI_LONG_LONG_INT, MPI_SUM,
+                      MPI_COMM_WORLD);
+        if (mpi_proc_rank == mpi_root) {
+            printf(" Sigma screening: skipped %lld of %lld row-block pairs.\n",
+                   nsum[0], nsum[1]);
+            fflush(stdout);
+        }
+        free(vmax);
+        free(pqdet);
+    }
     /* Deallocate buffers */
     free(wjscr);
     free(vjdata);
     free(cjdata);
     free(vidata);
+    free(vik);
     return;
 }
 
@@ -1578,47 +1796,39 @@ void compute_diagonal_matrix_elements(double *hdgls, int start, int final,
  *  final   = final determinant index
  *  mo1     = 1-e integrals
  *  mo2     = 2-e integrals
+ *  mslab   = per-pair integral slabs
  *  aelec   = CI alpha electrons
  *  belec   = CI beta  electrons
  *  intorb  = internal orbitals (DOCC + CAS)
- *  w_hndl  = global array handle for wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  */
 void compute_diagonal_iHi(double *hdgls, int start, int final,
-			  double *mo1, double *mo2, int aelec,
-			  int belec, int intorb, int w_hndl,
+			  double *mo1, double *mo2, struct moslab *mslab,
+			  int aelec, int belec, int intorb, struct detaddress *wdet,
 			  struct occstr *pstr, struct occstr *qstr)
 {
     struct det deti;
     int **w   = NULL;    /* Wavefunction elements */
     int *wdata = NULL;   /* Memory block for w */
-    int w_lo[2]= {0, 0}; /* Beginning block of W */
-    int w_hi[2]= {0, 0}; /* Ending block of W */
-    int w_ld[1]= {0};    /* Leading dimension of local W */
     int i;
     
-    /* Set starting and ending indices for W in global array and
-     * grab these determinants. */
-    w_lo[0] = start;
-    w_lo[1] = 0;
-    w_hi[0] = final;
-    w_hi[1] = 2;
-    w_ld[0] = 3;
+    /* Get (p, q, cas) of determinants start, ..., final. */
     wdata = allocate_mem_int_cont(&w, 3, (final - start + 1));
     if (wdata == NULL) printf("Error! Could not allocate wdata!\n");
-    NGA_Get(w_hndl, w_lo, w_hi, wdata, w_ld);
+    get_det_triples(wdet, start, final, wdata);
     
     /* OMP SECTION */
 #pragma omp parallel                                            \
     default(none)                                               \
-    shared(hdgls, final, start, mo1, mo2, aelec, belec, intorb, \
-           pstr, qstr, w)                                         \
+    shared(hdgls, final, start, mo1, mo2, mslab, aelec, belec,  \
+           intorb, pstr, qstr, w)                               \
     private(i)
     {
 #pragma omp for schedule(runtime)
         /* Loop over these determinants */
         for (i = 0; i <= (final - start); i++) {
-            hdgls[i] = hmatels_0x(pstr[w[i][0]].istr, aelec, qstr[w[i][1]].istr,
-                                  belec, mo1, mo2);
+            hdgls[i] = hmatels_0x_slab(pstr[w[i][0]].istr, aelec,
+                                       qstr[w[i][1]].istr, belec, mo1, mslab);
         }
     } /* END OMP SECTION */
     
@@ -1635,13 +1845,14 @@ void compute_diagonal_iHi(double *hdgls, int start, int final,
  *  v_hndl = GA handle for basis vectors (ckdim is new vector)
  *  c_hndl = GA handle for Hv=c vectors
  *  ckdim  = current dimension of space
- *  w_hndl = wavefunction list (deteriminant triplets)
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  */
 void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr,
                           struct eospace *peosp, int pegrps, struct occstr *qstr,
                           struct eospace *qeosp, int qegrps, int **pqs,
                           int num_pq, double *m1, double *m2, int aelec,
-                          int belec, int intorb, int ndets, int kmax, int w_hndl,
+                          int belec, int intorb, int ndets, int kmax,
+                          struct detaddress *wdet,
                           int ga_buffer_len)
 {
         
@@ -1671,15 +1882,9 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
         int c_hi[2]  = {0, 0};  /* ending indices of memory block */
         int v_lo[2]  = {0, 0};  /* starting indices of memory block */
         int v_hi[2]  = {0, 0};  /* ending indices of memory block */
-        int wi_lo[2] = {0, 0};
-        int wi_hi[2] = {0, 0};
-        int wj_lo[2] = {0, 0};
-        int wj_hi[2] = {0, 0};
         
         int v_ld[1]  = {0};  /* Leading dimensions of V local buffer */
         int c_ld[1]  = {0};  /* Leading dimensions of C local buffer */
-        int wi_ld[1] = {0};
-        int wj_ld[1] = {0};
 
         double alpha[1] = {1.0}; /* Scale factor for c_local into c_global. */
 
@@ -1699,16 +1904,11 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
         c_ld[0] = 1;          // 1-D array
         /* Allocate local array and get C data */
         c_local = malloc(sizeof(double) * c_rows);
-        NGA_Get(c_hndl, c_lo, c_hi, c_local, c_ld);
+        perftimer_nga_get(c_hndl, c_lo, c_hi, c_local, c_ld);
                 
         /* Allocate local Wi array and get W data */
         widata = allocate_mem_int_cont(&wi, 3, c_rows);
-        wi_lo[0] = c_lo[1];
-        wi_lo[1] = 0;
-        wi_hi[0] = c_hi[1];
-        wi_hi[1] = 2;
-        wi_ld[0] = 3;
-        NGA_Get(w_hndl, wi_lo, wi_hi, widata, wi_ld); 
+        get_det_triples(wdet, c_lo[1], c_hi[1], widata);
 
         v_lo[0] = ckdim - 1;
         v_hi[0] = ckdim - 1;
@@ -1724,9 +1924,6 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
         
         /* Allocate local Wj array  */
         wjdata = allocate_mem_int_cont(&wj, 3, buflen);
-        wj_lo[1] = 0;
-        wj_hi[1] = 2;
-        wj_ld[0] = 3;
 
         if (mpi_proc_rank == mpi_root) timestamp();
         GA_Sync();
@@ -1738,12 +1935,10 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
                 v_lo[1] = j;
                 v_hi[1] = jmax;
                 v_rows = v_hi[1] - v_lo[1] + 1;
-                NGA_Get(v_hndl, v_lo, v_hi, v_local, v_ld);
+                perftimer_nga_get(v_hndl, v_lo, v_hi, v_local, v_ld);
 
-                wj_lo[0] = j;
-                wj_hi[0] = jmax;
                 wjlen = jmax - j + 1;
-                NGA_Get(w_hndl, wj_lo, wj_hi, wjdata, wj_ld);
+                get_det_triples(wdet, j, jmax, wjdata);
                 
                 
                 /* Evaluate block of H(i,j)*V(j,k)=C(i,k). This is done via the   
@@ -1756,7 +1951,7 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
                                         intorb);
 
         }
-        NGA_Acc(c_hndl, c_lo, c_hi, c_local, c_ld, alpha);
+        perftimer_nga_acc(c_hndl, c_lo, c_hi, c_local, c_ld, alpha);
 
         free(v_local);
 
@@ -1773,15 +1968,22 @@ void compute_hv_newvector(int v_hndl, int c_hndl, int ckdim, struct occstr *pstr
  *  v_hndl = GA handle for basis vectors (ckdim is new vector)
  *  c_hndl = GA handle for Hv=c vectors
  *  ckdim  = current dimension of space
- *  w_hndl = wavefunction list (deteriminant triplets)
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ *  scr    = per-thread sigma scratch arrays
+ *  vtol   = |v| screening threshold (0 = off)
+ *  spinsym= Ms=0 spin-flip symmetry of v (1, -1; 0 = off)
  */
 void compute_hv_newvectorfaster(struct occstr *pstr, struct eospace *peosp, int pegrps,
                                 struct occstr *qstr, struct eospace *qeosp, int qegrps,
                                 int **pqs, int num_pq, double *m1, double *m2,
+                                struct moslab *mslab,
                                 int aelec, int belec, int intorb, int ndets,
                                 double core_e, int ckdim, int mdim, int v_hndl,
-                                int d_hndl, int c_hndl, int w_hndl, int ga_buffer_len,
-                                int nmo, int ndocc, int nactv)
+                                int d_hndl, int c_hndl,
+                                struct detaddress *wdet, int ga_buffer_len,
+                                int nmo, int ndocc, int nactv,
+                                struct sigma_scratch *scr, double vtol,
+                                int spinsym)
 {
     double *c_local = NULL;   /* Local array of C values */
     int c_lo[2] = {0, 0};     /* GA Init location */
@@ -1796,13 +1998,11 @@ void compute_hv_newvectorfaster(struct occstr *pstr, struct eospace *peosp, int
 
     int **wi       = NULL;     /* Local w array */
     int *widata    = NULL;     /* Local w array data (1-D) */
-    int wi_lo[2]   = {0, 0};
-    int wi_hi[2]   = {0, 0};
-    int wi_ld[1]   = {0};      /* Leading dimensions of Wi local buffer */
 
     int cindx[1] = {0};       /* Column v_i and c_i index i */
     
     double alpha[1] = {1.0};
+    double half = 0.5; /* Diagonal weight under spin-flip fold */
     
     if (mpi_proc_rank == mpi_root) {
         printf(" Computing Hv=c for new vector...\n");
@@ -1826,31 +2026,42 @@ void compute_hv_newvectorfaster(struct occstr *pstr, struct eospace *peosp, int
     c_ld[0] = 1;
     /* Allocate local array and get C data */
     c_local = malloc(sizeof(double) * c_rows);
-    NGA_Get(c_hndl, c_lo, c_hi, c_local, c_ld);
+    perftimer_nga_get(c_hndl, c_lo, c_hi, c_local, c_ld);
 
     /* Allocate local Wi array and get W data */
     widata = allocate_mem_int_cont(&wi, 3, c_rows);
-    wi_lo[0] = c_lo[1];
-    wi_lo[1] = 0;
-    wi_hi[0] = c_hi[1];
-    wi_hi[1] = 2;
-    wi_ld[0] = 3;
-    NGA_Get(w_hndl, wi_lo, wi_hi, widata, wi_ld); 
+    get_det_triples(wdet, c_lo[1], c_hi[1], widata);
     
     /* Compute C(i) = H(i,j)*V(j) for new vector */
     if (mpi_proc_rank == mpi_root) timestamp();
     GA_Sync();
     cindx[0] = ckdim - 1;
     compute_hvc_diagonal_ga(c_hndl, v_hndl, d_hndl, c_lo[0], c_lo[0], ndets);
-    compute_cblock_Hfastest(c_local, c_cols, c_rows, wi, w_hndl, v_hndl, d_hndl,
+    if (spinsym != 0) {
+        /* <i|H|i>v(i) is restored to full weight by the fold */
+        c_lo[1] = 0;
+        c_hi[1] = ndets - 1;
+        NGA_Scale_patch(c_hndl, c_lo, c_hi, &half);
+        c_lo[1] = lwrbnd;
+        c_hi[1] = uprbnd;
+    }
+    compute_cblock_Hfastest(c_local, c_cols, c_rows, wi, wdet, v_hndl, d_hndl,
                             ga_buffer_len, pstr, peosp, pegrps, qstr, qeosp, qegrps,
-                            pqs, num_pq, m1, m2, aelec, belec, intorb, ndets,
-                            nmo, ndocc, nactv, c_hndl, c_lo[1], c_hi[1], cindx);
-//    compute_cblock_Hfaster(c_local, c_cols, c_rows, wi, w_hndl, v_hndl, d_hndl,
+                            pqs, num_pq, m1, m2, mslab, aelec, belec, intorb,
+                            ndets, nmo, ndocc, nactv, c_hndl, c_lo[1], c_hi[1],
+                            cindx, scr, vtol, spinsym);
+//    compute_cblock_Hfaster(c_local, c_cols, c_rows, wi, wdet, v_hndl, d_hndl,
 //                           ga_buffer_len, pstr, peosp, pegrps, qstr, qeosp, qegrps,
 //                           pqs, num_pq, m1, m2, aelec, belec, intorb, ndets,
 //                           nmo, ndocc, nactv, c_hndl, c_lo[1], cindx);
-    NGA_Acc(c_hndl, c_lo, c_hi, c_local, c_ld, alpha);
+    perftimer_nga_acc(c_hndl, c_lo, c_hi, c_local, c_ld, alpha);
+    GA_Sync();
+    /* Restore the beta-only and remaining alpha-beta contributions */
+    if (spinsym != 0) {
+        apply_spinflip_ga(c_hndl, c_lo[0], c_lo[0], 1.0, (double) spinsym,
+                          wdet, pstr, peosp, pegrps, qstr, qeosp, qegrps,
+                          pqs, num_pq, ndocc, nactv);
+    }
     if (mpi_proc_rank == mpi_root) timestamp();
     free(c_local);
     deallocate_mem_cont_int(&wi, widata);
@@ -1867,12 +2078,14 @@ void compute_hv_newvectorfaster(struct occstr *pstr, struct eospace *peosp, int
 void compute_hij_eosp(double *ci, int ccols, int crows, int **wi,
                       struct occstr *pstr, struct eospace *peosp, int pegrps,
                       struct occstr *qstr, struct eospace *qeosp, int qegrps,
-                      int **pq, int npq, double *m1, double *m2, int aelec,
-                      int belec, int intorb,
+                      int **pq, int npq, double *m1, double *m2,
+                      struct moslab *mslab, int aelec, int belec, int intorb,
                       int nmos, int ndocc, int nactv, int cstep, int *cnums,
                       int jstart, int jmax, int jstartp, int jstartq,
                       int jfinalp, int jfinalq, int *jpair, double *vj,
-                      double *vi, double *cj, int jpq)
+                      double *vik, double *cj, int jpq,
+                      struct sigma_scratch *scr, double *vmax, int *pqdet,
+                      double vtol, long long int *nskip, int spinsym)
 {
     /* |i> determinant information */
     struct det deti;
@@ -1883,7 +2096,6 @@ void compute_hij_eosp(double *ci, int ccols, int crows, int **wi,
     int *jindx = NULL;
     
     /* replacement information and lists */
-    int xlistmax = 0;
     int npx = 0, nqx = 0;
     struct xstr *pxlist, *qxlist, *xstrscr;
     
@@ -1893,208 +2105,597 @@ void compute_hij_eosp(double *ci, int ccols, int crows, int **wi,
 
     /* c(i,k) array */
     double *cik = NULL;
-    /* c(j,k) array */
-    //double *cjk = NULL;
-    double **cjk = NULL;
-    double *cjkdat= NULL;
-    int cjkith = 0;
-    
-    /* v(i,k) array */
-    double *vik = NULL;
     /* h(i,j) values */
     double *hijval = NULL;
 
     int buflen = 0;
-    
-    /* OpenMP variables */
-    int nthreads = 0, ithread = 0;
 
+    /* Coefficient screening */
+    int ib = 0;
+    long long int nrowskip = 0;
+
+    /* Instrumentation: thread times (summed, sampled on one row in
+     * PERFTIMER_SAMPLE) and <i|H|j> counts */
+    double t0 = 0.0, t1 = 0.0, txgen = 0.0, thij = 0.0;
+    int smp = 0;
+    long long int na1x = 0, na2x = 0, nb1x = 0, nb2x = 0, nab = 0;
+
+    /* Spin-flip symmetry: alpha-beta elements are weighted by 1/2 and
+     * beta-only elements are skipped; both are restored by the fold
+     * c(i) = c'(i) + spinsym*c'(T(i)) after the pass. */
+    double hfac = 1.0;
+
+    /* c(j,k) contributions: binned per thread, summed by row owners
+     * after every rowblk rows |i>; or added to per-thread copies of
+     * c(j,k), summed by row owners after all rows */
+    struct cj_scatter *cjs = NULL;
+    int nthd = 0, nact = 0, rowblk = 0;
+    int i0 = 0, i1 = 0, own = 0;
+    int cjerr = 0;
+    
     int i, j, k;
 
     vorbs = nmos - intorb;
     buflen = jmax - jstart + 1;
-    
-    /* Set xlistmax for *xlist arrays */
-    xlistmax = int_max(peosp[jpair[0]].nstr, qeosp[jpair[1]].nstr);
-    
-    /* Set vik. All threads will share this, but each uses one row (i) */
-    vik = malloc(sizeof(double) * ccols * crows);
-    for (i = 0; i < crows; i++) {
-        for (k = 0; k < ccols; k++) {
-            /* vik[i][k] = vi[k][i] */
-            vik[i * ccols + k] = vi[k * crows + i];
-        }
+    if (spinsym != 0) hfac = 0.5;
+    nthd = scr[0].cjs.nbin;
+    for (k = 0; k < nthd; k++) {
+        scr[k].cjs.jrows = buflen;
+        scr[k].cjs.vik = vik;
+        scr[k].cjs.vcols = ccols;
     }
+    rowblk = SIGMA_ROWBLK * nthd;
+    if (scr[0].cjs.cjk != NULL) rowblk = int_max(crows, 1);
     
-    /* BEGIN OMP SECTION */
-#pragma omp parallel \
+    /* BEGIN OMP SECTION
+     * Each thread bins its c(j,k) contributions by the thread owning row
+     * j of cj. After each block of rows |i> every thread adds its own
+     * rows of cj from all bins, so cj is written without atomics, and
+     * scratch grows with the contributions of a block of rows rather
+     * than with threads x cj. SIGACC_COPIES keeps a copy of cj per
+     * thread instead, and reduces once after all rows. */
+#pragma omp parallel num_threads(nthd) \
     default(none) \
     shared(wi, crows, ccols, jpair, vj, vik, ci, cj, jpq,               \
            ndocc, nactv, vorbs, intorb, nmos, aelec, belec, pstr,	\
            peosp, pegrps, qstr, qeosp, qegrps, pq, npq, m1, m2,		\
-           buflen, xlistmax, jstart, cjk, cjkdat)			\
+           mslab, buflen, jstart, scr, vmax, pqdet, vtol, cstep,	\
+           spinsym, hfac, nthd, rowblk)					\
     private(deti, ip, iq, ipspace, iqspace, \
             qxlist, pxlist, xstrscr, elecx, orbsx,        \
-            cik, hijval, jindx, npx, nqx,		  \
-            i, j, k, nthreads, ithread)
+            cik, hijval, jindx, npx, nqx, ib,		  \
+            i, j, k, t0, t1, smp, cjs, nact, i0, i1, own) \
+    reduction(+:nrowskip, txgen, thij, na1x, na2x, nb1x, nb2x, nab)
     {
-	ithread = omp_get_thread_num();
-	nthreads = omp_get_num_threads();
-	
-#pragma omp single
-	{
-	    cjkdat = allocate_mem_double_cont(&cjk, ccols*buflen, nthreads);
-	}
-	
-	/* Allocate replacement lists */
-        pxlist = malloc(sizeof(struct xstr) * xlistmax);
-        qxlist = malloc(sizeof(struct xstr) * xlistmax);
-        xstrscr= malloc(sizeof(struct xstr) * xlistmax);
-        elecx  = malloc(sizeof(int) * int_max(aelec, belec));
-        orbsx  = malloc(sizeof(int) * nmos);
-        cik    = malloc(sizeof(double) * ccols);
-        //cjk    = malloc(sizeof(double) * ccols * buflen);
-	jindx  = malloc(sizeof(int) * xlistmax * xlistmax);
-        hijval = malloc(sizeof(double) * buflen);
-        
-        init_dbl_array_0(cjk[ithread], (ccols * buflen));
-
+	/* Point at this thread's scratch arrays */
+        pxlist = scr[omp_get_thread_num()].pxlist;
+        qxlist = scr[omp_get_thread_num()].qxlist;
+        xstrscr= scr[omp_get_thread_num()].xstrscr;
+        elecx  = scr[omp_get_thread_num()].elecx;
+        orbsx  = scr[omp_get_thread_num()].orbsx;
+        cik    = scr[omp_get_thread_num()].cik;
+	jindx  = scr[omp_get_thread_num()].jindx;
+        hijval = scr[omp_get_thread_num()].hijval;
+        cjs    = &(scr[omp_get_thread_num()].cjs);
+        nact   = omp_get_num_threads();
+
+        for (i0 = 0; i0 < crows; i0 += rowblk) {
+            i1 = int_min((i0 + rowblk), crows);
 #pragma omp for schedule(runtime)
-        /* Compute <i|H|j> */
-        for (i = 0; i < crows; i++) {
-            ip = wi[i][0];
-            iq = wi[i][1];
-            deti.astr = pstr[ip];
-            deti.bstr = qstr[iq];
-            deti.cas  = wi[i][2];
-            ipspace = get_string_eospace(&(pstr[ip]), ndocc, nactv, peosp, pegrps);
-            iqspace = get_string_eospace(&(qstr[iq]), ndocc, nactv, qeosp, qegrps);
-
-            /* Generate single replacements in p for the pq-pair jpair */
-            npx = generate_single_excitations(&(pstr[ip]), peosp[jpair[0]], aelec,
-                                              ndocc, nactv, intorb, vorbs,
-                                              pxlist, elecx, orbsx, pstr);
-            /* upper triangle only */
-            remove_leq_xstr(ip, pxlist, &npx, xstrscr);
+            /* Compute <i|H|j> */
+            for (i = i0; i < i1; i++) {
+                /* Skip rows where both |v(i)| and |v(j)| are below vtol */
+                if (vtol > 0.0 && vmax[jpq] < vtol) {
+                    ib = get_pqblock_of_det((cstep + i), pqdet, npq);
+                    if (vmax[ib] < vtol) {
+                        nrowskip++;
+                        continue;
+                    }
+                }
+                smp = ((i % PERFTIMER_SAMPLE) == 0);
+                ip = wi[i][0];
+                iq = wi[i][1];
+                deti.astr = pstr[ip];
+                deti.bstr = qstr[iq];
+                deti.cas  = wi[i][2];
+                ipspace = get_string_eospace(&(pstr[ip]), ndocc, nactv, peosp, pegrps);
+                iqspace = get_string_eospace(&(qstr[iq]), ndocc, nactv, qeosp, qegrps);
+
+                /* Generate single replacements in p for the pq-pair jpair */
+                t0 = (smp ? perftimer_wtime() : 0.0);
+                npx = generate_single_excitations(&(pstr[ip]), peosp[jpair[0]], aelec,
+                                                  ndocc, nactv, intorb, vorbs,
+                                                  pxlist, elecx, orbsx, pstr);
+                /* upper triangle only */
+                remove_leq_xstr(ip, pxlist, &npx, xstrscr);
+                t1 = (smp ? perftimer_wtime() : 0.0);
+                txgen += t1 - t0;
             
-            /* Evaluate <pq|H|p'q> */
-	    if (iqspace == jpair[1] && npx != 0) {
-                evaluate_hij_pxlist1x_ut2(deti, pxlist, npx, iq, 1, pstr, peosp,
-                                          pegrps, qstr, qeosp, qegrps, pq, npq,
-                                          m1, m2, aelec, belec, intorb, buflen,
-                                          ccols, jstart, cik, vj, &(vik[i*ccols]),
-                                          cjk[ithread], hijval, jindx, jpq);
-                for (k = 0; k < ccols; k++) {
-                     ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                /* Evaluate <pq|H|p'q> */
+                if (iqspace == jpair[1] && npx != 0) {
+                    na1x += npx;
+                    evaluate_hij_pxlist1x_ut2(deti, pxlist, npx, iq, 1, pstr, peosp,
+                                              pegrps, qstr, qeosp, qegrps, pq, npq,
+                                              m1, m2, mslab, aelec, belec, intorb,
+                                              buflen, ccols, jstart, cik, vj,
+                                              i, cjs,
+                                              hijval, jindx, jpq);
+                    for (k = 0; k < ccols; k++) {
+                         ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                    }
                 }
-            }
 
-            /* Generate single replacements in q' and pair with p' */
-            nqx = generate_single_excitations(&(qstr[iq]), qeosp[jpair[1]], belec,
-                                              ndocc, nactv, intorb, vorbs,
-                                              qxlist, elecx, orbsx, qstr);
+                /* Generate single replacements in q' and pair with p' */
+                t0 = (smp ? perftimer_wtime() : 0.0);
+                thij += t0 - t1;
+                nqx = generate_single_excitations(&(qstr[iq]), qeosp[jpair[1]], belec,
+                                                  ndocc, nactv, intorb, vorbs,
+                                                  qxlist, elecx, orbsx, qstr);
+                t1 = (smp ? perftimer_wtime() : 0.0);
+                txgen += t1 - t0;
 
-            /* Evaluate <pq|H|p'q'> */
-            if (npx != 0 && nqx != 0) {
-                evaluate_hij_pxqxlist2x_ut2(deti, pxlist, npx, qxlist, nqx,
-                                            pstr, peosp, pegrps, qstr, qeosp,
-                                            qegrps, pq, npq, m1, m2, aelec,
-                                            belec, intorb, buflen, ccols, jstart,
-                                            cik, vj, &(vik[i*ccols]), cjk[ithread],
-                                            hijval, jindx, jpq);
-                for (k = 0; k < ccols; k++) {
-                    ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                /* Evaluate <pq|H|p'q'> */
+                if (npx != 0 && nqx != 0) {
+                    nab += (long long int) npx * nqx;
+                    evaluate_hij_pxqxlist2x_ut2(deti, pxlist, npx, qxlist, nqx,
+                                                pstr, peosp, pegrps, qstr, qeosp,
+                                                qegrps, pq, npq, m1, m2, aelec,
+                                                belec, intorb, buflen, ccols, jstart,
+                                                cik, vj, i, cjs,
+                                                hijval, jindx, jpq, hfac);
+                    for (k = 0; k < ccols; k++) {
+                        ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                    }
                 }
-            }
 
-            /* Generate double replacements in p for the pq-pair jpair */
-            npx = generate_double_excitations(&(pstr[ip]), peosp[jpair[0]], aelec,
-                                              ndocc, nactv, intorb, vorbs,
-                                              pxlist, elecx, orbsx, pstr);
-            /* upper triangle only */
-            remove_leq_xstr(ip, pxlist, &npx, xstrscr);
+                /* Generate double replacements in p for the pq-pair jpair */
+                t0 = (smp ? perftimer_wtime() : 0.0);
+                thij += t0 - t1;
+                npx = generate_double_excitations(&(pstr[ip]), peosp[jpair[0]], aelec,
+                                                  ndocc, nactv, intorb, vorbs,
+                                                  pxlist, elecx, orbsx, pstr);
+                /* upper triangle only */
+                remove_leq_xstr(ip, pxlist, &npx, xstrscr);
+                t1 = (smp ? perftimer_wtime() : 0.0);
+                txgen += t1 - t0;
             
-            /* Evaluate <pq|H|p"q> */
-            if (iqspace == jpair[1] && npx != 0) {
-                evaluate_hij_pxlist2x_ut2(deti, pxlist, npx, iq, 1, pstr, peosp,
-                                          pegrps, qstr, qeosp, qegrps, pq, npq,
-                                          m1, m2, aelec, belec, intorb, buflen,
-                                          ccols, jstart, cik, vj, &(vik[i*ccols]),
-                                          cjk[ithread], hijval, jindx, jpq);
-                for (k = 0; k < ccols; k++) {
-                    ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                /* Evaluate <pq|H|p"q> */
+                if (iqspace == jpair[1] && npx != 0) {
+                    na2x += npx;
+                    evaluate_hij_pxlist2x_ut2(deti, pxlist, npx, iq, 1, pstr, peosp,
+                                              pegrps, qstr, qeosp, qegrps, pq, npq,
+                                              m1, m2, aelec, belec, intorb, buflen,
+                                              ccols, jstart, cik, vj, i, cjs,
+                                              hijval, jindx, jpq);
+                    for (k = 0; k < ccols; k++) {
+                        ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                    }
                 }
-            }
 
-            /* Generate single replacements in q for the pq-pair jpair */
-            nqx = generate_single_excitations(&(qstr[iq]), qeosp[jpair[1]], belec,
-                                              ndocc, nactv, intorb, vorbs,
-                                              qxlist, elecx, orbsx, qstr);
+                t0 = (smp ? perftimer_wtime() : 0.0);
+                thij += t0 - t1;
 
-            /* upper triangle only */
-            remove_leq_xstr(iq, qxlist, &nqx, xstrscr);
+                /* Beta-only replacements follow from the alpha-only ones */
+                if (spinsym != 0) continue;
+
+                /* Generate single replacements in q for the pq-pair jpair */
+                nqx = generate_single_excitations(&(qstr[iq]), qeosp[jpair[1]], belec,
+                                                  ndocc, nactv, intorb, vorbs,
+                                                  qxlist, elecx, orbsx, qstr);
+
+                /* upper triangle only */
+                remove_leq_xstr(iq, qxlist, &nqx, xstrscr);
+                t1 = (smp ? perftimer_wtime() : 0.0);
+                txgen += t1 - t0;
             
-            /* Evaluate <pq|H|pq'> */
-            if (ipspace == jpair[0] && nqx != 0) {
-                evaluate_hij_qxlist1x_ut2(deti, ip, 1, qxlist, nqx, pstr, peosp,
-                                          pegrps, qstr, qeosp, qegrps, pq, npq,
-                                          m1, m2, aelec, belec, intorb, buflen,
-                                          ccols, jstart, cik, vj, &(vik[i*ccols]),
-                                          cjk[ithread], hijval, jindx, jpq);
-                for (k = 0; k < ccols; k++) {
-                    ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                /* Evaluate <pq|H|pq'> */
+                if (ipspace == jpair[0] && nqx != 0) {
+                    nb1x += nqx;
+                    evaluate_hij_qxlist1x_ut2(deti, ip, 1, qxlist, nqx, pstr, peosp,
+                                              pegrps, qstr, qeosp, qegrps, pq, npq,
+                                              m1, m2, mslab, aelec, belec, intorb,
+                                              buflen, ccols, jstart, cik, vj,
+                                              i, cjs,
+                                              hijval, jindx, jpq);
+                    for (k = 0; k < ccols; k++) {
+                        ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                    }
+                }
+
+                /* Generate double replacements in q for the pq-pair jpair */
+                t0 = (smp ? perftimer_wtime() : 0.0);
+                thij += t0 - t1;
+                nqx = generate_double_excitations(&(qstr[iq]), qeosp[jpair[1]], belec,
+                                                  ndocc, nactv, intorb, vorbs,
+                                                  qxlist, elecx, orbsx, qstr);
+                /* upper triangle only */
+                remove_leq_xstr(iq, qxlist, &nqx, xstrscr);
+                t1 = (smp ? perftimer_wtime() : 0.0);
+                txgen += t1 - t0;
+
+                /* Evaluate <pq|H|pq"> */
+                if (ipspace == jpair[0] && nqx != 0) {
+                    nb2x += nqx;
+                    evaluate_hij_qxlist2x_ut2(deti, ip, 1, qxlist, nqx, pstr, peosp,
+                                              pegrps, qstr, qeosp, qegrps, pq, npq,
+                                              m1, m2, aelec, belec, intorb, buflen,
+                                              ccols, jstart, cik, vj, i, cjs,
+                                              hijval, jindx, jpq);
+                    for (k = 0; k < ccols; k++) {
+                        ci[k * crows + i] = ci[k * crows + i] + cik[k];
+                    }
                 }
+                if (smp) thij += perftimer_wtime() - t1;
+            
             }
+            /* All rows of the block are binned (implicit barrier). Add this
+             * thread's rows of cj, then wait before the bins are refilled. */
+            for (own = omp_get_thread_num(); own < nthd; own += nact) {
+                cj_scatter_reduce(scr, own, vik, ccols, cj);
+            }
+#pragma omp barrier
+        }
+    }
+    /* END OMP SECTION */
+    for (k = 0; k < nthd; k++) {
+        cjerr = cjerr + scr[k].cjs.error;
+    }
+    if (cjerr != 0) {
+        GA_Error("compute_hij_eosp: could not allocate c(j,k) bins", cjerr);
+    }
+    *nskip = *nskip + nrowskip;
+    perftimer_add(PT_SIGMA_XGEN,
+                  (txgen * PERFTIMER_SAMPLE / omp_get_max_threads()));
+    perftimer_add(PT_SIGMA_HIJ,
+                  (thij * PERFTIMER_SAMPLE / omp_get_max_threads()));
+    perftimer_count(PC_HIJ_A1X, na1x);
+    perftimer_count(PC_HIJ_A2X, na2x);
+    perftimer_count(PC_HIJ_B1X, nb1x);
+    perftimer_count(PC_HIJ_B2X, nb2x);
+    perftimer_count(PC_HIJ_AB, nab);
+    return;
+}
 
-            /* Generate double replacements in q for the pq-pair jpair */
-            nqx = generate_double_excitations(&(qstr[iq]), qeosp[jpair[1]], belec,
-                                              ndocc, nactv, intorb, vorbs,
-                                              qxlist, elecx, orbsx, qstr);
-            /* upper triangle only */
-            remove_leq_xstr(iq, qxlist, &nqx, xstrscr);
+/*
+ * cj_scatter_add: bin C(j,k) contributions of row |i> by owner of j, or
+ * add them to this thread's copy of C(j,k).
+ */
+void cj_scatter_add(struct cj_scatter *cjs, int irow, int *jindx,
+                    double *hijval, int n)
+{
+    struct cj_entry *tmp = NULL;
+    double *vi = NULL;
+    int b = 0, m = 0;
+    int r, k;
+
+    if (cjs->cjk != NULL) {
+        vi = &(cjs->vik[irow * cjs->vcols]);
+        for (k = 0; k < cjs->vcols; k++) {
+            for (r = 0; r < n; r++) {
+                cjs->cjk[k * cjs->jrows + jindx[r]] += hijval[jindx[r]] * vi[k];
+            }
+        }
+        return;
+    }
+    for (r = 0; r < n; r++) {
+        b = (int) ((long long int) jindx[r] * cjs->nbin / cjs->jrows);
+        if (cjs->n[b] == cjs->nmax[b]) {
+            m = int_max(256, (2 * cjs->nmax[b]));
+            tmp = realloc(cjs->e[b], (sizeof(struct cj_entry) * m));
+            if (tmp == NULL) {
+                cjs->error = 1;
+                return;
+            }
+            cjs->e[b] = tmp;
+            cjs->nmax[b] = m;
+        }
+        cjs->e[b][cjs->n[b]].j   = jindx[r];
+        cjs->e[b][cjs->n[b]].i   = irow;
+        cjs->e[b][cjs->n[b]].hij = hijval[jindx[r]];
+        cjs->n[b]++;
+    }
+    return;
+}
 
-            /* Evaluate <pq|H|pq"> */
-            if (ipspace == jpair[0] && nqx != 0) {
-                evaluate_hij_qxlist2x_ut2(deti, ip, 1, qxlist, nqx, pstr, peosp,
-                                          pegrps, qstr, qeosp, qegrps, pq, npq,
-                                          m1, m2, aelec, belec, intorb, buflen,
-                                          ccols, jstart, cik, vj, &(vik[i*ccols]),
-                                          cjk[ithread], hijval, jindx, jpq);
-                for (k = 0; k < ccols; k++) {
-                    ci[k * crows + i] = ci[k * crows + i] + cik[k];
+/*
+ * cj_scatter_reduce: add all threads' contributions to the rows of
+ * C(j,k) owned by thread owner, and empty those bins (or zero those
+ * rows of the copies).
+ */
+void cj_scatter_reduce(struct sigma_scratch *scr, int owner, double *vik,
+                       int vcols, double *cj)
+{
+    struct cj_scatter *cjs = NULL;
+    struct cj_entry *e = NULL;
+    int jrows = scr[owner].cjs.jrows;
+    int nbin = scr[owner].cjs.nbin;
+    int jlo = 0, jhi = 0;
+    int t, r, k;
+
+    if (scr[owner].cjs.cjk != NULL) {
+        /* Rows j with j*nbin/jrows = owner, as binned */
+        jlo = (int) (((long long int) owner * jrows + nbin - 1) / nbin);
+        jhi = (int) (((long long int) (owner + 1) * jrows + nbin - 1) / nbin);
+        for (t = 0; t < nbin; t++) {
+            cjs = &(scr[t].cjs);
+            for (k = 0; k < vcols; k++) {
+                for (r = jlo; r < jhi; r++) {
+                    cj[k * jrows + r] += cjs->cjk[k * jrows + r];
+                    cjs->cjk[k * jrows + r] = 0.0;
                 }
             }
-            
         }
+        return;
+    }
+    for (t = 0; t < nbin; t++) {
+        cjs = &(scr[t].cjs);
+        e = cjs->e[owner];
+        for (r = 0; r < cjs->n[owner]; r++) {
+            for (k = 0; k < vcols; k++) {
+                cj[k * jrows + e[r].j] += e[r].hij * vik[e[r].i * vcols + k];
+            }
+        }
+        cjs->n[owner] = 0;
+    }
+    return;
+}
 
-        /* Collect cjk into cj */
-#pragma omp for
-        for (k = 0; k < ccols*buflen; k++) {
+/*
+ * compute_hij_bound: compute an upper bound on |<i|H|j>| for i != j.
+ * A double replacement is bounded by 2max|(ij|kl)|; a single replacement
+ * by max|h(i,j)| plus one (ij|kk) and (ik|jk) term per electron, which
+ * is never smaller.
+ * Input:
+ *  m1    = 1-e integrals
+ *  m2    = 2-e integrals
+ *  nmos  = number of molecular orbitals
+ *  aelec = alpha electrons
+ *  belec = beta  electrons
+ */
+double compute_hij_bound(double *m1, double *m2, int nmos, int aelec,
+                         int belec)
+{
+    double max1 = 0.0, max2 = 0.0;
+    int n1, n2;
+    int i;
+
+    n1 = index1e(nmos, nmos);
+    n2 = index2e(nmos, nmos, nmos, nmos);
+    for (i = 0; i < n1; i++) {
+        if (fabs(m1[i]) > max1) max1 = fabs(m1[i]);
+    }
+    for (i = 0; i < n2; i++) {
+        if (fabs(m2[i]) > max2) max2 = fabs(m2[i]);
+    }
+    return (max1 + 2.0 * (aelec + belec) * max2);
+}
 
-            for (i = 0; i < nthreads; i++) {
-                cj[k] += cjk[i][k];
+/*
+ * compute_pqblock_vmax: compute max|v(i,k)| over each pq block of
+ * determinants for columns k = klo, ..., khi. Each process scans the rows
+ * of V it owns; the block maxima are then reduced over all processes.
+ * Input:
+ *  v_hndl = GA handle for basis vectors V
+ *  klo    = first column k
+ *  khi    = last  column k
+ *  pq     = alpha/beta eospace pairings
+ *  npq    = number of pairings
+ * Output:
+ *  pqdet  = first determinant of each pq block; pqdet[npq] = ndets
+ *  vmax   = max|v| for each pq block
+ */
+void compute_pqblock_vmax(int v_hndl, int klo, int khi, int **pq, int npq,
+                          struct eospace *peosp, int pegrps,
+                          struct eospace *qeosp, int qegrps, int *pqdet,
+                          double *vmax)
+{
+    double *vdata = NULL;
+    int lo[2] = {0, 0}, hi[2] = {0, 0}, ld[1] = {0};
+    int nrows = 0, ncols = 0;
+    int ib = 0;
+    int i, k;
+
+    pqdet[0] = 0;
+    for (i = 0; i < npq; i++) {
+        pqdet[i + 1] = pqdet[i] +
+            peosp[pq[i][0]].nstr * qeosp[pq[i][1]].nstr;
+        vmax[i] = 0.0;
+    }
+
+    NGA_Distribution(v_hndl, mpi_proc_rank, lo, hi);
+    if (lo[1] >= 0 && hi[1] >= lo[1]) {
+        lo[0] = klo;
+        hi[0] = khi;
+        nrows = hi[1] - lo[1] + 1;
+        ncols = khi - klo + 1;
+        ld[0] = nrows;
+        vdata = malloc(sizeof(double) * nrows * ncols);
+        perftimer_nga_get(v_hndl, lo, hi, vdata, ld);
+        ib = get_pqblock_of_det(lo[1], pqdet, npq);
+        for (i = 0; i < nrows; i++) {
+            while ((lo[1] + i) >= pqdet[ib + 1]) ib++;
+            for (k = 0; k < ncols; k++) {
+                if (fabs(vdata[k * nrows + i]) > vmax[ib]) {
+                    vmax[ib] = fabs(vdata[k * nrows + i]);
+                }
             }
+        }
+        free(vdata);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, vmax, npq, MPI_DOUBLE, MPI_MAX,
+                  MPI_COMM_WORLD);
+    return;
+}
 
+/*
+ * get_pqblock_of_det: return the pq block containing determinant det.
+ * Input:
+ *  det   = determinant index
+ *  pqdet = first determinant of each pq block; pqdet[npq] = ndets
+ *  npq   = number of pq blocks
+ */
+int get_pqblock_of_det(int det, int *pqdet, int npq)
+{
+    int lo = 0, hi = npq - 1, mid = 0;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (pqdet[mid] <= det) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
         }
-        
-        /* Deallocate private OMP arrays */
-        free(pxlist);
-        free(qxlist);
-        free(xstrscr);
-        free(elecx);
-        free(orbsx);
-        free(cik);
-        free(jindx);
-        free(hijval);
-        
-#pragma omp single
-        {
-            deallocate_mem_cont(&cjk, cjkdat);
+    }
+    return lo;
+}
+
+/*
+ * apply_spinflip_ga: combine a global array with its spin-flipped image,
+ *  G(k,i) = alpha*G(k,i) + beta*G(k,T(i)),  T|p,q> = |q,p>,
+ * for columns k = klo, ..., khi. For a 1-D array klo and khi are ignored.
+ * Requires identical alpha and beta strings (Ms = 0).
+ * Input:
+ *  g_hndl = GA handle ([cols, rows] or [rows])
+ *  klo    = first column
+ *  khi    = last  column
+ *  alpha  = factor on G(k,i)
+ *  beta   = factor on G(k,T(i))
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ */
+void apply_spinflip_ga(int g_hndl, int klo, int khi, double alpha,
+                       double beta,
+                       struct detaddress *wdet, struct occstr *pstr,
+                       struct eospace *peosp, int pegrps, struct occstr *qstr,
+                       struct eospace *qeosp, int qegrps, int **pq, int npq,
+                       int ndocc, int nactv)
+{
+    double *gdata = NULL, *tdata = NULL;
+    int **wi = NULL, *widata = NULL;
+    int **subs = NULL, *subsdata = NULL;
+    int lo[2] = {0, 0}, hi[2] = {0, 0}, ld[1] = {0};
+    int type = 0, ndim = 0, dims[2] = {0, 0};
+    int rdim = 0, nrows = 0, ncols = 1;
+    int ipspace = 0, iqspace = 0, tpq = 0, tdet = 0;
+    int error = 0;
+    int i, k;
+
+    NGA_Inquire(g_hndl, &type, &ndim, dims);
+    rdim = ndim - 1;
+    NGA_Distribution(g_hndl, mpi_proc_rank, lo, hi);
+    if (lo[rdim] >= 0 && hi[rdim] >= lo[rdim]) {
+        nrows = hi[rdim] - lo[rdim] + 1;
+    }
+    if (ndim == 2) {
+        lo[0] = klo;
+        hi[0] = khi;
+        ncols = khi - klo + 1;
+    }
+
+    if (nrows > 0) {
+        gdata = malloc(sizeof(double) * nrows * ncols);
+        tdata = malloc(sizeof(double) * nrows * ncols);
+        widata = allocate_mem_int_cont(&wi, 3, nrows);
+        subsdata = allocate_mem_int_cont(&subs, ndim, (nrows * ncols));
+        get_det_triples(wdet, lo[rdim], hi[rdim], widata);
+
+        /* Index of T|i> = |q,p> for each local |i> = |p,q> */
+        for (i = 0; i < nrows; i++) {
+            ipspace = get_string_eospace(&(pstr[wi[i][0]]), ndocc, nactv,
+                                         peosp, pegrps);
+            iqspace = get_string_eospace(&(qstr[wi[i][1]]), ndocc, nactv,
+                                         qeosp, qegrps);
+            for (tpq = 0; tpq < npq; tpq++) {
+                if (pq[tpq][0] == iqspace && pq[tpq][1] == ipspace) break;
+            }
+            if (tpq == npq) {
+                error = 1;
+                break;
+            }
+            tdet = string_info_to_determinant_fast(wi[i][1], wi[i][0],
+                                                   peosp, pegrps, qeosp,
+                                                   qegrps, pq, npq, tpq);
+            for (k = 0; k < ncols; k++) {
+                subs[k * nrows + i][0] = klo + k;
+                subs[k * nrows + i][rdim] = tdet;
+            }
         }
     }
-    /* END OMP SECTION */
-    /* Deallocate arrays shared by OMP */
-    free(vik);
+    mpi_error_check_msg(error, "apply_spinflip_ga",
+                        "No (q,p) space pair for a (p,q) pair.");
+    if (nrows > 0) {
+        ld[0] = nrows;
+        perftimer_nga_get(g_hndl, lo, hi, gdata, ld);
+        NGA_Gather(g_hndl, tdata, subs, (nrows * ncols));
+    }
+    /* All images must be read before any process overwrites its rows */
+    GA_Sync();
+    if (nrows > 0) {
+        for (i = 0; i < nrows * ncols; i++) {
+            gdata[i] = alpha * gdata[i] + beta * tdata[i];
+        }
+        NGA_Put(g_hndl, lo, hi, gdata, ld);
+        free(gdata);
+        free(tdata);
+        deallocate_mem_cont_int(&wi, widata);
+        deallocate_mem_cont_int(&subs, subsdata);
+    }
+    GA_Sync();
+    return;
+}
+
+/*
+ * project_spinflip_basis: project basis vectors v_k, k = 0, ..., nvecs-1,
+ * onto the spin-flip symmetry spinsym and reorthonormalize them. A vector
+ * with no component of this symmetry is replaced by the projection of the
+ * next unit vector that has one.
+ * Input:
+ *  v_hndl  = GA handle for basis vectors V
+ *  n_hndl  = GA handle for 1-D scratch vector
+ *  nvecs   = number of basis vectors
+ *  ndets   = number of determinants
+ *  spinsym = spin-flip symmetry (1, -1)
+ */
+void project_spinflip_basis(int v_hndl, int n_hndl, int nvecs, int ndets,
+                            int spinsym,
+                            struct detaddress *wdet, struct occstr *pstr,
+                            struct eospace *peosp, int pegrps,
+                            struct occstr *qstr, struct eospace *qeosp,
+                            int qegrps, int **pq, int npq, int ndocc,
+                            int nactv)
+{
+    int vlo[2] = {0, 0}, vhi[2] = {0, 0};
+    int nlo[1] = {0}, nhi[1] = {0};
+    int ulo[1] = {0}, uld[1] = {1};
+    double one = 1.0;
+    double nnorm = 0.0;
+    int unitdet = 0; /* Next unit vector to try */
+    int k;
+
+    nhi[0] = ndets - 1;
+    vhi[1] = ndets - 1;
+    for (k = 0; k < nvecs; k++) {
+        vlo[0] = k;
+        vhi[0] = k;
+        NGA_Copy_patch('n', v_hndl, vlo, vhi, n_hndl, nlo, nhi);
+        apply_spinflip_ga(n_hndl, 0, 0, 0.5, (0.5 * spinsym), wdet, pstr,
+                          peosp, pegrps, qstr, qeosp, qegrps, pq, npq, ndocc,
+                          nactv);
+        nnorm = GA_Ddot(n_hndl, n_hndl);
+        while (nnorm < 1.0e-8 && unitdet < ndets) {
+            GA_Zero(n_hndl);
+            if (mpi_proc_rank == mpi_root) {
+                ulo[0] = unitdet;
+                NGA_Put(n_hndl, ulo, ulo, &one, uld);
+            }
+            GA_Sync();
+            unitdet++;
+            apply_spinflip_ga(n_hndl, 0, 0, 0.5, (0.5 * spinsym), wdet,
+                              pstr, peosp, pegrps, qstr, qeosp, qegrps, pq,
+                              npq, ndocc, nactv);
+            nnorm = GA_Ddot(n_hndl, n_hndl);
+        }
+        orthonormalize_newvector(v_hndl, k, ndets, n_hndl);
+        add_new_vector(v_hndl, (k + 1), ndets, n_hndl);
+    }
     return;
 }
     
@@ -2144,7 +2745,7 @@ void compute_hvc_diagonal_ga(int c_hndl, int v_hndl, int d_hndl, int start,
  *  dim   = number of basis vectors
  *  mdim  = maximum size of krylov space
  *  v_hndl= (GLOBAL ARRAY HANDLE) basis vectors
- *  w_hndl= (GLOBAL ARRAY HANDLE) wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  * Output:
  *  c_hndl= (GLOBAL ARRAY HANDLE) Hv=c vectors
  */
@@ -2153,7 +2754,8 @@ void compute_hvnewvecfast(struct occstr *pstr, struct eospace *peosp, int pegrps
                           int **pqs, int num_pq, double *m1, double *m2,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl,
-                          int c_hndl, int w_hndl, int d_hndl, int ga_buffer_len,
+                          int c_hndl,
+                          struct detaddress *wdet, int d_hndl, int ga_buffer_len,
                           int nmo, int ndocc, int nactv)
 {
 
@@ -2173,6 +2775,54 @@ void compute_GA_norm (int r_hndl,  double *norm)
         return;
 }
         
+/*
+ * deallocate_sigma_scratch: free per-thread scratch arrays for the sigma
+ * kernels.
+ */
+void deallocate_sigma_scratch(struct sigma_scratch *scr, int nthrd)
+{
+    int i, j;
+    if (scr == NULL) return;
+    for (i = 0; i < nthrd; i++) {
+        if (scr[i].cjs.e != NULL) {
+            for (j = 0; j < scr[i].cjs.nbin; j++) {
+                free(scr[i].cjs.e[j]);
+            }
+        }
+        free(scr[i].cjs.e);
+        free(scr[i].cjs.n);
+        free(scr[i].cjs.nmax);
+        free(scr[i].cjs.cjk);
+        free(scr[i].pxlist);
+        free(scr[i].qxlist);
+        free(scr[i].xstrscr);
+        free(scr[i].elecx);
+        free(scr[i].orbsx);
+        free(scr[i].jindx);
+        free(scr[i].cik);
+        free(scr[i].hijval);
+    }
+    free(scr);
+    return;
+}
+
+/*
+ * free_precond: deallocate preconditioner arrays.
+ */
+void free_precond(struct precond *pc)
+{
+        free(pc->bidx);
+        free(pc->bvec);
+        free(pc->bval);
+        free(pc->bscr);
+        pc->bidx = NULL;
+        pc->bvec = NULL;
+        pc->bval = NULL;
+        pc->bscr = NULL;
+        pc->dim = 0;
+        return;
+}
+
 /*
  * determinant_string_info: compute string information given
  * a determinant.
@@ -2641,7 +3291,8 @@ void evaluate_hij_pxqxlist(struct det deti, struct xstr *pxlist, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl)
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl)
 {
     struct det detj;
     int buflen;      /* max length of buffer. equal to vrows. */
@@ -2665,10 +3316,11 @@ void evaluate_hij_pxqxlist(struct det deti, struct xstr *pxlist, int npx,
             if (njx == buflen || (r == (npx - 1) && s == (nqx - 1))) {
                 /* Set GA indexes */
                 set_ga_det_indexes(jindx, njx, vcols, vindx);
-                set_ga_det_indexes_trans(jindx, njx, 3, windx);
                 /* Get data from GLOBAL ARRAYS */
                 NGA_Gather(v_hndl, v1d, vindx, (njx * vcols));
-                NGA_Gather(w_hndl, w1d, windx, (njx * 3));
+                for (k = 0; k < njx; k++) {
+                    get_det_triple(wdet, jindx[k], &(w1d[3 * k]));
+                }
                 /* Evaluate <i|H|j> for j = 0, ... , njx */
                 for (k = 0; k < njx; k++) {
                     detj.astr = pstr[w[k][0]];
@@ -2697,7 +3349,7 @@ void evaluate_hij_pxqxlist(struct det deti, struct xstr *pxlist, int npx,
 //        set_ga_det_indexes_trans(&(jindx[j]), buflen,     3, windx);
 //        /* Get data from GLOBAL ARRAYS */
 //        NGA_Gather(v_hndl, v1d, vindx, (buflen * vcols));
-//        NGA_Gather(w_hndl, w1d, windx, (buflen * 3));
+//        NGA_Gather(wdet, w1d, windx, (buflen * 3));
 //        /* Evaluate <i|H|j> for j = 0, ... , buflen */
 //        for (k = 0; k < buflen; k++) {
 //            detj.astr = pstr[w[k][0]];
@@ -2725,7 +3377,8 @@ void evaluate_hij_pxlist1x(struct det deti, struct xstr *pxlist, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl)
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl)
 {
     struct det detj;
     int buflen;      /* max length of buffer. equal to vrows. */
@@ -2754,7 +3407,7 @@ void evaluate_hij_pxlist1x(struct det deti, struct xstr *pxlist, int npx,
             //set_ga_det_indexes_trans(jindx, njx, 3, windx);
             /* Get data from GLOBAL ARRAYS */
             NGA_Gather(v_hndl, v1d, vindx, (njx * vcols));
-            //NGA_Gather(w_hndl, w1d, windx, (njx * 3));
+            //NGA_Gather(wdet, w1d, windx, (njx * 3));
             /* Evaluate <i|H|j> for j = 0, ... , njx */
             for (k = 0; k < njx; k++) {
                 //detj.astr = pstr[w[k][0]];
@@ -2794,7 +3447,8 @@ void evaluate_hij_pxlist1x_ut(struct det deti, struct xstr *pxlist, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums)
 {
@@ -2875,6 +3529,7 @@ void evaluate_hij_pxlist1x_ut(struct det deti, struct xstr *pxlist, int npx,
  *  npq    = number of p,q space pairings
  *  m1     = 1-e integrals
  *  m2     = 2-e integrals
+ *  mslab  = per-pair integral slabs
  *  aelec  = alpha electrons
  *  belec  = beta  electrons
  *  intorb = internal orbitals
@@ -2883,8 +3538,8 @@ void evaluate_hij_pxlist1x_ut(struct det deti, struct xstr *pxlist, int npx,
  *  jstep  = index in wavefunction of first determinant in this buffer j
  *  cik    = C(i,k)
  *  vjk    = V(j,k)
- *  vik    = V(i,k)
- *  cjk    = C(j,k)
+ *  irow   = row of |i> in V(i,k)
+ *  cjs    = this thread's C(j,k) contributions
  *  hijval = <i|H|j> values
  *  jindx  = array for determinant indices
  *  jpq    = pq[i] index of |j>
@@ -2893,10 +3548,12 @@ void evaluate_hij_pxlist1x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                int qindx, int nqx,
                                struct occstr *pstr, struct eospace *peosp, int npe,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
-                               int **pq, int npq, double *m1, double *m2, int aelec,
-                               int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq)
+                               int **pq, int npq, double *m1, double *m2,
+                               struct moslab *mslab, int aelec, int belec,
+                               int intorb, int vrows, int vcols,
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq)
 {
     int j = 0, k = 0;
     int r = 0;
@@ -2911,17 +3568,16 @@ void evaluate_hij_pxlist1x_ut2(struct det deti, struct xstr *pxlist, int npx,
     }
     /* Evaluate <i|H|j> for j = 0, ... , njx */
     for (j = 0; j < npx; j++) {
-        hijval[jindx[j]] = hmatels_1x(deti.astr.istr, pxlist[j].io, pxlist[j].fo,
-                                      pxlist[j].permx, aelec, deti.bstr.istr, belec,
-                                      m1, m2);
+        hijval[jindx[j]] = hmatels_1x_slab(deti.astr.istr, pxlist[j].io,
+                                           pxlist[j].fo, pxlist[j].permx, aelec,
+                                           deti.bstr.istr, belec, m1, mslab);
     }
     for (k = 0; k < vcols; k++) {
         for (j = 0; j < npx; j++) {
             cik[k] = cik[k] + hijval[jindx[j]]*vjk[k * vrows + jindx[j]];
-            cjk[k * vrows + jindx[j]] = cjk[k * vrows + jindx[j]]
-                + hijval[jindx[j]]*vik[k];
         }
     }
+    cj_scatter_add(cjs, irow, jindx, hijval, npx);
     return;
 }
     
@@ -2936,7 +3592,8 @@ void evaluate_hij_pxlist2x(struct det deti, struct xstr *pxlist, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl)
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl)
 {
     struct det detj;
     int buflen;      /* max length of buffer. equal to vrows. */
@@ -2965,7 +3622,7 @@ void evaluate_hij_pxlist2x(struct det deti, struct xstr *pxlist, int npx,
             //set_ga_det_indexes_trans(jindx, njx, 3, windx);
             /* Get data from GLOBAL ARRAYS */
             NGA_Gather(v_hndl, v1d, vindx, (njx * vcols));
-            //NGA_Gather(w_hndl, w1d, windx, (njx * 3));
+            //NGA_Gather(wdet, w1d, windx, (njx * 3));
             /* Evaluate <i|H|j> for j = 0, ... , njx */
             for (k = 0; k < njx; k++) {
                 //detj.astr = pstr[w[k][0]];
@@ -3003,7 +3660,8 @@ void evaluate_hij_pxlist2x_ut(struct det deti, struct xstr *pxlist, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums)
 {
@@ -3074,8 +3732,9 @@ void evaluate_hij_pxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
                                int **pq, int npq, double *m1, double *m2, int aelec,
                                int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq)
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq)
 {
     int j = 0, k = 0;
     int r = 0;
@@ -3096,10 +3755,9 @@ void evaluate_hij_pxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
     for (k = 0; k < vcols; k++) {
         for (j = 0; j < npx; j++) {
             cik[k] = cik[k] + hijval[jindx[j]]*vjk[k * vrows + jindx[j]];
-            cjk[k * vrows + jindx[j]] = cjk[k * vrows + jindx[j]]
-                + hijval[jindx[j]]*vik[k];
         }
     }
+    cj_scatter_add(cjs, irow, jindx, hijval, npx);
     return;
 }
 
@@ -3115,7 +3773,8 @@ void evaluate_hij_pxqxlist2x(struct det deti, struct xstr *pxlist, int npx,
                              int aelec, int belec, int intorb, double *c,
                              int vrows, int vcols, int **vindx, int **windx,
                              int *jindx, double **v, double *v1d, int **w,
-                             int *w1d, double *hijval, int w_hndl, int v_hndl)
+                             int *w1d, double *hijval,
+                             struct detaddress *wdet, int v_hndl)
 {
     struct det detj;
     int buflen;      /* max length of buffer. equal to vrows. */
@@ -3144,7 +3803,7 @@ void evaluate_hij_pxqxlist2x(struct det deti, struct xstr *pxlist, int npx,
                 //set_ga_det_indexes_trans(jindx, njx, 3, windx);
                 /* Get data from GLOBAL ARRAYS */
                 NGA_Gather(v_hndl, v1d, vindx, (njx * vcols));
-                //NGA_Gather(w_hndl, w1d, windx, (njx * 3));
+                //NGA_Gather(wdet, w1d, windx, (njx * 3));
                 /* Evaluate <i|H|j> for j = 0, ... , njx */
                 k = 0;
                 for (rr = rmin; rr <= r; rr++) {
@@ -3189,7 +3848,8 @@ void evaluate_hij_pxqxlist2x_ut(struct det deti, struct xstr *pxlist, int npx,
                                 int aelec, int belec, int intorb, double *c,
                                 int vrows, int vcols, int **vindx, int **windx,
                                 int *jindx, double **v, double *v1d, int **w,
-                                int *w1d, double *hijval, int w_hndl, int v_hndl,
+                                int *w1d, double *hijval,
+                                struct detaddress *wdet, int v_hndl,
                                 int c_hndl, int cindx, double *vik, double *cjk,
                                 int **vx2, int *cnums)
 {
@@ -3261,7 +3921,7 @@ void evaluate_hij_pxqxlist2x_ut(struct det deti, struct xstr *pxlist, int npx,
 
 /*
  * evaluate_hij_pxqxlist2x_ut2: evaluate hij for single replacements in alpha
- * and beta strings. Upper triangle only.
+ * and beta strings. Upper triangle only. Each hij is scaled by hfac.
  */
 void evaluate_hij_pxqxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                  struct xstr *qxlist, int nqx,
@@ -3269,8 +3929,10 @@ void evaluate_hij_pxqxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                  struct occstr *qstr, struct eospace *qeosp, int nqe,
                                  int **pq, int npq, double *m1, double *m2, int aelec,
                                  int belec, int intorb, int vrows, int vcols,
-                                 int jstep, double *cik, double *vjk, double *vik,
-                                 double *cjk, double *hijval, int *jindx, int jpq)
+                                 int jstep, double *cik, double *vjk, int irow,
+                                 struct cj_scatter *cjs, double *hijval,
+                                 int *jindx, int jpq,
+                                 double hfac)
 {
     int j = 0, k = 0;
     int r = 0, s = 0;
@@ -3284,20 +3946,19 @@ void evaluate_hij_pxqxlist2x_ut2(struct det deti, struct xstr *pxlist, int npx,
                                                          peosp, npe, qeosp,
                                                          nqe, pq, npq, jpq);
             jindx[njx] = jindx[njx] - jstep;
-            hijval[jindx[njx]] = hmatels_2xab(pxlist[r].io, pxlist[r].fo,
-                                              pxlist[r].permx,
-                                              qxlist[s].io, qxlist[s].fo,
-                                              qxlist[s].permx, m2);
+            hijval[jindx[njx]] = hfac * hmatels_2xab(pxlist[r].io, pxlist[r].fo,
+                                                     pxlist[r].permx,
+                                                     qxlist[s].io, qxlist[s].fo,
+                                                     qxlist[s].permx, m2);
             njx++;
         }
     }
     for (k = 0; k < vcols; k++) {
         for (j = 0; j < njx; j++) {
             cik[k] = cik[k] + hijval[jindx[j]]*vjk[k * vrows + jindx[j]];
-            cjk[k * vrows + jindx[j]] = cjk[k * vrows + jindx[j]]
-                + hijval[jindx[j]]*vik[k];
         }
     }
+    cj_scatter_add(cjs, irow, jindx, hijval, njx);
     return;
 }
 
@@ -3313,7 +3974,8 @@ void evaluate_hij_qxlist1x(struct det deti, int pindx, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl)
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl)
 {
     struct det detj;
     int buflen;      /* max length of buffer. equal to vrows. */
@@ -3342,7 +4004,7 @@ void evaluate_hij_qxlist1x(struct det deti, int pindx, int npx,
             //set_ga_det_indexes_trans(jindx, njx, 3, windx);
             /* Get data from GLOBAL ARRAYS */
             NGA_Gather(v_hndl, v1d, vindx, (njx * vcols));
-            //NGA_Gather(w_hndl, w1d, windx, (njx * 3));
+            //NGA_Gather(wdet, w1d, windx, (njx * 3));
             /* Evaluate <i|H|j> for j = 0, ... , njx */
             for (k = 0; k < njx; k++) {
                 //detj.astr = pstr[w[k][0]];
@@ -3380,7 +4042,8 @@ void evaluate_hij_qxlist1x_ut(struct det deti, int pindx, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums)
 {
@@ -3460,6 +4123,7 @@ void evaluate_hij_qxlist1x_ut(struct det deti, int pindx, int npx,
  *  npq    = number of p,q space pairings
  *  m1     = 1-e integrals
  *  m2     = 2-e integrals
+ *  mslab  = per-pair integral slabs
  *  aelec  = alpha electrons
  *  belec  = beta  electrons
  *  intorb = internal orbitals
@@ -3468,8 +4132,8 @@ void evaluate_hij_qxlist1x_ut(struct det deti, int pindx, int npx,
  *  jstep  = index in wavefunction of first determinant in this buffer j
  *  cik    = C(i,k)
  *  vjk    = V(j,k)
- *  vik    = V(i,k)
- *  cjk    = C(j,k)
+ *  irow   = row of |i> in V(i,k)
+ *  cjs    = this thread's C(j,k) contributions
  *  hijval = <i|H|j> values
  *  jindx  = array for determinant indices
  */
@@ -3477,10 +4141,12 @@ void evaluate_hij_qxlist1x_ut2(struct det deti, int pindx, int npx,
                                struct xstr *qxlist, int nqx,
                                struct occstr *pstr, struct eospace *peosp, int npe,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
-                               int **pq, int npq, double *m1, double *m2, int aelec,
-                               int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq)
+                               int **pq, int npq, double *m1, double *m2,
+                               struct moslab *mslab, int aelec, int belec,
+                               int intorb, int vrows, int vcols,
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq)
 {
     int j = 0, k = 0;
     int s = 0;
@@ -3495,17 +4161,16 @@ void evaluate_hij_qxlist1x_ut2(struct det deti, int pindx, int npx,
     }
     /* Evaluate <i|H|j> for j = 0, ... , njx */
     for (j = 0; j < nqx; j++) {
-        hijval[jindx[j]] = hmatels_1x(deti.bstr.istr, qxlist[j].io, qxlist[j].fo,
-                                      qxlist[j].permx, belec, deti.astr.istr, aelec,
-                                      m1, m2);
+        hijval[jindx[j]] = hmatels_1x_slab(deti.bstr.istr, qxlist[j].io,
+                                           qxlist[j].fo, qxlist[j].permx, belec,
+                                           deti.astr.istr, aelec, m1, mslab);
     }
     for (k = 0; k < vcols; k++) {
         for (j = 0; j < nqx; j++) {
             cik[k] = cik[k] + hijval[jindx[j]]*vjk[k * vrows + jindx[j]];
-            cjk[k * vrows + jindx[j]] = cjk[k * vrows + jindx[j]]
-                + hijval[jindx[j]]*vik[k];
         }
     }
+    cj_scatter_add(cjs, irow, jindx, hijval, nqx);
     return;
 }
 
@@ -3521,7 +4186,8 @@ void evaluate_hij_qxlist2x(struct det deti, int pindx, int npx,
                            int aelec, int belec, int intorb, double *c,
                            int vrows, int vcols, int **vindx, int **windx,
                            int *jindx, double **v, double *v1d, int **w,
-                           int *w1d, double *hijval, int w_hndl, int v_hndl)
+                           int *w1d, double *hijval,
+                           struct detaddress *wdet, int v_hndl)
 {
     struct det detj;
     int buflen;      /* max length of buffer. equal to vrows. */
@@ -3550,7 +4216,7 @@ void evaluate_hij_qxlist2x(struct det deti, int pindx, int npx,
             //set_ga_det_indexes_trans(jindx, njx, 3, windx);
             /* Get data from GLOBAL ARRAYS */
             NGA_Gather(v_hndl, v1d, vindx, (njx * vcols));
-            //NGA_Gather(w_hndl, w1d, windx, (njx * 3));
+            //NGA_Gather(wdet, w1d, windx, (njx * 3));
             /* Evaluate <i|H|j> for j = 0, ... , njx */
             for (k = 0; k < njx; k++) {
                 //detj.astr = pstr[w[k][0]];
@@ -3588,7 +4254,8 @@ void evaluate_hij_qxlist2x_ut(struct det deti, int pindx, int npx,
                               int aelec, int belec, int intorb, double *c,
                               int vrows, int vcols, int **vindx, int **windx,
                               int *jindx, double **v, double *v1d, int **w,
-                              int *w1d, double *hijval, int w_hndl, int v_hndl,
+                              int *w1d, double *hijval,
+                              struct detaddress *wdet, int v_hndl,
                               int c_hndl, int cindx, double *vik, double *cjk,
                               int **vx2, int *cnums)
 {
@@ -3658,8 +4325,9 @@ void evaluate_hij_qxlist2x_ut2(struct det deti, int pindx, int npx,
                                struct occstr *qstr, struct eospace *qeosp, int nqe,
                                int **pq, int npq, double *m1, double *m2, int aelec,
                                int belec, int intorb, int vrows, int vcols,
-                               int jstep, double *cik, double *vjk, double *vik,
-                               double *cjk, double *hijval, int *jindx, int jpq)
+                               int jstep, double *cik, double *vjk, int irow,
+                               struct cj_scatter *cjs, double *hijval,
+                               int *jindx, int jpq)
 {
     int j = 0, k = 0;
     int s = 0;
@@ -3680,10 +4348,9 @@ void evaluate_hij_qxlist2x_ut2(struct det deti, int pindx, int npx,
     for (k = 0; k < vcols; k++) {
         for (j = 0; j < nqx; j++) {
             cik[k] = cik[k] + hijval[jindx[j]]*vjk[k * vrows + jindx[j]];
-            cjk[k * vrows + jindx[j]] = cjk[k * vrows + jindx[j]]
-                + hijval[jindx[j]]*vik[k];
         }
     }
+    cj_scatter_add(cjs, irow, jindx, hijval, nqx);
     return;
 }
 
@@ -3763,26 +4430,141 @@ void generate_det_triples (int ndeti, int **d_triplet, int pq_start,
 
 /*
  * generate_newvector: generate new vector to be added to space.
- *  n = - r / (d - E)
+ *  PRECOND_DIAG:  n = - r / (d - E)
+ *  PRECOND_SHIFT: n = - r / (d - E + shift), floored
+ *  PRECOND_OLSEN: n = - D^-1 (r - eps x), x = Ritz vector
+ *  PRECOND_BLOCK: exact inverse on block P, shifted diagonal elsewhere
+ * All but PRECOND_DIAG act on the locally owned patch of N.
  * Input:
  *  r_hndl = GA handle for residual vector
  *  d_hndl = GA handle for diagonal elements
  *  n_hndl = GA handle for new vector
  *  x_hndl = GA handle for scratch array
+ *  v_hndl = GA handle for basis vectors
+ *  hevec  = eigenvectors of v.Hv
+ *  ckdim  = current dimension of krylov space
+ *  croot  = current root
+ *  pc     = preconditioner
+ * Returns the number of floored denominators (all processes).
  */
-void generate_newvector (int r_hndl, int d_hndl, double eval, int ndets,
-                         int n_hndl, int x_hndl)
+int generate_newvector (int r_hndl, int d_hndl, double eval, int ndets,
+                        int n_hndl, int x_hndl, int v_hndl, double **hevec,
+                        int ckdim, int croot, struct precond *pc)
 {
         double e = 0.0;
         double neg1 = -1.0;
-        
-        NGA_Zero(x_hndl);
-        GA_Copy(d_hndl, x_hndl);
-        e = neg1 * eval;
-        GA_Add_constant(x_hndl, &e);
-        GA_Scale(x_hndl, &neg1);
-        GA_Elem_divide(r_hndl, x_hndl, n_hndl);
-        return;
+        int lo[2] = {0, 0}, hi[2] = {0, 0};
+        int ld[1] = {1};
+        int nloc = 0;           /* Local length of N */
+        double *r = NULL;       /* Local residual */
+        double *d = NULL;       /* Local <i|H|i> */
+        double *n = NULL;       /* Local new vector */
+        double *x = NULL;       /* Local Ritz vector */
+        double *v = NULL;       /* Local basis vectors */
+        double xd[2] = {0.0, 0.0}; /* (x,D^-1 r), (x,D^-1 x) */
+        double den = 0.0;
+        double eps = 0.0;
+        int nfloor = 0;
+        int i, j, k;
+
+        if (pc->type == PRECOND_DIAG) {
+                NGA_Zero(x_hndl);
+                GA_Copy(d_hndl, x_hndl);
+                e = neg1 * eval;
+                GA_Add_constant(x_hndl, &e);
+                GA_Scale(x_hndl, &neg1);
+                GA_Elem_divide(r_hndl, x_hndl, n_hndl);
+                return nfloor;
+        }
+
+        /* R, D and N are duplicates, so they share a distribution. */
+        NGA_Distribution(n_hndl, mpi_proc_rank, lo, hi);
+        nloc = hi[0] - lo[0] + 1;
+        if (nloc < 0) nloc = 0;
+        r = malloc(sizeof(double) * (nloc + 1));
+        d = malloc(sizeof(double) * (nloc + 1));
+        n = malloc(sizeof(double) * (nloc + 1));
+        if (nloc > 0) {
+                perftimer_nga_get(r_hndl, lo, hi, r, ld);
+                perftimer_nga_get(d_hndl, lo, hi, d, ld);
+        }
+
+        /* Shifted, floored diagonal. */
+        for (i = 0; i < nloc; i++) {
+                den = precond_denom(d[i], eval, pc->shift, &nfloor);
+                n[i] = neg1 * r[i] / den;
+        }
+
+        if (pc->type == PRECOND_OLSEN) {
+                /* x(i) = sum_k hevec[croot-1][k] * v[k][i] */
+                x = malloc(sizeof(double) * (nloc + 1));
+                v = malloc(sizeof(double) * (ckdim * nloc + 1));
+                init_dbl_array_0(x, nloc);
+                if (nloc > 0) {
+                        int vlo[2] = {0, lo[0]};
+                        int vhi[2] = {(ckdim - 1), hi[0]};
+                        int vld[1] = {nloc};
+                        perftimer_nga_get(v_hndl, vlo, vhi, v, vld);
+                }
+                for (k = 0; k < ckdim; k++) {
+                        for (i = 0; i < nloc; i++) {
+                                x[i] += hevec[croot - 1][k] * v[k * nloc + i];
+                        }
+                }
+                for (i = 0; i < nloc; i++) {
+                        den = precond_denom(d[i], eval, pc->shift, NULL);
+                        xd[0] += x[i] * r[i] / den;
+                        xd[1] += x[i] * x[i] / den;
+                }
+                MPI_Allreduce(MPI_IN_PLACE, xd, 2, MPI_DOUBLE, MPI_SUM,
+                              MPI_COMM_WORLD);
+                eps = xd[0] / xd[1];
+                for (i = 0; i < nloc; i++) {
+                        den = precond_denom(d[i], eval, pc->shift, NULL);
+                        n[i] += eps * x[i] / den;
+                }
+                free(x);
+                free(v);
+        } else if (pc->type == PRECOND_BLOCK) {
+                /* (H(P,P) - E + shift)^-1 = U (L - E + shift)^-1 U^T.
+                 * Each process contributes the r(P) it owns to U^T r. */
+                for (k = 0; k < pc->dim; k++) {
+                        pc->bscr[k] = 0.0;
+                        for (j = 0; j < pc->dim; j++) {
+                                if (pc->bidx[j] < lo[0] ||
+                                    pc->bidx[j] > hi[0]) continue;
+                                pc->bscr[k] += pc->bvec[k * pc->dim + j] *
+                                        r[pc->bidx[j] - lo[0]];
+                        }
+                }
+                MPI_Allreduce(MPI_IN_PLACE, pc->bscr, pc->dim, MPI_DOUBLE,
+                              MPI_SUM, MPI_COMM_WORLD);
+                for (k = 0; k < pc->dim; k++) {
+                        den = precond_denom(pc->bval[k], eval, pc->shift,
+                                            (mpi_proc_rank == mpi_root ?
+                                             &nfloor : NULL));
+                        pc->bscr[k] = pc->bscr[k] / den;
+                }
+                for (j = 0; j < pc->dim; j++) {
+                        if (pc->bidx[j] < lo[0] ||
+                            pc->bidx[j] > hi[0]) continue;
+                        i = pc->bidx[j] - lo[0];
+                        n[i] = 0.0;
+                        for (k = 0; k < pc->dim; k++) {
+                                n[i] -= pc->bvec[k * pc->dim + j] *
+                                        pc->bscr[k];
+                        }
+                }
+        }
+
+        if (nloc > 0) NGA_Put(n_hndl, lo, hi, n, ld);
+        free(r);
+        free(d);
+        free(n);
+        MPI_Allreduce(MPI_IN_PLACE, &nfloor, 1, MPI_INT, MPI_SUM,
+                      MPI_COMM_WORLD);
+        GA_Sync();
+        return nfloor;
 }
 
 /*
@@ -3835,66 +4617,6 @@ void generate_residual (int v_hndl, int c_hndl, int r_hndl, double **hevec,
         return;
 }
 
-/*
- * generate_wlist: generate the wavefunction list of triplets
- * Input:
- *  hndl     = handle of global array of W
- *  ndets    = number of determinants
- *  pq       = alpha/beta pairs
- *  npq      = number of alpha/beta pairs
- *  peospace = alpha string electron orbital space
- *  pegrps   = number of alpha string orbital spaces
- *  qeospace = beta  string electron orbital space
- *  qegrps   = number of beta  string orbital spaces
- */
-void generate_wlist(int hndl, int ndets, int **pq, int npq,
-                    struct eospace *peosp, int pegrps,
-                    struct eospace *qeosp, int qegrps)
-{
-        int lo[2] = {0, 0};
-        int hi[2] = {0, 0};
-        int ld[1] = {0};       /* Leading dimension of w buffer */
-        int rows = 0, cols = 0;/* Dimensions of local w array */
-        int **w = NULL;        /* Local w array */
-        int *wdata = NULL;     /* Local w array data (1-d) */
-
-        int pq_start = 0, pq_final = 0;
-        int pstart = 0, pfinal = 0;
-        int qstart = 0, qfinal = 0;
-        
-        /* Find distribution of W that is allocate on this process.
-         * Allocate local W array */
-        NGA_Distribution(hndl, mpi_proc_rank, lo, hi);
-        cols = hi[0] - lo[0] + 1;
-        rows = hi[1] - lo[1] + 1;
-        if (rows != 3) {
-                error_message(mpi_proc_rank, "rows != 3","generate_wlist");
-                error_flag(mpi_proc_rank, rows, "generate_wlist");
-                return;
-        }
-        wdata = allocate_mem_int_cont(&w, rows, cols);
-        
-        /* Get starting deteriminant index values, and generate the determinant
-         * triplet list for this section. */
-        determinant_string_info(lo[0], peosp, pegrps, qeosp, qegrps, pq, npq,
-                                &pq_start, &pstart, &qstart);
-        determinant_string_info(hi[0], peosp, pegrps, qeosp, qegrps, pq, npq,
-                                &pq_final, &pfinal, &qfinal);
-        generate_det_triples(cols, w, pq_start, pstart, qstart, pq_final,
-                             pfinal, qfinal, pq, npq, peosp, pegrps,
-                             qeosp, qegrps);
-
-        /* Send this info to the global array W. */
-        ld[0] = rows;
-        NGA_Put(hndl, lo, hi, wdata, ld);
-
-        deallocate_mem_cont_int(&w, wdata);
-
-        GA_Sync();
-                
-        return;
-}    
-
 /*
  * get_upptri_element_index: get index of an element (i,j) in
  * list of elements in upper triangle of H matrix (n x n).
@@ -3956,11 +4678,135 @@ long long int get_upptri_size (int n)
     return result;
 }
 
+/*
+ * init_precond: set up the correction vector preconditioner. For
+ * PRECOND_BLOCK the root process diagonalizes H(P,P) for the dim
+ * determinants of lowest <i|H|i> and broadcasts it.
+ * Input:
+ *  pc     = preconditioner
+ *  type   = PRECOND_*
+ *  shift  = level shift
+ *  dim    = PRECOND_BLOCK block dimension
+ *  d_hndl = GA handle for diagonal elements
+ *  ndets  = number of determinants
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ *  pstr   = alpha strings
+ *  qstr   = beta  strings
+ *  m1     = 1-e integrals
+ *  m2     = 2-e integrals
+ *  aelec  = alpha electrons
+ *  belec  = beta  electrons
+ *  intorb = internal orbitals (DOCC + ACTV)
+ */
+int init_precond(struct precond *pc, int type, double shift, int dim,
+                 int d_hndl, int ndets, struct detaddress *wdet,
+                 struct occstr *pstr, struct occstr *qstr,
+                 double *m1, double *m2, int aelec, int belec, int intorb)
+{
+        double *dgls = NULL;    /* All <i|H|i> (root) */
+        double *hmat = NULL;    /* H(P,P) (root) */
+        int *w = NULL;          /* (p, q, cas) of block determinants */
+        int lo[1] = {0}, hi[1] = {0}, ld[1] = {1};
+        int error = 0;
+        int i, j, k;
+
+        pc->type  = type;
+        pc->shift = shift;
+        pc->dim   = 0;
+        pc->bidx  = NULL;
+        pc->bvec  = NULL;
+        pc->bval  = NULL;
+        pc->bscr  = NULL;
+        if (type < PRECOND_DIAG || type > PRECOND_BLOCK) {
+                error_message(mpi_proc_rank, "Unknown preconditioner",
+                              "init_precond");
+                return type;
+        }
+        if (type != PRECOND_BLOCK) return error;
+
+        pc->dim  = int_min(dim, ndets);
+        pc->bidx = malloc(sizeof(int) * pc->dim);
+        pc->bvec = malloc(sizeof(double) * pc->dim * pc->dim);
+        pc->bval = malloc(sizeof(double) * pc->dim);
+        pc->bscr = malloc(sizeof(double) * pc->dim);
+        if (pc->bidx == NULL || pc->bvec == NULL || pc->bval == NULL ||
+            pc->bscr == NULL) {
+                error_message(mpi_proc_rank, "Cannot allocate block",
+                              "init_precond");
+                free_precond(pc);
+                return 1;
+        }
+
+        if (mpi_proc_rank == mpi_root) {
+                /* Choose the dim determinants of lowest <i|H|i>: keep
+                 * the block sorted by insertion, ties by index. */
+                dgls = malloc(sizeof(double) * ndets);
+                hmat = malloc(sizeof(double) * pc->dim * pc->dim);
+                w    = malloc(sizeof(int) * 3 * pc->dim);
+                lo[0] = 0;
+                hi[0] = ndets - 1;
+                perftimer_nga_get(d_hndl, lo, hi, dgls, ld);
+                k = 0;
+                for (i = 0; i < ndets; i++) {
+                        if (k == pc->dim &&
+                            dgls[i] >= dgls[pc->bidx[k - 1]]) continue;
+                        j = (k < pc->dim ? k++ : k - 1);
+                        while (j > 0 && dgls[pc->bidx[j - 1]] > dgls[i]) {
+                                pc->bidx[j] = pc->bidx[j - 1];
+                                j--;
+                        }
+                        pc->bidx[j] = i;
+                }
+                for (i = 0; i < pc->dim; i++) {
+                        get_det_triple(wdet, pc->bidx[i], &(w[3 * i]));
+                }
+#pragma omp parallel for schedule(dynamic,4) default(none) \
+        shared(pc, w, pstr, qstr, m1, m2, aelec, belec, intorb, hmat) \
+        private(j)
+                for (i = 0; i < pc->dim; i++) {
+                        struct det deti, detj;
+                        deti.astr = pstr[w[3 * i]];
+                        deti.bstr = qstr[w[3 * i + 1]];
+                        deti.cas  = w[3 * i + 2];
+                        for (j = i; j < pc->dim; j++) {
+                                detj.astr = pstr[w[3 * j]];
+                                detj.bstr = qstr[w[3 * j + 1]];
+                                detj.cas  = w[3 * j + 2];
+                                hmat[i * pc->dim + j] =
+                                        hmatels(deti, detj, m1, m2, aelec,
+                                                belec, intorb);
+                                hmat[j * pc->dim + i] =
+                                        hmat[i * pc->dim + j];
+                        }
+                }
+                error = diagmat_dsyevr(hmat, pc->dim, pc->bvec, pc->bval);
+                if (error != 0) {
+                        error_message(mpi_proc_rank,
+                                      "Error occured during DSYEVR",
+                                      "init_precond");
+                }
+                free(dgls);
+                free(hmat);
+                free(w);
+        }
+        MPI_Bcast(&error, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        if (error != 0) {
+                free_precond(pc);
+                return error;
+        }
+        MPI_Bcast(pc->bidx, pc->dim, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(pc->bvec, (pc->dim * pc->dim), MPI_DOUBLE, mpi_root,
+                  MPI_COMM_WORLD);
+        MPI_Bcast(pc->bval, pc->dim, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+        return error;
+}
+
 /*
  * init_diag_H_subspace: generate reference vectors from diagonalization
  * of a subspace of Hij.
  */
-void init_diag_H_subspace( int w_hndl, struct occstr *pstr, struct occstr *qstr,
+void init_diag_H_subspace(
+                          struct detaddress *wdet, struct occstr *pstr, struct occstr *qstr,
                            double *m1, double *m2,
                            int aelec, int belec, int intorb, int ndets, int dim,
                            double **refspace)
@@ -3974,9 +4820,6 @@ void init_diag_H_subspace( int w_hndl, struct occstr *pstr, struct occstr *qstr,
     
     int **w       = NULL;     /* Local w array */
     int *wdata    = NULL;     /* Local w array data (1-D) */
-    int w_lo[2] = {0, 0};
-    int w_hi[2] = {0, 0};
-    int w_ld[1] = {0};
     
     int i, j, ii;
     int error = 0;
@@ -3988,12 +4831,7 @@ void init_diag_H_subspace( int w_hndl, struct occstr *pstr, struct occstr *qstr,
     
     /* Allocate w array and get wavefunction information */
     wdata = allocate_mem_int_cont(&w, 3, dim);
-    w_lo[0] = 0;
-    w_lo[1] = 0;
-    w_hi[0] = dim - 1;
-    w_hi[1] = 2;
-    w_ld[0] = 3;
-    NGA_Get(w_hndl, w_lo, w_hi, wdata, w_ld);
+    get_det_triples(wdet, 0, (dim - 1), wdata);
     
     /* OMP SECTION */
 #pragma omp parallel                                                    \
@@ -4157,7 +4995,7 @@ void orthonormalize_newvector (int v_hndl, int nvecs, int ndets, int n_hndl)
  *  mdim  = maximum size of krylov space
  *  v_hndl= (GLOBAL ARRAY HANDLE) basis vectors
  *  d_hndl= (GLOBAL ARRAY HANDLE) diagonal elements <i|H|i>
- *  w_hndl= (GLOBAL ARRAY HANDLE) wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  * Output:
  *  c_hndl= (GLOBAL ARRAY HANDLE) Hv=c vectors
  */
@@ -4166,7 +5004,8 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
                           int **pqs, int num_pq, double *m1, double *m2,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl, int d_hndl,
-                          int c_hndl, int w_hndl, int ga_buffer_len)
+                          int c_hndl,
+                          struct detaddress *wdet, int ga_buffer_len)
 {
         
         double **c_local = NULL;  /* Local c array */
@@ -4199,15 +5038,9 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
         int c_hi[2] = {0, 0}; /* ending indices of memory block */
         int v_lo[2] = {0, 0}; /* starting indices of memory block */
         int v_hi[2] = {0, 0}; /* ending indices of memory block */
-        int wi_lo[2] = {0, 0};
-        int wi_hi[2] = {0, 0};
-        int wj_lo[2] = {0, 0};
-        int wj_hi[2] = {0, 0};
 
         int v_ld[1] = {0}; /* Leading dimensions of V local buffer */
         int c_ld[1] = {0}; /* Leading dimensions of C local buffer */
-        int wi_ld[1] = {0};
-        int wj_ld[1] = {0};
         
         double alpha[1] = {1.0}; /* Scale factor for c_local into c_global. */
 
@@ -4230,16 +5063,11 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
         c_ld[0] = c_rows;
         /* Allocate local array and get C data */
         cdata = allocate_mem_double_cont(&c_local, c_rows, c_cols);
-        NGA_Get(c_hndl, c_lo, c_hi, cdata, c_ld);
+        perftimer_nga_get(c_hndl, c_lo, c_hi, cdata, c_ld);
 
         /* Allocate local Wi array and get W data */
         widata = allocate_mem_int_cont(&wi, 3, c_rows);
-        wi_lo[0] = c_lo[1];
-        wi_lo[1] = 0;
-        wi_hi[0] = c_hi[1];
-        wi_hi[1] = 2;
-        wi_ld[0] = 3;
-        NGA_Get(w_hndl, wi_lo, wi_hi, widata, wi_ld); 
+        get_det_triples(wdet, c_lo[1], c_hi[1], widata);
 
         buflen = ndets;
         //buflen = ga_buffer_len; /* Set buffer size for each column */
@@ -4256,9 +5084,6 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
 
         /* allocate local Wj array */
         wjdata = allocate_mem_int_cont(&wj, 3, buflen);
-        wj_lo[1] = 0;
-        wj_hi[1] = 2;
-        wj_ld[0] = 3;
 
         if (mpi_proc_rank == mpi_root) timestamp();
         GA_Sync();
@@ -4270,12 +5095,10 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
                 v_lo[1] = j;
                 v_hi[1] = jmax;
                 v_rows = v_hi[1] - v_lo[1] + 1;
-                NGA_Get(v_hndl, v_lo, v_hi, vdata, v_ld);
+                perftimer_nga_get(v_hndl, v_lo, v_hi, vdata, v_ld);
 
-                wj_lo[0] = j;
-                wj_hi[0] = jmax;
                 wjlen = jmax - j + 1;
-                NGA_Get(w_hndl, wj_lo, wj_hi, wjdata, wj_ld);
+                get_det_triples(wdet, j, jmax, wjdata);
 
                 /* Evaluate block of H(i,j)*V(j,k)=C(i,k). This is done via the
                  * space indexes. Each block is over all V vectors, k.*/
@@ -4288,7 +5111,7 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
                                      qegrps, qstr, pqs, num_pq, m1, m2,
                                      aelec, belec, intorb);
         }
-        NGA_Acc(c_hndl, c_lo, c_hi, cdata, c_ld, alpha);
+        perftimer_nga_acc(c_hndl, c_lo, c_hi, cdata, c_ld, alpha);
 
         deallocate_mem_cont(&v_local, vdata);
         deallocate_mem_cont(&c_local, cdata);
@@ -4312,6 +5135,7 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
  *  num_pq= number of alpha and beta space pairs
  *  m1    = 1-e integrals
  *  m2    = 2-e integrals
+ *  mslab = per-pair integral slabs
  *  aelec = alpha electrons
  *  belec = beta  electrons
  *  intorb= internal orbitals
@@ -4321,17 +5145,24 @@ void perform_hv_initspace(struct occstr *pstr, struct eospace *peosp, int pegrps
  *  mdim  = maximum size of krylov space
  *  v_hndl= (GLOBAL ARRAY HANDLE) basis vectors
  *  d_hndl= (GLOBAL ARRAY HANDLE) diagonal elements <i|H|i>
- *  w_hndl= (GLOBAL ARRAY HANDLE) wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
+ *  scr   = per-thread sigma scratch arrays
+ *  vtol  = |v| screening threshold (0 = off)
+ *  spinsym = Ms=0 spin-flip symmetry of v (1, -1; 0 = off)
  * Output:
  *  c_hndl= (GLOBAL ARRAY HANDLE) Hv=c vectors
  */
 void perform_hvispacefast(struct occstr *pstr, struct eospace *peosp, int pegrps,
                           struct occstr *qstr, struct eospace *qeosp, int qegrps,
                           int **pqs, int num_pq, double *m1, double *m2,
+                          struct moslab *mslab,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl,
-                          int d_hndl, int c_hndl, int w_hndl, int ga_buffer_len,
-                          int nmo, int ndocc, int nactv)
+                          int d_hndl, int c_hndl,
+                          struct detaddress *wdet, int ga_buffer_len,
+                          int nmo, int ndocc, int nactv,
+                          struct sigma_scratch *scr, double vtol,
+                          int spinsym)
 {
     /*
      * The following convention is used: H(i,j)*V(j,k)=C(i,k)
@@ -4349,12 +5180,12 @@ void perform_hvispacefast(struct occstr *pstr, struct eospace *peosp, int pegrps
     
     int **wi       = NULL;     /* Local w array */
     int *widata    = NULL;     /* Local w array data (1-D) */
-    int wi_lo[2]   = {0, 0};
-    int wi_hi[2]   = {0, 0};
-    int wi_ld[1]   = {0};      /* Leading dimensions of Wi local buffer */
     int i;
     int *cindx = NULL;         /* Column indices i for v_i and c_i */
     double alpha[1] = {1.0};
+    double half = 0.5;         /* Diagonal weight under spin-flip fold */
+    int scl_lo[2]  = {0, 0};
+    int scl_hi[2]  = {0, 0};
     
     if (mpi_proc_rank == mpi_root) {
         printf(" Performing Hv=c on initial vector space...\n");
@@ -4374,16 +5205,11 @@ void perform_hvispacefast(struct occstr *pstr, struct eospace *peosp, int pegrps
     c_ld[0] = c_rows;
     /* Allocate local array and get C data */
     cdata = allocate_mem_double_cont(&c_local, c_rows, c_cols);
-    NGA_Get(c_hndl, c_lo, c_hi, cdata, c_ld);
+    perftimer_nga_get(c_hndl, c_lo, c_hi, cdata, c_ld);
     
     /* Allocate local Wi array and get W data */
     widata = allocate_mem_int_cont(&wi, 3, c_rows);
-    wi_lo[0] = c_lo[1];
-    wi_lo[1] = 0;
-    wi_hi[0] = c_hi[1];
-    wi_hi[1] = 2;
-    wi_ld[0] = 3;
-    NGA_Get(w_hndl, wi_lo, wi_hi, widata, wi_ld); 
+    get_det_triples(wdet, c_lo[1], c_hi[1], widata);
 
     cindx = malloc(sizeof(int) * c_cols);
     for (i = 0; i < c_cols; i++) {
@@ -4393,16 +5219,30 @@ void perform_hvispacefast(struct occstr *pstr, struct eospace *peosp, int pegrps
     if (mpi_proc_rank == mpi_root) timestamp();
     GA_Sync();
     compute_hvc_diagonal_ga(c_hndl, v_hndl, d_hndl, 0, (dim - 1), ndets);
-    compute_cblock_Hfastest(cdata, c_cols, c_rows, wi, w_hndl, v_hndl, d_hndl,
+    if (spinsym != 0) {
+        /* <i|H|i>v(i) is restored to full weight by the fold */
+        scl_lo[1] = 0;
+        scl_hi[0] = dim - 1;
+        scl_hi[1] = ndets - 1;
+        NGA_Scale_patch(c_hndl, scl_lo, scl_hi, &half);
+    }
+    compute_cblock_Hfastest(cdata, c_cols, c_rows, wi, wdet, v_hndl, d_hndl,
                             ga_buffer_len, pstr, peosp, pegrps, qstr, qeosp, qegrps,
-                            pqs, num_pq, m1, m2, aelec, belec, intorb, ndets,
-                            nmo, ndocc, nactv, c_hndl, c_lo[1], c_hi[1], cindx);
-//    compute_cblock_Hfaster(cdata, c_cols, c_rows, wi, w_hndl, v_hndl, d_hndl,
+                            pqs, num_pq, m1, m2, mslab, aelec, belec, intorb,
+                            ndets, nmo, ndocc, nactv, c_hndl, c_lo[1], c_hi[1],
+                            cindx, scr, vtol, spinsym);
+//    compute_cblock_Hfaster(cdata, c_cols, c_rows, wi, wdet, v_hndl, d_hndl,
 //                           ga_buffer_len, pstr, peosp, pegrps, qstr, qeosp, qegrps,
 //                          pqs, num_pq, m1, m2, aelec, belec, intorb, ndets,
 //                           nmo, ndocc, nactv, c_hndl, c_lo[1], cindx);
-    NGA_Acc(c_hndl, c_lo, c_hi, cdata, c_ld, alpha);
+    perftimer_nga_acc(c_hndl, c_lo, c_hi, cdata, c_ld, alpha);
     GA_Sync();
+    /* Restore the beta-only and remaining alpha-beta contributions */
+    if (spinsym != 0) {
+        apply_spinflip_ga(c_hndl, 0, (dim - 1), 1.0, (double) spinsym,
+                          wdet, pstr, peosp, pegrps, qstr, qeosp, qegrps,
+                          pqs, num_pq, ndocc, nactv);
+    }
     if (mpi_proc_rank == mpi_root) timestamp();
     
     deallocate_mem_cont(&c_local, cdata);
@@ -4435,7 +5275,7 @@ void perform_hvispacefast(struct occstr *pstr, struct eospace *peosp, int pegrps
  *  mdim  = maximum size of krylov space
  *  v_hndl= (GLOBAL ARRAY HANDLE) basis vectors
  *  d_hndl= (GLOBAL ARRAY HANDLE) diagonal elements <i|H|i>
- *  w_hndl= (GLOBAL ARRAY HANDLE) wavefunction
+ *  wdet   = implicit determinant list, |i> = |(p, q, cas)>
  * Output:
  *  c_hndl= (GLOBAL ARRAY HANDLE) Hv=c vectors
  */
@@ -4444,7 +5284,8 @@ void perform_hvispacefast_debug(struct occstr *pstr, struct eospace *peosp, int
                           int **pqs, int num_pq, double *m1, double *m2,
                           int aelec, int belec, int intorb, int ndets,
                           double core_e, int dim, int mdim, int v_hndl,
-                          int d_hndl, int c_hndl, int w_hndl, int ga_buffer_len,
+                          int d_hndl, int c_hndl,
+                          struct detaddress *wdet, int ga_buffer_len,
                           int nmo, int ndocc, int nactv)
 {
     /*
@@ -4463,9 +5304,6 @@ void perform_hvispacefast_debug(struct occstr *pstr, struct eospace *peosp, int
     
     int **wi       = NULL;     /* Local w array */
     int *widata    = NULL;     /* Local w array data (1-D) */
-    int wi_lo[2]   = {0, 0};
-    int wi_hi[2]   = {0, 0};
-    int wi_ld[1]   = {0};      /* Leading dimensions of Wi local buffer */
     int i;
     int *cindx = NULL;         /* Column indices i for v_i and c_i */
     double alpha[1] = {1.0};
@@ -4488,16 +5326,11 @@ void perform_hvispacefast_debug(struct occstr *pstr, struct eospace *peosp, int
     c_ld[0] = c_rows;
     /* Allocate local array and get C data */
     cdata = allocate_mem_double_cont(&c_local, c_rows, c_cols);
-    NGA_Get(c_hndl, c_lo, c_hi, cdata, c_ld);
+    perftimer_nga_get(c_hndl, c_lo, c_hi, cdata, c_ld);
     
     /* Allocate local Wi array and get W data */
     widata = allocate_mem_int_cont(&wi, 3, c_rows);
-    wi_lo[0] = c_lo[1];
-    wi_lo[1] = 0;
-    wi_hi[0] = c_hi[1];
-    wi_hi[1] = 2;
-    wi_ld[0] = 3;
-    NGA_Get(w_hndl, wi_lo, wi_hi, widata, wi_ld); 
+    get_det_triples(wdet, c_lo[1], c_hi[1], widata);
 
     cindx = malloc(sizeof(int) * c_cols);
     for (i = 0; i < c_cols; i++) {
@@ -4506,15 +5339,15 @@ void perform_hvispacefast_debug(struct occstr *pstr, struct eospace *peosp, int
     /* Compute C(i,k) = H(i,j)*V(j,k) for all i in c_lo[1]..c_hi[1] */
     if (mpi_proc_rank == mpi_root) timestamp();
     compute_hvc_diagonal_ga(c_hndl, v_hndl, d_hndl, 0, (dim - 1), ndets);
-//    compute_cblock_Hfastest(cdata, c_cols, c_rows, wi, w_hndl, v_hndl, d_hndl,
+//    compute_cblock_Hfastest(cdata, c_cols, c_rows, wi, wdet, v_hndl, d_hndl,
 //                            ga_buffer_len, pstr, peosp, pegrps, qstr, qeosp, qegrps,
 //                            pqs, num_pq, m1, m2, aelec, belec, intorb, ndets,
 //                            nmo, ndocc, nactv, c_hndl, c_lo[1], c_hi[1], cindx);
-    compute_cblock_Hfaster(cdata, c_cols, c_rows, wi, w_hndl, v_hndl, d_hndl,
+    compute_cblock_Hfaster(cdata, c_cols, c_rows, wi, wdet, v_hndl, d_hndl,
                            ga_buffer_len, pstr, peosp, pegrps, qstr, qeosp, qegrps,
                           pqs, num_pq, m1, m2, aelec, belec, intorb, ndets,
                            nmo, ndocc, nactv, c_hndl, c_lo[1], cindx);
-    NGA_Acc(c_hndl, c_lo, c_hi, cdata, c_ld, alpha);
+    perftimer_nga_acc(c_hndl, c_lo, c_hi, cdata, c_ld, alpha);
     GA_Sync();
     if (mpi_proc_rank == mpi_root) timestamp();
     
@@ -4560,6 +5393,48 @@ void print_iter_info(double *heval, int ckdim, int croot, double rnorm,
         return;
 }
 
+/*
+ * precond_denom: shifted denominator H(i,i) - E + shift, with its
+ * magnitude kept above PRECOND_FLOOR. nfloor (may be NULL) counts
+ * floored values.
+ */
+double precond_denom(double dgl, double eval, double shift, int *nfloor)
+{
+        double den = dgl - eval + shift;
+        if (fabs(den) < PRECOND_FLOOR) {
+                den = (den < 0.0 ? -PRECOND_FLOOR : PRECOND_FLOOR);
+                if (nfloor != NULL) (*nfloor)++;
+        }
+        return den;
+}
+
+/*
+ * print_precond_info: print the correction vector preconditioner.
+ */
+void print_precond_info(struct precond *pc)
+{
+        if (mpi_proc_rank != mpi_root) return;
+        switch (pc->type) {
+        case PRECOND_DIAG:
+                printf(" Preconditioner: diagonal\n");
+                break;
+        case PRECOND_SHIFT:
+                printf(" Preconditioner: shifted diagonal");
+                printf(" (shift = %10.5lf)\n", pc->shift);
+                break;
+        case PRECOND_OLSEN:
+                printf(" Preconditioner: Olsen");
+                printf(" (shift = %10.5lf)\n", pc->shift);
+                break;
+        case PRECOND_BLOCK:
+                printf(" Preconditioner: block inverse, %d dets", pc->dim);
+                printf(" (shift = %10.5lf)\n", pc->shift);
+                break;
+        }
+        fflush(stdout);
+        return;
+}
+
 
 
 /*
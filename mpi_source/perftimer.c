@@ -0,0 +1,241 @@
+// File: perftimer.c
+/*
+ * Phase timers and communication counters for pjayci.
+ *
+ * Timers and counters are per process and cost one clock read per
+ * start/stop. Thread-level times (excitation generation, <i|H|j>) are
+ * summed over threads by the caller and added as a thread average.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi_utilities.h"
+#include "perftimer.h"
+#include <mpi.h>
+#include <ga.h>
+#include <macdecls.h>
+
+/* -- OpenMP options -- */
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#endif
+/* -------------------- */
+
+static double pt_time[PT_NTIMERS];    /* Accumulated time */
+static double pt_start[PT_NTIMERS];   /* Start time of running timer */
+static int pt_running[PT_NTIMERS];    /* Running flag */
+static long long int pt_count[PC_NCOUNTERS];
+
+static const char *pt_name[PT_NTIMERS] = {
+    "davidson", "diagonal", "guess", "sigma", "sigma_xgen", "sigma_hij",
+    "sigma_ga", "subspace", "residual", "orthonormalize", "io", "ga_get_acc"
+};
+
+static const char *pc_name[PC_NCOUNTERS] = {
+    "ga_get_bytes", "ga_acc_bytes", "ga_get_calls", "ga_acc_calls",
+    "hij_alpha_1x", "hij_alpha_2x", "hij_beta_1x", "hij_beta_2x",
+    "hij_alpha_beta", "sigma_calls"
+};
+
+/*
+ * ga_patch_bytes: bytes in a patch of a double global array.
+ */
+static long long int ga_patch_bytes(int g_a, int *lo, int *hi)
+{
+    long long int n = sizeof(double);
+    int ndim = GA_Ndim(g_a);
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        n = n * (hi[i] - lo[i] + 1);
+    }
+    return n;
+}
+
+/*
+ * perftimer_init: zero all timers and counters.
+ */
+void perftimer_init()
+{
+    int i;
+
+    for (i = 0; i < PT_NTIMERS; i++) {
+        pt_time[i] = 0.0;
+        pt_start[i] = 0.0;
+        pt_running[i] = 0;
+    }
+    for (i = 0; i < PC_NCOUNTERS; i++) {
+        pt_count[i] = 0;
+    }
+    return;
+}
+
+/*
+ * perftimer_wtime: wall clock time (s). Safe to call from threads.
+ */
+double perftimer_wtime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return MPI_Wtime();
+#endif
+}
+
+/*
+ * perftimer_start: start timer t.
+ */
+void perftimer_start(int t)
+{
+    pt_start[t] = perftimer_wtime();
+    pt_running[t] = 1;
+    return;
+}
+
+/*
+ * perftimer_stop: stop timer t, adding the elapsed time.
+ */
+void perftimer_stop(int t)
+{
+    if (pt_running[t] == 0) return;
+    pt_time[t] += perftimer_wtime() - pt_start[t];
+    pt_running[t] = 0;
+    return;
+}
+
+/*
+ * perftimer_add: add sec seconds to timer t.
+ */
+void perftimer_add(int t, double sec)
+{
+    pt_time[t] += sec;
+    return;
+}
+
+/*
+ * perftimer_count: add n to counter c.
+ */
+void perftimer_count(int c, long long int n)
+{
+    pt_count[c] += n;
+    return;
+}
+
+/*
+ * perftimer_time: accumulated time (s) of timer t on this process.
+ */
+double perftimer_time(int t)
+{
+    return pt_time[t];
+}
+
+/*
+ * perftimer_counter: value of counter c on this process.
+ */
+long long int perftimer_counter(int c)
+{
+    return pt_count[c];
+}
+
+/*
+ * perftimer_nga_get: NGA_Get of a double array, timed and counted.
+ */
+void perftimer_nga_get(int g_a, int *lo, int *hi, double *buf, int *ld)
+{
+    double t0 = perftimer_wtime(), dt;
+
+    NGA_Get(g_a, lo, hi, buf, ld);
+    dt = perftimer_wtime() - t0;
+    pt_time[PT_GA] += dt;
+    if (pt_running[PT_SIGMA]) pt_time[PT_SIGMA_GA] += dt;
+    pt_count[PC_GA_GET_BYTES] += ga_patch_bytes(g_a, lo, hi);
+    pt_count[PC_GA_GET_CALLS]++;
+    return;
+}
+
+/*
+ * perftimer_nga_acc: NGA_Acc of a double array, timed and counted.
+ */
+void perftimer_nga_acc(int g_a, int *lo, int *hi, double *buf, int *ld,
+                       double *alpha)
+{
+    double t0 = perftimer_wtime(), dt;
+
+    NGA_Acc(g_a, lo, hi, buf, ld, alpha);
+    dt = perftimer_wtime() - t0;
+    pt_time[PT_GA] += dt;
+    if (pt_running[PT_SIGMA]) pt_time[PT_SIGMA_GA] += dt;
+    pt_count[PC_GA_ACC_BYTES] += ga_patch_bytes(g_a, lo, hi);
+    pt_count[PC_GA_ACC_CALLS]++;
+    return;
+}
+
+/*
+ * perftimer_report: gather min/avg/max of each timer and counter over all
+ * processes, print a summary and write it to a JSON file.
+ */
+void perftimer_report(char *filename, int niter)
+{
+    double tmin[PT_NTIMERS], tmax[PT_NTIMERS], tsum[PT_NTIMERS];
+    long long int cmin[PC_NCOUNTERS], cmax[PC_NCOUNTERS];
+    long long int csum[PC_NCOUNTERS];
+    FILE *fptr = NULL;
+    int i;
+
+    MPI_Reduce(pt_time, tmin, PT_NTIMERS, MPI_DOUBLE, MPI_MIN, mpi_root,
+               MPI_COMM_WORLD);
+    MPI_Reduce(pt_time, tmax, PT_NTIMERS, MPI_DOUBLE, MPI_MAX, mpi_root,
+               MPI_COMM_WORLD);
+    MPI_Reduce(pt_time, tsum, PT_NTIMERS, MPI_DOUBLE, MPI_SUM, mpi_root,
+               MPI_COMM_WORLD);
+    MPI_Reduce(pt_count, cmin, PC_NCOUNTERS, MPI_LONG_LONG_INT, MPI_MIN,
+               mpi_root, MPI_COMM_WORLD);
+    MPI_Reduce(pt_count, cmax, PC_NCOUNTERS, MPI_LONG_LONG_INT, MPI_MAX,
+               mpi_root, MPI_COMM_WORLD);
+    MPI_Reduce(pt_count, csum, PC_NCOUNTERS, MPI_LONG_LONG_INT, MPI_SUM,
+               mpi_root, MPI_COMM_WORLD);
+    if (mpi_proc_rank != mpi_root) return;
+
+    printf("\n Timers (s) over %d processes, %d iterations:\n",
+           mpi_num_procs, niter);
+    printf(" %-16s %12s %12s %12s\n", "phase", "min", "avg", "max");
+    for (i = 0; i < PT_NTIMERS; i++) {
+        printf(" %-16s %12.3lf %12.3lf %12.3lf\n", pt_name[i], tmin[i],
+               (tsum[i] / mpi_num_procs), tmax[i]);
+    }
+    printf(" GA get: %.3lf MB  acc: %.3lf MB (all processes)\n",
+           (csum[PC_GA_GET_BYTES] / 1048576.0),
+           (csum[PC_GA_ACC_BYTES] / 1048576.0));
+    fflush(stdout);
+
+    fptr = fopen(filename, "w");
+    if (fptr == NULL) {
+        printf("Could not open file: %s\n", filename);
+        return;
+    }
+    fprintf(fptr, "{\n");
+    fprintf(fptr, "  \"nprocs\": %d,\n", mpi_num_procs);
+    fprintf(fptr, "  \"nthreads\": %d,\n", omp_get_max_threads());
+    fprintf(fptr, "  \"iterations\": %d,\n", niter);
+    fprintf(fptr, "  \"timers\": {\n");
+    for (i = 0; i < PT_NTIMERS; i++) {
+        fprintf(fptr, "    \"%s\": {\"min\": %.6lf, \"avg\": %.6lf, "
+                "\"max\": %.6lf}%s\n", pt_name[i], tmin[i],
+                (tsum[i] / mpi_num_procs), tmax[i],
+                (i < PT_NTIMERS - 1 ? "," : ""));
+    }
+    fprintf(fptr, "  },\n");
+    fprintf(fptr, "  \"counters\": {\n");
+    for (i = 0; i < PC_NCOUNTERS; i++) {
+        fprintf(fptr, "    \"%s\": {\"min\": %lld, \"avg\": %.1lf, "
+                "\"max\": %lld, \"total\": %lld}%s\n", pc_name[i], cmin[i],
+                ((double) csum[i] / mpi_num_procs), cmax[i], csum[i],
+                (i < PC_NCOUNTERS - 1 ? "," : ""));
+    }
+    fprintf(fptr, "  }\n");
+    fprintf(fptr, "}\n");
+    fclose(fptr);
+    printf(" Timer summary written to %s\n", filename);
+    return;
+}
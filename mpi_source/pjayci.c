@@ -38,6 +38,7 @@ int main (int argc, char **argv)
         if (! MA_init(C_DBL, stack, heap)) GA_Error("MA_init failed",stack+heap);
 
         set_ga_process_number_and_rank();
+        set_mpi_node_comm();
 	printf("Greetings from process: %d\n", mpi_proc_rank);
 	fflush(stdout);
         error = execute_pjayci();
@@ -6,6 +6,7 @@ subroutine readnamelist(nmlist, nmlstr, err)
   !  nmlist = 1: general
   !           2: dalginfo
   !           3: dysonorb
+  !           6: transmo
   ! Output:
   !  nmlstr = namelist string
   implicit none
@@ -19,7 +20,7 @@ subroutine readnamelist(nmlist, nmlstr, err)
   
   ! .. namelists ..
   integer :: gen_nml = 1, dai_nml = 2, dys_wf0 = 3, dys_wf1 = 4
-  integer :: dys_orb = 5
+  integer :: dys_orb = 5, dys_tmo = 6
   
   ! .. &general arguments ..
   integer :: electrons, orbitals
@@ -28,27 +29,41 @@ subroutine readnamelist(nmlist, nmlstr, err)
 
   ! .. &dalginfo arguments ..
   integer :: maxiter, krymin, krymax, nroots
-  integer :: prediagr, refdim, buflen
-  real*8  :: restol
+  integer :: prediagr, refdim, buflen, spinsym, precond, memnode
+  integer :: numarank, nthread, nodeshare, sigaccum
+  real*8  :: restol, sigscreen, pcshift
 
   ! .. &wavefcn0 & &wavefcn1 unique arguments ..
   character*300 :: wvfcn_file0, wvfcn_file1
   integer :: nstates
 
   ! .. &dysonorbital arguments ..
-  integer, dimension(5) :: states0, states1
+  ! maxdyst must match MAX_DYSON_STATES in ioutil.h. states0(1) = -1
+  ! (or states1(1) = -1) selects every state of that wavefunction.
+  integer, parameter :: maxdyst = 100
+  integer, dimension(maxdyst) :: states0, states1
+  ! cubefile = 1 writes each dyson orbital to a cube file with cubepts
+  ! points along the longest side of the grid.
+  integer :: cubefile, cubepts
+
+  ! .. &transmo arguments ..
+  ! Photoelectron energies emin..emax (eV) and ionization energy (eV).
+  real*8  :: emin, emax, ionpot
+  integer :: nenergy, ntheta, nphi
 
   integer :: i, j
   
   namelist /general/ electrons, orbitals, nfrozen, ndocc, nactive, &
           nfrzvirt, xlevel, printlvl, printwvf
   namelist /dalginfo/ maxiter, krymin, krymax, nroots, prediagr, &
-          restol, refdim, buflen
+          restol, refdim, buflen, sigscreen, spinsym, precond, pcshift, &
+          memnode, numarank, nthread, nodeshare, sigaccum
   namelist /wavefcn0/ electrons, orbitals, nfrozen, ndocc, nactive, &
           nfrzvirt, xlevel, nstates
   namelist /wavefcn1/ electrons, orbitals, nfrozen, ndocc, nactive, &
           nfrzvirt, xlevel, nstates
-  namelist /dysonorbital/ states0, states1
+  namelist /dysonorbital/ states0, states1, cubefile, cubepts
+  namelist /transmo/ emin, emax, nenergy, ionpot, ntheta, nphi
   
   ! initialize error flag
   err = 0
@@ -90,6 +105,15 @@ subroutine readnamelist(nmlist, nmlstr, err)
           restol    = 1.0d-5
           refdim    =  3
           buflen    = 1000
+          sigscreen = 0.0d0
+          spinsym   =  0
+          precond   =  0
+          pcshift   = 0.0d0
+          memnode   =  0
+          numarank  =  0
+          nthread   =  0
+          nodeshare =  0
+          sigaccum  =  0
           open(file = "jayci.in", unit = 10, action = "read", status = "old", &
                   iostat = err)
           if (err .ne. 0) return
@@ -104,6 +128,15 @@ subroutine readnamelist(nmlist, nmlstr, err)
           write(nmlstr(6),8) restol
           write(nmlstr(7),9) refdim
           write(nmlstr(8),9) buflen
+          write(nmlstr(9),7) sigscreen
+          write(nmlstr(10),9) spinsym
+          write(nmlstr(11),9) precond
+          write(nmlstr(12),8) pcshift
+          write(nmlstr(13),9) memnode
+          write(nmlstr(14),9) numarank
+          write(nmlstr(15),9) nthread
+          write(nmlstr(16),9) nodeshare
+          write(nmlstr(17),9) sigaccum
           
           close(10)
           return
@@ -161,20 +194,49 @@ subroutine readnamelist(nmlist, nmlstr, err)
           return
 
   else if (nmlist .eq. dys_orb) then
-          states0 = (/ 1, 0, 0, 0, 0 /)
-          states1 = (/ 1, 0, 0, 0, 0 /)
+          states0 = 0
+          states1 = 0
+          states0(1) = 1
+          states1(1) = 1
+          cubefile   = 0
+          cubepts    = 80
           open(file="dycicalc.in", unit=10, action="read", status="old", &
                   position="rewind", iostat=err)
           if (err .ne. 0) return
 
           read(10, nml=dysonorbital)
 
-          ! write values to namelist array
-          do i = 1, 5
-                  j = i + 5
-                  write(nmlstr(i),9) states0(i)
-                  write(nmlstr(j),9) states1(i)
+          ! write values to namelist array, ten states per line
+          do i = 1, maxdyst / 10
+                  j = (i - 1) * 10
+                  write(nmlstr(i),6) states0((j + 1):(j + 10))
+                  write(nmlstr(i + maxdyst / 10),6) states1((j + 1):(j + 10))
           end do
+          write(nmlstr(2 * maxdyst / 10 + 1),9) cubefile
+          write(nmlstr(2 * maxdyst / 10 + 2),9) cubepts
+
+          close(10)
+
+          return
+  else if (nmlist .eq. dys_tmo) then
+          emin    = 0.1d0
+          emax    = 10.0d0
+          nenergy = 100
+          ionpot  = 0.0d0
+          ntheta  = 12
+          nphi    = 24
+          open(file="dycicalc.in", unit=10, action="read", status="old", &
+                  position="rewind", iostat=err)
+          if (err .ne. 0) return
+
+          read(10, nml=transmo)
+
+          write(nmlstr(1),7) emin
+          write(nmlstr(2),7) emax
+          write(nmlstr(3),9) nenergy
+          write(nmlstr(4),7) ionpot
+          write(nmlstr(5),9) ntheta
+          write(nmlstr(6),9) nphi
 
           close(10)
 
@@ -184,6 +246,8 @@ subroutine readnamelist(nmlist, nmlstr, err)
           err = 99
           return
   endif
+6 format(10i10)
+7 format(es15.6)
 8 format(f10.5)
 9 format(i10)
 end subroutine readnamelist
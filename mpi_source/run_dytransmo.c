@@ -4,8 +4,18 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include "mpi_utilities.h"
+#include "errorlib.h"
+#include "allocate_mem.h"
+#include "ioutil.h"
+#include "dysonio.h"
+#include "buildao.h"
+#include "aogrid.h"
+#include "transmo.h"
 #include "run_dytransmo.h"
 
+#include <mpi.h>
+
 /*
  * run_dytransmo: driver for computing dyson orbital transition moments.
  */
@@ -14,12 +24,212 @@ int run_dytransmo()
     int error = 0; /* Error flag */
 
     /* Free electron wavefunction input */
-    double *kval = 0.0; /* K-value */
-    double *eval = 0.0; /* Kinetic energy */
-    
-    /* Read AO basis input */
+    double emin = 0.0;    /* Lowest photoelectron energy (eV) */
+    double emax = 0.0;    /* Highest photoelectron energy (eV) */
+    int nenergy = 0;      /* Number of photoelectron energies */
+    double ionpot = 0.0;  /* Ionization energy (eV) */
+    int ntheta = 0;       /* Photoelectron directions in theta */
+    int nphi = 0;         /* Photoelectron directions in phi */
+    double *eval = NULL;  /* Kinetic energies (hartree) */
+    double *khat = NULL;  /* Photoelectron directions */
+    double *wt   = NULL;  /* Direction weights */
+    int ndir = 0;
+
+    /* Wavefunction input (frozen core of dyson orbitals) */
+    int nelecs0 = 0, norbs0 = 0, nfrzc0 = 0, ndocc0 = 0, nactv0 = 0;
+    int nfrzv0 = 0, xlvl0 = 0, nstates0 = 0;
+
+    /* Dyson orbitals */
+    struct ao_gridbasis gb;  /* Atomic orbital basis */
+    int ndyo = 0;            /* Number of dyson orbitals */
+    int ndyst0 = 0, ndyst1 = 0;
+    int *dyst0 = NULL;       /* Anion states */
+    int *dyst1 = NULL;       /* Neutral states */
+    double *orbao = NULL;    /* Dyson orbitals in AO basis, [ndyo][nao] */
+
+    double *sigma_lc = NULL; /* LOCAL cross sections */
+    double *sigma_gl = NULL; /* GLOBAL cross sections */
+    int chunk = 0, lo = 0, hi = 0;
+    int i;
+
+    /* Read input */
+    if (mpi_proc_rank == mpi_root) {
+        readtransmoinput(&emin, &emax, &nenergy, &ionpot, &ntheta, &nphi,
+                         &error);
+        if (error == 0) {
+            readwf0input(&nelecs0, &norbs0, &nfrzc0, &ndocc0, &nactv0,
+                         &xlvl0, &nfrzv0, &nstates0, &error);
+        }
+        if (error == 0 && (nenergy < 1 || ntheta < 1 || nphi < 1 ||
+                           emin <= 0.0 || emax < emin)) {
+            error_message(mpi_proc_rank, "Incorrect &transmo input",
+                          "run_dytransmo");
+            error = 1;
+        }
+    }
+    mpi_error_check_msg(error, "run_dytransmo", "Error reading input.");
+    MPI_Bcast(&emin,    1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(&emax,    1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(&nenergy, 1, MPI_INT,    mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(&ionpot,  1, MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(&ntheta,  1, MPI_INT,    mpi_root, MPI_COMM_WORLD);
+    MPI_Bcast(&nphi,    1, MPI_INT,    mpi_root, MPI_COMM_WORLD);
+
+    /* Read AO basis input and dyson orbitals */
+    error = ao_buildao_gridbasis(&gb);
+    mpi_error_check_msg(error, "run_dytransmo", "Error building AO basis.");
+    if (mpi_proc_rank == mpi_root) {
+        error = read_dyson_ao_orbitals("dysonorb.dat", nfrzc0, gb.nao,
+                                       &ndyo, &orbao, &dyst0, &ndyst0, &dyst1,
+                                       &ndyst1);
+    }
+    mpi_error_check_msg(error, "run_dytransmo",
+                        "Error reading dyson orbitals.");
+    MPI_Bcast(&ndyo, 1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+    if (mpi_proc_rank != mpi_root) {
+        orbao = malloc(sizeof(double) * ndyo * gb.nao);
+    }
+    MPI_Bcast(orbao, (ndyo * gb.nao), MPI_DOUBLE, mpi_root, MPI_COMM_WORLD);
+
     /* Read free electron wave input */
-    /* Compute <i_AO|u|Y_e> */
-    
+    eval = malloc(sizeof(double) * nenergy);
+    for (i = 0; i < nenergy; i++) {
+        eval[i] = emin;
+        if (nenergy > 1) eval[i] += i * (emax - emin) / (nenergy - 1);
+        eval[i] = eval[i] / AU2EV;
+    }
+    ndir = ntheta * nphi;
+    khat = malloc(sizeof(double) * 3 * ndir);
+    wt   = malloc(sizeof(double) * ndir);
+    transmo_orientation_grid(ntheta, nphi, khat, wt);
+
+    /* Compute <i_AO|u|Y_e>. Energies are split between processes. */
+    mpi_split_work_array_1d(nenergy, &chunk, &lo, &hi);
+    sigma_lc = calloc(nenergy * ndyo, sizeof(double));
+    sigma_gl = calloc(nenergy * ndyo, sizeof(double));
+    if (mpi_proc_rank == mpi_root) {
+        printf("\nComputing cross sections: %d energies x %d directions\n",
+               nenergy, ndir);
+    }
+    if (hi >= lo) {
+        transmo_cross_sections(&gb, orbao, ndyo, &(eval[lo]), (hi - lo + 1),
+                               (ionpot / AU2EV), khat, wt, ndir,
+                               &(sigma_lc[(lo * ndyo)]));
+    }
+    MPI_Reduce(sigma_lc, sigma_gl, (nenergy * ndyo), MPI_DOUBLE, MPI_SUM,
+               mpi_root, MPI_COMM_WORLD);
+
+    if (mpi_proc_rank == mpi_root) {
+        print_cross_sections("dytransmo.dat", nenergy, eval, ionpot, ndyo,
+                             sigma_gl, dyst0, ndyst0, dyst1, ndyst1);
+        free(dyst0);
+        free(dyst1);
+    }
+
+    aogrid_free(&gb);
+    free(orbao);
+    free(eval);
+    free(khat);
+    free(wt);
+    free(sigma_lc);
+    free(sigma_gl);
+    return error;
+}
+
+/*
+ * print_cross_sections: print cross sections (Mb) to file.
+ */
+void print_cross_sections(char *filename, int nener, double *ener,
+                          double ionpot, int ndyo, double *sigma, int *dyst0,
+                          int ndyst0, int *dyst1, int ndyst1)
+{
+    FILE *fptr = NULL; /* File pointer */
+    int i, j;
+
+    fptr = fopen(filename, "w");
+    if (fptr == NULL) {
+        printf("Could not open file: %s\n", filename);
+        return;
+    }
+    fprintf(fptr, "# Photoionization cross sections (Mb), plane wave,");
+    fprintf(fptr, " length gauge, orientation averaged\n");
+    fprintf(fptr, "# Ionization energy (eV): %lf\n", ionpot);
+    fprintf(fptr, "# E (eV)      k (au)    ");
+    for (i = 0; i < ndyst0; i++) {
+        for (j = 0; j < ndyst1; j++) {
+            fprintf(fptr, "      (%3d,%3d)", dyst0[i], dyst1[j]);
+        }
+    }
+    fprintf(fptr, "\n");
+    for (i = 0; i < nener; i++) {
+        fprintf(fptr, " %10.5lf %10.5lf", (ener[i] * AU2EV),
+                compute_k(ener[i]));
+        for (j = 0; j < ndyo; j++) {
+            fprintf(fptr, " %15.8E", (sigma[(i * ndyo + j)] * AU2MB));
+        }
+        fprintf(fptr, "\n");
+    }
+    fclose(fptr);
+    return;
+}
+
+/*
+ * read_dyson_ao_orbitals: read the dyson orbitals and transform them to
+ * the atomic orbital basis.
+ */
+int read_dyson_ao_orbitals(char *filename, int nfrzc, int nao, int *ndyo,
+                           double **orbao, int **dyst0, int *ndyst0,
+                           int **dyst1, int *ndyst1)
+{
+    int error = 0;
+    double **dyson = NULL;   /* Dyson orbitals, MO basis */
+    double *dyson1d = NULL;
+    double *mocoef = NULL;   /* MO coefficients, [norbs][nao] */
+    int norbs = 0;
+    int d, o, a;
+
+    error = read_dysonorbital_number(filename, ndyo, ndyst0, ndyst1);
+    if (error != 0) return 1;
+    *dyst0 = malloc(sizeof(int) * (*ndyst0));
+    *dyst1 = malloc(sizeof(int) * (*ndyst1));
+    read_dysonorbital_info(filename, ndyo, ndyst0, ndyst1, &norbs, *dyst0,
+                           *dyst1);
+    if (nao != norbs) {
+        error_message(mpi_proc_rank, "Number of AOs != number of MOs",
+                      "read_dyson_ao_orbitals");
+        free(*dyst0);
+        free(*dyst1);
+        *dyst0 = NULL;
+        *dyst1 = NULL;
+        return 1;
+    }
+    print_dysonorbital_info(*ndyo, *ndyst0, *ndyst1, norbs, *dyst0, *dyst1);
+    dyson1d = allocate_mem_double_cont(&dyson, norbs, *ndyo);
+    error = read_dysonorbitals_from_file(filename, *ndyo, norbs, dyson);
+    if (error != 0) {
+        deallocate_mem_cont(&dyson, dyson1d);
+        free(*dyst0);
+        free(*dyst1);
+        *dyst0 = NULL;
+        *dyst1 = NULL;
+        return 1;
+    }
+
+    mocoef = malloc(sizeof(double) * nao * nao);
+    readmocoeffs(mocoef, (nao * nao));
+
+    /* orbao = C^T dyson */
+    *orbao = calloc((*ndyo) * nao, sizeof(double));
+    for (d = 0; d < *ndyo; d++) {
+        for (o = 0; o < (norbs - nfrzc); o++) {
+            for (a = 0; a < nao; a++) {
+                (*orbao)[(d * nao + a)] += dyson[d][o] *
+                    mocoef[((nfrzc + o) * nao + a)];
+            }
+        }
+    }
+
+    free(mocoef);
+    deallocate_mem_cont(&dyson, dyson1d);
     return error;
 }
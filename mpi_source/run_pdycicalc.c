@@ -12,7 +12,10 @@
 #include "binarystr.h"
 #include "iminmax.h"
 #include "citruncate.h"
+#include "detaddress.h"
 #include "dysoncomp.h"
+#include "buildao.h"
+#include "aogrid.h"
 #include "run_pdycicalc.h"
 
 #include <ga.h>
@@ -25,15 +28,10 @@
  */
 int run_pdycicalc ()
 {
-#define MAXSTATES_CI 5
         int error = 0; /* Error flag */
 
-        int w0_hndl = 0;               /* GA wavefunction 0 */
-        int w0_dims[2] = {0, 0};       /* GA wavefunction 0 dimension */
-        int w0_chunk[2]= {0, 0};       /* GA wavefunction 0 chunk sizes */
-        int w1_hndl = 0;               /* GA wavefunction 1 */
-        int w1_dims[2] = {0, 0};       /* GA wavefunction 1 dimension */
-        int w1_chunk[2]= {0, 0};       /* GA wavefunction 1 chunk sizes */
+        struct detaddress *w0det = NULL; /* Wavefunction 0 determinants */
+        struct detaddress *w1det = NULL; /* Wavefunction 1 determinants */
 
         /*
          * Wavefunction information.
@@ -107,11 +105,16 @@ int run_pdycicalc ()
         int v1_chunk[2]= {0, 0};  /* GA 1 (Neutral) CI vector chunk sizes */
         
         int ndyorbs = 0;              /* Number of dyson orbitals to compute */
-        int dysnst0[MAXSTATES_CI];    /* Anion states of dyson orbital */
-        int dysnst1[MAXSTATES_CI];    /* Neutral states of dyson orbital */
-        int maxstates = 0;            /* Max Anion/Neutral states */
+        int dysin0[MAX_DYSON_STATES]; /* Anion states from input */
+        int dysin1[MAX_DYSON_STATES]; /* Neutral states from input */
+        int *dysnst0 = NULL;          /* Anion states of dyson orbital */
+        int *dysnst1 = NULL;          /* Neutral states of dyson orbital */
+        int maxstates = 0;            /* Max Anion/Neutral input states */
         int ndyst0 = 0;               /* Number of anion staets in dyson orb. */
         int ndyst1 = 0;               /* Number of neutral states in dyson orb.*/
+        int cubes = 0;                /* Write dyson orbital cube files */
+        int cubepts = 0;              /* Cube points along longest side */
+        struct ao_gridbasis gb;       /* Atomic orbital basis for cubes */
         double **dyorb_lc = NULL;     /* LOCAL dyson orbitals */
         double *dyorb_lc_data = NULL; /* LOCAL dyson orbital memory block */
         double **dyorb_gl = NULL;     /* GLOBAL dyson orbitals */
@@ -178,34 +181,46 @@ int run_pdycicalc ()
                             "Error in wavefunction input");
 
         /* Read dysonorbital input */
-        maxstates = MAXSTATES_CI;
+        maxstates = MAX_DYSON_STATES;
         if (mpi_proc_rank == mpi_root) {
-                readdysoninput(dysnst0, dysnst1, maxstates, &ndyst0, &ndyst1,
-                               &error);
+                readdysoninput(dysin0, dysin1, maxstates, &ndyst0, &ndyst1,
+                               &cubes, &cubepts, &error);
+        }
+        mpi_error_check_msg(error, "run_dycicalc", "Error reading dyson input.");
+        MPI_Bcast(dysin0,    maxstates, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&ndyst0,           1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(dysin1,    maxstates, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&ndyst1,           1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+        MPI_Bcast(&cubes,            1, MPI_INT, mpi_root, MPI_COMM_WORLD);
+
+        /* Build the atomic orbital basis for the cube files now, so that
+         * missing or bad basis files stop the run before the calculation. */
+        if (cubes == 1) {
+                error = ao_buildao_gridbasis(&gb);
+                if (error == 0 && gb.nao != norbs0) error = 1;
+                mpi_error_check_msg(error, "run_pdycicalc",
+                                    "Could not build AO basis (nao = norbs?)");
+        }
 
+        /* Expand state lists; there is no limit on the number of states. */
+        dysnst0 = set_dyson_states(dysin0, ndyst0, nstates0, &ndyst0);
+        dysnst1 = set_dyson_states(dysin1, ndyst1, nstates1, &ndyst1);
+        if (dysnst0 == NULL || dysnst1 == NULL) error = 1;
+        mpi_error_check_msg(error, "run_pdycicalc",
+                            "Dyson orbital states must be in 1..nstates.");
+        if (mpi_proc_rank == mpi_root) {
                 printf("\nComputing dyson orbitals between:\n");
                 printf(" Anion states (%d):   ", ndyst0);
                 for (i = 0; i < ndyst0; i++) {
-                        printf(" %d", dysnst0[i]);
-                        /* Decrement value for C array indexing. */
-                        dysnst0[i] = dysnst0[i] - 1;
+                        printf(" %d", (dysnst0[i] + 1));
                 }
                 printf("\n");
                 printf(" Neutral states (%d): ", ndyst1);
                 for (i = 0; i < ndyst1; i++) {
-                        /* Decrement value for C array indexing. */
-                        printf(" %d", dysnst1[i]);
-                        dysnst1[i] = dysnst1[i] - 1;
+                        printf(" %d", (dysnst1[i] + 1));
                 }
                 printf("\n\n");
-        
         }
-        
-        mpi_error_check_msg(error, "run_dycicalc", "Error reading dyson input.");
-        MPI_Bcast(&dysnst0,  maxstates, MPI_INT, mpi_root, MPI_COMM_WORLD);
-        MPI_Bcast(&ndyst0,           1, MPI_INT, mpi_root, MPI_COMM_WORLD);
-        MPI_Bcast(&dysnst1,  maxstates, MPI_INT, mpi_root, MPI_COMM_WORLD);
-        MPI_Bcast(&ndyst1,           1, MPI_INT, mpi_root, MPI_COMM_WORLD);
 
         /* Set up wavefunctions */
         /* W0 (Anion) */
@@ -272,23 +287,11 @@ int run_pdycicalc ()
                 / 1048576;
 	}
 
-        /* Allocate GLOBAL arrays: W0, W1, V0, V1 */
-        /* WX arrays are 3 x ndet arrays with (p, q, cas) where p is the
-         * alpha string index, q is the beta string index, and cas is the
-         * CAS flag. */
+        /* Allocate GLOBAL arrays: V0, V1 */
+        /* Determinants are addressed implicitly as (p, q, cas) triples,
+         * where p is the alpha string index, q is the beta string index,
+         * and cas is the CAS flag, so no W arrays are stored. */
         if (mpi_proc_rank == mpi_root) printf("\nCreating global arrays...\n");
-        w0_dims[0] = dtrm0_len;
-        w0_dims[1] = 3;
-        w0_chunk[0] = -1; // Distribute evenly
-        w0_chunk[1] = 3;
-        w0_hndl = NGA_Create(C_INT, 2, w0_dims, "W0: (p, q, cas)", w0_chunk);
-        if (!w0_hndl) GA_Error("Create failed: W0: (p, q, cas)", 2);
-        w1_dims[0] = dtrm1_len;
-        w1_dims[1] = 3;
-        w1_chunk[0] = -1;
-        w1_chunk[1] = 3;
-        w1_hndl = NGA_Create(C_INT, 2, w1_dims, "W1: (p, q, cas)", w1_chunk);
-        if (!w1_hndl) GA_Error("Create failed: W1: (p, q, cas)", 2);
         /* Vx arrays are nstate x ndet arrays. They are the CI vectors */
         v0_dims[0] = nstates0;
         v0_dims[1] = dtrm0_len;
@@ -317,11 +320,14 @@ int run_pdycicalc ()
         read_gavectorsfile_dbl_ufmt(v0_hndl, dtrm0_len, nstates0, "anion.ci");
         read_gavectorsfile_dbl_ufmt(v1_hndl, dtrm1_len, nstates1, "neutral.ci");
 
-        /* Generate W arrays for each wavefunction. */
-        generate_wlist(w0_hndl, dtrm0_len, pq_space_pairs0, num_pq0, peospace0,
-                       pegrps0, qeospace0, qegrps0);
-        generate_wlist(w1_hndl, dtrm1_len, pq_space_pairs1, num_pq1, peospace1,
-                       pegrps1, qeospace1, qegrps1);
+        /* Build determinant addressers for each wavefunction. */
+        w0det = create_detaddress(pq_space_pairs0, num_pq0, peospace0, pegrps0,
+                                  qeospace0, qegrps0);
+        w1det = create_detaddress(pq_space_pairs1, num_pq1, peospace1, pegrps1,
+                                  qeospace1, qegrps1);
+        if (w0det == NULL || w1det == NULL) error = 1;
+        mpi_error_check_msg(error, "run_pdycicalc",
+                            "Could not build determinant addressing.");
 
 	/* Generate list of N-electron strings that pair with N+1-electron
 	 * strings */
@@ -377,7 +383,7 @@ int run_pdycicalc ()
 			fflush(stdout);
 		}
                 /* S/T (N+1) wavefunction, compare beta  strings. */
-		compute_dyson_orbital_b(v0_hndl, v1_hndl, w0_hndl, w1_hndl,
+		compute_dyson_orbital_b(v0_hndl, v1_hndl, w0det, w1det,
                                         pstrings0, peospace0, pegrps0,
                                         qstrings0, qeospace0, qegrps0,
                                         pstrings1, peospace1, pegrps1,
@@ -395,7 +401,7 @@ int run_pdycicalc ()
 			fflush(stdout);
 		}
                 /* D   (N+1) wavefunction, compare alpha strings. */
-		compute_dyson_orbital_a(v0_hndl, v1_hndl, w0_hndl, w1_hndl,
+		compute_dyson_orbital_a(v0_hndl, v1_hndl, w0det, w1det,
                                         pstrings0, peospace0, pegrps0,
                                         qstrings0, qeospace0, qegrps0,
                                         pstrings1, peospace1, pegrps1,
@@ -427,10 +433,23 @@ int run_pdycicalc ()
                 print_dysonorbitals_to_file("dysonorb.dat", ndyorbs, norbs0,
                                             dyorb_gl, dysnst0, ndyst0, dysnst1,
                                             ndyst1);
+                if (cubes == 1) {
+                        error = write_dysonorbital_cubes(&gb, ndyorbs, norbs0,
+                                                         nfrzc0, dyorb_gl,
+                                                         dysnst0, ndyst0,
+                                                         dysnst1, ndyst1,
+                                                         cubepts);
+                }
         }
+        mpi_error_check_msg(error, "run_pdycicalc",
+                            "Error writing dyson orbital cube files.");
+        if (cubes == 1) aogrid_free(&gb);
 
         GA_Sync();
         
+        free_detaddress(w0det);
+        free_detaddress(w1det);
+
         /* Deallocate pstrings and qstrings */
         free(pstrings0);
         free(pstrings1);
@@ -448,9 +467,48 @@ int run_pdycicalc ()
         deallocate_mem_cont_int(&pq_space_pairs1, pqsp1data);
         /* Deallocate strcont lists */
         deallocate_mem_cont_int(&strcont, strcont1d);
+        free(dysnst0);
+        free(dysnst1);
         return error;
 }
 
+/*
+ * set_dyson_states: build the (0-indexed) list of states entering the
+ * dyson orbitals from the (1-indexed) input list. A first input state
+ * of -1 selects all nstates states.
+ * Input:
+ *  instates = input states
+ *  nin      = number of input states
+ *  nstates  = number of states of wavefunction
+ * Output:
+ *  nst      = number of states
+ * Returns:
+ *  states   = state list, NULL if a state is not in 1..nstates
+ */
+int *set_dyson_states(int *instates, int nin, int nstates, int *nst)
+{
+        int *states = NULL;
+        int i;
+
+        if (nin > 0 && instates[0] == -1) nin = nstates;
+        if (nin <= 0) return NULL;
+        states = malloc(sizeof(int) * nin);
+        if (states == NULL) return NULL;
+        for (i = 0; i < nin; i++) {
+                if (instates[0] == -1) {
+                        states[i] = i;
+                        continue;
+                }
+                if (instates[i] < 1 || instates[i] > nstates) {
+                        free(states);
+                        return NULL;
+                }
+                states[i] = instates[i] - 1;
+        }
+        *nst = nin;
+        return states;
+}
+
 /*
  * check_wavefunction_input: check user input of global wavefunction variables.
  * This is executed on all processes.
@@ -609,64 +667,82 @@ void generate_det_triples (int ndeti, int **d_triplet, int pq_start,
 }
 
 /*
- * generate_wlist: generate the wavefunction list of triplets
- * Input:
- *  hndl     = handle of global array of W
- *  ndets    = number of determinants
- *  pq       = alpha/beta pairs
- *  npq      = number of alpha/beta pairs
- *  peospace = alpha string electron orbital space
- *  pegrps   = number of alpha string orbital spaces
- *  qeospace = beta  string electron orbital space
- *  qegrps   = number of beta  string orbital spaces
+ * write_dysonorbital_cubes: evaluate the dyson orbitals on a grid around
+ * the molecule and write one cube file per orbital, dyson.<s0>.<s1>.cube.
+ * Requires mocoef.
  */
-void generate_wlist(int hndl, int ndets, int **pq, int npq,
-                    struct eospace *peosp, int pegrps,
-                    struct eospace *qeosp, int qegrps)
+int write_dysonorbital_cubes(struct ao_gridbasis *gb, int ndyorbs, int orbs,
+                             int nfrzc, double **dyorbs, int *dysnst0,
+                             int ndyst0, int *dysnst1, int ndyst1,
+                             int cubepts)
 {
-        int lo[2] = {0, 0};
-        int hi[2] = {0, 0};
-        int ld[1] = {0};       /* Leading dimension of w buffer */
-        int rows = 0, cols = 0;/* Dimensions of local w array */
-        int **w = NULL;        /* Local w array */
-        int *wdata = NULL;     /* Local w array data (1-d) */
-
-        int pq_start = 0, pq_final = 0;
-        int pstart = 0, pfinal = 0;
-        int qstart = 0, qfinal = 0;
-        
-        /* Find distribution of W that is allocate on this process.
-         * Allocate local W array */
-        NGA_Distribution(hndl, mpi_proc_rank, lo, hi);
-        cols = hi[0] - lo[0] + 1;
-        rows = hi[1] - lo[1] + 1;
-        if (rows != 3) {
-                error_message(mpi_proc_rank, "rows != 3","generate_wlist");
-                error_flag(mpi_proc_rank, rows, "generate_wlist");
-                return;
+        int error = 0;
+        double *mocoef = NULL;  /* MO coefficients, [orbs][nao] */
+        double *orbao  = NULL;  /* Dyson orbitals in AO basis, [ngrp][nao] */
+        double *vals   = NULL;  /* Grid values, [ngrp][ntot] */
+        double origin[3], step[3];
+        int npts[3], ntot = 0;
+        int nao = orbs;
+        int ngrp = DYSON_CUBE_GROUP;
+        char filename[MAX_LINE_SIZE];
+        char comment[MAX_LINE_SIZE];
+        int d, g, o, a, n;
+
+        printf("\nWriting dyson orbital cube files...\n");
+        mocoef = malloc(sizeof(double) * nao * nao);
+        readmocoeffs(mocoef, (nao * nao));
+
+        aogrid_box(gb, DYSON_CUBE_PAD, cubepts, origin, npts, step);
+        ntot = npts[0] * npts[1] * npts[2];
+        printf(" Grid: %d x %d x %d, spacing %lf\n", npts[0], npts[1],
+               npts[2], step[0]);
+        if (ngrp > ndyorbs) ngrp = ndyorbs;
+        orbao = malloc(sizeof(double) * ngrp * nao);
+        vals  = malloc(sizeof(double) * ngrp * ntot);
+        if (mocoef == NULL || orbao == NULL || vals == NULL) {
+                error_message(mpi_proc_rank, "Could not allocate grid",
+                              "write_dysonorbital_cubes");
+                error = 1;
         }
-        wdata = allocate_mem_int_cont(&w, rows, cols);
-        
-        /* Get starting deteriminant index values, and generate the determinant
-         * triplet list for this section. */
-        determinant_string_info(lo[0], peosp, pegrps, qeosp, qegrps, pq, npq,
-                                &pq_start, &pstart, &qstart);
-        determinant_string_info(hi[0], peosp, pegrps, qeosp, qegrps, pq, npq,
-                                &pq_final, &pfinal, &qfinal);
-        generate_det_triples(cols, w, pq_start, pstart, qstart, pq_final,
-                             pfinal, qfinal, pq, npq, peosp, pegrps,
-                             qeosp, qegrps);
-
-        /* Send this info to the global array W. */
-        ld[0] = rows;
-        NGA_Put(hndl, lo, hi, wdata, ld);
-
-        deallocate_mem_cont_int(&w, wdata);
 
-        GA_Sync();
-                
-        return;
-}    
+        for (d = 0; d < ndyorbs && error == 0; d += ngrp) {
+                n = (ndyorbs - d < ngrp ? ndyorbs - d : ngrp);
+                /* Transform to the AO basis: orbao = C^T dyorb */
+                for (g = 0; g < n; g++) {
+                        for (a = 0; a < nao; a++) {
+                                orbao[(g * nao + a)] = 0.0;
+                        }
+                        for (o = 0; o < (orbs - nfrzc); o++) {
+                                for (a = 0; a < nao; a++) {
+                                        orbao[(g * nao + a)] +=
+                                                dyorbs[(d + g)][o] *
+                                                mocoef[((nfrzc + o) * nao + a)];
+                                }
+                        }
+                }
+                aogrid_evaluate_orbitals(gb, orbao, n, origin, npts, step,
+                                         vals);
+                for (g = 0; g < n; g++) {
+                        sprintf(filename, "dyson.%d.%d.cube",
+                                (dysnst0[((d + g) / ndyst1)] + 1),
+                                (dysnst1[((d + g) % ndyst1)] + 1));
+                        sprintf(comment, "Dyson orbital %d", (d + g + 1));
+                        error = aogrid_write_cube(filename, comment, gb,
+                                                  origin, npts, step,
+                                                  &(vals[(g * ntot)]));
+                        if (error != 0) {
+                                printf("Could not open file: %s\n", filename);
+                                break;
+                        }
+                        printf(" %s\n", filename);
+                }
+        }
+
+        free(mocoef);
+        free(orbao);
+        free(vals);
+        return error;
+}
 
 /*
  * print_dysonorbitals_to_file: print the compute dyson orbitals to file.
@@ -0,0 +1,277 @@
+// File: sigmabench.c
+/*
+ * Synthetic-integral benchmark of the Hv=c (sigma) kernel.
+ *
+ * Builds a CI expansion from the command line, fills it with reproducible
+ * random integrals and times Hv=c on one and on several vectors through
+ * perform_hvispacefast(), as in pdavidson(). No moints file or namelist
+ * input is read. numarank and nthread place processes and threads as the
+ * &dalginfo keywords of the same name do, for strong-scaling runs over
+ * processes x threads on a node. sigaccum selects the C(j,k)
+ * accumulation over threads, as the &dalginfo keyword does.
+ *
+ * Usage: sigmabench electrons ndocc nactv orbitals xlvl
+ *                   [nvec nrep buflen numarank nthread sigaccum]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi_utilities.h"
+#include "moslab.h"
+#include "binarystr.h"
+#include "citruncate.h"
+#include "detaddress.h"
+#include "pdavidson.h"
+#include "perftimer.h"
+#include "topology.h"
+#include "sigmabench.h"
+#include <mpi.h>
+#include <ga.h>
+#include <macdecls.h>
+
+/* -- OpenMP options -- */
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#endif
+/* -------------------- */
+
+const int mpi_root = 0; /* MPI: Root rank is always 0 */
+
+/*
+ * Main driver.
+ */
+int main (int argc, char **argv)
+{
+    int error = 0;
+    long long int stack = 80000000, heap = 80000000;
+    struct sigmabench sb;
+    int electrons = 0, ndocc = 0, nactv = 0, orbitals = 0, xlvl = 0;
+    int nvec = 8;      /* Vectors of the multi-vector product (krymax) */
+    int nrep = 3;      /* Timed repetitions of each product */
+    int buflen = 1000; /* GA buffer length */
+    int numarank = 0;  /* Processes per NUMA domain, 0 = no binding */
+    int nthread = 0;   /* Threads per process, 0 = default */
+    int sigaccum = SIGACC_BINS; /* C(j,k) accumulation */
+    struct topology tplace;
+
+    MPI_Init(&argc, &argv);
+    GA_Initialize();
+    if (! MA_init(C_DBL, stack, heap)) GA_Error("MA_init failed",stack+heap);
+    set_ga_process_number_and_rank();
+    set_mpi_node_comm();
+
+    if (argc < 6) {
+        if (mpi_proc_rank == mpi_root) {
+            printf("Usage: %s electrons ndocc nactv orbitals xlvl", argv[0]);
+            printf(" [nvec nrep buflen numarank nthread sigaccum]\n");
+        }
+        GA_Terminate();
+        MPI_Finalize();
+        return 1;
+    }
+    electrons = atoi(argv[1]);
+    ndocc     = atoi(argv[2]);
+    nactv     = atoi(argv[3]);
+    orbitals  = atoi(argv[4]);
+    xlvl      = atoi(argv[5]);
+    if (argc > 6) nvec   = atoi(argv[6]);
+    if (argc > 7) nrep   = atoi(argv[7]);
+    if (argc > 8) buflen = atoi(argv[8]);
+    if (argc > 9) numarank = atoi(argv[9]);
+    if (argc > 10) nthread = atoi(argv[10]);
+    if (argc > 11) sigaccum = atoi(argv[11]);
+    topology_place(numarank, nthread, &tplace);
+
+    if (mpi_proc_rank == mpi_root) {
+        printf("Sigma benchmark: %d electrons, %d orbitals,", electrons,
+               orbitals);
+        printf(" CAS(%d docc, %d actv), xlvl = %d\n", ndocc, nactv, xlvl);
+        printf(" %d processes x %d threads, buflen = %d, sigaccum = %d\n",
+               mpi_num_procs, omp_get_max_threads(), buflen, sigaccum);
+        fflush(stdout);
+    }
+    topology_print(&tplace, numarank);
+    error = sigmabench_setup(&sb, electrons, ndocc, nactv, orbitals, xlvl,
+                             nvec, buflen, sigaccum);
+    mpi_error_check_msg(error, "sigmabench", "Could not set up benchmark.");
+
+    /* Untimed warm-up pass, then one and nvec vectors. */
+    perform_hvispacefast(sb.ci.pstr, sb.ci.peosp, sb.ci.pegrps, sb.ci.qstr,
+                         sb.ci.qeosp, sb.ci.qegrps, sb.ci.pq, sb.ci.npq,
+                         sb.ci.m1, sb.ci.m2, &(sb.ci.mslab), sb.ci.ci_aelec,
+                         sb.ci.ci_belec, sb.ci.intorb, sb.ci.ndets, 0.0, 1,
+                         sb.mdim, sb.v_hndl, sb.d_hndl, sb.c_hndl, sb.ci.wdet,
+                         sb.buflen, sb.ci.ci_orbs, sb.ci.ndocc, sb.ci.nactv,
+                         sb.scr, 0.0, 0);
+    sigmabench_run(&sb, 1, nrep);
+    if (nvec > 1) sigmabench_run(&sb, nvec, nrep);
+
+    sigmabench_free(&sb);
+    GA_Terminate();
+    MPI_Finalize();
+    return 0;
+}
+
+/*
+ * sigmabench_setup: build the CI expansion, synthetic integrals and the
+ * global arrays V, C and D.
+ */
+int sigmabench_setup(struct sigmabench *sb, int electrons, int ndocc,
+                     int nactv, int orbitals, int xlvl, int nvec, int buflen,
+                     int sigaccum)
+{
+    int error = 0;
+    struct benchci *ci = &(sb->ci);
+    int v_dims[2], v_chunk[2], d_dims[1], d_chunk[1];
+    int lo[2], hi[2], ld[1];
+    double *buf = NULL;
+    int nrows = 0, ncols = 0;
+    int i, k;
+
+    if (nvec < 1 || buflen < 1) return 1;
+    error = benchci_setup(ci, electrons, ndocc, nactv, orbitals, xlvl);
+    if (error != 0) return error;
+    sb->mdim   = nvec;
+    sb->buflen = buflen;
+    sb->nthrd = omp_get_max_threads();
+    sb->scr = allocate_sigma_scratch(sb->nthrd, ci->peosp, ci->pegrps,
+                                     ci->qeosp, ci->qegrps, ci->pq, ci->npq,
+                                     sb->mdim, ci->ci_aelec, ci->ci_belec,
+                                     ci->ci_orbs, sigaccum);
+    if (sb->scr == NULL) return 1;
+
+    /* Global arrays are laid out as in pdavidson. */
+    v_dims[0]  = sb->mdim;
+    v_dims[1]  = ci->ndets;
+    v_chunk[0] = sb->mdim;
+    v_chunk[1] = -1;
+    sb->v_hndl = NGA_Create(C_DBL, 2, v_dims, "Basis vectors", v_chunk);
+    if (!sb->v_hndl) GA_Error("Create failed: Basis vectors", 2);
+    sb->c_hndl = NGA_Duplicate(sb->v_hndl, "Hv=c vectors");
+    if (!sb->c_hndl) GA_Error("Duplicate failed: Hv=c vectors", 2);
+    d_dims[0]  = ci->ndets;
+    d_chunk[0] = -1;
+    sb->d_hndl = NGA_Create(C_DBL, 1, d_dims, "Diagonal vector", d_chunk);
+    if (!sb->d_hndl) GA_Error("Create failed: Diagonal vector", 1);
+
+    /* Random vectors, V(k,i) depends only on k and i */
+    NGA_Distribution(sb->v_hndl, mpi_proc_rank, lo, hi);
+    nrows = hi[0] - lo[0] + 1;
+    ncols = hi[1] - lo[1] + 1;
+    if (nrows > 0 && ncols > 0) {
+        buf = malloc(sizeof(double) * nrows * ncols);
+        for (k = 0; k < nrows; k++) {
+            for (i = 0; i < ncols; i++) {
+                buf[(k * ncols + i)] = benchci_random(
+                    (BENCHCI_SEED + 2),
+                    ((long long int) (lo[0] + k) * ci->ndets + lo[1] + i));
+            }
+        }
+        ld[0] = ncols;
+        NGA_Put(sb->v_hndl, lo, hi, buf, ld);
+        free(buf);
+    }
+
+    /* Diagonal <i|H|i> */
+    NGA_Zero(sb->d_hndl);
+    NGA_Distribution(sb->d_hndl, mpi_proc_rank, lo, hi);
+    if (hi[0] >= lo[0]) {
+        buf = malloc(sizeof(double) * (hi[0] - lo[0] + 1));
+        compute_diagonal_iHi(buf, lo[0], hi[0], ci->m1, ci->m2, &(ci->mslab),
+                             ci->ci_aelec, ci->ci_belec, ci->intorb, ci->wdet,
+                             ci->pstr, ci->qstr);
+        ld[0] = 1;
+        NGA_Put(sb->d_hndl, lo, hi, buf, ld);
+        free(buf);
+    }
+    GA_Sync();
+    return error;
+}
+
+/*
+ * sigmabench_run: time nrep Hv=c products on dim vectors and print
+ * throughput.
+ */
+void sigmabench_run(struct sigmabench *sb, int dim, int nrep)
+{
+    static const char *cname[5] = {
+        "alpha single", "alpha double", "beta  single", "beta  double",
+        "alpha-beta"
+    };
+    static const int cindx[5] = {
+        PC_HIJ_A1X, PC_HIJ_A2X, PC_HIJ_B1X, PC_HIJ_B2X, PC_HIJ_AB
+    };
+    struct benchci *ci = &(sb->ci);
+    double t[4], tmax[4], tsum[4];
+    long long int nhij[5], nhij_gl[5], ntot = 0;
+    double thv = 0.0, nelem = 0.0;
+    int i;
+
+    GA_Sync();
+    perftimer_init();
+    for (i = 0; i < nrep; i++) {
+        perftimer_start(PT_SIGMA);
+        perftimer_count(PC_SIGMA_CALLS, 1);
+        perform_hvispacefast(ci->pstr, ci->peosp, ci->pegrps, ci->qstr,
+                             ci->qeosp, ci->qegrps, ci->pq, ci->npq, ci->m1,
+                             ci->m2, &(ci->mslab), ci->ci_aelec, ci->ci_belec,
+                             ci->intorb, ci->ndets, 0.0, dim, sb->mdim,
+                             sb->v_hndl, sb->d_hndl, sb->c_hndl, ci->wdet,
+                             sb->buflen, ci->ci_orbs, ci->ndocc, ci->nactv,
+                             sb->scr, 0.0, 0);
+        perftimer_stop(PT_SIGMA);
+    }
+
+    t[0] = perftimer_time(PT_SIGMA);
+    t[1] = perftimer_time(PT_SIGMA_XGEN);
+    t[2] = perftimer_time(PT_SIGMA_HIJ);
+    t[3] = perftimer_time(PT_SIGMA_GA);
+    for (i = 0; i < 5; i++) {
+        nhij[i] = perftimer_counter(cindx[i]);
+    }
+    MPI_Reduce(t, tmax, 4, MPI_DOUBLE, MPI_MAX, mpi_root, MPI_COMM_WORLD);
+    MPI_Reduce(t, tsum, 4, MPI_DOUBLE, MPI_SUM, mpi_root, MPI_COMM_WORLD);
+    MPI_Reduce(nhij, nhij_gl, 5, MPI_LONG_LONG_INT, MPI_SUM, mpi_root,
+               MPI_COMM_WORLD);
+    if (mpi_proc_rank != mpi_root) return;
+
+    /* Hv=c is complete when the slowest process is done. */
+    thv = tmax[0] / nrep;
+    for (i = 0; i < 5; i++) {
+        ntot = ntot + nhij_gl[i];
+    }
+    nelem = (double) ntot / nrep;
+    printf("\n Hv=c on %d vector(s), %d repetition(s)\n", dim, nrep);
+    printf("  Time per Hv=c (s)          %15.6lf\n", thv);
+    printf("  Determinants/s             %15.6E\n",
+           ((double) ci->ndets * dim / thv));
+    printf("  Matrix elements per Hv=c   %15.6E\n", nelem);
+    printf("  Matrix elements/s          %15.6E\n", (nelem / thv));
+    printf("  Element-vector products/s  %15.6E\n", (nelem * dim / thv));
+    printf("  %-14s %15s %9s\n", "Class", "Elements", "Fraction");
+    for (i = 0; i < 5; i++) {
+        printf("  %-14s %15.6E %9.4lf\n", cname[i],
+               ((double) nhij_gl[i] / nrep),
+               (ntot > 0 ? (double) nhij_gl[i] / ntot : 0.0));
+    }
+    printf("  Time split per Hv=c (s, process average):\n");
+    printf("   excitations %12.6lf  <i|H|j> %12.6lf  GA %12.6lf\n",
+           (tsum[1] / mpi_num_procs / nrep), (tsum[2] / mpi_num_procs / nrep),
+           (tsum[3] / mpi_num_procs / nrep));
+    fflush(stdout);
+    return;
+}
+
+/*
+ * sigmabench_free: deallocate benchmark data.
+ */
+void sigmabench_free(struct sigmabench *sb)
+{
+    GA_Destroy(sb->v_hndl);
+    GA_Destroy(sb->c_hndl);
+    GA_Destroy(sb->d_hndl);
+    deallocate_sigma_scratch(sb->scr, sb->nthrd);
+    benchci_free(&(sb->ci));
+    return;
+}
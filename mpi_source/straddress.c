@@ -4,6 +4,13 @@
  * ----------
  * Contains string addressing utilities
  *
+ * Strings are addressed in reverse lexical order. The number of
+ * strings with electron i in orbital j, given that electrons 1..i-1
+ * are in lower orbitals, is C(orbs - j, elec - i); summing these over
+ * a run of skipped orbitals collapses to two binomial coefficients, so
+ * a string address is found with O(elec) lookups. struct strgraph
+ * tabulates the resulting arc weights for repeated use.
+ *
  * Christopher L Malbon
  * Dept. of Chemistry, The Johns Hopkins University
  *******************************************************************/
@@ -16,30 +23,39 @@
 
 /* str_adr2str: Computes orbital index string from address
  * -------------------------------------------------------------------
- * [citation]
+ * The string is built one electron at a time, skipping past each
+ * orbital whose subgraph holds fewer strings than the remaining
+ * offset.
  * 
  * Input:
  *  index = index of string
  *  elec  = number of electrons
  *  orbs  = number of orbitals 
- *  scr   = scratch array
  * Output:
  *  str = orbital index string */
-void str_adr2str(int index, int *scr, int elec, int orbs, int *str)
+void str_adr2str(int index, int elec, int orbs, int *str)
 {
-    int i;
+    int i, j, n;
+    int off;
     if (index == 0) return;
-    for (i = 0; i < elec; i++) {
-	scr[i] = i + 1;
+    off = index - 1;
+    j = 0;
+    for (i = 1; i <= elec; i++) {
+	j++;
+	while ((n = binomial_coef2((orbs - j), (elec - i))) <= off) {
+	    off = off - n;
+	    j++;
+	}
+	str[i - 1] = j;
     }
-    str_strfind2(scr, 1, elec, orbs, index, str);
     return;
 
 }    
-
 /* str_adrfind: Computes address of orbital index string
  * -------------------------------------------------------------------
- * [citation]
+ * The strings skipped by electron i moving from orbital p+1 to q-1
+ * number sum_{j=p+1}^{q-1} C(orbs-j, elec-i)
+ *           = C(orbs-p, elec-i+1) - C(orbs-q+1, elec-i+1).
  *
  * Input:
  *  str  = orbital index string
@@ -48,18 +64,15 @@ void str_adr2str(int index, int *scr, int elec, int orbs, int *str)
 int str_adrfind(int *str, int elec, int orbs)
 {
      int address;
-     int i, j;
+     int i, k, p;
 
      address = 1;
-     for (i = 2; i <= elec; i++) {
-	  for (j = (str[i - 2] + 1); j <= (str[i - 1] - 1); j++ ) {
-	       address = address +
-		    binomial_coef2((orbs - j),(elec - i));
-	  }
-     }
-     for (i = 1; i <= str[0] - 1; i++) {
-	  address = address +
-	       binomial_coef2((orbs - i),(elec - 1));
+     p = 0;
+     for (i = 1; i <= elec; i++) {
+	  k = elec - i + 1;
+	  address = address + binomial_coef2((orbs - p), k) -
+	       binomial_coef2((orbs - str[i - 1] + 1), k);
+	  p = str[i - 1];
      }
      return address;
 }
@@ -75,22 +88,120 @@ int str_adrfind(int *str, int elec, int orbs)
 int str_adrfind_fast(int *str, int elec, int orbs)
 {
     int address;
-    int i, j;
+    int i, k, p;
     
     address = 1;
-    for (i = 2; i <= elec; i++) {
-        for (j = (str[i - 2] + 1); j <= (str[i - 1] - 1); j++ ) {
-            address = address +
-                binomial_coef3((orbs - j),(elec - i));
-        }
+    p = 0;
+    for (i = 1; i <= elec; i++) {
+        k = elec - i + 1;
+        address = address + binomial_coef3((orbs - p), k) -
+            binomial_coef3((orbs - str[i - 1] + 1), k);
+        p = str[i - 1];
     }
-    for (i = 1; i <= str[0] - 1; i++) {
-        address = address +
-            binomial_coef3((orbs - i),(elec - 1));
+    return address;
+}
+
+/* init_strgraph: build the lexical addressing graph for strings of
+ * elec electrons in orbs orbitals.
+ * -------------------------------------------------------------------
+ * arcw[(i-1)*orbs + (j-1)] is the weight of the arc placing electron
+ * i in orbital j, such that address = 1 + sum_i arcw(i, str[i]).
+ * nsub[(i-1)*orbs + (j-1)] = C(orbs-j, elec-i) is the number of
+ * strings below that vertex and is used to invert addresses.
+ *
+ * Input:
+ *  elec = electrons
+ *  orbs = orbitals
+ * Output:
+ *  g = addressing graph
+ *  error = 0: no error, 1: allocation error */
+int init_strgraph(int elec, int orbs, struct strgraph *g)
+{
+    int i, j, k;
+
+    g->elec = elec;
+    g->orbs = orbs;
+    g->nstr = binomial_coef2(orbs, elec);
+    g->arcw = NULL;
+    g->nsub = NULL;
+    if (elec == 0) return 0;
+    
+    g->arcw = (int *) malloc(elec * orbs * sizeof(int));
+    g->nsub = (int *) malloc(elec * orbs * sizeof(int));
+    if (g->arcw == NULL || g->nsub == NULL) {
+	free(g->arcw);
+	free(g->nsub);
+	g->arcw = g->nsub = NULL;
+	return 1;
+    }
+    for (i = 1; i <= elec; i++) {
+	k = elec - i + 1;
+	for (j = 1; j <= orbs; j++) {
+	    /* sum_{m=i}^{j-1} C(orbs-m-1, elec-i): the strings skipped
+	     * by electron i, net of the next electron's lower bound. */
+	    g->arcw[(i - 1) * orbs + (j - 1)] = (j < i ? 0 :
+		binomial_coef2((orbs - i), k) - binomial_coef2((orbs - j), k));
+	    g->nsub[(i - 1) * orbs + (j - 1)] =
+		binomial_coef2((orbs - j), (k - 1));
+	}
+    }
+    return 0;
+}
+
+/* free_strgraph: free lexical addressing graph arrays. */
+void free_strgraph(struct strgraph *g)
+{
+    free(g->arcw);
+    free(g->nsub);
+    g->arcw = g->nsub = NULL;
+    return;
+}
+
+/* str_adrfind_graph: Computes address of orbital index string from
+ * the arc weights of a lexical addressing graph.
+ *
+ * Input:
+ *  str = orbital index string
+ *  g   = addressing graph */
+int str_adrfind_graph(int *str, struct strgraph *g)
+{
+    int address = 1;
+    int i;
+    const int *w = g->arcw;
+    for (i = 0; i < g->elec; i++) {
+	address += w[(str[i] - 1)];
+	w += g->orbs;
     }
     return address;
 }
 
+/* str_adr2str_graph: Computes orbital index string from address using
+ * a lexical addressing graph.
+ *
+ * Input:
+ *  index = index of string
+ *  g     = addressing graph
+ * Output:
+ *  str = orbital index string */
+void str_adr2str_graph(int index, struct strgraph *g, int *str)
+{
+    int i, j;
+    int off;
+    const int *n = g->nsub;
+    if (index == 0) return;
+    off = index - 1;
+    j = 0;
+    for (i = 0; i < g->elec; i++) {
+	while (n[j] <= off) {
+	    off -= n[j];
+	    j++;
+	}
+	str[i] = j + 1;
+	j++;
+	n += g->orbs;
+    }
+    return;
+}
 
 /* str_strfind1: 
  *   Compute orbital occupation string from preceding string 
@@ -127,7 +238,6 @@ void str_strfind1(int *str1, int elec, int orbs, int *str2)
      return;
 
 }
-
 /* str_strfind2:
  *  Compute orbital occupation string for jth string from ith
  * -------------------------------------------------------------------
@@ -0,0 +1,201 @@
+// File: topology.c
+/*
+ * Process and thread placement on the NUMA domains of a node.
+ *
+ * Domains and their CPUs are read from sysfs; if these are not
+ * available the node is taken as one domain of all online CPUs.
+ * Processes are assigned to domains in order of node rank, numarank per
+ * domain, and each gets an equal slice of the CPUs of its domain. Its
+ * threads are bound round-robin to that slice. Pages are placed by the
+ * kernel on first touch, so arrays a process or thread initializes
+ * after topology_place() are local to it.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include "mpi_utilities.h"
+#include "topology.h"
+#include <mpi.h>
+
+/* -- OpenMP options -- */
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_thread_num() 0
+#define omp_get_max_threads() 1
+#define omp_set_num_threads(n) ((void) (n))
+#endif
+/* -------------------- */
+
+/* Largest NUMA domain index read from sysfs */
+#define TOPOLOGY_MAXDOM 256
+
+/*
+ * read_domain_cpus: read the CPUs of NUMA domain id from sysfs. The list
+ * has the form "0-3,8-11".
+ * Returns number of CPUs, 0 if the domain does not exist or has none.
+ */
+static int read_domain_cpus(int id, int *cpu)
+{
+    char path[128];
+    char line[4096];
+    char *tok = NULL, *save = NULL;
+    FILE *fp = NULL;
+    int lo = 0, hi = 0, n = 0;
+    int i;
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/node/node%d/cpulist", id);
+    fp = fopen(path, "r");
+    if (fp == NULL) return 0;
+    if (fgets(line, sizeof(line), fp) == NULL) line[0] = '\0';
+    fclose(fp);
+
+    for (tok = strtok_r(line, ",\n", &save); tok != NULL;
+         tok = strtok_r(NULL, ",\n", &save)) {
+        if (sscanf(tok, "%d-%d", &lo, &hi) == 2) {
+            /* range */
+        } else if (sscanf(tok, "%d", &lo) == 1) {
+            hi = lo;
+        } else {
+            continue;
+        }
+        for (i = lo; i <= hi && n < TOPOLOGY_MAXCPU; i++) {
+            cpu[n] = i;
+            n++;
+        }
+    }
+    return n;
+}
+
+/*
+ * topology_place: bind this process and its threads to a NUMA domain.
+ */
+void topology_place(int numarank, int nthread, struct topology *tp)
+{
+    int cpu[TOPOLOGY_MAXCPU];
+    int dom[TOPOLOGY_MAXDOM];
+    int ncpu = 0, per = 0, first = 0, slot = 0;
+    int error = 0, errsum = 0;
+    cpu_set_t mask;
+    int i;
+
+    tp->ndom = 1;
+    tp->dom = -1;
+    tp->cpu0 = -1;
+    tp->ncpu = 0;
+    if (numarank <= 0) {
+        if (nthread > 0) omp_set_num_threads(nthread);
+        tp->nthrd = omp_get_max_threads();
+        return;
+    }
+
+    /* Domains with CPUs. */
+    tp->ndom = 0;
+    for (i = 0; i < TOPOLOGY_MAXDOM; i++) {
+        if (read_domain_cpus(i, cpu) > 0) {
+            dom[tp->ndom] = i;
+            tp->ndom++;
+        }
+    }
+    if (tp->ndom > 0) {
+        tp->dom = (mpi_node_rank / numarank) % tp->ndom;
+        ncpu = read_domain_cpus(dom[tp->dom], cpu);
+    } else {
+        tp->ndom = 1;
+        tp->dom = 0;
+        ncpu = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (ncpu > TOPOLOGY_MAXCPU) ncpu = TOPOLOGY_MAXCPU;
+        for (i = 0; i < ncpu; i++) {
+            cpu[i] = i;
+        }
+    }
+    if (ncpu < 1) {
+        tp->dom = -1;
+        tp->nthrd = omp_get_max_threads();
+        return;
+    }
+
+    /* Slice of the domain for this process. */
+    slot = mpi_node_rank % numarank;
+    per = ncpu / numarank;
+    if (per < 1) per = 1;
+    first = (slot * per) % ncpu;
+    if ((first + per) > ncpu) per = ncpu - first;
+    tp->cpu0 = cpu[first];
+    tp->ncpu = per;
+    tp->nthrd = (nthread > 0 ? nthread : per);
+    omp_set_num_threads(tp->nthrd);
+
+    /* Bind the process, then each thread to one CPU of the slice. */
+    CPU_ZERO(&mask);
+    for (i = 0; i < per; i++) {
+        CPU_SET(cpu[first + i], &mask);
+    }
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &mask) != 0) error = 1;
+#pragma omp parallel default(none) shared(cpu, first, per) private(mask) \
+    reduction(+:error)
+    {
+        CPU_ZERO(&mask);
+        CPU_SET(cpu[first + omp_get_thread_num() % per], &mask);
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &mask) != 0) error++;
+    }
+    if (error != 0) tp->dom = -1;
+
+    MPI_Allreduce(&error, &errsum, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (mpi_proc_rank == mpi_root) {
+        if (errsum != 0) {
+            printf(" Warning: CPU binding failed on %d thread(s).\n",
+                   errsum);
+        }
+        if (mpi_node_procs > numarank * tp->ndom) {
+            printf(" Warning: %d processes on a node with %d domain(s)",
+                   mpi_node_procs, tp->ndom);
+            printf(" x numarank = %d; domains are shared.\n", numarank);
+        }
+        fflush(stdout);
+    }
+    return;
+}
+
+/*
+ * topology_print: print the placement of the processes.
+ */
+void topology_print(struct topology *tp, int numarank)
+{
+    int mine[5];
+    int *all = NULL;
+    int i;
+
+    mine[0] = mpi_node_rank;
+    mine[1] = tp->dom;
+    mine[2] = tp->cpu0;
+    mine[3] = tp->ncpu;
+    mine[4] = tp->nthrd;
+    if (mpi_proc_rank == mpi_root) {
+        all = malloc(sizeof(int) * 5 * mpi_num_procs);
+    }
+    MPI_Gather(mine, 5, MPI_INT, all, 5, MPI_INT, mpi_root, MPI_COMM_WORLD);
+    if (mpi_proc_rank != mpi_root) return;
+
+    printf("\nProcess placement (%d node(s), numarank = %d)\n",
+           mpi_num_nodes, numarank);
+    printf(" %8s %8s %8s %9s %8s %8s\n", "Process", "On node", "Domain",
+           "First CPU", "CPUs", "Threads");
+    for (i = 0; i < mpi_num_procs; i++) {
+        if (all[(i * 5 + 1)] < 0) {
+            printf(" %8d %8d %8s %9s %8s %8d\n", i, all[(i * 5)], "-", "-",
+                   "-", all[(i * 5 + 4)]);
+        } else {
+            printf(" %8d %8d %8d %9d %8d %8d\n", i, all[(i * 5)],
+                   all[(i * 5 + 1)], all[(i * 5 + 2)], all[(i * 5 + 3)],
+                   all[(i * 5 + 4)]);
+        }
+    }
+    fflush(stdout);
+    free(all);
+    return;
+}
@@ -2,12 +2,52 @@
 /*
  * Routines to compute transition moments of AO with free
  * electrons.
+ *
+ * The free electron is a plane wave, (2 pi)^(-3/2) exp(i k.r). For a
+ * gaussian primitive on center A the dipole integral separates into
+ * products of one-dimensional integrals int x^n exp(-a x^2 + i k x) dx,
+ * which have a closed form, times the phase exp(i k.A). Many k-vectors
+ * (directions and energies) are evaluated together and contracted with
+ * the dyson orbitals by DGEMM.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <complex.h>
+#include "mathutil.h"
+#include "aogrid.h"
 #include "transmo.h"
 
+/* -- OpenMP options -- */
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+/* -------------------- */
+
+/*
+ * Cartesian monomials of each orbital type (see transmo_type_terms).
+ * {nterms, {coef, lx, ly, lz} x 3}
+ */
+static const double type_terms[17][13] = {
+    {0},
+    {1,  1, 0, 0, 0},                                  /* s */
+    {1,  1, 1, 0, 0},                                  /* x */
+    {1,  1, 0, 1, 0},                                  /* y */
+    {1,  1, 0, 0, 1},                                  /* z */
+    {1,  1, 1, 1, 0},                                  /* xy */
+    {1,  1, 1, 0, 1},                                  /* xz */
+    {3,  2, 0, 0, 2,  -1, 2, 0, 0,  -1, 0, 2, 0},      /* 2zz - xx - yy */
+    {1,  1, 0, 1, 1},                                  /* yz */
+    {2,  1, 2, 0, 0,  -1, 0, 2, 0},                    /* xx - yy */
+    {2,  1, 2, 1, 0,  -1, 0, 3, 0},                    /* xxy - yyy */
+    {1,  1, 1, 1, 1},                                  /* xyz */
+    {3,  4, 0, 1, 2,  -3, 0, 3, 0,  -1, 2, 1, 0},      /* 4yzz - 3yyy - xxy */
+    {3,  1, 2, 0, 1,   1, 0, 2, 1,  -2, 0, 0, 3},      /* xxz + yyz - 2zzz */
+    {3,  4, 1, 0, 2,  -3, 3, 0, 0,  -1, 1, 2, 0},      /* 4xzz - 3xxx - xyy */
+    {2,  1, 2, 0, 1,  -1, 0, 2, 1},                    /* xxz - yyz */
+    {2,  1, 1, 2, 0,  -1, 3, 0, 0}                     /* xyy - xxx */
+};
+
 /*
  * compute_k: compute the wavevector k of a free electron given
  * the kinetic energy. (Atomic units: hbar = 1, m_e = 1)
@@ -19,3 +59,228 @@ double compute_k(double e)
     kval = sqrt(kval);
     return kval;
 }
+
+/*
+ * transmo_gauss_ft_1d: compute the one-dimensional integrals
+ *   I_n = int x^n exp(-a x^2) exp(i k x) dx,  n = 0, ..., nmax
+ */
+void transmo_gauss_ft_1d(double a, double k, int nmax, double complex *ival)
+{
+    double rta = 0.5 / a;
+    int n;
+
+    ival[0] = sqrt(M_PI / a) * exp(-0.5 * k * k * rta);
+    if (nmax == 0) return;
+    ival[1] = (I * k * rta) * ival[0];
+    for (n = 1; n < nmax; n++) {
+        ival[(n + 1)] = (I * k * ival[n] + n * ival[(n - 1)]) * rta;
+    }
+    return;
+}
+
+/*
+ * transmo_type_terms: cartesian monomials of an orbital type.
+ */
+int transmo_type_terms(int type, double *coef, int *lxyz)
+{
+    int nt, t;
+
+    if (type < 1 || type > 16) return 0;
+    nt = (int) type_terms[type][0];
+    for (t = 0; t < nt; t++) {
+        coef[t] = type_terms[type][(1 + 4 * t)];
+        lxyz[(3 * t)]     = (int) type_terms[type][(2 + 4 * t)];
+        lxyz[(3 * t + 1)] = (int) type_terms[type][(3 + 4 * t)];
+        lxyz[(3 * t + 2)] = (int) type_terms[type][(4 + 4 * t)];
+    }
+    return nt;
+}
+
+/*
+ * transmo_ao_dipoles: compute the dipole matrix elements of each atomic
+ * orbital with plane waves.
+ */
+void transmo_ao_dipoles(struct ao_gridbasis *gb, double *kvec, int nk,
+                        double *momr, double *momi)
+{
+    int nao = gb->nao;
+    double pwnorm = pow(2.0 * M_PI, -1.5); /* Plane wave normalization */
+
+#pragma omp parallel default(shared)
+    {
+        double complex *phase = malloc(sizeof(double complex) * gb->ncntr);
+        double complex ix[(TRANSMO_MAXN + 1)];
+        double complex iy[(TRANSMO_MAXN + 1)];
+        double complex iz[(TRANSMO_MAXN + 1)];
+        double complex s0, sx, sy, sz, f; /* Overlap and r_c integrals */
+        double coef[3];
+        int lxyz[9];
+        int nt;
+        double kx, ky, kz, *ax;
+        int j, c, i, p, t, lx, ly, lz;
+
+#pragma omp for schedule(static)
+        for (j = 0; j < nk; j++) {
+            kx = kvec[(3 * j)];
+            ky = kvec[(3 * j + 1)];
+            kz = kvec[(3 * j + 2)];
+            for (c = 0; c < gb->ncntr; c++) {
+                ax = &(gb->xyz[(3 * c)]);
+                phase[c] = pwnorm * cexp(I * (kx * ax[0] + ky * ax[1] +
+                                              kz * ax[2]));
+            }
+            for (i = 0; i < nao; i++) {
+                nt = transmo_type_terms(gb->type[i], coef, lxyz);
+                s0 = 0.0;
+                sx = 0.0;
+                sy = 0.0;
+                sz = 0.0;
+                for (p = gb->pstart[i]; p < gb->pstart[(i + 1)]; p++) {
+                    transmo_gauss_ft_1d(gb->expn[p], kx, TRANSMO_MAXN, ix);
+                    transmo_gauss_ft_1d(gb->expn[p], ky, TRANSMO_MAXN, iy);
+                    transmo_gauss_ft_1d(gb->expn[p], kz, TRANSMO_MAXN, iz);
+                    for (t = 0; t < nt; t++) {
+                        lx = lxyz[(3 * t)];
+                        ly = lxyz[(3 * t + 1)];
+                        lz = lxyz[(3 * t + 2)];
+                        f = gb->coef[p] * coef[t];
+                        s0 += f * ix[lx] * iy[ly] * iz[lz];
+                        sx += f * ix[(lx + 1)] * iy[ly] * iz[lz];
+                        sy += f * ix[lx] * iy[(ly + 1)] * iz[lz];
+                        sz += f * ix[lx] * iy[ly] * iz[(lz + 1)];
+                    }
+                }
+                /* r = (r - A) + A */
+                ax = &(gb->xyz[(3 * gb->cntr[i])]);
+                f = phase[(gb->cntr[i])];
+                sx = f * (sx + ax[0] * s0);
+                sy = f * (sy + ax[1] * s0);
+                sz = f * (sz + ax[2] * s0);
+                momr[((3 * j) * nao + i)]     = creal(sx);
+                momi[((3 * j) * nao + i)]     = cimag(sx);
+                momr[((3 * j + 1) * nao + i)] = creal(sy);
+                momi[((3 * j + 1) * nao + i)] = cimag(sy);
+                momr[((3 * j + 2) * nao + i)] = creal(sz);
+                momi[((3 * j + 2) * nao + i)] = cimag(sz);
+            }
+        }
+        free(phase);
+    }
+    return;
+}
+
+/*
+ * transmo_orientation_grid: directions and weights for integrating over
+ * the unit sphere.
+ */
+void transmo_orientation_grid(int nth, int nph, double *khat, double *wt)
+{
+    double *x = malloc(sizeof(double) * nth);
+    double *w = malloc(sizeof(double) * nth);
+    double p0, p1, p2, dp, z, st, phi;
+    int i, j, n, it;
+
+    /* Gauss-Legendre nodes by Newton iteration on P_nth */
+    for (i = 0; i < nth; i++) {
+        z = cos(M_PI * (i + 0.75) / (nth + 0.5));
+        it = 0;
+        do {
+            p0 = 1.0;
+            p1 = z;
+            for (n = 2; n <= nth; n++) {
+                p2 = ((2 * n - 1) * z * p1 - (n - 1) * p0) / n;
+                p0 = p1;
+                p1 = p2;
+            }
+            dp = nth * (z * p1 - p0) / (z * z - 1.0);
+            z = z - p1 / dp;
+            it++;
+        } while (fabs(p1 / dp) > 1.0e-14 && it < 100);
+        x[i] = z;
+        w[i] = 2.0 / ((1.0 - z * z) * dp * dp);
+    }
+    for (i = 0; i < nth; i++) {
+        st = sqrt(1.0 - x[i] * x[i]);
+        for (j = 0; j < nph; j++) {
+            phi = 2.0 * M_PI * j / nph;
+            n = i * nph + j;
+            khat[(3 * n)]     = st * cos(phi);
+            khat[(3 * n + 1)] = st * sin(phi);
+            khat[(3 * n + 2)] = x[i];
+            wt[n] = w[i] * 2.0 * M_PI / nph;
+        }
+    }
+    free(x);
+    free(w);
+    return;
+}
+
+/*
+ * transmo_cross_sections: orientation averaged photoionization cross
+ * sections (bohr^2) of each dyson orbital.
+ */
+void transmo_cross_sections(struct ao_gridbasis *gb, double *orbao, int norb,
+                            double *ener, int nener, double ionpot,
+                            double *khat, double *wt, int ndir,
+                            double *sigma)
+{
+    int nao = gb->nao;
+    int ntot = nener * ndir; /* (energy, direction) pairs */
+    double *kvec = malloc(sizeof(double) * 3 * TRANSMO_KBATCH);
+    double *momr = malloc(sizeof(double) * 3 * TRANSMO_KBATCH * nao);
+    double *momi = malloc(sizeof(double) * 3 * TRANSMO_KBATCH * nao);
+    double *dr   = malloc(sizeof(double) * 3 * TRANSMO_KBATCH * norb);
+    double *di   = malloc(sizeof(double) * 3 * TRANSMO_KBATCH * norb);
+    double kval, pref;
+    int b, nb, j, e, n, c, d, m;
+
+    for (j = 0; j < nener * norb; j++) sigma[j] = 0.0;
+
+    for (b = 0; b < ntot; b += TRANSMO_KBATCH) {
+        nb = (ntot - b < TRANSMO_KBATCH ? ntot - b : TRANSMO_KBATCH);
+        for (j = 0; j < nb; j++) {
+            e = (b + j) / ndir;
+            n = (b + j) % ndir;
+            kval = compute_k(ener[e]);
+            kvec[(3 * j)]     = kval * khat[(3 * n)];
+            kvec[(3 * j + 1)] = kval * khat[(3 * n + 1)];
+            kvec[(3 * j + 2)] = kval * khat[(3 * n + 2)];
+        }
+        transmo_ao_dipoles(gb, kvec, nb, momr, momi);
+
+        /* D(d, (j,c)) = sum_ao orbao(d, ao) mom((j,c), ao) */
+        matmul_dgemm_tn(orbao, nao, momr, nao, norb, (3 * nb), nao, 0.0,
+                        dr, norb);
+        matmul_dgemm_tn(orbao, nao, momi, nao, norb, (3 * nb), nao, 0.0,
+                        di, norb);
+
+        for (j = 0; j < nb; j++) {
+            e = (b + j) / ndir;
+            n = (b + j) % ndir;
+            for (c = 0; c < 3; c++) {
+                m = (3 * j + c) * norb;
+                for (d = 0; d < norb; d++) {
+                    sigma[(e * norb + d)] += wt[n] *
+                        (dr[(m + d)] * dr[(m + d)] +
+                         di[(m + d)] * di[(m + d)]);
+                }
+            }
+        }
+    }
+
+    for (e = 0; e < nener; e++) {
+        kval = compute_k(ener[e]);
+        pref = 4.0 * M_PI * M_PI * FINE_STRUCT * (ener[e] + ionpot) * kval
+            / 3.0;
+        for (d = 0; d < norb; d++) {
+            sigma[(e * norb + d)] *= pref;
+        }
+    }
+
+    free(kvec);
+    free(momr);
+    free(momi);
+    free(dr);
+    free(di);
+    return;
+}
@@ -32,6 +32,8 @@
 #include <omp.h>
 #else
 #define omp_get_thread_num() 0
+#define omp_get_num_threads() 1
+#define omp_get_max_threads() 1
 #endif
 /* ----------------- */
 
@@ -108,6 +110,7 @@ void compute_hdgls(struct det *dlist, int ndets, double *moints1,
 		   int ninto)
 {
 	int i;
+#pragma omp parallel for schedule(static)
 	for (i = 0; i < ndets; i++) {
 		hdgls[i] = 0.0 + hmatels(dlist[i], dlist[i], moints1, moints2,
 					 aelec, belec, ninto);
@@ -117,76 +120,338 @@ void compute_hdgls(struct det *dlist, int ndets, double *moints1,
 
 /*
  * compute_hv: perform Hv=c
+ *
+ * Rows i are split among threads in blocks of HV_ROWBLK rows per thread.
+ * The row sum <i|H|j>v(j) is added to c(i) by the thread doing row i.
+ * The symmetric updates c(j) += <i|H|j>v(i) are binned by the thread that
+ * owns element j of c, and each thread sums its own elements after every
+ * block, so no element of c is written by two threads and no per-thread
+ * copy of c is needed. If hmap holds <i|H|j> in core these are used
+ * instead of calling hmatels.
+ * Returns 0, or 1 if scratch could not be allocated.
  */
-void compute_hv(struct det *dlist, int ndets, double *moints1, double *moints2,
-		int aelec, int belec, double *restrict v, double *restrict c,
-		int ninto, struct rowmap *hmap)
+int compute_hv(struct det *dlist, int ndets, double *moints1, double *moints2,
+	       int aelec, int belec, double *restrict v, double *restrict c,
+	       int ninto, struct cimap *hmap)
 {
-	int i, j;
-	double valij;
-	struct section *csec; /* current section of row */
+	int i, j, tid, nact, own, blk, bend;
+	long long int k;
+	double valij, ci;
+	struct hv_scatter *hvs = NULL;  /* binned c(j) updates per thread */
+	int nthd = 1, rowblk = 0, error = 0;
+
+	hvs = allocate_hv_scatter(ndets, &nthd);
+	if (hvs == NULL) return 1;
+	rowblk = HV_ROWBLK * nthd;
 
 	/* OMP Section */
-#pragma omp parallel						       \
-	shared(ndets,c,v,hmap,moints1,moints2,dlist,ninto,aelec,belec) \
-	private(csec,i,j,valij)
+#pragma omp parallel num_threads(nthd)				       \
+	shared(ndets,c,v,hmap,moints1,moints2,dlist,ninto,aelec,belec, \
+	       hvs,nthd,rowblk)					       \
+	private(i,j,k,valij,ci,tid,nact,own,blk,bend)
 	{
+	tid = omp_get_thread_num();
+	nact = omp_get_num_threads();
+	for (blk = 0; blk < ndets; blk += rowblk) {
+		bend = (blk + rowblk < ndets ? blk + rowblk : ndets);
 #pragma omp for schedule(runtime)
-	/* loop over hmap */
-	for (i = 0; i < ndets; i++) {
-		csec = hmap[i].sec;
-		while (csec != NULL) {
-			for (j = (csec->first + i); j <= (csec->last + i); j++) {
-                                valij = hmatels(dlist[i], dlist[j], moints1,
-						moints2, aelec, belec, ninto);
-#pragma omp atomic update
-				c[i] = c[i] + valij * v[j];
+		for (i = blk; i < bend; i++) {
+			ci = 0.0;
+			for (k = hmap->rowptr[i]; k < hmap->rowptr[i + 1];
+			     k++) {
+				j = hmap->cols[k];
+				if (hmap->vals != NULL) {
+					valij = hmap->vals[k];
+				} else if (hmap->svals != NULL) {
+					valij = (i == j ? hmap->diag[i] :
+						 (double) hmap->svals[k]);
+				} else {
+					valij = hmatels(dlist[i], dlist[j],
+							moints1, moints2,
+							aelec, belec, ninto);
+				}
+				ci = ci + valij * v[j];
 				/* off diagonals */
 				if (i != j) {
-#pragma omp atomic update
-					c[j] = c[j] + valij * v[i];
+					hv_scatter_add(&(hvs[tid]), i, j,
+						       valij);
 				}
 			}
-			csec = csec->next;
+			c[i] = c[i] + ci;
+		}
+		for (own = tid; own < nthd; own += nact) {
+			hv_scatter_reduce(hvs, own, v, 1, c);
 		}
+#pragma omp barrier
 	}
 	}/* End of OMP Section */
-	return;
+
+	error = deallocate_hv_scatter(hvs, nthd);
+	return error;
 }
 
 /*
- * compute_hv_nomap: perform Hv=c. No cimap.
+ * compute_hv_multi: perform Hv=c for nvec vectors at once. Each <i|H|j>
+ * is evaluated once and applied to all vectors. Vectors are interleaved:
+ * element i of vector k is v[i * nvec + k].
+ *
+ * Threads split rows and bin the c(j) updates as in compute_hv. A binned
+ * update holds <i|H|j> and i, not the nvec products, so scratch is one
+ * hv_entry per off-diagonal element of a row block, whatever nvec is.
+ * Returns 0, or 1 if scratch could not be allocated.
  */
-void compute_hv_nomap(struct det *dlist, int ndets, double *moints1, double *moints2,
-                      int aelec, int belec, double *restrict v, double *restrict c,
-                      int ninto)
+int compute_hv_multi(struct det *dlist, int ndets, double *moints1,
+		     double *moints2, int aelec, int belec,
+		     double *restrict v, double *restrict c, int nvec,
+		     int ninto, struct cimap *hmap)
 {
-	int i, j;
+	int i, j, l, tid, nact, own, blk, bend;
+	long long int k;
 	double valij;
+	double *ci = NULL;              /* row i of c, all vectors */
+	struct hv_scatter *hvs = NULL;  /* binned c(j) updates per thread */
+	int nthd = 1, rowblk = 0, error = 0;
+
+	hvs = allocate_hv_scatter(ndets, &nthd);
+	if (hvs == NULL) return 1;
+	rowblk = HV_ROWBLK * nthd;
 
 	/* OMP Section */
-#pragma omp parallel                                              \
-	shared(ndets,c,v,moints1,moints2,dlist,ninto,aelec,belec) \
-	private(i,j,valij)
+#pragma omp parallel num_threads(nthd)				       \
+	shared(ndets,c,v,hmap,moints1,moints2,dlist,ninto,aelec,belec, \
+	       nvec,hvs,nthd,rowblk,error)			       \
+	private(i,j,k,l,valij,ci,tid,nact,own,blk,bend)
 	{
+	tid = omp_get_thread_num();
+	nact = omp_get_num_threads();
+	ci = (double *) malloc(nvec * sizeof(double));
+	if (ci == NULL) {
+#pragma omp atomic write
+		error = 1;
+	}
+#pragma omp barrier
+	for (blk = 0; blk < ndets && error == 0; blk += rowblk) {
+		bend = (blk + rowblk < ndets ? blk + rowblk : ndets);
 #pragma omp for schedule(runtime)
-        for (i = 0; i < ndets; i++) {
-                valij = hmatels(dlist[i], dlist[i], moints1,
-                                moints2, aelec, belec, ninto);
-                c[i] = c[i] + valij * v[i];
-                for (j = i + 1; j < ndets; j++) {
-                        valij = hmatels(dlist[i], dlist[j], moints1,
-                                        moints2, aelec, belec, ninto);
-#pragma omp atomic update
-                        c[i] = c[i] + valij * v[j];
-#pragma omp atomic update
-                        c[j] = c[j] + valij * v[i];
-                }
-        }
-        }/* End of OMP Section */
-        return;
+		for (i = blk; i < bend; i++) {
+			for (l = 0; l < nvec; l++) ci[l] = 0.0;
+			for (k = hmap->rowptr[i]; k < hmap->rowptr[i + 1];
+			     k++) {
+				j = hmap->cols[k];
+				if (hmap->vals != NULL) {
+					valij = hmap->vals[k];
+				} else if (hmap->svals != NULL) {
+					valij = (i == j ? hmap->diag[i] :
+						 (double) hmap->svals[k]);
+				} else {
+					valij = hmatels(dlist[i], dlist[j],
+							moints1, moints2,
+							aelec, belec, ninto);
+				}
+				for (l = 0; l < nvec; l++) {
+					ci[l] = ci[l] + valij *
+						v[(size_t) j * nvec + l];
+				}
+				/* off diagonals */
+				if (i != j) {
+					hv_scatter_add(&(hvs[tid]), i, j,
+						       valij);
+				}
+			}
+			for (l = 0; l < nvec; l++) {
+				c[(size_t) i * nvec + l] += ci[l];
+			}
+		}
+		for (own = tid; own < nthd; own += nact) {
+			hv_scatter_reduce(hvs, own, v, nvec, c);
+		}
+#pragma omp barrier
+	}
+	free(ci);
+	}/* End of OMP Section */
+
+	if (deallocate_hv_scatter(hvs, nthd) != 0) error = 1;
+	return error;
+}
+
+/*
+ * cache_hamiltonian: compute all <i|H|j> of hmap and store them in
+ * hmap->vals, if they fit within memlim MB. Otherwise hmap is left
+ * unchanged and compute_hv evaluates elements on the fly. With sngl = 1
+ * the elements are stored in single precision in hmap->svals, and the
+ * diagonal, which dominates the energy, in double precision in
+ * hmap->diag.
+ * Returns 1 if H is held in core, 0 if not.
+ */
+int cache_hamiltonian(struct det *dlist, int ndets, double *moints1,
+		      double *moints2, int aelec, int belec, int ninto,
+		      struct cimap *hmap, int memlim, int sngl, int plvl)
+{
+	int i;
+	long long int k;
+	double valij;
+	double memreq = 0.0; /* MB required to store H */
+
+	if (memlim <= 0) return 0;
+	if (sngl == 1) {
+		memreq = ((double) hmap->nnz * sizeof(float) +
+			  (double) ndets * sizeof(double)) / (1024.0 * 1024.0);
+	} else {
+		memreq = (double) hmap->nnz * sizeof(double) /
+			(1024.0 * 1024.0);
+	}
+	if (memreq > (double) memlim) {
+		if (plvl > 0) fprintf(stdout,
+				      " In-core H needs %.1lf MB > %d MB."
+				      " Computing H on the fly.\n",
+				      memreq, memlim);
+		return 0;
+	}
+	if (sngl == 1) {
+		hmap->svals = (float *) malloc(hmap->nnz * sizeof(float));
+		hmap->diag = (double *) malloc(ndets * sizeof(double));
+		if (hmap->svals == NULL || hmap->diag == NULL) {
+			free(hmap->svals);
+			free(hmap->diag);
+			hmap->svals = NULL;
+			hmap->diag = NULL;
+		}
+	} else {
+		hmap->vals = (double *) malloc(hmap->nnz * sizeof(double));
+	}
+	if (hmap->vals == NULL && hmap->svals == NULL) {
+		if (plvl > 0) fprintf(stdout,
+				      " Could not allocate in-core H."
+				      " Computing H on the fly.\n");
+		return 0;
+	}
+	if (plvl > 0) fprintf(stdout, " Storing H in core (%s precision):"
+			      " %lld elements, %.1lf MB\n",
+			      (sngl == 1 ? "single" : "double"), hmap->nnz,
+			      memreq);
+
+#pragma omp parallel for schedule(dynamic, 64)				\
+	shared(ndets,hmap,moints1,moints2,dlist,ninto,aelec,belec)	\
+	private(i,k,valij)
+	for (i = 0; i < ndets; i++) {
+		for (k = hmap->rowptr[i]; k < hmap->rowptr[i + 1]; k++) {
+			valij = hmatels(dlist[i], dlist[hmap->cols[k]],
+					moints1, moints2, aelec, belec,
+					ninto);
+			if (hmap->vals != NULL) {
+				hmap->vals[k] = valij;
+			} else {
+				hmap->svals[k] = (float) valij;
+				if (hmap->cols[k] == i) hmap->diag[i] = valij;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * allocate_hv_scatter: allocate one hv_scatter per OpenMP thread, each
+ * with one bin per thread. nthd is set to the number of threads.
+ * Returns NULL if allocation fails.
+ */
+struct hv_scatter *allocate_hv_scatter(int ndets, int *nthd)
+{
+	struct hv_scatter *hvs = NULL;
+	int t, error = 0;
+
+	*nthd = omp_get_max_threads();
+	hvs = (struct hv_scatter *) malloc(*nthd * sizeof(struct hv_scatter));
+	if (hvs == NULL) return NULL;
+	for (t = 0; t < *nthd; t++) {
+		hvs[t].nbin  = *nthd;
+		hvs[t].ndets = ndets;
+		hvs[t].error = 0;
+		hvs[t].n     = (int *) calloc(*nthd, sizeof(int));
+		hvs[t].nmax  = (int *) calloc(*nthd, sizeof(int));
+		hvs[t].e     = (struct hv_entry **)
+			calloc(*nthd, sizeof(struct hv_entry *));
+		if (hvs[t].n == NULL || hvs[t].nmax == NULL ||
+		    hvs[t].e == NULL) {
+			error = 1;
+		}
+	}
+	if (error != 0) {
+		deallocate_hv_scatter(hvs, *nthd);
+		return NULL;
+	}
+	return hvs;
+}
+
+/*
+ * deallocate_hv_scatter: free hv_scatter of all threads.
+ * Returns 1 if any thread failed to grow a bin, else 0.
+ */
+int deallocate_hv_scatter(struct hv_scatter *hvs, int nthd)
+{
+	int t, b, error = 0;
+	for (t = 0; t < nthd; t++) {
+		if (hvs[t].error != 0) error = 1;
+		if (hvs[t].e != NULL) {
+			for (b = 0; b < hvs[t].nbin; b++) free(hvs[t].e[b]);
+		}
+		free(hvs[t].e);
+		free(hvs[t].n);
+		free(hvs[t].nmax);
+	}
+	free(hvs);
+	return error;
+}
+
+/*
+ * hv_scatter_add: bin c(j) += <i|H|j>v(i) by the thread that owns j.
+ */
+void hv_scatter_add(struct hv_scatter *hvs, int i, int j, double hij)
+{
+	struct hv_entry *tmp = NULL;
+	int b, m;
+
+	b = (int) ((long long int) j * hvs->nbin / hvs->ndets);
+	if (hvs->n[b] == hvs->nmax[b]) {
+		m = (hvs->nmax[b] < 128 ? 256 : 2 * hvs->nmax[b]);
+		tmp = (struct hv_entry *) realloc(hvs->e[b],
+						  m * sizeof(struct hv_entry));
+		if (tmp == NULL) {
+			hvs->error = 1;
+			return;
+		}
+		hvs->e[b] = tmp;
+		hvs->nmax[b] = m;
+	}
+	hvs->e[b][hvs->n[b]].j   = j;
+	hvs->e[b][hvs->n[b]].i   = i;
+	hvs->e[b][hvs->n[b]].hij = hij;
+	hvs->n[b]++;
+	return;
 }
 
+/*
+ * hv_scatter_reduce: add all threads' updates to the elements of c owned
+ * by thread owner, and empty those bins. v and c hold nvec interleaved
+ * vectors.
+ */
+void hv_scatter_reduce(struct hv_scatter *hvs, int owner, double *v,
+		       int nvec, double *c)
+{
+	struct hv_entry *e = NULL;
+	int t, r, l;
+
+	for (t = 0; t < hvs[owner].nbin; t++) {
+		e = hvs[t].e[owner];
+		for (r = 0; r < hvs[t].n[owner]; r++) {
+			for (l = 0; l < nvec; l++) {
+				c[(size_t) e[r].j * nvec + l] +=
+					e[r].hij * v[(size_t) e[r].i * nvec + l];
+			}
+		}
+		hvs[t].n[owner] = 0;
+	}
+	return;
+}
 
 /* 
  * hmatels: compute matrix element <i|H|j>
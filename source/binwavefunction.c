@@ -0,0 +1,234 @@
+// File: binwavefunction.c
+/*
+ * Binary determinant list and wavefunction files.
+ *
+ * Determinants are stored as packed records: the four occupation bytes
+ * of the alpha and beta strings, the virtual orbitals as 16-bit
+ * integers, and the virtual counts and CAS flag as single bytes.
+ * Records are read and written in blocks of BINWF_BUFLEN.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "errorlib.h"
+#include "binarystr.h"
+#include "binwavefunction.h"
+
+static void pack_det(struct det *d, unsigned char *rec);
+static void unpack_det(unsigned char *rec, struct det *d);
+
+/*
+ * binwf_is_binary: return 1 if file_name is a binary wavefunction file.
+ */
+int binwf_is_binary(char *file_name)
+{
+        FILE *fptr = NULL;
+        char magic[8];
+        int isbin = 0;
+
+        fptr = fopen(file_name, "rb");
+        if (fptr == NULL) return 0;
+        if (fread(magic, 1, 8, fptr) == 8 &&
+            memcmp(magic, BINWF_MAGIC, 8) == 0) {
+                isbin = 1;
+        }
+        fclose(fptr);
+        return isbin;
+}
+
+/*
+ * binwf_open_write: open file and write header. hdr->magic is set here.
+ */
+FILE *binwf_open_write(char *file_name, struct binwf_header *hdr)
+{
+        FILE *fptr = NULL;
+
+        memcpy(hdr->magic, BINWF_MAGIC, 8);
+        fptr = fopen(file_name, "wb");
+        if (fptr == NULL) {
+                error_message("Could not open file.", "binwf_open_write");
+                return NULL;
+        }
+        if (fwrite(hdr, sizeof(struct binwf_header), 1, fptr) != 1) {
+                error_message("Could not write header.", "binwf_open_write");
+                fclose(fptr);
+                return NULL;
+        }
+        return fptr;
+}
+
+/*
+ * binwf_close_write: rewrite header (final ndets/nroots) and close file.
+ */
+int binwf_close_write(FILE *fptr, struct binwf_header *hdr)
+{
+        int error = 0;
+        memcpy(hdr->magic, BINWF_MAGIC, 8);
+        if (fseek(fptr, 0L, SEEK_SET) != 0 ||
+            fwrite(hdr, sizeof(struct binwf_header), 1, fptr) != 1) {
+                error = 1;
+                error_message("Could not write header.", "binwf_close_write");
+        }
+        if (fclose(fptr) != 0) error = 1;
+        return error;
+}
+
+/*
+ * binwf_write_dets: append n determinants to an open file.
+ */
+int binwf_write_dets(FILE *fptr, struct det *dlist, int n)
+{
+        unsigned char *buf = NULL;
+        int i, nblk, done = 0;
+
+        buf = (unsigned char *) malloc(BINWF_BUFLEN * BINWF_DETREC);
+        if (buf == NULL) return 1;
+        while (done < n) {
+                nblk = n - done;
+                if (nblk > BINWF_BUFLEN) nblk = BINWF_BUFLEN;
+                for (i = 0; i < nblk; i++) {
+                        pack_det(&(dlist[done + i]), &(buf[i * BINWF_DETREC]));
+                }
+                if (fwrite(buf, BINWF_DETREC, nblk, fptr) != (size_t) nblk) {
+                        free(buf);
+                        error_message("Write failed.", "binwf_write_dets");
+                        return 1;
+                }
+                done = done + nblk;
+        }
+        free(buf);
+        return 0;
+}
+
+/*
+ * binwf_write_vectors: append eigenvalues and vectors to an open file.
+ */
+int binwf_write_vectors(FILE *fptr, int nroots, int ndets, double **civec,
+                        double *cival)
+{
+        int i;
+        if (fwrite(cival, sizeof(double), nroots, fptr) != (size_t) nroots) {
+                error_message("Write failed.", "binwf_write_vectors");
+                return 1;
+        }
+        for (i = 0; i < nroots; i++) {
+                if (fwrite(civec[i], sizeof(double), ndets, fptr) !=
+                    (size_t) ndets) {
+                        error_message("Write failed.", "binwf_write_vectors");
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+/*
+ * binwf_open_read: open file and read header. Returns NULL if the file
+ * cannot be opened or is not a binary wavefunction file.
+ */
+FILE *binwf_open_read(char *file_name, struct binwf_header *hdr)
+{
+        FILE *fptr = NULL;
+
+        fptr = fopen(file_name, "rb");
+        if (fptr == NULL) return NULL;
+        if (fread(hdr, sizeof(struct binwf_header), 1, fptr) != 1 ||
+            memcmp(hdr->magic, BINWF_MAGIC, 8) != 0) {
+                fclose(fptr);
+                return NULL;
+        }
+        return fptr;
+}
+
+/*
+ * binwf_read_dets: read next n determinants from an open file.
+ */
+int binwf_read_dets(FILE *fptr, struct det *dlist, int n)
+{
+        unsigned char *buf = NULL;
+        int i, nblk, done = 0;
+
+        buf = (unsigned char *) malloc(BINWF_BUFLEN * BINWF_DETREC);
+        if (buf == NULL) return 1;
+        while (done < n) {
+                nblk = n - done;
+                if (nblk > BINWF_BUFLEN) nblk = BINWF_BUFLEN;
+                if (fread(buf, BINWF_DETREC, nblk, fptr) != (size_t) nblk) {
+                        free(buf);
+                        error_message("Unexpected end of file.",
+                                      "binwf_read_dets");
+                        return 1;
+                }
+                for (i = 0; i < nblk; i++) {
+                        unpack_det(&(buf[i * BINWF_DETREC]), &(dlist[done + i]));
+                }
+                done = done + nblk;
+        }
+        free(buf);
+        return 0;
+}
+
+/*
+ * binwf_read_vectors: read eigenvalues and vectors from an open file.
+ */
+int binwf_read_vectors(FILE *fptr, int nroots, int ndets, double **civec,
+                       double *cival)
+{
+        int i;
+        if (fread(cival, sizeof(double), nroots, fptr) != (size_t) nroots) {
+                error_message("Unexpected end of file.", "binwf_read_vectors");
+                return 1;
+        }
+        for (i = 0; i < nroots; i++) {
+                if (fread(civec[i], sizeof(double), ndets, fptr) !=
+                    (size_t) ndets) {
+                        error_message("Unexpected end of file.",
+                                      "binwf_read_vectors");
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+/*
+ * pack_det: pack determinant into BINWF_DETREC bytes.
+ */
+static void pack_det(struct det *d, unsigned char *rec)
+{
+        uint16_t v[4];
+        memcpy(&(rec[0]),  &(d->astr.byte1), 8);
+        memcpy(&(rec[8]),  &(d->astr.byte2), 8);
+        memcpy(&(rec[16]), &(d->bstr.byte1), 8);
+        memcpy(&(rec[24]), &(d->bstr.byte2), 8);
+        v[0] = (uint16_t) d->astr.virtx[0];
+        v[1] = (uint16_t) d->astr.virtx[1];
+        v[2] = (uint16_t) d->bstr.virtx[0];
+        v[3] = (uint16_t) d->bstr.virtx[1];
+        memcpy(&(rec[32]), v, 8);
+        rec[40] = (unsigned char) d->astr.nvrtx;
+        rec[41] = (unsigned char) d->bstr.nvrtx;
+        rec[42] = (unsigned char) d->cas;
+        rec[43] = 0;
+        return;
+}
+
+/*
+ * unpack_det: unpack determinant from BINWF_DETREC bytes.
+ */
+static void unpack_det(unsigned char *rec, struct det *d)
+{
+        uint16_t v[4];
+        memcpy(&(d->astr.byte1), &(rec[0]),  8);
+        memcpy(&(d->astr.byte2), &(rec[8]),  8);
+        memcpy(&(d->bstr.byte1), &(rec[16]), 8);
+        memcpy(&(d->bstr.byte2), &(rec[24]), 8);
+        memcpy(v, &(rec[32]), 8);
+        d->astr.virtx[0] = v[0];
+        d->astr.virtx[1] = v[1];
+        d->bstr.virtx[0] = v[2];
+        d->bstr.virtx[1] = v[3];
+        d->astr.nvrtx = rec[40];
+        d->bstr.nvrtx = rec[41];
+        d->cas = rec[42];
+        return;
+}
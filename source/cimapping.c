@@ -1,7 +1,16 @@
 // File: cimapping.c
 
 /*
- * Generate linked-list for evaluation of CI Hamiltonian.
+ * Generate compressed row map for evaluation of CI Hamiltonian.
+ *
+ * Nonzero elements <i|H|j> are found from the alpha and beta strings of
+ * the determinant list: <i|H|j> can only be nonzero if the alpha and beta
+ * strings of i and j differ by at most two orbitals in total. Each unique
+ * string is given a list of strings that are single and double
+ * replacements of it, found through the substrings it shares with them
+ * when one or two electrons are removed. The rows of H are built from
+ * these lists, so the cost of generating the map scales with the number
+ * of nonzero elements rather than ndets^2.
  */
 
 #include <stdio.h>
@@ -16,128 +25,179 @@
 #define omp_get_thread_num() 0
 #endif
 /*------------------ */
-  
-/*
- * convertrow2map: convert a row of bits into rowmap structure
- */
-void convertrow2map(int *row, int n2v, struct rowmap *v2v)
-{
-	int i, j;
-	int currstat; /* current status: 0 or 1 */
-	struct section *csec; /* current section */
-	struct section *tmp;
-	/* allocate first section */
-	v2v->sec = (struct section *) malloc(sizeof(struct section));
-	v2v->nsec = 1; /* at least one section */
-	csec = v2v->sec;
-	v2v->sec->next = NULL;
-	
-	/* loop over row */
-	csec->first = 0;  /* diagonal is always on */
-	currstat = 1;    /* and our current status is "ON" */
-	for (i = 1; i < n2v; i++) {
-		if (currstat == row[i]) continue;
-		/* new section found */
-		if (row[i-1] == 1) {
-			csec->last = i - 1;
-			csec->next =(struct section *)
-				malloc(sizeof(struct section));
-			csec->next->prev = csec;
-			csec = csec->next;
-			csec->next = NULL;
-			currstat = 0;
-		} else {
-			csec->first = i;
-			v2v->nsec++;
-			currstat = 1;
-		}
-	}
-	if (currstat == 1){
-		csec->last = n2v - 1;
-		csec->next = NULL;
-	} else {
-		tmp = csec;
-		csec = csec->prev;
-		csec->next = NULL;
-		free(tmp);
-	}
-	return;
-}
+
+/* strindx: string and the determinant it was taken from */
+struct strindx {
+	struct occstr str;
+	int indx;
+};
+
+/* strxlist: single and double replacement lists of unique strings */
+struct strxlist {
+	int nstr;             /* number of unique strings          */
+	long long int *sptr;  /* singles of s: sx[sptr[s]..sptr[s+1]-1] */
+	int *sx;              /* single replacement strings        */
+	long long int *dptr;  /* doubles of s: dx[dptr[s]..dptr[s+1]-1] */
+	int *dx;              /* double replacement strings        */
+};
+
+/* holelist: sorted substrings of a string set with one or two electrons
+ * removed, and the strings each substring was taken from */
+struct holelist {
+	int nhole;            /* number of unique substrings       */
+	struct occstr *hole;  /* unique substrings, ascending      */
+	long long int *ptr;   /* strings of h: str[ptr[h]..ptr[h+1]-1] */
+	int *str;             /* string indices                    */
+};
+
+/* detlookup: determinants sorted by (alpha, beta) string index */
+struct detlookup {
+	int *aptr;  /* dets of alpha string a: aptr[a]..aptr[a+1]-1 */
+	int *bstr;  /* beta string index of sorted dets */
+	int *det;   /* determinant index of sorted dets */
+};
+
+static int compare_occstr(struct occstr s1, struct occstr s2);
+static int compare_strindx(const void *s1, const void *s2);
+static int compare_int(const void *i1, const void *i2);
+static int index_det_strings(struct det *dlist, int ndets, int spin,
+			     struct occstr **strs, int *detstr);
+static int generate_strxlist(struct occstr *strs, int nstr,
+			     struct strxlist *xlist);
+static void deallocate_strxlist(struct strxlist *xlist);
+static void get_strx(int i, struct occstr *strs, struct holelist *h1,
+		     struct holelist *h2, int *sx, int *dx,
+		     long long int *ns, long long int *nd);
+static int remove_electron(struct occstr s, int n, struct occstr *t);
+static int generate_holelist(struct occstr *strs, int nstr, int nrem,
+			     struct holelist *hl);
+static void deallocate_holelist(struct holelist *hl);
+static int lookup_hole(struct occstr h, struct holelist *hl);
+static int generate_detlookup(int ndets, int nastr, int *detastr,
+			      int *detbstr, struct detlookup *dlook);
+static void deallocate_detlookup(struct detlookup *dlook);
+static int lookup_det(int astr, int bstr, struct detlookup *dlook);
+static int occstr_xlevel(struct occstr s1, struct occstr s2);
+static long long int get_cimap_row(int i, int astr, int bstr,
+				   struct strxlist *axl, struct strxlist *bxl,
+				   struct detlookup *dlook, int *row);
 
 /*
- * deallocate_cimap: deallocate a cimap linked list array.
+ * deallocate_cimap: deallocate a cimap structure.
  */
-int deallocate_cimap(struct rowmap *hmap, int ndets)
+int deallocate_cimap(struct cimap *hmap)
 {
-	struct section *tsec; /* temporary section */
-	struct section *csec; /* current section */
-	int i;
-
-	for (i = 0; i < ndets; i++) {
-		csec = hmap[i].sec;
-		while (csec->next != NULL) {
-			tsec = csec;
-			csec = csec->next;
-			free(tsec);
-		}
-		free(csec);
-	}
+	int ndets;
+	ndets = hmap->ndets;
+	free(hmap->rowptr);
+	free(hmap->cols);
+	free(hmap->vals);
+	free(hmap->svals);
+	free(hmap->diag);
 	free(hmap);
-	return i;
+	return ndets;
 }
+
 /*
  * generate_cimap: generate map for evaluating nonzero matrix elements of
  * the CI Hamiltonian.
  */
-int generate_cimap(struct det *dlist, int ndets, int nactv, struct rowmap *hmap)
+int generate_cimap(struct det *dlist, int ndets, struct cimap *hmap)
 {
-	int i, j = 0;
-	int v = 0;
-	int ddiff;
-	int naxc, nbxc, naxv, nbxv, naxcv, nbxcv;
-	long long int axi, axf, bxi, bxf;
-	//int row[ndets];
-        int *row = NULL;
-
-	/* OMP Section */
-#pragma omp parallel                    \
-	shared(ndets, dlist, nactv, hmap) \
-	private(i, j, v, row, ddiff)
-	{
-                row = (int *) malloc(ndets * sizeof(int));
-#pragma omp for schedule(dynamic)
-	/* Loop over each row in H. Flag nonzero matrix elements, creating
-	 * an array of elements 1 or 0. */
+	int i;
+	int error = 0;
+	int nastr, nbstr;
+	int *detastr = NULL, *detbstr = NULL; /* string index of each det */
+	struct occstr *astrs = NULL, *bstrs = NULL; /* unique strings */
+	struct strxlist axl, bxl;
+	struct detlookup dlook;
+	long long int *rowptr = NULL;
+	int *cols = NULL;
+
+	hmap->ndets = ndets;
+	hmap->nnz = 0;
+	hmap->rowptr = NULL;
+	hmap->cols = NULL;
+	hmap->vals = NULL;
+	hmap->svals = NULL;
+	hmap->diag = NULL;
+
+	/* Index the unique alpha and beta strings of the expansion. */
+	detastr = (int *) malloc(ndets * sizeof(int));
+	detbstr = (int *) malloc(ndets * sizeof(int));
+	if (detastr == NULL || detbstr == NULL) {
+		error = 1;
+		goto cleanup;
+	}
+	nastr = index_det_strings(dlist, ndets, 0, &astrs, detastr);
+	nbstr = index_det_strings(dlist, ndets, 1, &bstrs, detbstr);
+	if (nastr < 0 || nbstr < 0) {
+		error = 1;
+		goto cleanup;
+	}
+
+	/* Single and double replacement lists for each string. */
+	error = generate_strxlist(astrs, nastr, &axl);
+	if (error != 0) goto cleanup;
+	error = generate_strxlist(bstrs, nbstr, &bxl);
+	if (error != 0) {
+		deallocate_strxlist(&axl);
+		goto cleanup;
+	}
+
+	error = generate_detlookup(ndets, nastr, detastr, detbstr, &dlook);
+	if (error != 0) goto cleanup_xlist;
+
+	/* Count the nonzero elements of each row, j >= i. */
+	rowptr = (long long int *) malloc((ndets + 1) * sizeof(long long int));
+	if (rowptr == NULL) {
+		error = 1;
+		goto cleanup_dlook;
+	}
+	rowptr[0] = 0;
+#pragma omp parallel for schedule(dynamic, 64) default(none)	\
+	shared(ndets, detastr, detbstr, axl, bxl, dlook, rowptr) \
+	private(i)
 	for (i = 0; i < ndets; i++) {
-                int tid = omp_get_thread_num();
-                v = 0;
-		for (j = i; j < ndets; j++) {
-
-                        ddiff = get_detdiffs(dlist[i],dlist[j], nactv);
-			///* Check if determinants are CAS-flagged. */
-			//if (dlist[i].cas + dlist[j].cas < 2) {
-			//	ddiff = comparedets_ncas(
-			//		dlist[i], dlist[j],
-			//		&naxc, &nbxc, &naxv, &nbxv, &naxcv,
-			//		&nbxcv, &axi, &axf, &bxi, &bxf, nactv);
-			//} else {
-			//	ddiff = comparedets_cas(
-			//		dlist[i], dlist[j],
-			//		&naxc, &nbxc, &axi, &axf, &bxi, &bxf,
-			//		nactv);
-			//}
-                        if (ddiff > 2) {
-				row[v] = 0;
-			} else {
-				row[v] = 1;
-			}
-                        v = v + 1;
-		}
-		/* Convert row of 1,0,1,1,... into rowmap structure */
-		convertrow2map(row, v, &(hmap[i]));
+		rowptr[i + 1] = get_cimap_row(i, detastr[i], detbstr[i],
+					      &axl, &bxl, &dlook, NULL);
 	}
-	} /* End of OMP Section */
-	return 0;
+	for (i = 0; i < ndets; i++) {
+		rowptr[i + 1] = rowptr[i + 1] + rowptr[i];
+	}
+
+	/* Fill and sort the columns of each row. */
+	cols = (int *) malloc(rowptr[ndets] * sizeof(int));
+	if (cols == NULL) {
+		error = 1;
+		free(rowptr);
+		goto cleanup_dlook;
+	}
+#pragma omp parallel for schedule(dynamic, 64) default(none)		\
+	shared(ndets, detastr, detbstr, axl, bxl, dlook, rowptr, cols)	\
+	private(i)
+	for (i = 0; i < ndets; i++) {
+		get_cimap_row(i, detastr[i], detbstr[i], &axl, &bxl, &dlook,
+			      &(cols[rowptr[i]]));
+		qsort(&(cols[rowptr[i]]), (rowptr[i + 1] - rowptr[i]),
+		      sizeof(int), compare_int);
+	}
+
+	hmap->nnz = rowptr[ndets];
+	hmap->rowptr = rowptr;
+	hmap->cols = cols;
+
+cleanup_dlook:
+	deallocate_detlookup(&dlook);
+cleanup_xlist:
+	deallocate_strxlist(&axl);
+	deallocate_strxlist(&bxl);
+cleanup:
+	free(astrs);
+	free(bstrs);
+	free(detastr);
+	free(detbstr);
+	return error;
 }
 
 int get_detdiffs(struct det d1, struct det d2, int nactv)
@@ -161,4 +221,543 @@ int get_detdiffs(struct det d1, struct det d2, int nactv)
         return ddiff;
 }
 
-        
+/*
+ * compare_occstr: order two strings. Returns -1, 0, 1.
+ */
+static int compare_occstr(struct occstr s1, struct occstr s2)
+{
+	int i;
+	if (s1.byte1 != s2.byte1) return (s1.byte1 < s2.byte1 ? -1 : 1);
+	if (s1.byte2 != s2.byte2) return (s1.byte2 < s2.byte2 ? -1 : 1);
+	if (s1.nvrtx != s2.nvrtx) return (s1.nvrtx < s2.nvrtx ? -1 : 1);
+	for (i = 0; i < s1.nvrtx; i++) {
+		if (s1.virtx[i] != s2.virtx[i])
+			return (s1.virtx[i] < s2.virtx[i] ? -1 : 1);
+	}
+	return 0;
+}
+
+static int compare_strindx(const void *s1, const void *s2)
+{
+	const struct strindx *t1 = (const struct strindx *) s1;
+	const struct strindx *t2 = (const struct strindx *) s2;
+	return compare_occstr(t1->str, t2->str);
+}
+
+static int compare_int(const void *i1, const void *i2)
+{
+	int a = *((const int *) i1), b = *((const int *) i2);
+	return (a > b) - (a < b);
+}
+
+/*
+ * index_det_strings: find unique alpha (spin=0) or beta (spin=1) strings
+ * of a determinant list.
+ * Input:
+ *  dlist = determinant list
+ *  ndets = number of determinants
+ *  spin  = 0: alpha, 1: beta
+ * Output:
+ *  strs   = unique strings (allocated here)
+ *  detstr = index of string in strs for each determinant
+ * Returns number of unique strings, -1 on error.
+ */
+static int index_det_strings(struct det *dlist, int ndets, int spin,
+			     struct occstr **strs, int *detstr)
+{
+	int i, nstr = 0;
+	struct strindx *slist = NULL;
+
+	slist = (struct strindx *) malloc(ndets * sizeof(struct strindx));
+	*strs = (struct occstr *) malloc(ndets * sizeof(struct occstr));
+	if (slist == NULL || *strs == NULL) {
+		free(slist);
+		return -1;
+	}
+	for (i = 0; i < ndets; i++) {
+		slist[i].str = (spin == 0 ? dlist[i].astr : dlist[i].bstr);
+		slist[i].indx = i;
+	}
+	qsort(slist, ndets, sizeof(struct strindx), compare_strindx);
+	for (i = 0; i < ndets; i++) {
+		if (i == 0 ||
+		    compare_occstr(slist[i].str, (*strs)[nstr - 1]) != 0) {
+			(*strs)[nstr] = slist[i].str;
+			nstr++;
+		}
+		detstr[slist[i].indx] = nstr - 1;
+	}
+	free(slist);
+	return nstr;
+}
+
+/*
+ * occstr_xlevel: number of orbitals occupied in s1 and not in s2. For
+ * strings of equal electron count this is the excitation level.
+ */
+static int occstr_xlevel(struct occstr s1, struct occstr s2)
+{
+	int i, j, nx;
+	nx = __builtin_popcountll(s1.byte1 & ~s2.byte1) +
+		__builtin_popcountll(s1.byte2 & ~s2.byte2);
+	for (i = 0; i < s1.nvrtx; i++) {
+		for (j = 0; j < s2.nvrtx; j++) {
+			if (s1.virtx[i] == s2.virtx[j]) break;
+		}
+		if (j == s2.nvrtx) nx++;
+	}
+	return nx;
+}
+
+/*
+ * generate_strxlist: build the single and double replacement lists of a
+ * set of unique strings.
+ * Two strings are single (double) replacements of each other if they
+ * share a substring with one (two) electrons removed. The one- and
+ * two-hole substrings of every string are sorted into hole lists, and
+ * the replacements of a string are read from the entries of its own
+ * hole substrings, so the cost scales with the size of the lists rather
+ * than nstr^2.
+ */
+static int generate_strxlist(struct occstr *strs, int nstr,
+			     struct strxlist *xlist)
+{
+	int i, error = 0;
+	struct holelist h1, h2;
+
+	xlist->nstr = nstr;
+	xlist->sx = NULL;
+	xlist->dx = NULL;
+	xlist->sptr = (long long int *) malloc((nstr + 1) *
+					       sizeof(long long int));
+	xlist->dptr = (long long int *) malloc((nstr + 1) *
+					       sizeof(long long int));
+	if (xlist->sptr == NULL || xlist->dptr == NULL) {
+		deallocate_strxlist(xlist);
+		return 1;
+	}
+
+	error = generate_holelist(strs, nstr, 1, &h1);
+	if (error != 0) {
+		deallocate_strxlist(xlist);
+		return 1;
+	}
+	error = generate_holelist(strs, nstr, 2, &h2);
+	if (error != 0) {
+		deallocate_holelist(&h1);
+		deallocate_strxlist(xlist);
+		return 1;
+	}
+
+	/* Count replacements of each string. */
+	xlist->sptr[0] = 0;
+	xlist->dptr[0] = 0;
+#pragma omp parallel for schedule(dynamic, 64) default(none)	\
+	shared(nstr, strs, xlist, h1, h2) private(i)
+	for (i = 0; i < nstr; i++) {
+		get_strx(i, strs, &h1, &h2, NULL, NULL,
+			 &(xlist->sptr[i + 1]), &(xlist->dptr[i + 1]));
+	}
+	for (i = 0; i < nstr; i++) {
+		xlist->sptr[i + 1] = xlist->sptr[i + 1] + xlist->sptr[i];
+		xlist->dptr[i + 1] = xlist->dptr[i + 1] + xlist->dptr[i];
+	}
+
+	xlist->sx = (int *) malloc((xlist->sptr[nstr] + 1) * sizeof(int));
+	xlist->dx = (int *) malloc((xlist->dptr[nstr] + 1) * sizeof(int));
+	if (xlist->sx == NULL || xlist->dx == NULL) {
+		deallocate_strxlist(xlist);
+		error = 1;
+		goto cleanup;
+	}
+
+	/* Fill replacement lists. */
+#pragma omp parallel for schedule(dynamic, 64) default(none)	\
+	shared(nstr, strs, xlist, h1, h2) private(i)
+	for (i = 0; i < nstr; i++) {
+		long long int ns, nd;
+		get_strx(i, strs, &h1, &h2, &(xlist->sx[xlist->sptr[i]]),
+			 &(xlist->dx[xlist->dptr[i]]), &ns, &nd);
+	}
+
+cleanup:
+	deallocate_holelist(&h1);
+	deallocate_holelist(&h2);
+	return error;
+}
+
+/*
+ * get_strx: find the single and double replacements of string i. If sx
+ * (dx) is NULL, only count them.
+ * Input:
+ *  i    = string
+ *  strs = unique strings
+ *  h1   = one-hole list of strs
+ *  h2   = two-hole list of strs
+ * Output:
+ *  sx = single replacements of i
+ *  dx = double replacements of i
+ *  ns = number of single replacements
+ *  nd = number of double replacements
+ */
+static void get_strx(int i, struct occstr *strs, struct holelist *h1,
+		     struct holelist *h2, int *sx, int *dx,
+		     long long int *ns, long long int *nd)
+{
+	int j, n1, n2, g;
+	long long int x;
+	struct occstr h, t;
+
+	*ns = 0;
+	*nd = 0;
+
+	/* Strings sharing a one-hole substring with i */
+	for (n1 = 0; remove_electron(strs[i], n1, &h) != 0; n1++) {
+		g = lookup_hole(h, h1);
+		for (x = h1->ptr[g]; x < h1->ptr[g + 1]; x++) {
+			j = h1->str[x];
+			if (j == i) continue;
+			if (sx != NULL) sx[*ns] = j;
+			(*ns)++;
+		}
+	}
+
+	/* Strings sharing a two-hole substring with i, excluding singles.
+	 * A double replacement shares exactly one such substring. */
+	for (n2 = 1; remove_electron(strs[i], n2, &t) != 0; n2++) {
+		for (n1 = 0; n1 < n2; n1++) {
+			remove_electron(t, n1, &h);
+			g = lookup_hole(h, h2);
+			for (x = h2->ptr[g]; x < h2->ptr[g + 1]; x++) {
+				j = h2->str[x];
+				if (j == i) continue;
+				if (occstr_xlevel(strs[i], strs[j]) != 2)
+					continue;
+				if (dx != NULL) dx[*nd] = j;
+				(*nd)++;
+			}
+		}
+	}
+	return;
+}
+
+/*
+ * remove_electron: remove the n-th occupied orbital (n = 0, 1, ...) of
+ * string s, returning the new string in t. Internal orbitals are counted
+ * first, then virtual orbitals.
+ * Returns 1, or 0 if s has fewer than n+1 electrons.
+ */
+static int remove_electron(struct occstr s, int n, struct occstr *t)
+{
+	int b, k, v, nb;
+	long long int bits;
+
+	*t = s;
+	/* Internal orbitals 1 -> 64 */
+	nb = __builtin_popcountll(s.byte1);
+	if (n < nb) {
+		bits = s.byte1;
+		for (k = 0; k < n; k++) bits = bits & (bits - 1);
+		b = __builtin_ctzll(bits);
+		t->byte1 = s.byte1 & ~(1LL << b);
+		return 1;
+	}
+	n = n - nb;
+	/* Internal orbitals 65 -> 128 */
+	nb = __builtin_popcountll(s.byte2);
+	if (n < nb) {
+		bits = s.byte2;
+		for (k = 0; k < n; k++) bits = bits & (bits - 1);
+		b = __builtin_ctzll(bits);
+		t->byte2 = s.byte2 & ~(1LL << b);
+		return 1;
+	}
+	n = n - nb;
+	/* Virtual orbitals */
+	if (n >= s.nvrtx) return 0;
+	v = 0;
+	for (k = 0; k < s.nvrtx; k++) {
+		if (k == n) continue;
+		t->virtx[v] = s.virtx[k];
+		v++;
+	}
+	for (k = v; k < 2; k++) t->virtx[k] = 0;
+	t->nvrtx = s.nvrtx - 1;
+	return 1;
+}
+
+/*
+ * generate_holelist: sort the substrings of a set of strings with nrem
+ * (1 or 2) electrons removed, and list the strings each substring
+ * came from.
+ */
+static int generate_holelist(struct occstr *strs, int nstr, int nrem,
+			     struct holelist *hl)
+{
+	int i, n1, n2;
+	long long int np = 0, k;
+	struct occstr t;
+	struct strindx *plist = NULL;
+
+	hl->nhole = 0;
+	hl->hole = NULL;
+	hl->ptr = NULL;
+	hl->str = NULL;
+
+	/* Count (substring, string) pairs. */
+	for (i = 0; i < nstr; i++) {
+		for (n1 = 0; remove_electron(strs[i], n1, &t) != 0; n1++) {
+			np = np + (nrem == 1 ? 1 : n1);
+		}
+	}
+
+	plist = (struct strindx *) malloc((np + 1) * sizeof(struct strindx));
+	hl->str = (int *) malloc((np + 1) * sizeof(int));
+	if (plist == NULL || hl->str == NULL) {
+		free(plist);
+		deallocate_holelist(hl);
+		return 1;
+	}
+	np = 0;
+	for (i = 0; i < nstr; i++) {
+		for (n2 = 0; remove_electron(strs[i], n2, &t) != 0; n2++) {
+			if (nrem == 1) {
+				plist[np].str = t;
+				plist[np].indx = i;
+				np++;
+				continue;
+			}
+			for (n1 = 0; n1 < n2; n1++) {
+				remove_electron(t, n1, &(plist[np].str));
+				plist[np].indx = i;
+				np++;
+			}
+		}
+	}
+	qsort(plist, np, sizeof(struct strindx), compare_strindx);
+
+	/* Unique substrings and the strings of each. */
+	for (k = 0; k < np; k++) {
+		if (k == 0 ||
+		    compare_occstr(plist[k].str, plist[k - 1].str) != 0) {
+			hl->nhole++;
+		}
+	}
+	hl->hole = (struct occstr *) malloc((hl->nhole + 1) *
+					    sizeof(struct occstr));
+	hl->ptr = (long long int *) malloc((hl->nhole + 1) *
+					   sizeof(long long int));
+	if (hl->hole == NULL || hl->ptr == NULL) {
+		free(plist);
+		deallocate_holelist(hl);
+		return 1;
+	}
+	hl->nhole = 0;
+	for (k = 0; k < np; k++) {
+		if (k == 0 ||
+		    compare_occstr(plist[k].str, plist[k - 1].str) != 0) {
+			hl->hole[hl->nhole] = plist[k].str;
+			hl->ptr[hl->nhole] = k;
+			hl->nhole++;
+		}
+		hl->str[k] = plist[k].indx;
+	}
+	hl->ptr[hl->nhole] = np;
+	free(plist);
+	return 0;
+}
+
+static void deallocate_holelist(struct holelist *hl)
+{
+	free(hl->hole);
+	free(hl->ptr);
+	free(hl->str);
+	hl->hole = NULL;
+	hl->ptr = NULL;
+	hl->str = NULL;
+	return;
+}
+
+/*
+ * lookup_hole: return index of substring h in hole list hl, or -1.
+ */
+static int lookup_hole(struct occstr h, struct holelist *hl)
+{
+	int lo, hi, mid, c;
+	lo = 0;
+	hi = hl->nhole - 1;
+	while (lo <= hi) {
+		mid = lo + (hi - lo) / 2;
+		c = compare_occstr(hl->hole[mid], h);
+		if (c == 0) return mid;
+		if (c < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return -1;
+}
+
+static void deallocate_strxlist(struct strxlist *xlist)
+{
+	free(xlist->sptr);
+	free(xlist->dptr);
+	free(xlist->sx);
+	free(xlist->dx);
+	xlist->sptr = NULL;
+	xlist->dptr = NULL;
+	xlist->sx = NULL;
+	xlist->dx = NULL;
+	return;
+}
+
+/*
+ * generate_detlookup: bucket determinants by alpha string, with beta
+ * strings of each bucket in ascending order.
+ */
+static int generate_detlookup(int ndets, int nastr, int *detastr,
+			      int *detbstr, struct detlookup *dlook)
+{
+	int i, j, k, a, b, d;
+	int *pos = NULL;
+
+	dlook->aptr = (int *) calloc((nastr + 1), sizeof(int));
+	dlook->bstr = (int *) malloc(ndets * sizeof(int));
+	dlook->det  = (int *) malloc(ndets * sizeof(int));
+	pos = (int *) malloc(nastr * sizeof(int));
+	if (dlook->aptr == NULL || dlook->bstr == NULL ||
+	    dlook->det == NULL || pos == NULL) {
+		deallocate_detlookup(dlook);
+		free(pos);
+		return 1;
+	}
+	for (i = 0; i < ndets; i++) dlook->aptr[detastr[i] + 1]++;
+	for (i = 0; i < nastr; i++) {
+		dlook->aptr[i + 1] = dlook->aptr[i + 1] + dlook->aptr[i];
+		pos[i] = dlook->aptr[i];
+	}
+	for (i = 0; i < ndets; i++) {
+		dlook->bstr[pos[detastr[i]]] = detbstr[i];
+		dlook->det[pos[detastr[i]]] = i;
+		pos[detastr[i]]++;
+	}
+	/* Insertion sort each bucket on beta string. Buckets are short. */
+	for (a = 0; a < nastr; a++) {
+		for (j = dlook->aptr[a] + 1; j < dlook->aptr[a + 1]; j++) {
+			b = dlook->bstr[j];
+			d = dlook->det[j];
+			k = j - 1;
+			while (k >= dlook->aptr[a] && dlook->bstr[k] > b) {
+				dlook->bstr[k + 1] = dlook->bstr[k];
+				dlook->det[k + 1] = dlook->det[k];
+				k--;
+			}
+			dlook->bstr[k + 1] = b;
+			dlook->det[k + 1] = d;
+		}
+	}
+	free(pos);
+	return 0;
+}
+
+static void deallocate_detlookup(struct detlookup *dlook)
+{
+	free(dlook->aptr);
+	free(dlook->bstr);
+	free(dlook->det);
+	dlook->aptr = NULL;
+	dlook->bstr = NULL;
+	dlook->det = NULL;
+	return;
+}
+
+/*
+ * lookup_det: return determinant with strings (astr, bstr), or -1.
+ */
+static int lookup_det(int astr, int bstr, struct detlookup *dlook)
+{
+	int lo, hi, mid;
+	lo = dlook->aptr[astr];
+	hi = dlook->aptr[astr + 1] - 1;
+	while (lo <= hi) {
+		mid = lo + (hi - lo) / 2;
+		if (dlook->bstr[mid] == bstr) return dlook->det[mid];
+		if (dlook->bstr[mid] < bstr) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return -1;
+}
+
+/*
+ * get_cimap_row: find determinants j >= i with <i|H|j> possibly nonzero.
+ * If row is NULL, only count them.
+ * Input:
+ *  i    = determinant (row)
+ *  astr = alpha string of i
+ *  bstr = beta string of i
+ *  axl  = alpha string replacement lists
+ *  bxl  = beta string replacement lists
+ *  dlook= determinant lookup table
+ * Output:
+ *  row  = columns j (unsorted)
+ * Returns number of columns in row.
+ */
+static long long int get_cimap_row(int i, int astr, int bstr,
+				   struct strxlist *axl, struct strxlist *bxl,
+				   struct detlookup *dlook, int *row)
+{
+	long long int n = 0, x, y;
+	int j;
+
+	/* Diagonal */
+	if (row != NULL) row[n] = i;
+	n++;
+
+	/* Alpha single and double replacements, same beta string */
+	for (x = axl->sptr[astr]; x < axl->sptr[astr + 1]; x++) {
+		j = lookup_det(axl->sx[x], bstr, dlook);
+		if (j > i) {
+			if (row != NULL) row[n] = j;
+			n++;
+		}
+	}
+	for (x = axl->dptr[astr]; x < axl->dptr[astr + 1]; x++) {
+		j = lookup_det(axl->dx[x], bstr, dlook);
+		if (j > i) {
+			if (row != NULL) row[n] = j;
+			n++;
+		}
+	}
+
+	/* Beta single and double replacements, same alpha string */
+	for (x = bxl->sptr[bstr]; x < bxl->sptr[bstr + 1]; x++) {
+		j = lookup_det(astr, bxl->sx[x], dlook);
+		if (j > i) {
+			if (row != NULL) row[n] = j;
+			n++;
+		}
+	}
+	for (x = bxl->dptr[bstr]; x < bxl->dptr[bstr + 1]; x++) {
+		j = lookup_det(astr, bxl->dx[x], dlook);
+		if (j > i) {
+			if (row != NULL) row[n] = j;
+			n++;
+		}
+	}
+
+	/* Alpha single, beta single replacements */
+	for (x = axl->sptr[astr]; x < axl->sptr[astr + 1]; x++) {
+		for (y = bxl->sptr[bstr]; y < bxl->sptr[bstr + 1]; y++) {
+			j = lookup_det(axl->sx[x], bxl->sx[y], dlook);
+			if (j > i) {
+				if (row != NULL) row[n] = j;
+				n++;
+			}
+		}
+	}
+	return n;
+}
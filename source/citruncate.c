@@ -13,6 +13,7 @@
 #include "combinatorial.h"
 #include "straddress.h"
 #include "binarystr.h"
+#include "binwavefunction.h"
 #include "citruncate.h"
 
 /*--------------------------------------------------------------------------*/
@@ -30,13 +31,15 @@
  *  nactv = number of active reference orbitals
  *  nfrzv = number of frozen virtual orbitals
  *  xlvl  = excitation level (DOCC->ACTV & (DOCC + ACTV)->VIRT)
+ *  txtlist = 1: also write text determinant list det.list
  * Output:
  *  astr_len = alpha string number
  *  bstr_len = beta  string number
  *  dstr_len = determinant number
+ * The determinant list is written to det.bin.
  */
 int citrunc(int aelec, int belec, int orbs, int nfrzc, int ndocc,
-	    int nactv, int nfrzv, int xlvl, int *astr_len,
+	    int nactv, int nfrzv, int xlvl, int txtlist, int *astr_len,
 	    int *bstr_len, int *dtrm_len)
 {
         int error = 0; /* Error flag */
@@ -52,6 +55,7 @@ int citrunc(int aelec, int belec, int orbs, int nfrzc, int ndocc,
         int qegrps;            /* Beta  electron groupings */
         struct eospace *peosp = NULL; /* Alpha electron space array */
         struct eospace *qeosp = NULL; /* Beta  electron space array */
+        struct binwf_header hdr;      /* det.bin header */
         
         /* Compute electron and orbital number in CI expansion space.
          * Compute alpha and beta string numbers */
@@ -94,9 +98,23 @@ int citrunc(int aelec, int belec, int orbs, int nfrzc, int ndocc,
                              nactv, xlvl, qeosp, qegrps);
 
         /* Generate determinant list */
-        generate_determinant_list(pstrings, *astr_len, ci_aelec, qstrings,
-                                  *bstr_len, ci_belec, peosp, pegrps, qeosp,
-                                  qegrps, ndocc, nactv, xlvl, dtrm_len);
+        hdr.electrons = aelec + belec;
+        hdr.orbitals  = orbs;
+        hdr.elec  = ci_aelec + ci_belec;
+        hdr.orbs  = ci_orbs;
+        hdr.ninto = ndocc + nactv;
+        hdr.ndets = 0;
+        hdr.nfrzc = nfrzc;
+        hdr.ndocc = ndocc;
+        hdr.nactv = nactv;
+        hdr.nfrzv = nfrzv;
+        hdr.xlvl  = xlvl;
+        hdr.nroots = 0;
+        error = generate_determinant_list(pstrings, *astr_len, ci_aelec,
+                                          qstrings, *bstr_len, ci_belec,
+                                          peosp, pegrps, qeosp, qegrps,
+                                          ndocc, nactv, xlvl, dtrm_len,
+                                          &hdr, txtlist);
         
         return error;
 }
@@ -320,8 +338,7 @@ int compute_detnum(struct eospace *peosp, int pegrps, struct eospace *qeosp,
  */
 void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                        int ndocc, int nactv, int docc_elec, int actv_elec,
-                       int virt_elec, int *docc, int *actv, int *virt,
-                       int *doccscr, int *actvscr, int *virtscr)
+                       int virt_elec, int *docc, int *actv, int *virt)
 {
         int i, j, k, l;
         int virt_orbs;
@@ -356,7 +373,7 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                 strlist[ptr].doccx = ndocc - docc_elec;
                 strlist[ptr].actvx = virt_elec;
 
-                str_adr2str(i, doccscr, elecs[0], orbs[0], docc);
+                str_adr2str(i, elecs[0], orbs[0], docc);
                 for (j = 0; j < elecs[0]; j++) {
                         strlist[ptr].string[j] = docc[j] + pegs[0];
                 }
@@ -369,7 +386,7 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                 }
                 /* Loop over second space's strings */
                 for (j = 1; j <= nstr[1]; j++) {
-                        str_adr2str(j, actvscr, elecs[1], orbs[1], actv);
+                        str_adr2str(j, elecs[1], orbs[1], actv);
                         for (k = 0; k < elecs[0]; k++) {
                                 strlist[ptr].string[k] = docc[k] + pegs[0];
                         }
@@ -387,7 +404,7 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                         }
                         /* Loop over third space's strings */
                         for (k = 1; k <= nstr[2]; k++) {
-                                str_adr2str(k, virtscr, elecs[2], orbs[2], virt);
+                                str_adr2str(k, elecs[2], orbs[2], virt);
                                 for (l = 0; l < elecs[0]; l++) {
                                         strlist[ptr].string[l] = docc[l] + pegs[0];
                                 }
@@ -452,42 +469,162 @@ int compute_stringnum(int orbs, int elecs, int ndocc, int nactv, int xlvl)
 }
 
 /*
- * generate_determinant_list: generate determinant list.
+ * detiter_init: set up a determinant list traversal at the first
+ * determinant.
+ */
+void detiter_init(struct detiter *it, struct eostring *pstr,
+                  struct eostring *qstr, struct eospace *peosp, int pegrps,
+                  struct eospace *qeosp, int qegrps, int aelec, int belec,
+                  int ndocc, int nactv, int xlvl)
+{
+        it->pstr  = pstr;
+        it->qstr  = qstr;
+        it->peosp = peosp;
+        it->qeosp = qeosp;
+        it->pegrps = pegrps;
+        it->qegrps = qegrps;
+        it->aelec = aelec;
+        it->belec = belec;
+        it->ndocc = ndocc;
+        it->nactv = nactv;
+        /* Set max/min occupation numbers of alpha + beta strings */
+        it->doccmin = 2 * (ndocc - int_min(ndocc, xlvl));
+        it->virtmax = xlvl;
+        it->pg = 0;
+        it->qg = 0;
+        it->ip = 0;
+        it->iq = 0;
+        if (pegrps == 0 || qegrps == 0) {
+                it->pg = pegrps;
+                return;
+        }
+        it->ip = peosp[0].start;
+        it->iq = qeosp[0].start;
+        return;
+}
+
+/*
+ * detiter_fill: generate the next determinants of a traversal. Each
+ * alpha string is converted once per run of beta strings.
  */
-void generate_determinant_list(struct eostring *pstrlist, int npstr, int aelec,
-                               struct eostring *qstrlist, int nqstr, int belec,
-                               struct eospace *peosp, int pegrps,
-                               struct eospace *qeosp, int qegrps,
-                               int ndocc, int nactv, int xlvl, int *dtrm_len)
+int detiter_fill(struct detiter *it, struct det *dbuf, int *pidx, int *qidx,
+                 int nmax)
 {
+        struct eospace *pe = NULL, *qe = NULL;
+        struct occstr astr;
+        int cflag = 0;
+        int n = 0;
+
+        while (n < nmax && it->pg < it->pegrps) {
+                pe = &(it->peosp[it->pg]);
+                qe = &(it->qeosp[it->qg]);
+                /* Skip invalid pairs, and move to the next pair at the end
+                 * of this one */
+                if ((pe->docc + qe->docc) < it->doccmin ||
+                    (pe->virt + qe->virt) > it->virtmax ||
+                    it->ip >= (pe->start + pe->nstr)) {
+                        it->qg++;
+                        if (it->qg == it->qegrps) {
+                                it->qg = 0;
+                                it->pg++;
+                        }
+                        if (it->pg < it->pegrps) {
+                                it->ip = it->peosp[it->pg].start;
+                                it->iq = it->qeosp[it->qg].start;
+                        }
+                        continue;
+                }
+                cflag = ((pe->virt + qe->virt) == 0 ? 1 : 0);
+                astr = str2occstr(it->pstr[it->ip].string, it->aelec,
+                                  it->ndocc, it->nactv);
+                while (n < nmax && it->iq < (qe->start + qe->nstr)) {
+                        dbuf[n].astr = astr;
+                        dbuf[n].bstr = str2occstr(it->qstr[it->iq].string,
+                                                  it->belec, it->ndocc,
+                                                  it->nactv);
+                        dbuf[n].cas = cflag;
+                        if (pidx != NULL) pidx[n] = it->pstr[it->ip].index;
+                        if (qidx != NULL) qidx[n] = it->qstr[it->iq].index;
+                        n++;
+                        it->iq++;
+                }
+                if (it->iq == (qe->start + qe->nstr)) {
+                        it->iq = qe->start;
+                        it->ip++;
+                }
+        }
+        return n;
+}
+
+/*
+ * generate_determinant_list: generate determinant list, streaming it to
+ * the binary file det.bin (and the text file det.list if txtlist = 1).
+ */
+int generate_determinant_list(struct eostring *pstrlist, int npstr, int aelec,
+                              struct eostring *qstrlist, int nqstr, int belec,
+                              struct eospace *peosp, int pegrps,
+                              struct eospace *qeosp, int qegrps,
+                              int ndocc, int nactv, int xlvl, int *dtrm_len,
+                              struct binwf_header *hdr, int txtlist)
+{
+        int error = 0;
         int dcnt = 0; /* Determinant count */
-        int doccmin = 0; /* Minimum occupation for DOCC orbitals */
-        int virtmax = 0; /* Maximum occupation ofr VIRT orbitals */
         FILE *fptr = NULL;
-        int i, j;
-
-        /* Set max/min occupation numbers of alpha + beta strings */
-        doccmin = 2 * (ndocc - int_min(ndocc, xlvl));
-        virtmax = xlvl;
+        FILE *bptr = NULL;
+        struct detiter it;       /* Determinant list traversal */
+        struct det *dbuf = NULL; /* Determinant block buffer */
+        int *pidx = NULL;        /* Alpha string indices (det.list) */
+        int *qidx = NULL;        /* Beta  string indices (det.list) */
+        int nbuf = 0;
+        int i;
 
-        /* Open determinant file */
-        fptr = fopen("det.list","w");
-        
-        /* Loop over p string groups */
-        for (i = 0; i < pegrps; i++) {
-                /* Loop over q string groups */
-                for (j = 0; j < qegrps; j++) {
-                        if ((peosp[i].docc + qeosp[j].docc) < doccmin) continue;
-                        if ((peosp[i].virt + qeosp[j].virt) > virtmax) continue;
+        /* Open determinant files */
+        bptr = binwf_open_write("det.bin", hdr);
+        dbuf = (struct det *) malloc(BINWF_BUFLEN * sizeof(struct det));
+        if (bptr == NULL || dbuf == NULL) {
+                error_message("Cannot write det.bin", "generate_determinant_list");
+                if (bptr != NULL) fclose(bptr);
+                free(dbuf);
+                return 1;
+        }
+        if (txtlist == 1) {
+                fptr = fopen("det.list","w");
+                pidx = (int *) malloc(BINWF_BUFLEN * sizeof(int));
+                qidx = (int *) malloc(BINWF_BUFLEN * sizeof(int));
+                if (pidx == NULL || qidx == NULL) {
+                        free(pidx);
+                        free(qidx);
+                        pidx = NULL;
+                        qidx = NULL;
+                        if (fptr != NULL) fclose(fptr);
+                        fptr = NULL;
+                }
+        }
 
-                        write_determinant_strpairs(fptr, peosp[i].start,
-                                                   peosp[i].nstr, qeosp[j].start,
-                                                   qeosp[j].nstr, &dcnt,
-                                                   pstrlist, qstrlist);
+        /* Generate and write one block of determinants at a time */
+        detiter_init(&it, pstrlist, qstrlist, peosp, pegrps, qeosp, qegrps,
+                     aelec, belec, ndocc, nactv, xlvl);
+        nbuf = detiter_fill(&it, dbuf, pidx, qidx, BINWF_BUFLEN);
+        while (nbuf > 0) {
+                error = binwf_write_dets(bptr, dbuf, nbuf);
+                if (error != 0) break;
+                if (fptr != NULL) {
+                        for (i = 0; i < nbuf; i++) {
+                                fprintf(fptr, " %14d %14d\n", pidx[i],
+                                        qidx[i]);
+                        }
                 }
+                dcnt = dcnt + nbuf;
+                nbuf = detiter_fill(&it, dbuf, pidx, qidx, BINWF_BUFLEN);
         }
+        hdr->ndets = dcnt;
+        error = error + binwf_close_write(bptr, hdr);
+        if (fptr != NULL) fclose(fptr);
+        free(dbuf);
+        free(pidx);
+        free(qidx);
         *dtrm_len = dcnt;
-        return;
+        return error;
 }
 
 /*
@@ -502,38 +639,11 @@ void generate_determinant_list_rtnlist(struct eostring *pstrlist, int npstr,
                                        int ndocc, int nactv, int xlvl,
                                        int dtrm_len, struct det *dtlist)
 {
-        int dcnt = 0;     /* Determinant count */
-        int doccmin = 0;  /* Minimum occupation for DOCC orbitals */
-        int virtmax = 0;  /* Maximum occupation ofr VIRT orbitals */
-        int cflag = 0;    /* CAS flag */
-        int i, j;
-
-        /* Set max/min occupation numbers of alpha + beta strings */
-        doccmin = 2 * (ndocc - int_min(ndocc, xlvl));
-        virtmax = xlvl;
-
-        /* Loop over p string groups */
-        for (i = 0; i < pegrps; i++) {
-                /* Loop over q string groups */
-                for (j = 0; j < qegrps; j++) {
-                        if ((peosp[i].docc + qeosp[j].docc) < doccmin) continue;
-                        if ((peosp[i].virt + qeosp[j].virt) > virtmax) continue;
-                        if ((peosp[i].virt + qeosp[j].virt) == 0) {
-                                cflag = 1;
-                        } else {
-                                cflag = 0;
-                        }
+        struct detiter it; /* Determinant list traversal */
 
-                        write_determinant_strpairs_dtlist(peosp[i].start,
-                                                          peosp[i].nstr,
-                                                          qeosp[j].start,
-                                                          qeosp[j].nstr,
-                                                          pstrlist, qstrlist,
-                                                          aelec, belec, ndocc,
-                                                          nactv, dtlist, &dcnt,
-                                                          cflag);
-                }
-        }
+        detiter_init(&it, pstrlist, qstrlist, peosp, pegrps, qeosp, qegrps,
+                     aelec, belec, ndocc, nactv, xlvl);
+        detiter_fill(&it, dtlist, NULL, NULL, dtrm_len);
         return;
 }
 
@@ -546,23 +656,17 @@ void generate_string_list(struct eostring *strlist, int nstr, int orbs,
 {
 
         int count = 0; /* String counter */
-        int *docc = NULL, *doccscr = NULL;
-        int *actv = NULL, *actvscr = NULL;
-        int *virt = NULL, *virtscr = NULL;
+        int *docc = NULL;
+        int *actv = NULL;
+        int *virt = NULL;
         int max_space_size = 20;
         int i;
         docc = (int *) malloc(sizeof(int) * max_space_size);
-        doccscr = (int *) malloc(sizeof(int) * max_space_size);
         init_int_array_0(docc, max_space_size);
-        init_int_array_0(doccscr, max_space_size);
         actv = (int *) malloc(sizeof(int) * max_space_size);
-        actvscr = (int *) malloc(sizeof(int) * max_space_size);
         init_int_array_0(actv, max_space_size);
-        init_int_array_0(actvscr, max_space_size);
         virt = (int *) malloc(sizeof(int) * max_space_size);
-        virtscr = (int *) malloc(sizeof(int) * max_space_size);
         init_int_array_0(virt, max_space_size);
-        init_int_array_0(virtscr, max_space_size);
 
         /* Loop over electron groupings */
         for (i = 0; i < egrps; i++) {
@@ -570,7 +674,7 @@ void generate_string_list(struct eostring *strlist, int nstr, int orbs,
                 eosp[i].start = count;
                 compute_eostrings(strlist, &count, orbs, ndocc, nactv,
                                   eosp[i].docc, eosp[i].actv, eosp[i].virt,
-                                  docc, actv, virt, doccscr, actvscr, virtscr);
+                                  docc, actv, virt);
                 eosp[i].nstr = count - eosp[i].nstr;
         }
         return;
@@ -694,70 +798,3 @@ int string_number(int nde, int nae, int nve, int ndocc, int nactv, int orbs,
                 binomial_coef2((orbs - (ndocc + nactv)), nve);
         return total;
 }
-
-/*
- * write_determinant_strpairs: write determinant alpha/beta string pairs for
- * valid determinants to file.
- */
-void write_determinant_strpairs(FILE *fptr, int pstart, int pnstr, int qstart,
-                                int qnstr, int *cnt,
-                                struct eostring *pstr, struct eostring *qstr)
-{
-        FILE *ptr; /* New file pointer */
-        int i, j;
-        ptr = fptr;
-        for (i = pstart; i < (pstart + pnstr); i++) {
-                for (j = qstart; j < (qstart + qnstr); j++) {
-                        fprintf(ptr, " %14d %14d\n",
-                                pstr[i].index, qstr[j].index);
-                        (*cnt)++;
-                }
-        }
-        fptr = ptr;
-        return;
-}
-
-/*
- * write_determinant_strpairs_dtlist: write determinant alpha/beta string
- * pairs for valid determinants to dtlist.
- */
-void write_determinant_strpairs_dtlist(int pstart, int pnstr, int qstart,
-                                       int qnstr, struct eostring *pstr,
-                                       struct eostring *qstr, int aelec,
-                                       int belec, int ndocc, int nactv,
-                                       struct det *dlist, int *dptr,
-                                       int cflag)
-{
-        
-        int i, j;
-        int array[4];
-        
-        if (cflag == 1) {
-                for (i = pstart; i < (pstart + pnstr); i++) {
-                        for (j = qstart; j < (qstart + qnstr); j++) {
-                                dlist[*dptr].astr = str2occstr(pstr[i].string,
-                                                               aelec,
-                                                               ndocc, nactv);
-                                dlist[*dptr].bstr = str2occstr(qstr[j].string,
-                                                               belec,
-                                                               ndocc, nactv);
-                                dlist[*dptr].cas = 1;
-                                (*dptr)++;
-                        }
-                }
-        } else {
-                for (i = pstart; i < (pstart + pnstr); i++) {
-                        for (j = qstart; j < (qstart + qnstr); j++) {
-                                dlist[*dptr].astr = str2occstr(pstr[i].string,
-                                                               aelec,
-                                                               ndocc, nactv);
-                                dlist[*dptr].bstr = str2occstr(qstr[j].string,
-                                                               belec,
-                                                               ndocc, nactv);
-                                dlist[*dptr].cas = 0;
-                                (*dptr)++;
-                        }
-                }
-        }
-        return;
-}
@@ -193,14 +193,14 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
         printf("vstr = %d\n", vstr);
         for (i = 1; i <= dstr; i++) {
                 strlist[*pos].doccx = ndocc - docc_elec;
-                str_adr2str(i, doccscr, docc_elec, ndocc, docc);
+                str_adr2str(i, docc_elec, ndocc, docc);
                 for (j = 0; j < docc_elec; j++) {
                         strlist[*pos].string[j] = docc[j];
                 }
                 /* Loop over ACTV strings */
                 for (j = 1; j <= astr; j++) {
                         strlist[*pos].actvx = virt_elec;
-                        str_adr2str(j, actvscr, actv_elec, nactv, actv);
+                        str_adr2str(j, actv_elec, nactv, actv);
                         for (k = 0; k < docc_elec; k++) {
                                 strlist[*pos].string[k] = docc[k];
                         }
@@ -210,7 +210,7 @@ void compute_eostrings(struct eostring *strlist, int *pos, int ci_orbs,
                         if (vstr == 0) (*pos)++;
                         /* Loop over VIRT strings */
                         for (k = 1; k <= vstr; k++) {
-                                str_adr2str(k, virtscr, virt_elec, virt_orbs, virt);
+                                str_adr2str(k, virt_elec, virt_orbs, virt);
                                 for (l = 0; l < docc_elec; l++) {
                                         strlist[*pos].string[l] = docc[l];
                                 }
@@ -252,14 +252,14 @@ void compute_eostrings_sr(struct eostring *strlist, int *pos, int ci_orbs,
         printf("vstr = %d\n", vstr);
         for (i = 1; i <= dstr; i++) {
                 strlist[*pos].doccx = ndocc - docc_elec;
-                str_adr2str(i, doccscr, docc_elec, ndocc, docc);
+                str_adr2str(i, docc_elec, ndocc, docc);
                 for (j = 0; j < docc_elec; j++) {
                         strlist[*pos].string[j] = docc[j];
                 }
                 if (vstr == 0) (*pos)++;
                 /* Loop over VIRT strings */
                 for (k = 1; k <= vstr; k++) {
-                        str_adr2str(k, virtscr, virt_elec, virt_orbs, virt);
+                        str_adr2str(k, virt_elec, virt_orbs, virt);
                         for (l = 0; l < docc_elec; l++) {
                                 strlist[*pos].string[l] = docc[l];
                         }
@@ -505,7 +505,7 @@ int generate_actv_strings(int **qactv_array, int nstr, int nactv, int elecs,
         scr = (int *) malloc(sizeof(int) * maxelecs);
         for (i = minelecs; i <= maxelecs; i++) {
                 for (j = 1; j <= binomial_coef2(nactv, i); j++) {
-                        str_adr2str(j, scr, i, nactv, qactv_array[cnt]);
+                        str_adr2str(j, i, nactv, qactv_array[cnt]);
                         cnt++;
                 }
         }
@@ -528,7 +528,7 @@ int generate_docc_strings(int **qdocc_array, int nstr, int orbs, int elec,
         scr = (int *) malloc(sizeof(int) * elec);
         for (i = 0; i <= maxholes; i++) {
                 for (j = 1; j <= binomial_coef2(orbs, (elec - i)); j++) {
-                        str_adr2str(j, scr, (elec - i), orbs, qdocc_array[cnt]);
+                        str_adr2str(j, (elec - i), orbs, qdocc_array[cnt]);
                         cnt++;
                 }
         }
@@ -553,7 +553,7 @@ int generate_virt_strings(int **virt_array, int nstr, int orbs, int elec,
         scr = (int *) malloc(sizeof(int) * xlvl);
         for (i = 0; i <= xlvl; i++) {
                 for (j = 1; j <= binomial_coef2(virt_orbs, i); j++) {
-                        str_adr2str(j, scr, i, virt_orbs, virt_array[cnt]);
+                        str_adr2str(j, i, virt_orbs, virt_array[cnt]);
                         cnt++;
                 }
         }
@@ -9,6 +9,7 @@
  *  dvdalg: main davidson algorithm driver.
  *  make_subspacehmat: build subspace hamiltonian matrix, v.Hv
  *  perform_hv_initspace: perform Hv=c for all v in current space.
+ *  generate_newvector: build preconditioned correction vector.
  */
 
 #include <stdio.h>
@@ -24,6 +25,8 @@
 #include "mathutil.h"
 #include "initguess_sbd.h"
 #include "initguess_roldv.h"
+#include "prediagfcns.h"
+#include "iminmax.h"
 #include "davidson.h"
 
 /*
@@ -86,13 +89,16 @@ int diag_subspacehmat(double **hmat, double **hevec, double *heval, int dim,
  * predr = prediagonalization routine
  * plvl = print level
  * norbs = total number of CI orbitals
- * refdim = reference space size of prediag routine
+ * refdim = reference space size of prediag routine (and of the
+ *          PRECOND_BLOCK block)
+ * pctype = correction vector preconditioner, PRECOND_*
+ * pcshift = preconditioner level shift
  */
 int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 	   int aelec, int belec, double *hdgls, int ninto, double totfrze,
 	   int maxiter, int krymin, int krymax, int nroots, double restol,
-	   struct rowmap *hmap, double **civec, double *cival, int predr,
-	   int plvl, int norbs, int refdim)
+	   struct cimap *hmap, double **civec, double *cival, int predr,
+	   int plvl, int norbs, int refdim, int pctype, double pcshift)
 {
 	int error = 0; /* error flag */
 	int cflag = 0; /* convergence flag */
@@ -109,6 +115,9 @@ int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 	double *heval = NULL; /* krylov eigenvalues array */
 	double *rvec = NULL; /* residual vector: Hv - (v.Hv)c = r */
 	double *nvec = NULL; /* new vector */
+	double *xvec = NULL; /* Ritz vector (Olsen preconditioner) */
+	struct precond pc; /* correction vector preconditioner */
+	int nfloor = 0; /* floored preconditioner denominators */
 	double rnorm = 0.0; /* norm of residual vector */
 	int croot = 0; /* current root solving for {1..nroot} */
 	int ckdim = 0; /* current dimension of krylov space */
@@ -168,6 +177,18 @@ int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 		error_flag(error, "dvdalg");
 		return error;
 	}
+
+	/* Set up the correction vector preconditioner. */
+	error = init_precond(&pc, pctype, pcshift, refdim, dlist, ndets,
+			     moints1, moints2, aelec, belec, hdgls, ninto);
+	if (error != 0) {
+		error_flag(error, "dvdalg");
+		return error;
+	}
+	if (pc.type == PRECOND_OLSEN) {
+		xvec = (double *) malloc(ndets * sizeof(double));
+	}
+	print_precond_info(&pc);
 	
 	/* Main Loop */
 	citer = 1;
@@ -176,8 +197,13 @@ int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 	while (citer < maxiter && croot <= nroots) {
 		/* Perform Hv=c on all basis vectors v. Then build the subspace
 		 * Hamiltonian v.Hv = v.c */
-		perform_hv_initspace(dlist, ndets, moints1, moints2, aelec,
-				     belec, ninto, hmap, ckdim, vscr, cscr);
+		error = perform_hv_initspace(dlist, ndets, moints1, moints2,
+					     aelec, belec, ninto, hmap, ckdim,
+					     vscr, cscr);
+		if (error != 0) {
+			error_flag(error, "dvdalg");
+			return error;
+		}
 		make_subspacehmat(vscr, cscr, ndets, ckdim, hscr);
 		if (plvl > 3) {
 			fprintf(stdout, "\n Subspace hamiltonian:\n");
@@ -221,18 +247,31 @@ int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 			}
 			
 			/* generate new vector to add to space */
-			generate_newvector(rvec, hdgls, heval[croot - 1],
-					   ndets, nvec);
-                        double nvecnrm = compute_vector_norm(nvec, ndets);
-                        printf("New vec norm = %15.8lf\n", nvecnrm);
+			if (pc.type == PRECOND_OLSEN) {
+				generate_ritzvector(vscr, ndets, ckdim, hevec,
+						    croot, xvec);
+			}
+			nfloor = generate_newvector(rvec, hdgls,
+						    heval[croot - 1], ndets,
+						    nvec, xvec, &pc);
+			if (plvl > 1) {
+				fprintf(stdout, "New vec norm = %15.8lf  "
+					"floored = %d\n",
+					compute_vector_norm(nvec, ndets),
+					nfloor);
+			}
 			orthonormalize_vector(vscr, ckdim, ndets, nvec);
                         append_vector_to_space(vscr, ckdim, ndets, nvec);
 			ckdim++;
 			
 			/* compute Hv=c for new vector */
-			compute_hv(dlist, ndets, moints1, moints2, aelec,
-				   belec, vscr[ckdim - 1], cscr[ckdim - 1],
-				   ninto, hmap);
+			error = compute_hv(dlist, ndets, moints1, moints2,
+					   aelec, belec, vscr[ckdim - 1],
+					   cscr[ckdim - 1], ninto, hmap);
+			if (error != 0) {
+				error_flag(error, "dvdalg");
+				return error;
+			}
 			/* make subspace hamiltonian */
 			make_subspacehmat(vscr, cscr, ndets, ckdim, hscr);
 			if (plvl > 3) {
@@ -264,6 +303,7 @@ int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 		init_dbl_2darray_0(cscr, ndets, krymax);
 	}
 	fprintf(stdout, " Davidson algorithm finished.\n");
+	fprintf(stdout, " Davidson iterations: %d\n", citer);
 	/* copy arrays into final vectors, civec and cival */
 	cparray_1d1d(heval, ckdim, cival, nroots);
 	for (i = 0; i < nroots; i++) {
@@ -274,6 +314,8 @@ int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 	free(heval);
 	free(rvec);
 	free(nvec);
+	free(xvec);
+	free_precond(&pc);
 	free(hscr_1d);
 	free(hevec_1d);
 	free(vscr_1d);
@@ -287,15 +329,119 @@ int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 	return error;
 }
 
+/*
+ * free_precond: deallocate preconditioner arrays.
+ */
+void free_precond(struct precond *pc)
+{
+	free(pc->bidx);
+	free(pc->bvec);
+	free(pc->bval);
+	free(pc->bscr);
+	pc->bidx = NULL;
+	pc->bvec = NULL;
+	pc->bval = NULL;
+	pc->bscr = NULL;
+	pc->dim = 0;
+	return;
+}
+
+/*
+ * precond_denom: shifted denominator H(i,i) - E + shift, with its
+ * magnitude kept above PRECOND_FLOOR. nfloor counts floored values.
+ */
+double precond_denom(double dgl, double eval, double shift, int *nfloor)
+{
+	double den = dgl - eval + shift;
+	if (fabs(den) < PRECOND_FLOOR) {
+		den = (den < 0.0 ? -PRECOND_FLOOR : PRECOND_FLOOR);
+		if (nfloor != NULL) (*nfloor)++;
+	}
+	return den;
+}
+
 /*
  * generate_newvector: build correction vector.
+ *  PRECOND_DIAG:  n(i) = -r(i) / (H(i,i) - E)
+ *  PRECOND_SHIFT: n(i) = -r(i) / (H(i,i) - E + shift), |denominator|
+ *                 kept above PRECOND_FLOOR
+ *  PRECOND_OLSEN: n = -D^-1 (r - eps x), eps = (x,D^-1 r)/(x,D^-1 x),
+ *                 with D the shifted diagonal and x the Ritz vector
+ *  PRECOND_BLOCK: n(P) = -(H(P,P) - E + shift)^-1 r(P) on the block P of
+ *                 lowest H(i,i), shifted diagonal elsewhere
+ * Returns the number of denominators that were floored.
  */
-void generate_newvector(double *rvec, double *dgls, double eval, int ndets,
-			double *nvec)
+int generate_newvector(double *rvec, double *dgls, double eval, int ndets,
+		       double *nvec, double *xvec, struct precond *pc)
 {
-	int i;
+	double xdr = 0.0, xdx = 0.0, eps = 0.0;
+	double den = 0.0;
+	int nfloor = 0;
+	int i, j, k;
+
+	if (pc->type == PRECOND_DIAG) {
+		for (i = 0; i < ndets; i++) {
+			nvec[i] = (-1.0) * rvec[i] / (dgls[i] - eval);
+		}
+		return nfloor;
+	}
+
+	/* Shifted, floored diagonal. */
 	for (i = 0; i < ndets; i++) {
-		nvec[i] = (-1.0) * rvec[i] / (dgls[i] - eval);
+		den = precond_denom(dgls[i], eval, pc->shift, &nfloor);
+		nvec[i] = (-1.0) * rvec[i] / den;
+	}
+
+	if (pc->type == PRECOND_OLSEN) {
+		/* nvec = -D^-1 r. Add back eps * D^-1 x. */
+		for (i = 0; i < ndets; i++) {
+			den = precond_denom(dgls[i], eval, pc->shift, NULL);
+			xdr += xvec[i] * rvec[i] / den;
+			xdx += xvec[i] * xvec[i] / den;
+		}
+		eps = xdr / xdx;
+		for (i = 0; i < ndets; i++) {
+			den = precond_denom(dgls[i], eval, pc->shift, NULL);
+			nvec[i] += eps * xvec[i] / den;
+		}
+	} else if (pc->type == PRECOND_BLOCK) {
+		/* (H(P,P) - E + shift)^-1 = U (L - E + shift)^-1 U^T */
+		for (k = 0; k < pc->dim; k++) {
+			pc->bscr[k] = 0.0;
+			for (j = 0; j < pc->dim; j++) {
+				pc->bscr[k] += pc->bvec[(k * pc->dim) + j] *
+					rvec[pc->bidx[j]];
+			}
+			den = precond_denom(pc->bval[k], eval, pc->shift,
+					    &nfloor);
+			pc->bscr[k] = pc->bscr[k] / den;
+		}
+		for (j = 0; j < pc->dim; j++) {
+			nvec[pc->bidx[j]] = 0.0;
+			for (k = 0; k < pc->dim; k++) {
+				nvec[pc->bidx[j]] -= pc->bvec[(k * pc->dim) + j] *
+					pc->bscr[k];
+			}
+		}
+	}
+	return nfloor;
+}
+
+/*
+ * generate_ritzvector: build the current root's Ritz vector,
+ *  x(i) = sum_j hevec[croot-1][j] * v[j][i]
+ */
+void generate_ritzvector(double **vvecs, int ndets, int nvec,
+			 double **hevec, int croot, double *xvec)
+{
+	int i, j;
+	int root_id;
+	root_id = croot - 1;
+	init_dbl_array_0(xvec, ndets);
+	for (j = 0; j < nvec; j++) {
+		for (i = 0; i < ndets; i++) {
+			xvec[i] += hevec[root_id][j] * vvecs[j][i];
+		}
 	}
 	return;
 }
@@ -333,6 +479,66 @@ void generate_residual(double **vvecs, double **cvecs, int ndets, int nvec,
 	return;
 }
 
+/*
+ * init_precond: set up the correction vector preconditioner. For
+ * PRECOND_BLOCK, the dim determinants of lowest <i|H|i> are chosen and
+ * H(P,P) is diagonalized once; each iteration then only needs U^T r(P).
+ */
+int init_precond(struct precond *pc, int type, double shift, int dim,
+		 struct det *dlist, int ndets, double *moints1,
+		 double *moints2, int aelec, int belec, double *hdgls,
+		 int ninto)
+{
+	double *hmat = NULL; /* H(P,P) */
+	int error = 0;
+
+	pc->type  = type;
+	pc->shift = shift;
+	pc->dim   = 0;
+	pc->bidx  = NULL;
+	pc->bvec  = NULL;
+	pc->bval  = NULL;
+	pc->bscr  = NULL;
+	if (type < PRECOND_DIAG || type > PRECOND_BLOCK) {
+		error = type;
+		fprintf(stderr, "Unknown preconditioner: %d\n", type);
+		error_flag(error, "init_precond");
+		return error;
+	}
+	if (type != PRECOND_BLOCK) return error;
+
+	pc->dim  = int_min(dim, ndets);
+	pc->bidx = (int *) malloc(pc->dim * sizeof(int));
+	pc->bvec = (double *) malloc(pc->dim * pc->dim * sizeof(double));
+	pc->bval = (double *) malloc(pc->dim * sizeof(double));
+	pc->bscr = (double *) malloc(pc->dim * sizeof(double));
+	hmat = (double *) malloc(pc->dim * pc->dim * sizeof(double));
+	if (pc->bidx == NULL || pc->bvec == NULL || pc->bval == NULL ||
+	    pc->bscr == NULL || hmat == NULL) {
+		error = 1;
+		error_flag(error, "init_precond");
+		goto cleanup;
+	}
+
+	error = select_refdets(hdgls, ndets, pc->dim, pc->bidx);
+	if (error != 0) {
+		error_flag(error, "init_precond");
+		goto cleanup;
+	}
+	build_refblock(dlist, pc->bidx, pc->dim, moints1, moints2, aelec,
+		       belec, ninto, hmat);
+	error = diagmat_dsyevr(hmat, pc->dim, pc->bvec, pc->bval);
+	if (error != 0) {
+		error_flag(error, "init_precond");
+		goto cleanup;
+	}
+
+cleanup:
+	free(hmat);
+	if (error != 0) free_precond(pc);
+	return error;
+}
+
 /*
  * make_subspacehmat: build krylov space hamiltonian v.Hv.
  */
@@ -350,25 +556,53 @@ void make_subspacehmat(double **v, double **hv, int ndets, int ckdim,
 }
 
 /*
- * perform_hv_initspace: perform hv on inital vectors.
+ * perform_hv_initspace: perform hv on inital vectors. All vectors are
+ * done in one pass over H, with v and c interleaved so that each <i|H|j>
+ * is applied to every vector at once. The interleaved copies take
+ * 2 x ndets x nvec doubles; if they cannot be allocated the vectors are
+ * done one at a time.
+ * Returns 0, or 1 if Hv scratch could not be allocated.
  */
-void perform_hv_initspace(struct det *dlist, int ndets, double *moints1,
-			  double *moints2, int aelec, int belec, int ninto,
-			  struct rowmap *hmap, int nvec, double **vecs,
-			  double **hvecs)
+int perform_hv_initspace(struct det *dlist, int ndets, double *moints1,
+			 double *moints2, int aelec, int belec, int ninto,
+			 struct cimap *hmap, int nvec, double **vecs,
+			 double **hvecs)
 {
-	int i;
-	
-	/* Loop over vectors */
-	for (i = 0; i < nvec; i++) {
-		compute_hv(dlist, ndets, moints1, moints2, aelec, belec, vecs[i],
-                           hvecs[i], ninto, hmap);
+	int i, j;
+	int error = 0;
+	double *vi = NULL; /* interleaved v */
+	double *ci = NULL; /* interleaved c */
+
+	vi = (double *) malloc((size_t) ndets * nvec * sizeof(double));
+	ci = (double *) malloc((size_t) ndets * nvec * sizeof(double));
+	if (vi == NULL || ci == NULL) {
+		/* Not enough memory: one vector at a time */
+		free(vi);
+		free(ci);
+		for (i = 0; i < nvec && error == 0; i++) {
+			error = compute_hv(dlist, ndets, moints1, moints2,
+					   aelec, belec, vecs[i], hvecs[i],
+					   ninto, hmap);
+		}
+	} else {
+		for (i = 0; i < ndets; i++) {
+			for (j = 0; j < nvec; j++) {
+				vi[(size_t) i * nvec + j] = vecs[j][i];
+				ci[(size_t) i * nvec + j] = hvecs[j][i];
+			}
+		}
+		error = compute_hv_multi(dlist, ndets, moints1, moints2,
+					 aelec, belec, vi, ci, nvec, ninto,
+					 hmap);
+		for (i = 0; i < ndets; i++) {
+			for (j = 0; j < nvec; j++) {
+				hvecs[j][i] = ci[(size_t) i * nvec + j];
+			}
+		}
+		free(vi);
+		free(ci);
 	}
-        printf("      V            C\n");
-        for (i = 0; i < 21; i++) {
-                printf("%14.5lf%14.5lf\n", vecs[1][i], hvecs[1][i]);
-        }
-	return;
+	return error;
 }
 
 /*
@@ -401,6 +635,32 @@ void print_iteration_info(double *heval, int ckdim, int croot, double rnorm,
         return;
 }
 
+/*
+ * print_precond_info: print the correction vector preconditioner.
+ */
+void print_precond_info(struct precond *pc)
+{
+	switch (pc->type) {
+	case PRECOND_DIAG:
+		fprintf(stdout, " Preconditioner: diagonal\n");
+		break;
+	case PRECOND_SHIFT:
+		fprintf(stdout, " Preconditioner: shifted diagonal");
+		fprintf(stdout, " (shift = %10.5lf)\n", pc->shift);
+		break;
+	case PRECOND_OLSEN:
+		fprintf(stdout, " Preconditioner: Olsen");
+		fprintf(stdout, " (shift = %10.5lf)\n", pc->shift);
+		break;
+	case PRECOND_BLOCK:
+		fprintf(stdout, " Preconditioner: block inverse, %d dets",
+			pc->dim);
+		fprintf(stdout, " (shift = %10.5lf)\n", pc->shift);
+		break;
+	}
+	return;
+}
+
 /*
  * test_convergence: test convergence of davidson algorithm. returns
  * convergence flag.
@@ -3,6 +3,10 @@
  * Functions to compute dyson orbital.
  * comparedets_dyson
  * compute_dyson_orbitals
+ *
+ * The N electron determinants are indexed in a hash table keyed by their
+ * alpha and beta strings, so each N+1 electron determinant only visits
+ * the determinants reached by annihilating one of its electrons.
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,6 +18,30 @@
 #include "action_util.h"
 #include "dysoncomp.h"
 
+/* dethash: open-addressing hash index of a determinant list, keyed by the
+ * alpha and beta strings. */
+struct dethash {
+        unsigned long long mask; /* table size - 1 (size is a power of 2) */
+        int *slot;               /* determinant index, or -1 if empty */
+        struct det *dlist;       /* indexed determinants */
+};
+
+#define DYSON_ANNIHILATE_ALPHA 1
+#define DYSON_ANNIHILATE_BETA  2
+
+static unsigned long long hash_occstr(struct occstr s, unsigned long long h);
+static unsigned long long hash_det(struct occstr a, struct occstr b);
+static int equal_occstr(struct occstr s1, struct occstr s2);
+static int build_dethash(struct det *dlist, int ndets, struct dethash *ht);
+static int lookup_dethash(struct occstr a, struct occstr b,
+                          struct dethash *ht);
+static int annihilate_occstr(struct occstr s, int n, struct occstr *t);
+static void compute_dyson_orbital_hashed(struct det *dlist0, double *civec0,
+                                         int ndets0, struct det *dlist1,
+                                         double *civec1, int ndets1,
+                                         int orbs, double *dysonorb,
+                                         int spins);
+
 /*
  * compute_dyson_orbital: compute the dyson orbital between one N+1 electron
  * wavefunction and on N electron wavefunction.
@@ -22,61 +50,15 @@ void compute_dyson_orbital(struct det *dlist0, double *civec0, int ndets0,
                            struct det *dlist1, double *civec1, int ndets1,
                            int orbs, double *dysonorb)
 {
-        int i = 0, j = 0;
-        int ndiff = 0; /* number of differences */
-        int orbindx = 0; /* orbital index of contribution */
-
-#ifdef DEBUGGING
-        char str1[65];
-        char str2[65];
-#endif
-        
-        /* Loop over determinants. N electrons must be in the same slots
-         * for both determinants. The N+1 electron, in a unique slot, is
-         * the MO index for which the matrix element contributes to the
-         * dyson orbital. */
-        for (i = 0; i < ndets0; i++) {
-                for (j = 0; j < ndets1; j++) {
-                        /* Compare N and N+1 electron determinants */
-                        orbindx = comparedets_dyson(dlist0[i],dlist1[j]);
-                        if (orbindx == 0) continue;
-#ifdef DEBUGGING
-                        printf(" -----------------------------------\n");
-                        printf(" Matrix element = < %d | %d >\n", (i+1), (j+1));
-                        llint2bin(dlist0[i].astr.byte1, str1);
-                        llint2bin(dlist1[j].astr.byte1, str2);
-                        printf(" Alpha strings: \n");
-                        printf("   %s\n", str1);
-                        printf("   %s\n", str2);
-                        printf("  Virtual orbitals: \n");
-                        printf("   %d  %d\n", dlist0[i].astr.virtx[0],
-                               dlist0[i].astr.virtx[1]);
-                        printf("   %d  %d\n", dlist1[j].astr.virtx[0],
-                               dlist1[j].astr.virtx[1]);
-                        llint2bin(dlist0[i].bstr.byte1, str1);
-                        llint2bin(dlist1[j].bstr.byte1, str2);
-                        printf(" Beta  strings: \n");
-                        printf("   %s\n", str1);
-                        printf("   %s\n", str2);
-                        printf("  Virtual orbitals: \n");
-                        printf("   %d  %d\n", dlist0[i].bstr.virtx[0],
-                               dlist0[i].bstr.virtx[1]);
-                        printf("   %d  %d\n", dlist1[j].bstr.virtx[0],
-                               dlist1[j].bstr.virtx[1]);
-                        printf("\n");
-                        printf(" Orbital index = %d\n", orbindx);
-                        printf(" -----------------------------------\n");
-#endif
-
-                        dysonorb[(orbindx - 1)] = civec0[i]*civec1[j];
-                }
-        }
+        int i;
+        compute_dyson_orbital_hashed(dlist0, civec0, ndets0, dlist1, civec1,
+                                     ndets1, orbs, dysonorb,
+                                     (DYSON_ANNIHILATE_ALPHA |
+                                      DYSON_ANNIHILATE_BETA));
         printf(" Dyson orbital:\n");
         for (i = 0; i < orbs; i++) {
                 printf(" %14.8lf\n", dysonorb[i]);
         }
-        
-                
         return;
 }
 
@@ -89,61 +71,14 @@ void compute_dyson_orbital_beq(struct det *dlist0, double *civec0, int ndets0,
                                struct det *dlist1, double *civec1, int ndets1,
                                int orbs, double *dysonorb)
 {
-        int i = 0, j = 0;
-        int ndiff = 0; /* number of differences */
-        int orbindx = 0; /* orbital index of contribution */
-
-#ifdef DEBUGGING
-        char str1[65];
-        char str2[65];
-#endif
-        
-        /* Loop over determinants. N electrons must be in the same slots
-         * for both determinants. The N+1 electron, in a unique slot, is
-         * the MO index for which the matrix element contributes to the
-         * dyson orbital. */
-        for (i = 0; i < ndets0; i++) {
-                for (j = 0; j < ndets1; j++) {
-                        /* Compare N and N+1 electron determinants */
-                        orbindx = comparedets_dyson_beq(dlist0[i],dlist1[j]);
-                        if (orbindx == 0) continue;
-#ifdef DEBUGGING
-                        printf(" ----------- POST EVAL -------------\n");
-                        printf(" Matrix element = < %d | %d >\n", (i+1), (j+1));
-                        llint2bin(dlist0[i].astr.byte1, str1);
-                        llint2bin(dlist1[j].astr.byte1, str2);
-                        printf(" Alpha strings: \n");
-                        printf("   %s\n", str1);
-                        printf("   %s\n", str2);
-                        printf("  Virtual orbitals: \n");
-                        printf("   %d  %d\n", dlist0[i].astr.virtx[0],
-                               dlist0[i].astr.virtx[1]);
-                        printf("   %d  %d\n", dlist1[j].astr.virtx[0],
-                               dlist1[j].astr.virtx[1]);
-                        llint2bin(dlist0[i].bstr.byte1, str1);
-                        llint2bin(dlist1[j].bstr.byte1, str2);
-                        printf(" Beta  strings: \n");
-                        printf("   %s\n", str1);
-                        printf("   %s\n", str2);
-                        printf("  Virtual orbitals: \n");
-                        printf("   %d  %d\n", dlist0[i].bstr.virtx[0],
-                               dlist0[i].bstr.virtx[1]);
-                        printf("   %d  %d\n", dlist1[j].bstr.virtx[0],
-                               dlist1[j].bstr.virtx[1]);
-                        printf("\n");
-                        printf(" Orbital index = %d\n", orbindx);
-                        printf(" -----------------------------------\n");
-#endif
-
-                        dysonorb[(orbindx - 1)] = civec0[i]*civec1[j];
-                }
-        }
+        int i;
+        compute_dyson_orbital_hashed(dlist0, civec0, ndets0, dlist1, civec1,
+                                     ndets1, orbs, dysonorb,
+                                     DYSON_ANNIHILATE_ALPHA);
         printf(" Dyson orbital:\n");
         for (i = 0; i < orbs; i++) {
                 printf(" %14.8lf\n", dysonorb[i]);
         }
-        
-                
         return;
 }
 
@@ -156,64 +91,197 @@ void compute_dyson_orbital_aeq(struct det *dlist0, double *civec0, int ndets0,
                                struct det *dlist1, double *civec1, int ndets1,
                                int orbs, double *dysonorb)
 {
-        int i = 0, j = 0;
-        int ndiff = 0; /* number of differences */
-        int orbindx = 0; /* orbital index of contribution */
-
-#ifdef DEBUGGING
-        char str1[65];
-        char str2[65];
-#endif
-        
-        /* Loop over determinants. N electrons must be in the same slots
-         * for both determinants. The N+1 electron, in a unique slot, is
-         * the MO index for which the matrix element contributes to the
-         * dyson orbital. */
-        for (i = 0; i < ndets0; i++) {
-                for (j = 0; j < ndets1; j++) {
-                        /* Compare N and N+1 electron determinants */
-                        orbindx = comparedets_dyson_aeq(dlist0[i],dlist1[j]);
-                        if (orbindx == 0) continue;
-#ifdef DEBUGGING
-                        printf(" -----------------------------------\n");
-                        printf(" Matrix element = < %d | %d >\n", (i+1), (j+1));
-                        llint2bin(dlist0[i].astr.byte1, str1);
-                        llint2bin(dlist1[j].astr.byte1, str2);
-                        printf(" Alpha strings: \n");
-                        printf("   %s\n", str1);
-                        printf("   %s\n", str2);
-                        printf("  Virtual orbitals: \n");
-                        printf("   %d  %d\n", dlist0[i].astr.virtx[0],
-                               dlist0[i].astr.virtx[1]);
-                        printf("   %d  %d\n", dlist1[j].astr.virtx[0],
-                               dlist1[j].astr.virtx[1]);
-                        llint2bin(dlist0[i].bstr.byte1, str1);
-                        llint2bin(dlist1[j].bstr.byte1, str2);
-                        printf(" Beta  strings: \n");
-                        printf("   %s\n", str1);
-                        printf("   %s\n", str2);
-                        printf("  Virtual orbitals: \n");
-                        printf("   %d  %d\n", dlist0[i].bstr.virtx[0],
-                               dlist0[i].bstr.virtx[1]);
-                        printf("   %d  %d\n", dlist1[j].bstr.virtx[0],
-                               dlist1[j].bstr.virtx[1]);
-                        printf("\n");
-                        printf(" Orbital index = %d\n", orbindx);
-                        printf(" -----------------------------------\n");
-#endif
-
-                        dysonorb[(orbindx - 1)] = civec0[i]*civec1[j];
-                }
-        }
+        int i;
+        compute_dyson_orbital_hashed(dlist0, civec0, ndets0, dlist1, civec1,
+                                     ndets1, orbs, dysonorb,
+                                     DYSON_ANNIHILATE_BETA);
         printf(" Dyson orbital:\n");
         for (i = 0; i < orbs; i++) {
                 printf(" %14.8lf\n", dysonorb[i]);
         }
-        
-                
         return;
 }
 
+/*
+ * compute_dyson_orbital_hashed: accumulate dyson orbital contributions
+ * c0(i) * c1(j) for every N+1 electron determinant i and N electron
+ * determinant j = a_p i. The N electron determinants are hashed by their
+ * strings; each j is found by annihilating every occupied orbital p of i
+ * (alpha and/or beta, as given by spins) and looking up the result.
+ * Cost is O(ndets0 * nelec) rather than O(ndets0 * ndets1).
+ */
+static void compute_dyson_orbital_hashed(struct det *dlist0, double *civec0,
+                                         int ndets0, struct det *dlist1,
+                                         double *civec1, int ndets1,
+                                         int orbs, double *dysonorb,
+                                         int spins)
+{
+        struct dethash ht;
+        struct occstr nstr;  /* N electron string */
+        int i, j, k, p;
+
+        if (build_dethash(dlist1, ndets1, &ht) != 0) {
+                error_message("Could not allocate hash table.",
+                              "compute_dyson_orbital");
+                return;
+        }
+
+#pragma omp parallel for schedule(dynamic, 256) default(none)      \
+        shared(dlist0, civec0, ndets0, civec1, spins, ht)          \
+        private(i, j, k, p, nstr)                                  \
+        reduction(+:dysonorb[:orbs])
+        for (i = 0; i < ndets0; i++) {
+                /* Annihilate alpha electrons */
+                if (spins & DYSON_ANNIHILATE_ALPHA) {
+                        k = 0;
+                        while ((p = annihilate_occstr(dlist0[i].astr, k,
+                                                      &nstr)) != 0) {
+                                k++;
+                                j = lookup_dethash(nstr, dlist0[i].bstr, &ht);
+                                if (j < 0) continue;
+                                dysonorb[p - 1] += civec0[i] * civec1[j];
+                        }
+                }
+                /* Annihilate beta electrons */
+                if (spins & DYSON_ANNIHILATE_BETA) {
+                        k = 0;
+                        while ((p = annihilate_occstr(dlist0[i].bstr, k,
+                                                      &nstr)) != 0) {
+                                k++;
+                                j = lookup_dethash(dlist0[i].astr, nstr, &ht);
+                                if (j < 0) continue;
+                                dysonorb[p - 1] += civec0[i] * civec1[j];
+                        }
+                }
+        }
+
+        free(ht.slot);
+        return;
+}
+
+/*
+ * annihilate_occstr: remove the n-th occupied orbital (n = 0, 1, ...) of
+ * string s, returning the new string in t. Internal orbitals are counted
+ * first, then virtual orbitals.
+ * Returns the orbital removed (1, 2, ...), or 0 if s has fewer than n+1
+ * electrons.
+ */
+static int annihilate_occstr(struct occstr s, int n, struct occstr *t)
+{
+        int b, k, v;
+        long long int bits;
+
+        *t = s;
+        /* Internal orbitals 1 -> 64 */
+        bits = s.byte1;
+        for (b = 0; b < 64 && bits != 0; b++) {
+                if ((bits >> b) & 0x1) {
+                        if (n == 0) {
+                                t->byte1 = s.byte1 & ~(1LL << b);
+                                return (b + 1);
+                        }
+                        n--;
+                }
+        }
+        /* Internal orbitals 65 -> 128 */
+        bits = s.byte2;
+        for (b = 0; b < 64 && bits != 0; b++) {
+                if ((bits >> b) & 0x1) {
+                        if (n == 0) {
+                                t->byte2 = s.byte2 & ~(1LL << b);
+                                return (b + 65);
+                        }
+                        n--;
+                }
+        }
+        /* Virtual orbitals */
+        if (n >= s.nvrtx) return 0;
+        v = 0;
+        for (k = 0; k < s.nvrtx; k++) {
+                if (k == n) continue;
+                t->virtx[v] = s.virtx[k];
+                v++;
+        }
+        for (k = v; k < 2; k++) t->virtx[k] = 0;
+        t->nvrtx = s.nvrtx - 1;
+        return s.virtx[n];
+}
+
+/*
+ * hash_occstr: fold string s into hash h (FNV-1a style).
+ */
+static unsigned long long hash_occstr(struct occstr s, unsigned long long h)
+{
+        int k;
+        h = (h ^ (unsigned long long) s.byte1) * 0x100000001b3ULL;
+        h = (h ^ (unsigned long long) s.byte2) * 0x100000001b3ULL;
+        for (k = 0; k < s.nvrtx; k++) {
+                h = (h ^ (unsigned long long) s.virtx[k]) * 0x100000001b3ULL;
+        }
+        h = (h ^ (unsigned long long) s.nvrtx) * 0x100000001b3ULL;
+        return h;
+}
+
+static unsigned long long hash_det(struct occstr a, struct occstr b)
+{
+        unsigned long long h = 0xcbf29ce484222325ULL;
+        h = hash_occstr(a, h);
+        h = hash_occstr(b, h);
+        return (h ^ (h >> 29));
+}
+
+/*
+ * equal_occstr: return 1 if strings s1 and s2 are equal.
+ */
+static int equal_occstr(struct occstr s1, struct occstr s2)
+{
+        int k;
+        if (s1.byte1 != s2.byte1 || s1.byte2 != s2.byte2) return 0;
+        if (s1.nvrtx != s2.nvrtx) return 0;
+        for (k = 0; k < s1.nvrtx; k++) {
+                if (s1.virtx[k] != s2.virtx[k]) return 0;
+        }
+        return 1;
+}
+
+/*
+ * build_dethash: build hash index of determinant list.
+ */
+static int build_dethash(struct det *dlist, int ndets, struct dethash *ht)
+{
+        unsigned long long size = 16, h;
+        int i;
+
+        while (size < 2ULL * ndets) size = size * 2;
+        ht->mask = size - 1;
+        ht->dlist = dlist;
+        ht->slot = (int *) malloc(size * sizeof(int));
+        if (ht->slot == NULL) return 1;
+        for (h = 0; h < size; h++) ht->slot[h] = -1;
+        for (i = 0; i < ndets; i++) {
+                h = hash_det(dlist[i].astr, dlist[i].bstr) & ht->mask;
+                while (ht->slot[h] != -1) h = (h + 1) & ht->mask;
+                ht->slot[h] = i;
+        }
+        return 0;
+}
+
+/*
+ * lookup_dethash: return index of determinant with strings (a, b), or -1.
+ */
+static int lookup_dethash(struct occstr a, struct occstr b, struct dethash *ht)
+{
+        unsigned long long h;
+        int j;
+        h = hash_det(a, b) & ht->mask;
+        while ((j = ht->slot[h]) != -1) {
+                if (equal_occstr(ht->dlist[j].astr, a) &&
+                    equal_occstr(ht->dlist[j].bstr, b)) return j;
+                h = (h + 1) & ht->mask;
+        }
+        return -1;
+}
+
 /*
  * comparedets_dyson: compare two determinants for computation of dyson
  * orbital.
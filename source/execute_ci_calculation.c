@@ -40,12 +40,16 @@ int execute_ci_calculation(int aelec, int belec, int orbs, int nastr, int nbstr,
 	int prediag_routine = 0; /* prediagonalization routine */
 	int refdim = 0; /* prediagonalization reference space */
 	double restol = 0.0; /* residual norm converegence tolerance */
+	int hcachemb = 0; /* memory limit (MB) for in-core H */
+	int hcachesp = 0; /* 1 = in-core H in single precision */
+	int precond = 0; /* correction vector preconditioner */
+	double pcshift = 0.0; /* preconditioner level shift */
 	
 	struct det *detlist = NULL; /* determinant list */
 	double *hdgls = NULL; /* diagonal elements of hamiltonian */
 	double **civec = NULL; /* final CI eigenvectors */
 	double *cival = NULL; /* final ci eigenvalues */
-	struct rowmap *hmap = NULL; /* valid <i|H|j> combinations */
+	struct cimap *hmap = NULL; /* valid <i|H|j> combinations */
 
         int i;
         
@@ -61,7 +65,8 @@ int execute_ci_calculation(int aelec, int belec, int orbs, int nastr, int nbstr,
 	
 	/* Read &dgalinfo namelist. */
 	readdaiinput(&maxiter, &krymin, &krymax, &nroots, &prediag_routine,
-		     &refdim, &restol, &error);
+		     &refdim, &restol, &hcachemb, &precond, &pcshift,
+		     &hcachesp, &error);
 	if (error != 0) {
 		error_flag(error, "execute_ci_calculation");
 		return error;
@@ -91,8 +96,8 @@ int execute_ci_calculation(int aelec, int belec, int orbs, int nastr, int nbstr,
 	/* Generate CI map of valid determinants. */
 	prev_time = clock();
 	if (plvl > 0) fprintf(stdout, " Generating cimap.\n");
-	hmap = (struct rowmap *) malloc(ndets * sizeof(struct rowmap));
-	error = generate_cimap(detlist, ndets, ninto, hmap);
+	hmap = (struct cimap *) malloc(sizeof(struct cimap));
+	error = generate_cimap(detlist, ndets, hmap);
 	if (error != 0) {
 		error_flag(error, "execute_ci_calculation");
 		return error;
@@ -101,6 +106,10 @@ int execute_ci_calculation(int aelec, int belec, int orbs, int nastr, int nbstr,
 	if (plvl > 1) fprintf(stdout,
 			      " Total time generating ci map: %10.5f sec\n",
 			      (double) (curr_time - prev_time)/CLOCKS_PER_SEC);
+
+	/* Store <i|H|j> in core if it fits within hcachemb. */
+	cache_hamiltonian(detlist, ndets, moints1, moints2, aelec, belec,
+			  ninto, hmap, hcachemb, hcachesp, plvl);
 	
 	/* Compute diagonal elements <i|H|i>. */
 	if (plvl > 0) fprintf(stdout, " Computing diagonal elements.\n");
@@ -120,7 +129,8 @@ int execute_ci_calculation(int aelec, int belec, int orbs, int nastr, int nbstr,
 	/* Davidson algorithm */
 	error = dvdalg(detlist, ndets, moints1, moints2, aelec, belec, hdgls,
 		       ninto, totfrze, maxiter, krymin, krymax, nroots, restol,
-		       hmap, civec, cival, prediag_routine, plvl, orbs, refdim);
+		       hmap, civec, cival, prediag_routine, plvl, orbs, refdim,
+		       precond, pcshift);
 
         /* Print final eigenvalues */
         for (i = 0; i < nroots; i++) {
@@ -132,8 +142,10 @@ int execute_ci_calculation(int aelec, int belec, int orbs, int nastr, int nbstr,
 	if (error != 0) {
 		error_flag(error, "execute_ci_calculation");
 	}
-        if (pwvf == 1) {
-                fprintf(stdout, " Printing wavefunction info to ciwvfcn.dat.\n");
+        if (pwvf > 0) {
+                fprintf(stdout, " Printing wavefunction info to %s.\n",
+                        (pwvf == 2 ? "ciwvfcn.bin" :
+                         "ciwvfcn.dat and ciwvfcn.bin"));
                 write_wavefunction(detlist, ndets, nroots, civec, cival, orbs,
                                    ninto, (aelec + belec));
         }
@@ -142,7 +154,7 @@ int execute_ci_calculation(int aelec, int belec, int orbs, int nastr, int nbstr,
 	free(hdgls);
 	free(cival);
 	free(detlist);
-	deallocate_cimap(hmap, ndets);
+	deallocate_cimap(hmap);
 	deallocate_mem(&civec, ndets, nroots);
 	return error;
 }
@@ -169,11 +181,15 @@ int execute_ci_calculation_inpdlist(int aelec, int belec, int orbs, int nastr,
 	int prediag_routine = 0; /* prediagonalization routine */
 	int refdim = 0; /* prediagonalization reference space */
 	double restol = 0.0; /* residual norm converegence tolerance */
+	int hcachemb = 0; /* memory limit (MB) for in-core H */
+	int hcachesp = 0; /* 1 = in-core H in single precision */
+	int precond = 0; /* correction vector preconditioner */
+	double pcshift = 0.0; /* preconditioner level shift */
 	
 	double *hdgls = NULL; /* diagonal elements of hamiltonian */
 	double **civec = NULL; /* final CI eigenvectors */
 	double *cival = NULL; /* final ci eigenvalues */
-	struct rowmap *hmap = NULL; /* valid <i|H|j> combinations */
+	struct cimap *hmap = NULL; /* valid <i|H|j> combinations */
 
         int i;
         
@@ -189,7 +205,8 @@ int execute_ci_calculation_inpdlist(int aelec, int belec, int orbs, int nastr,
 	
 	/* Read &dgalinfo namelist. */
 	readdaiinput(&maxiter, &krymin, &krymax, &nroots, &prediag_routine,
-		     &refdim, &restol, &error);
+		     &refdim, &restol, &hcachemb, &precond, &pcshift,
+		     &hcachesp, &error);
 	if (error != 0) {
 		error_flag(error, "execute_ci_calculation");
 		return error;
@@ -205,8 +222,8 @@ int execute_ci_calculation_inpdlist(int aelec, int belec, int orbs, int nastr,
 	/* Generate CI map of valid determinants. */
 	prev_time = clock();
 	if (plvl > 0) fprintf(stdout, " Generating cimap.\n");
-	hmap = (struct rowmap *) malloc(ndets * sizeof(struct rowmap));
-	error = generate_cimap(detlist, ndets, ninto, hmap);
+	hmap = (struct cimap *) malloc(sizeof(struct cimap));
+	error = generate_cimap(detlist, ndets, hmap);
 	if (error != 0) {
 		error_flag(error, "execute_ci_calculation");
 		return error;
@@ -215,6 +232,10 @@ int execute_ci_calculation_inpdlist(int aelec, int belec, int orbs, int nastr,
 	if (plvl > 1) fprintf(stdout,
 			      " Total time generating ci map: %10.5f sec\n",
 			      (double) (curr_time - prev_time)/CLOCKS_PER_SEC);
+
+	/* Store <i|H|j> in core if it fits within hcachemb. */
+	cache_hamiltonian(detlist, ndets, moints1, moints2, aelec, belec,
+			  ninto, hmap, hcachemb, hcachesp, plvl);
 	
 	/* Compute diagonal elements <i|H|i>. */
 	if (plvl > 0) fprintf(stdout, " Computing diagonal elements.\n");
@@ -235,7 +256,8 @@ int execute_ci_calculation_inpdlist(int aelec, int belec, int orbs, int nastr,
 	/* Davidson algorithm */
 	error = dvdalg(detlist, ndets, moints1, moints2, aelec, belec, hdgls,
 		       ninto, totfrze, maxiter, krymin, krymax, nroots, restol,
-		       hmap, civec, cival, prediag_routine, plvl, orbs, refdim);
+		       hmap, civec, cival, prediag_routine, plvl, orbs, refdim,
+		       precond, pcshift);
 
         /* Print final eigenvalues */
         for (i = 0; i < nroots; i++) {
@@ -247,8 +269,10 @@ int execute_ci_calculation_inpdlist(int aelec, int belec, int orbs, int nastr,
 	if (error != 0) {
 		error_flag(error, "execute_ci_calculation");
 	}
-        if (pwvf == 1) {
-                fprintf(stdout, " Printing wavefunction info to ciwvfcn.dat.\n");
+        if (pwvf > 0) {
+                fprintf(stdout, " Printing wavefunction info to %s.\n",
+                        (pwvf == 2 ? "ciwvfcn.bin" :
+                         "ciwvfcn.dat and ciwvfcn.bin"));
                 write_wavefunction(detlist, ndets, nroots, civec, cival, orbs,
                                    ninto, (aelec + belec));
         }
@@ -256,7 +280,7 @@ int execute_ci_calculation_inpdlist(int aelec, int belec, int orbs, int nastr,
 	/* Free memory */
 	free(hdgls);
 	free(cival);
-	deallocate_cimap(hmap, ndets);
+	deallocate_cimap(hmap);
 	deallocate_mem(&civec, ndets, nroots);
 	return error;
 }
@@ -6,14 +6,26 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "errorlib.h"
 #include "arrayutil.h"
+#include "ioutil.h"
+#include "abecalc.h"
 #include "straddress.h"
 #include "binarystr.h"
 #include "citruncate.h"
+#include "binwavefunction.h"
 #include "genbindet.h"
 
+static int checkbinarydetlist(int aelec, int belec, int orbs, int ndocc,
+			      int nactv, int ndets);
+static int regenbinarydetlist(int ndets);
+static int readbinarydetlist(struct det *dlist, int ndets);
+
 /* genbinarydetlist: generate list of determinants in binary format
  * -------------------------------------------------------------------
+ * Reads det.bin if present, otherwise the text list det.list. If the
+ * det.bin header does not match the &general input and the expansion,
+ * det.bin (and det.list) are regenerated from &general first.
  * Input:
  *  aelec = alpha electrons
  *  belec = beta  electrons
@@ -30,19 +42,32 @@ int genbinarydetlist(struct det *dlist, int aelec, int belec, int orbs,
 {
     int i = 0;
     int ai = 0, bi = 0;
-    int *aistr = NULL, *bistr = NULL, *strscr = NULL;
+    int *aistr = NULL, *bistr = NULL;
+    struct strgraph agraph, bgraph; /* alpha/beta addressing graphs */
     int error = 0;
     FILE *dlistfl = NULL;
 
-    
-
+    if (binwf_is_binary("det.bin")) {
+	if (checkbinarydetlist(aelec, belec, orbs, ndocc, nactv, ndets)
+	    != 0) {
+	    fprintf(stdout,
+		    "det.bin does not match input. Regenerating list.\n");
+	    error = regenbinarydetlist(ndets);
+	    if (error != 0) return error;
+	}
+        return readbinarydetlist(dlist, ndets);
+    }
     
     aistr = (int *) malloc(aelec * sizeof(int));
     init_int_array_0(aistr, aelec);
     bistr = (int *) malloc(belec * sizeof(int));
     init_int_array_0(bistr, belec);
-    strscr= (int *) malloc(aelec * sizeof(int));
-    init_int_array_0(strscr, aelec);
+    if (init_strgraph(aelec, orbs, &agraph) != 0 ||
+        init_strgraph(belec, orbs, &bgraph) != 0) {
+	fprintf(stderr, "*** ERROR: Cannot allocate string graphs! ***\n");
+	error = 1;
+	return error;
+    }
 
     dlistfl = fopen("det.list", "r");
     if (dlistfl == NULL) {
@@ -53,8 +78,8 @@ int genbinarydetlist(struct det *dlist, int aelec, int belec, int orbs,
     i = 0;
     printf("Reading file.\n");
     while (fscanf(dlistfl, " %d %d\n", &ai, &bi) != EOF) {
-	str_adr2str(ai, strscr, aelec, orbs, aistr);
-	str_adr2str(bi, strscr, belec, orbs, bistr);
+	str_adr2str_graph(ai, &agraph, aistr);
+	str_adr2str_graph(bi, &bgraph, bistr);
 	dlist[i].astr = str2occstr(aistr, aelec, ndocc, nactv);
 	dlist[i].bstr = str2occstr(bistr, belec, ndocc, nactv);
 	/* is this determinant a CAS determinant? */
@@ -69,7 +94,8 @@ int genbinarydetlist(struct det *dlist, int aelec, int belec, int orbs,
     fclose(dlistfl);
     free(aistr);
     free(bistr);
-    free(strscr);
+    free_strgraph(&agraph);
+    free_strgraph(&bgraph);
 
     fprintf(stdout, "Read in %d determinants.\n", i);
     if (i != ndets) {
@@ -80,3 +106,110 @@ int genbinarydetlist(struct det *dlist, int aelec, int belec, int orbs,
     return error;
 }
 
+/* checkbinarydetlist: compare det.bin header with the &general input and
+ * the expansion being read.
+ * -------------------------------------------------------------------
+ * Input:
+ *  aelec = CI alpha electrons
+ *  belec = CI beta  electrons
+ *  orbs  = CI orbitals
+ *  ndocc = docc orbitals
+ *  nactv = active orbitals
+ *  ndets = number of determinants
+ * Returns:
+ *  0: header matches, 1: mismatch or unreadable header
+ */
+static int checkbinarydetlist(int aelec, int belec, int orbs, int ndocc,
+			      int nactv, int ndets)
+{
+    int electrons, orbitals, nfrzc, gdocc, gactv, xlvl, nfrzv;
+    int printlvl, printwvf;
+    int error = 0;
+    struct binwf_header hdr;
+    FILE *dlistfl = NULL;
+
+    readgeninput(&electrons, &orbitals, &nfrzc, &gdocc, &gactv, &xlvl,
+		 &nfrzv, &printlvl, &printwvf, &error);
+    if (error != 0) return 1;
+    dlistfl = binwf_open_read("det.bin", &hdr);
+    if (dlistfl == NULL) return 1;
+    fclose(dlistfl);
+    if (hdr.electrons != electrons || hdr.orbitals != orbitals ||
+	hdr.nfrzc != nfrzc || hdr.nfrzv != nfrzv || hdr.xlvl != xlvl ||
+	hdr.ndocc != ndocc || hdr.nactv != nactv ||
+	hdr.elec != (aelec + belec) || hdr.orbs != orbs ||
+	hdr.ndets != ndets) {
+	return 1;
+    }
+    return 0;
+}
+
+/* regenbinarydetlist: regenerate det.bin from the &general input.
+ * -------------------------------------------------------------------
+ * det.list is also written unless printwvf = 2.
+ * Input:
+ *  ndets = number of determinants expected
+ * Returns:
+ *  error = 0: no error, 1: error
+ */
+static int regenbinarydetlist(int ndets)
+{
+    int electrons, orbitals, nfrzc, ndocc, nactv, xlvl, nfrzv;
+    int printlvl, printwvf;
+    int aelec, belec, astr_len, bstr_len, dtrm_len;
+    int error = 0;
+
+    readgeninput(&electrons, &orbitals, &nfrzc, &ndocc, &nactv, &xlvl,
+		 &nfrzv, &printlvl, &printwvf, &error);
+    if (error != 0) {
+	error_flag(error, "regenbinarydetlist");
+	return 1;
+    }
+    abecalc(electrons, &aelec, &belec);
+    error = citrunc(aelec, belec, orbitals, nfrzc, ndocc, nactv, nfrzv,
+		    xlvl, (printwvf == 2 ? 0 : 1), &astr_len, &bstr_len,
+		    &dtrm_len);
+    if (error != 0) {
+	error_flag(error, "regenbinarydetlist");
+	return 1;
+    }
+    if (dtrm_len != ndets) {
+	fprintf(stderr,
+		"*** ERROR: &general gives %d determinants, expected %d."
+		" Rerun jayci_exp. ***\n", dtrm_len, ndets);
+	return 1;
+    }
+    return 0;
+}
+
+/* readbinarydetlist: read determinant list from det.bin
+ * -------------------------------------------------------------------
+ * Input:
+ *  ndets = number of determinants
+ * Output:
+ *  dlist = determinant list
+ * Returns:
+ *  error = 0: no error, 1: error
+ */
+static int readbinarydetlist(struct det *dlist, int ndets)
+{
+    int error = 0;
+    struct binwf_header hdr;
+    FILE *dlistfl = NULL;
+
+    dlistfl = binwf_open_read("det.bin", &hdr);
+    if (dlistfl == NULL) {
+	fprintf(stderr, "*** ERROR: Cannot open det.bin! ***\n");
+	return 1;
+    }
+    if (hdr.ndets != ndets) {
+	fprintf(stderr, "*** ERROR: Incorrect number of determinants! ***\n");
+	fclose(dlistfl);
+	return 1;
+    }
+    printf("Reading file.\n");
+    error = binwf_read_dets(dlistfl, dlist, ndets);
+    fclose(dlistfl);
+    if (error == 0) fprintf(stdout, "Read in %d determinants.\n", ndets);
+    return error;
+}
@@ -6,6 +6,31 @@
 #ifndef action_util_h
 #define action_util_h
 
+/* Rows i per thread between c(j) reductions in compute_hv */
+#define HV_ROWBLK 64
+
+/*
+ * hv_entry: update c(j) += <i|H|j>v(i).
+ */
+struct hv_entry {
+	int j;      /* element of c */
+	int i;      /* element of v */
+	double hij; /* <i|H|j> */
+};
+
+/*
+ * hv_scatter: one thread's c(j) updates, binned by the thread that owns
+ * element j of c.
+ */
+struct hv_scatter {
+	int nbin;            /* bins (threads) */
+	int ndets;           /* length of c */
+	int *n;              /* entries per bin */
+	int *nmax;           /* allocated entries per bin */
+	struct hv_entry **e; /* entries per bin */
+	int error;           /* allocation failure */
+};
+
 /* 
  * cas_to_virt_replacements: compute excitations for cas<->virt replacements
  */
@@ -312,10 +337,20 @@ void compute_hdgls(
     double *hdgls, /* diagonal elements */
     int ninto); /* internal orbitals */
 
+/*
+ * allocate_hv_scatter: allocate one hv_scatter per OpenMP thread.
+ * Returns NULL if allocation fails.
+ */
+struct hv_scatter *allocate_hv_scatter(
+	int ndets,   /* length of c */
+	int *nthd    /* number of threads (output) */
+	);
+
 /*
  * compute_hv: perform Hv=c
+ * Returns 0, or 1 if scratch could not be allocated.
  */
-void compute_hv(
+int compute_hv(
 	struct det *dlist, /* list of determinants */ 
 	int ndets,         /* number of determinants */
 	double *moints1,   /* 1-e integrals */
@@ -325,21 +360,80 @@ void compute_hv(
 	double *restrict v,         /* input vector */
 	double *restrict c,        /* output vector */
 	int ninto,         /* internal orbitals */
-	struct rowmap *hmap /* rowmap for H matrix */
+	struct cimap *hmap /* nonzero map of H matrix */
 	);
 /*
- * compute_hv_nomap: perform Hv=c. No cimap.
- */
-void compute_hv_nomap(
-        struct det *dlist,
-        int ndets,
-        double *moints1,
-        double *moints2,
-        int aelec,
-        int belec,
-        double *restrict v,
-        double *restrict c,
-        int ninto);
+ * compute_hv_multi: perform Hv=c for nvec vectors at once. Each <i|H|j>
+ * is evaluated once and applied to all vectors. Vectors are interleaved:
+ * element i of vector k is v[i * nvec + k].
+ * Returns 0, or 1 if scratch could not be allocated.
+ */
+int compute_hv_multi(
+	struct det *dlist, /* list of determinants */
+	int ndets,         /* number of determinants */
+	double *moints1,   /* 1-e integrals */
+	double *moints2,   /* 2-e integrals */
+	int aelec,         /* alpha electrons */
+	int belec,         /* beta  electrons */
+	double *restrict v, /* input vectors, interleaved */
+	double *restrict c, /* output vectors, interleaved */
+	int nvec,          /* number of vectors */
+	int ninto,         /* internal orbitals */
+	struct cimap *hmap /* nonzero map of H matrix */
+	);
+
+/*
+ * cache_hamiltonian: compute all <i|H|j> of hmap and store them in
+ * hmap->vals, if they fit within memlim MB. Otherwise hmap is left
+ * unchanged and compute_hv evaluates elements on the fly. With sngl = 1
+ * the elements go to hmap->svals in single precision, and the diagonal
+ * is kept in double precision in hmap->diag.
+ * Returns 1 if H is held in core, 0 if not.
+ */
+int cache_hamiltonian(
+	struct det *dlist, /* list of determinants */
+	int ndets,         /* number of determinants */
+	double *moints1,   /* 1-e integrals */
+	double *moints2,   /* 2-e integrals */
+	int aelec,         /* alpha electrons */
+	int belec,         /* beta  electrons */
+	int ninto,         /* internal orbitals */
+	struct cimap *hmap, /* nonzero map of H matrix */
+	int memlim,        /* memory limit (MB); 0 = do not cache */
+	int sngl,          /* 1 = store in single precision */
+	int plvl           /* print level */
+	);
+
+/*
+ * deallocate_hv_scatter: free hv_scatter of all threads.
+ * Returns 1 if any thread failed to grow a bin, else 0.
+ */
+int deallocate_hv_scatter(
+	struct hv_scatter *hvs, /* per-thread scatter */
+	int nthd                /* number of threads */
+	);
+
+/*
+ * hv_scatter_add: bin c(j) += <i|H|j>v(i) by the thread that owns j.
+ */
+void hv_scatter_add(
+	struct hv_scatter *hvs, /* this thread's scatter */
+	int i,                  /* element of v */
+	int j,                  /* element of c */
+	double hij              /* <i|H|j> */
+	);
+
+/*
+ * hv_scatter_reduce: add all threads' updates to the elements of c owned
+ * by thread owner, and empty those bins.
+ */
+void hv_scatter_reduce(
+	struct hv_scatter *hvs, /* scatter of all threads */
+	int owner,              /* owning thread */
+	double *v,              /* input vectors, interleaved */
+	int nvec,               /* number of vectors */
+	double *c               /* output vectors, interleaved */
+	);
 
 double hmatels(
 	struct det deti,
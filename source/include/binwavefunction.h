@@ -0,0 +1,113 @@
+// File: binwavefunction.h
+
+#ifndef binwavefunction_h
+#define binwavefunction_h
+
+#include <stdio.h>
+
+struct det;
+
+/*
+ * Binary determinant list / wavefunction files.
+ *
+ * Layout:
+ *  struct binwf_header
+ *  ndets packed determinant records (BINWF_DETREC bytes each)
+ *  nroots eigenvalues (double)
+ *  nroots vectors of ndets doubles
+ * A determinant list (det.bin) is the same file with nroots = 0.
+ */
+
+#define BINWF_MAGIC   "JAYCIWF1"  /* file identifier, 8 bytes */
+#define BINWF_BUFLEN  4096        /* determinants per I/O block */
+#define BINWF_DETREC  44          /* bytes per packed determinant */
+
+struct binwf_header {
+        char magic[8]; /* BINWF_MAGIC */
+        int electrons; /* total electrons (&general) */
+        int orbitals;  /* total orbitals (&general) */
+        int elec;      /* CI electrons */
+        int orbs;      /* CI orbitals */
+        int ninto;     /* internal (docc + active) orbitals */
+        int ndets;     /* number of determinants */
+        int nfrzc;     /* frozen core orbitals */
+        int ndocc;     /* doubly-occupied orbitals */
+        int nactv;     /* active orbitals */
+        int nfrzv;     /* frozen virtual orbitals */
+        int xlvl;      /* excitation level */
+        int nroots;    /* number of vectors (0 for a determinant list) */
+};
+
+/*
+ * binwf_is_binary: return 1 if file_name is a binary wavefunction file.
+ */
+int binwf_is_binary(char *file_name);
+
+/*
+ * binwf_open_write: open file and write header. hdr->magic is set here.
+ */
+FILE *binwf_open_write(
+        char *file_name,
+        struct binwf_header *hdr
+        );
+
+/*
+ * binwf_close_write: rewrite header (final ndets/nroots) and close file.
+ */
+int binwf_close_write(
+        FILE *fptr,
+        struct binwf_header *hdr
+        );
+
+/*
+ * binwf_write_dets: append n determinants to an open file.
+ */
+int binwf_write_dets(
+        FILE *fptr,
+        struct det *dlist,
+        int n
+        );
+
+/*
+ * binwf_write_vectors: append eigenvalues and vectors to an open file.
+ * Must follow all determinants.
+ */
+int binwf_write_vectors(
+        FILE *fptr,
+        int nroots,
+        int ndets,
+        double **civec,
+        double *cival
+        );
+
+/*
+ * binwf_open_read: open file and read header. Returns NULL if the file
+ * cannot be opened or is not a binary wavefunction file.
+ */
+FILE *binwf_open_read(
+        char *file_name,
+        struct binwf_header *hdr
+        );
+
+/*
+ * binwf_read_dets: read next n determinants from an open file.
+ */
+int binwf_read_dets(
+        FILE *fptr,
+        struct det *dlist,
+        int n
+        );
+
+/*
+ * binwf_read_vectors: read eigenvalues and vectors from an open file.
+ * Must follow reading all determinants.
+ */
+int binwf_read_vectors(
+        FILE *fptr,
+        int nroots,
+        int ndets,
+        double **civec,
+        double *cival
+        );
+
+#endif
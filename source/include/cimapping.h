@@ -3,35 +3,27 @@
 #ifndef cimapping_h
 #define cimapping_h
 
-/* section: section of valid matrix elements */
-struct section {
-    int first; /* first j of section */
-    int last;  /* final j of section */
-    struct section *next; /* next section */
-    struct section *prev; /* previous section */
-};
-
-struct rowmap {
-    int nsec; /* number of sections to read in */
-    struct section *sec; /* sections */
-};
-
 /*
- * convertrow2map: convert a row of bits into rowmap structure
+ * cimap: compressed row map of nonzero matrix elements <i|H|j>, j >= i.
+ * Row i holds columns cols[rowptr[i]] ... cols[rowptr[i+1]-1], in
+ * ascending order, starting with the diagonal. If the Hamiltonian is
+ * held in core, vals[k] = <i|H|cols[k]>; otherwise vals is NULL.
  */
-void convertrow2map(
-    int *row, /* array of bits indicating nonzero matrix elements */
-    int n2v,  /* length of row */
-    struct rowmap *v2v /* rowmap structure of above array */
-    );
-
+struct cimap {
+    int ndets;              /* number of rows (determinants) */
+    long long int nnz;      /* number of stored elements */
+    long long int *rowptr;  /* row offsets into cols, length ndets + 1 */
+    int *cols;              /* column indices, length nnz */
+    double *vals;           /* matrix elements, length nnz (or NULL) */
+    float *svals;           /* single-precision elements, length nnz (or NULL) */
+    double *diag;           /* diagonal elements when svals is set (or NULL) */
+};
 
 /*
- * deallocate_cimap: deallocate a cimap linked list array.
+ * deallocate_cimap: deallocate a cimap structure.
  */
 int deallocate_cimap(
-	struct rowmap *hmap,
-	int ndets
+	struct cimap *hmap
 	);
 
 	
@@ -42,8 +34,7 @@ int deallocate_cimap(
 int generate_cimap(
     struct det *dlist, /* determinant list */
     int ndets, /* number of determinants */
-    int nactv, /* active orbitals */
-    struct rowmap *hmap /* linked list of nonzero elements of H */
+    struct cimap *hmap /* compressed row map of nonzero elements of H */
     );
 
 int get_detdiffs(struct det d1, struct det d2, int nactv);
@@ -2,6 +2,8 @@
 #ifndef citruncate_h
 #define citruncate_h
 
+struct binwf_header;
+
 /*
  * struct eospace: electron numbers in a space making
  * a valid determinant.
@@ -24,6 +26,30 @@ struct eostring {
         int *string;
 };
 
+/*
+ * struct detiter: position in the determinant list. Determinants are
+ * generated in list order: valid (p,q) space pairs with p outermost,
+ * then the alpha strings of p, then the beta strings of q.
+ */
+struct detiter {
+        struct eostring *pstr;  /* Alpha strings */
+        struct eostring *qstr;  /* Beta  strings */
+        struct eospace *peosp;  /* Alpha electron spaces */
+        struct eospace *qeosp;  /* Beta  electron spaces */
+        int pegrps;
+        int qegrps;
+        int aelec;
+        int belec;
+        int ndocc;
+        int nactv;
+        int doccmin;            /* Minimum DOCC occupation of a pair */
+        int virtmax;            /* Maximum VIRT occupation of a pair */
+        int pg;                 /* Current alpha space */
+        int qg;                 /* Current beta  space */
+        int ip;                 /* Next alpha string of the pair */
+        int iq;                 /* Next beta  string of the pair */
+};
+
 /*
  * struct xstrmap: starting string index and ending string index in
  * struct eostring list of valid strings for excitation.
@@ -44,6 +70,7 @@ int citrunc(int aelec,
 	    int nactv,
 	    int nfrzv,
 	    int xlvl,
+	    int txtlist,
 	    int *astr_len,
 	    int *bstr_len,
 	    int *dtrm_len);
@@ -95,17 +122,43 @@ void compute_eostrings_sr(struct eostring *strlist, int *pos, int ci_orbs,
 int compute_stringnum(int orbs, int elecs, int ndocc, int nactv, int xlvl);
 
 /*
- * generate_determinant_list: generate determinant list.
+ * detiter_init: set up a determinant list traversal at the first
+ * determinant.
+ */
+void detiter_init(struct detiter *it, struct eostring *pstr,
+                  struct eostring *qstr, struct eospace *peosp, int pegrps,
+                  struct eospace *qeosp, int qegrps, int aelec, int belec,
+                  int ndocc, int nactv, int xlvl);
+
+/*
+ * detiter_fill: generate the next determinants of a traversal.
+ * Input:
+ *  it   = traversal
+ *  nmax = most determinants to generate
+ * Output:
+ *  dbuf = determinants
+ *  pidx = alpha string index of each determinant (may be NULL)
+ *  qidx = beta  string index of each determinant (may be NULL)
+ * Returns the number generated; 0 at the end of the list.
+ */
+int detiter_fill(struct detiter *it, struct det *dbuf, int *pidx, int *qidx,
+                 int nmax);
+
+/*
+ * generate_determinant_list: generate determinant list, streaming it to
+ * the binary file det.bin (and the text file det.list if txtlist = 1).
  */
-void generate_determinant_list(struct eostring *pstrlist, int npstr, int aelec,
-                               struct eostring *qstrlist, int nqstr, int belec,
-                               struct eospace *peosp, int pegrps,
-                               struct eospace *qeosp, int qegrps,
-                               int ndocc, int nactv, int xlvl, int *dcnt);
+int generate_determinant_list(struct eostring *pstrlist, int npstr, int aelec,
+                              struct eostring *qstrlist, int nqstr, int belec,
+                              struct eospace *peosp, int pegrps,
+                              struct eospace *qeosp, int qegrps,
+                              int ndocc, int nactv, int xlvl, int *dcnt,
+                              struct binwf_header *hdr, int txtlist);
 
 /*
  * generate_determinant_list_rtnlist: generate determinant list, returning
- * the list.
+ * the list. This holds every determinant; generate_determinant_list()
+ * and detiter_fill() generate them a block at a time.
  */
 void generate_determinant_list_rtnlist(struct eostring *pstrlist, int npstr,
                                        int aelec, struct eostring *qstrlist,
@@ -138,24 +191,5 @@ void setup_eostrings_compute(int *elecs, int *orbs, int *nstr, int *pegs,
 int string_number(int nde, int nae, int nve, int ndocc, int nactv, int orbs,
                   int elecs);
 
-/*
- * write_determinant_strpairs: write determinant alpha/beta string pairs for
- * valid determinants to file.
- */
-void write_determinant_strpairs(FILE *fptr, int pstart, int pnstr, int qstart,
-                                int qnstr, int *cnt,
-                                struct eostring *pstr, struct eostring *qstr);
-
-/*
- * write_determinant_strpairs_dtlist: write determinant alpha/beta string
- * pairs for valid determinants to dtlist.
- */
-void write_determinant_strpairs_dtlist(int pstart, int pnstr, int qstart,
-                                       int qnstr, struct eostring *pstr,
-                                       struct eostring *qstr, int aelec,
-                                       int belec, int ndocc, int nactv,
-                                       struct det *dtlist, int *dptr,
-                                       int cflag);
-
 #endif
 
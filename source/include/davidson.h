@@ -5,6 +5,26 @@
 #ifndef davidson_h
 #define davidson_h
 
+/* Correction vector preconditioners (&dalginfo precond). */
+#define PRECOND_DIAG  0 /* -r(i)/(H(i,i) - E) */
+#define PRECOND_SHIFT 1 /* shifted diagonal with denominator floor */
+#define PRECOND_OLSEN 2 /* Olsen's correction */
+#define PRECOND_BLOCK 3 /* exact inverse on lowest-H(i,i) block */
+#define PRECOND_FLOOR 1.0e-4 /* smallest |H(i,i) - E + shift| */
+
+/*
+ * precond: correction vector preconditioner.
+ */
+struct precond {
+    int type; /* preconditioner, PRECOND_* */
+    double shift; /* level shift of H(i,i) - E */
+    int dim; /* dimension of exact-inverse block */
+    int *bidx; /* block determinant indices */
+    double *bvec; /* eigenvectors of H(P,P), bvec[k*dim + j] */
+    double *bval; /* eigenvalues of H(P,P) */
+    double *bscr; /* block scratch */
+};
+
 /*
  * append_vector_to_space: append new orthonormal basis vector to space.
  */
@@ -51,22 +71,57 @@ int diag_subspacehmat(
  * predr = prediagonalization routine
  * plvl = print level
  * norbs = total number of orbitals (excluding frozen core)
+ * refdim = reference space size of prediag routine (and of the
+ *          PRECOND_BLOCK block)
+ * pctype = correction vector preconditioner, PRECOND_*
+ * pcshift = preconditioner level shift
  */
 int dvdalg(struct det *dlist, int ndets, double *moints1, double *moints2,
 	   int aelec, int belec, double *hdgls, int ninto, double totfrze,
 	   int maxiter, int krymin, int krymax, int nroots, double restol,
-	   struct rowmap *hmap, double **civec, double *cival, int predr,
-	   int plvl, int norbs, int refdim);
+	   struct cimap *hmap, double **civec, double *cival, int predr,
+	   int plvl, int norbs, int refdim, int pctype, double pcshift);
 
 /*
- * generate_newvector: build correction vector.
+ * free_precond: deallocate preconditioner arrays.
  */
-void generate_newvector(
+void free_precond(struct precond *pc);
+
+/*
+ * precond_denom: shifted denominator H(i,i) - E + shift, with its
+ * magnitude kept above PRECOND_FLOOR.
+ */
+double precond_denom(
+    double dgl, /* <i|H|i> */
+    double eval, /* current root's eigenvalue */
+    double shift, /* level shift */
+    int *nfloor /* incremented if floored (may be NULL) */
+    );
+
+/*
+ * generate_newvector: build preconditioned correction vector. Returns
+ * the number of floored denominators.
+ */
+int generate_newvector(
     double *rvec, /* residual vector */
     double *dgls, /* diagonals, <i|H|i> */
     double eval, /* current root's eigenvalue */
     int ndets, /* dimension of residual vector */
-    double *nvec /* new vector */
+    double *nvec, /* new vector */
+    double *xvec, /* Ritz vector (PRECOND_OLSEN only) */
+    struct precond *pc /* preconditioner */
+    );
+
+/*
+ * generate_ritzvector: build the current root's Ritz vector.
+ */
+void generate_ritzvector(
+    double **vvecs, /* basis vectors v */
+    int ndets, /* length of vectors */
+    int nvec, /* size of vector basis */
+    double **hevec, /* eigenvectors of v.Hv */
+    int croot, /* current root being solved for */
+    double *xvec /* Ritz vector */
     );
 
 /*
@@ -83,6 +138,24 @@ void generate_residual(
     double *rvec /* residual vector */
     );
 
+/*
+ * init_precond: set up the correction vector preconditioner.
+ */
+int init_precond(
+    struct precond *pc, /* preconditioner */
+    int type, /* PRECOND_* */
+    double shift, /* level shift */
+    int dim, /* PRECOND_BLOCK block dimension */
+    struct det *dlist, /* determinant list */
+    int ndets, /* number of determinants */
+    double *moints1, /* 1-e integrals */
+    double *moints2, /* 2-e integrals */
+    int aelec, /* alpha electrons */
+    int belec, /* beta electrons */
+    double *hdgls, /* <i|H|i> */
+    int ninto /* docc + active orbitals */
+    );
+
 /*
  * make_subspacehmat: build krylov space hamiltonian v.Hv.
  */
@@ -95,9 +168,11 @@ void make_subspacehmat(
     );
 
 /*
- * perform_hv_initspace: perform hv on inital vectors.
+ * perform_hv_initspace: perform hv on inital vectors. All vectors are
+ * done in one pass over H.
+ * Returns 0, or 1 if Hv scratch could not be allocated.
  */
-void perform_hv_initspace(
+int perform_hv_initspace(
     struct det *dlist, /* determinant list */
     int ndets, /* number of determinants */
     double *moints1, /* 1-e integrals */
@@ -105,7 +180,7 @@ void perform_hv_initspace(
     int aelec, /* alpha electrons */
     int belec, /* beta electrons */
     int ninto, /* docc + active orbitals */
-    struct rowmap *hmap, /* map of nonzero <i|H|j> */
+    struct cimap *hmap, /* map of nonzero <i|H|j> */
     int nvec, /* number of vectors to compute (krymin) */
     double **vecs, /* vectors v */
     double **hvecs /* vectors c */
@@ -122,6 +197,11 @@ void print_iteration_info(
     double totfrze /* nuc rep + frozen core energy contribution */
     );
 
+/*
+ * print_precond_info: print the correction vector preconditioner.
+ */
+void print_precond_info(struct precond *pc);
+
 /*
  * test_convergence: test convergence of davidson algorithm. returns
  * convergence flag.
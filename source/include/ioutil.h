@@ -77,6 +77,10 @@ void readdaiinput(int *maxiter,
 		  int *prediagr,
 		  int *refdim,
 		  double *restol,
+		  int *hcachemb,
+		  int *precond,
+		  double *pcshift,
+		  int *hcachesp,
 		  int *err);
 
 void readgeninput(int *elec,
@@ -7,6 +7,7 @@
  * ------------
  * compute_vector_norm: compute norm of a vector
  * diagmat_dsyevr:      diagonalizes a square matrix using dsyevr
+ * diagmat_dsyevr_lowest: lowest eigenpairs of a square matrix using dsyevr
  * dot_product:         computes dot product of two vectors.
  * gauss_fcn:           gaussian function evaluated at x.
  * matmul_dgemm:        matrix multiplication with dgemm.  
@@ -39,6 +40,18 @@ int diagmat_dsyevr(
         double            *eigen_values
         );
 
+/*
+ * diagmat_dsyevr_lowest: compute only the lowest nev eigenpairs of a
+ * square, symmetric matrix using DSYEVR with range = 'I'.
+ */
+int diagmat_dsyevr_lowest(
+        double           *square_matrix,
+        int         dimension_of_matrix,
+        int       number_of_eigenpairs,
+        double           *eigen_vectors, /* dimension*nev */
+        double            *eigen_values
+        );
+
 /*
  * dot_product: compute the dot product of two vectors
  *  U.V=d
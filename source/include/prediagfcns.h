@@ -2,6 +2,20 @@
 #ifndef prediagfcns_h
 #define prediagfcns_h
 
+/* build_refblock: build the reference block H(ridx,ridx); rows are
+ * distributed over OpenMP threads. ridx = NULL gives H(1:refdim,1:refdim). */
+void build_refblock(
+	struct det *detlist,
+	int *ridx,            /* reference determinant indices, or NULL */
+	int refdim,           /* dimension of reference space */
+	double *moints1,
+	double *moints2,
+	int aelec,
+	int belec,
+	int ninto,            /* internal orbitals */
+	double *hmat          /* output block, refdim*refdim */
+	);
+
 int drefblock(
 	struct det *detlist,
 	double *moints1,
@@ -15,5 +29,14 @@ int drefblock(
 	double frzce,         /* frozen core energy */ 
 	int ninto           /* internal orbitals  */
 	);
+
+/* select_refdets: choose the refdim determinants of lowest <i|H|i>.
+ * Indices are returned in ascending order. */
+int select_refdets(
+	double *hdgls,        /* diagonal matrix elements */
+	int ndets,            /* number of determinants */
+	int refdim,           /* dimension of reference space */
+	int *ridx             /* output reference determinant indices */
+	);
 	
 #endif
@@ -1,8 +1,21 @@
 #ifndef straddress_h_
 #define straddress_h_
 
+/*
+ * struct strgraph: reverse lexical addressing graph for strings of
+ * elec electrons in orbs orbitals.
+ *  arcw = arc weights, elec x orbs; address = 1 + sum_i arcw(i, str[i])
+ *  nsub = strings below each vertex, elec x orbs; used for inversion
+ */
+struct strgraph {
+        int elec;
+        int orbs;
+        int nstr;
+        int *arcw;
+        int *nsub;
+};
+
 void str_adr2str(int index,
-		 int *scr,
 		 int elec,
 		 int orbs,
 		 int *str);
@@ -11,6 +24,24 @@ int str_adrfind(int *str,
 		int elec,
 		int orbs);
 
+/* init_strgraph: build lexical addressing graph. Returns 1 on
+ * allocation failure. */
+int init_strgraph(int elec,
+                  int orbs,
+                  struct strgraph *g);
+
+/* free_strgraph: free lexical addressing graph arrays. */
+void free_strgraph(struct strgraph *g);
+
+/* str_adrfind_graph: address of orbital index string; O(elec). */
+int str_adrfind_graph(int *str,
+                      struct strgraph *g);
+
+/* str_adr2str_graph: orbital index string of address; O(orbs). */
+void str_adr2str_graph(int index,
+                       struct strgraph *g,
+                       int *str);
+
 void str_strfind1(int *str1,
 		 int elec,
 		 int orbs,
@@ -15,11 +15,15 @@
 #include "action_util.h"
 #include "mathutil.h"
 #include "det2string.h"
+#include "prediagfcns.h"
 #include "initguess_sbd.h"
 
 /*
  * initguess_sbd: diagonalize a sublock of CI Hamiltonian and return
  * krymin eigenvectors.
+ *
+ * The subblock is spanned by the rdim determinants of lowest <i|H|i>,
+ * and only its lowest krymin eigenpairs are computed.
  */
 int initguess_sbd(struct det *dlist, int ndets, double *moints1,
 		  double *moints2, int aelec, int belec, int ninto,
@@ -29,79 +33,63 @@ int initguess_sbd(struct det *dlist, int ndets, double *moints1,
     double *hmat = NULL; /* Hamiltonian subblock */
     double *hevec = NULL; /* eigenvectors of subblock */
     double *heval = NULL; /* eigenvalues of subblock */
+    double *hdgls = NULL; /* diagonal elements <i|H|i> */
+    int *ridx = NULL; /* determinants spanning the subblock */
     int sbsize = 0; /* subblock size */
     int i = 0, j = 0;
-    int hp = 0, hp2 = 0;
 
     /* Get reference space size */
     sbsize = int_min(rdim, ndets);
+    if (krymin > sbsize) {
+            error = -1;
+            fprintf(stderr, "krymin (%d) > reference space (%d)\n",
+                    krymin, sbsize);
+            error_flag(error, "initguess_sbd");
+            return error;
+    }
 
     /* Allocate arrays */
     hmat = (double *) malloc(sbsize * sbsize * sizeof(double));
-    hevec= (double *) malloc(sbsize * sbsize * sizeof(double));
+    hevec= (double *) malloc(sbsize * krymin * sizeof(double));
     heval= (double *) malloc(sbsize * sizeof(double));
-    init_dbl_array_0(hmat, (sbsize * sbsize));
-    init_dbl_array_0(hevec,(sbsize * sbsize));
+    hdgls= (double *) malloc(ndets * sizeof(double));
+    ridx = (int *) malloc(sbsize * sizeof(int));
+    init_dbl_array_0(hevec,(sbsize * krymin));
     init_dbl_array_0(heval, sbsize);
 
-
-    /*double tmp = 0;
-    FILE *fptr;
-    char fname[80];
-    for (j = 0; j < 1000; j++) {
-            sprintf(fname, "column%d.txt", (j + 1));
-            fptr = fopen(fname, "w");
-            for (i = 0; i < sbsize; i++) {
-                    tmp = hmatels(dlist[i], dlist[j], moints1, moints2,
-                                  aelec, belec, ninto);
-                    fprintf(fptr, "%15.8lf", tmp);
-                    fprintf(fptr, "\n");
-            }
-            fclose(fptr);
+    /* choose reference determinants by diagonal energy */
+    compute_hdgls(dlist, ndets, moints1, moints2, aelec, belec, hdgls,
+                  ninto);
+    error = select_refdets(hdgls, ndets, sbsize, ridx);
+    if (error != 0) {
+	error_flag(error, "initguess_sbd");
+	goto cleanup;
     }
-    tmp = hmatels(dlist[2 - 1], dlist[228 - 1], moints1, moints2,
-                  aelec, belec, ninto);
-    printf("<2|H|228> = %15.8lf\n", tmp);
-    //tmp = hmatels(dlist[254 - 1], dlist[26 - 1], moints1, moints2,
-    //              aelec, belec, ninto);
-    //printf("<254|H|26> = %15.8lf\n", tmp);
-    
-    //return (300);
-    */
-
     
     /* build subblock of Hamiltonian */
-    hp = 0;
-    for (i = 0; i < sbsize; i++) {
-            hp = (i * sbsize) + i;
-            hmat[hp] = 0.0 + hmatels(dlist[i], dlist[i], moints1, moints2,
-                                     aelec, belec, ninto);
-	for (j = i + 1; j < sbsize; j++) {
-	    hp = (i * sbsize) + j;
-	    hmat[hp] = 0.0 + hmatels(dlist[i], dlist[j], moints1, moints2,
-				     aelec, belec, ninto);
-	    hp2 = (j * sbsize) + i;
-	    hmat[hp2] = 0.0 + hmat[hp];
-	}
-
-    }
+    build_refblock(dlist, ridx, sbsize, moints1, moints2, aelec, belec,
+                   ninto, hmat);
 
     /* diagonalize matrix */
-    error = diagmat_dsyevr(hmat, sbsize, hevec, heval);
+    error = diagmat_dsyevr_lowest(hmat, sbsize, krymin, hevec, heval);
     if (error != 0) {
 	error_flag(error, "initguess_sbd");
-	return error;
+	goto cleanup;
     }
     fprintf(stdout, " Lowest eigenvalue in subblock = %15.8lf\n",
             (heval[0] + totfrze));
-    //return 1000;
+
     /* set values for initial guess */
     for (i = 0; i < krymin; i++) {
+        init_dbl_array_0(vscr[i], ndets);
 	for (j = 0; j < sbsize; j++) {
-	    vscr[i][j] = 0.0 + hevec[(i * sbsize) + j];
+	    vscr[i][ridx[j]] = 0.0 + hevec[(i * sbsize) + j];
 	}
     }
 
+cleanup:
+    free(ridx);
+    free(hdgls);
     free(hevec);
     free(hmat);
     free(heval);
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "binwavefunction.h"
 #include "ioutil.h"
 
 /** fortran subroutines **/
@@ -27,7 +28,7 @@ extern void _readnamelist_(long long int  nmlist,
 			   unsigned char *nmlstr,
                            long long int *err);
 
-extern void _readmocoef_(double *c, long long int clen);
+extern void readmocoef_(double *c, long long int *clen);
 /*************************/
 
 /* check_for_file
@@ -57,7 +58,7 @@ int check_for_file(char *filename, char *fileoperation)
  *  (1) = jayci.in    = input file containing &general and &diagalg namelists
  *  (2) = input.jayci = input file generated by jayci_exp.x
  *  (3) = moints      = molecular integral file
- *  (4) = det.list    = determinant input list
+ *  (4) = det.bin     = determinant input list (or text det.list)
  * Returns integer value of missing input file.
  */
 int checkinputfiles()
@@ -72,6 +73,7 @@ int checkinputfiles()
      if (err != 0) return 2;
      err = check_for_file("moints","r");
      if (err != 0) return 3;
+     if (binwf_is_binary("det.bin")) return 0;
      err = check_for_file("det.list","r");
      if (err != 0) return 4;
 
@@ -267,6 +269,10 @@ int read_civectors(int aelec, int belec, int orbs, double **civec,
  *  nmlstr[4] = prediagr
  *  nmlstr[5] = refdim
  *  nmlstr[6] = restol
+ *  nmlstr[7] = hcachemb
+ *  nmlstr[8] = precond
+ *  nmlstr[9] = pcshift
+ *  nmlstr[10]= hcachesp
  *
  * Output:
  *  maxiter = maximum iterations of davidson algorithm
@@ -276,9 +282,15 @@ int read_civectors(int aelec, int belec, int orbs, double **civec,
  *  prediagr= prediagonalization subroutine choice
  *  refdim  = intitial reference-space dimension (prediagonalization)
  *  restol  = convergence tolerance of residual
+ *  hcachemb= memory limit (MB) for caching H in core; 0 = do not cache
+ *  precond = correction vector preconditioner: 0 = diagonal,
+ *            1 = shifted diagonal, 2 = Olsen, 3 = block inverse
+ *  pcshift = preconditioner level shift
+ *  hcachesp= 1 = cache off-diagonal H in single precision
  *  err     = error handling: n = missing variable n */
 void readdaiinput(int *maxiter,  int *krymin, int *krymax, int *nroots,
-		  int *prediagr, int *refdim, double *restol, int *err)
+		  int *prediagr, int *refdim, double *restol, int *hcachemb,
+		  int *precond, double *pcshift, int *hcachesp, int *err)
 {
     /* .. local scalars ..
      * gnml = namelist to read in */
@@ -301,6 +313,10 @@ void readdaiinput(int *maxiter,  int *krymin, int *krymax, int *nroots,
     sscanf(nmlstr[4], "%d", prediagr);
     sscanf(nmlstr[6], "%d",   refdim);
     sscanf(nmlstr[5], "%lf",  restol);
+    sscanf(nmlstr[7], "%d", hcachemb);
+    sscanf(nmlstr[8], "%d",  precond);
+    sscanf(nmlstr[9], "%lf", pcshift);
+    sscanf(nmlstr[10], "%d", hcachesp);
     
     return;
 }
@@ -327,7 +343,9 @@ void readdaiinput(int *maxiter,  int *krymin, int *krymax, int *nroots,
  *  xlevel = excitaion level (Default is 2)
  *  nfrzvirt = number of frozen virtual orbitals
  *  printlvl = print level
- *  printwvf = print wavefunctions (0: no; 1: yes)
+ *  printwvf = print wavefunctions (0: no; 1: text ciwvfcn.dat and
+ *             binary ciwvfcn.bin; 2: binary ciwvfcn.bin only, and no
+ *             text det.list). Default is 0.
  *  err = error handling: n = missing variable n */
 void readgeninput(int *elec,     int *orbs,   int *nfrozen,  int *ndocc,
 	          int *nactive,  int *xlevel, int *nfrzvirt, int *printlvl,
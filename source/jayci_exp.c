@@ -26,8 +26,8 @@ int main()
  *  Reads input.(&general)
  *  Computes number of alpha/beta electrons.
  *  Truncates space generating the following files:
- *   det.list (list of determinants)
- *   str.list (alpha/beta string lists)
+ *   det.bin  (binary list of determinants)
+ *   det.list (text list of determinants, unless printwvf = 2)
  *  Generates binary string lists:
  *   bin.det.list ([alpha string] [beta string] binary digits)
  *   bin.str.list (alpha/beta binary digit lists)
@@ -91,7 +91,7 @@ int main()
             aelec, belec);
      /* truncate ci-space, generating expansion */
      err = citrunc(aelec, belec, orbs, nfrzc, ndocc, nactv, nfrzv, xlevel,
-		   &astr_len, &bstr_len, &dtrm_len);
+		   (printwvf == 2 ? 0 : 1), &astr_len, &bstr_len, &dtrm_len);
      if (err != 0) {
 	  // ERROR HANDLING //
 	  exit(err);
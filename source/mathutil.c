@@ -4,6 +4,7 @@
  * -------------------------------------------------------------------
  * compute_vector_norm: compute norm of a vector
  * diagmat_dsyevr: diagonalizes a square matrix using dsyevr
+ * diagmat_dsyevr_lowest: lowest eigenpairs of a square matrix using dsyevr
  * dot_product: computes dot product of two vectors.
  * matmul_dgemm: perform A_ij B_jk = C_ik with dgemm
  * orthonormalize_vector: orthonormalize vector to space
@@ -107,6 +108,72 @@ int diagmat_dsyevr(double *mat, int dim, double *evecs, double *evals)
     }
     return err;
 }
+
+/*
+ * diagmat_dsyevr_lowest: compute the lowest nev eigenpairs of a square
+ * matrix using the dsyevr LAPACK subroutine (range = 'I'). evecs must
+ * hold dim * nev values; evals must hold dim values.
+ */
+int diagmat_dsyevr_lowest(double *mat, int dim, int nev, double *evecs,
+                          double *evals)
+{
+    unsigned char jobz[1]  = "v"; /* return eigenvectors and eigenvalues */
+    unsigned char range[1] = "i"; /* compute eigenvectors il through iu */
+    unsigned char uplo[1]  = "u"; /* upper triangle stored */
+    long long int n;              /* order of matrix */
+    long long int lda;            /* leading dimension of a */
+    double vl, vu;                /* not referenced for range = 'I' */
+    long long int il, iu;         /* indices of smallest and largest 
+                                   *  eigenvalues to find */
+    double abstol;                /* absolute error tolerance */
+    long long int m;              /* total number of eigenvalues found */
+    long long int ldz;            /* leading dimension of eigenvector array */
+    long long int *isuppz;        /* support array */
+    double *work;                 /* workspace array */
+    long long int lwork;          /* dimension of workspace array */
+    long long int *iwork;         /* integer workspace array */
+    long long int liwork;         /* dimension of integer workspace array */
+    long long int info = 0;       /* information */
+
+    int err = 0;
+
+    if (nev < 1 || nev > dim) {
+        fprintf(stderr,"*** ERROR in diagmat_dsyevr_lowest! nev = %d ***\n",
+                nev);
+        return -1;
+    }
+
+    /* set size */
+    n = dim;
+    lda = dim;
+    vl = 0.0;
+    vu = 0.0;
+    il = 1;
+    iu = nev;
+    m = 0;
+    ldz= dim;
+    abstol = dlamch_fcn_();
+    lwork = 30 * dim + 10;
+    liwork = 15 * dim;
+    isuppz = (long long int *) malloc(2 * nev * sizeof(long long int));
+    work = (double *) malloc(lwork * sizeof(double));
+    iwork = (long long int *) malloc(liwork * sizeof(long long int));
+
+    dsyevr_(&jobz, &range, &uplo, &n, mat, &lda, &vl, &vu, &il, &iu,
+	    &abstol, &m, evals, evecs, &ldz, isuppz, work, &lwork,
+	    iwork, &liwork, &info);
+
+    free(isuppz);
+    free(work);
+    free(iwork);
+
+    if (info != 0 || m != nev) {
+	fprintf(stderr,"*** ERROR in DSYEVR_! info = %lld, m = %lld ***\n",
+                info, m);
+	err = -1;
+    }
+    return err;
+}
     
 /*
  * dot_product: compute the dot product of two vectors
@@ -2,7 +2,9 @@
 /*********************************************************************
  * prediagrcns: prediagonalization functions
  * -------------------------------------------------------------------
+ * build_refblock: build a reference block of the hamiltonian
  * drefblock : diagonalize a reference space of the hamiltonian
+ * select_refdets: choose reference determinants by diagonal energy
  *
  * By Christopher L Malbon
  * Dept of Chemistry, The Johns Hopkins University
@@ -19,6 +21,58 @@
 #include "action_util.h"
 #include "prediagfcns.h"
 
+/* -- OpenMP options -- */
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+/* ----------------- */
+
+/* refdet_pair: diagonal energy and list index of a determinant */
+struct refdet_pair {
+	double hii;
+	int indx;
+};
+
+static int compare_refdet_pair(const void *a, const void *b);
+static int compare_int(const void *a, const void *b);
+
+/* build_refblock: build the reference block H(ridx,ridx) of the
+ *                 hamiltonian.
+ * -------------------------------------------------------------------
+ * Only the upper triangle is evaluated; rows are distributed over
+ * threads and the lower triangle is copied afterwards. If ridx is
+ * NULL the block is H(1:refdim,1:refdim).
+ *
+ * Input:
+ *  detlist = determinant list
+ *  ridx    = list indices of reference determinants (or NULL)
+ *  refdim  = size of reference block
+ * Output:
+ *  hmat = reference block, refdim * refdim */
+void build_refblock(struct det *detlist, int *ridx, int refdim,
+		    double *moints1, double *moints2, int aelec, int belec,
+		    int ninto, double *hmat)
+{
+	int i, j, di, dj;
+
+#pragma omp parallel for schedule(dynamic,4) private(j, di, dj)
+	for (i = 0; i < refdim; i++) {
+		di = (ridx == NULL ? i : ridx[i]);
+		for (j = i; j < refdim; j++) {
+			dj = (ridx == NULL ? j : ridx[j]);
+			hmat[(i * refdim) + j] =
+				hmatels(detlist[di], detlist[dj], moints1,
+					moints2, aelec, belec, ninto);
+		}
+	}
+	for (i = 0; i < refdim; i++) {
+		for (j = 0; j < i; j++) {
+			hmat[(i * refdim) + j] = hmat[(j * refdim) + i];
+		}
+	}
+	return;
+}
+
 /* drefblock: diagonalizes an explicitly constructed reference space 
  *            of the hamiltonian.
  * -------------------------------------------------------------------
@@ -39,28 +93,15 @@ int drefblock(struct det *detlist,  double *moints1, double *moints2,
 	      int m1len, int m2len, int aelec, int belec, int refdim, 
 	      double *evecs, double frzce, int ninto)
 {
-	int i, j, k, l;
 	double *hmat;
 	double *evals;
 	int err = 0;
 
 	hmat = (double *) malloc(refdim * refdim * sizeof(double));
 	evals = (double *) malloc(refdim * sizeof(double));
-	init_dbl_array_0(hmat, (refdim * refdim));
 	init_dbl_array_0(evals,(refdim));
-        printf("aelec = %d\n", aelec);
-        printf("belec = %d\n", belec);
-	for (i = 0; i < refdim; i++) {
-		printf("Computing %d\n", i);
-		for (j = i; j < refdim; j++) {
-			
-			k = (i * refdim) + j;
-			l = (j * refdim) + i;
-			hmat[k] = hmatels(detlist[i], detlist[j], moints1, moints2,
-					  aelec, belec, ninto);
-			hmat[l] = hmat[k];
-		}
-	}
+	build_refblock(detlist, NULL, refdim, moints1, moints2, aelec, belec,
+		       ninto, hmat);
 	/* diagonalize reference block */
 	err = diagmat_dsyevr(hmat, refdim, evecs, evals);
         
@@ -74,3 +115,58 @@ int drefblock(struct det *detlist,  double *moints1, double *moints2,
 	return err;
 	
 }
+
+/* select_refdets: choose the refdim determinants with the lowest
+ *                 diagonal energy <i|H|i> as the reference space.
+ * -------------------------------------------------------------------
+ * Ties are broken by list order, and the chosen indices are returned
+ * in ascending order.
+ *
+ * Input:
+ *  hdgls  = diagonal matrix elements
+ *  ndets  = number of determinants
+ *  refdim = size of reference space
+ * Output:
+ *  ridx = list indices of reference determinants */
+int select_refdets(double *hdgls, int ndets, int refdim, int *ridx)
+{
+	struct refdet_pair *pairs;
+	int i;
+
+	pairs = (struct refdet_pair *)
+		malloc(ndets * sizeof(struct refdet_pair));
+	if (pairs == NULL) {
+		fprintf(stderr, "*** ERROR in select_refdets! malloc ***\n");
+		return -1;
+	}
+	for (i = 0; i < ndets; i++) {
+		pairs[i].hii = hdgls[i];
+		pairs[i].indx = i;
+	}
+	qsort(pairs, ndets, sizeof(struct refdet_pair), compare_refdet_pair);
+	for (i = 0; i < refdim; i++) {
+		ridx[i] = pairs[i].indx;
+	}
+	qsort(ridx, refdim, sizeof(int), compare_int);
+
+	free(pairs);
+	return 0;
+}
+
+/* compare_refdet_pair: order by diagonal energy, then list index */
+static int compare_refdet_pair(const void *a, const void *b)
+{
+	const struct refdet_pair *pa = a;
+	const struct refdet_pair *pb = b;
+	if (pa->hii < pb->hii) return -1;
+	if (pa->hii > pb->hii) return 1;
+	return (pa->indx > pb->indx) - (pa->indx < pb->indx);
+}
+
+/* compare_int: ascending integer order */
+static int compare_int(const void *a, const void *b)
+{
+	int ia = *(const int *) a;
+	int ib = *(const int *) b;
+	return (ia > ib) - (ia < ib);
+}
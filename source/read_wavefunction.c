@@ -6,10 +6,19 @@
 #include <stdlib.h>
 #include "errorlib.h"
 #include "binarystr.h"
+#include "binwavefunction.h"
 #include "read_wavefunction.h"
 
+static int read_wavefunction_binary(struct det *detlist, int ndets,
+                                    int nroots, double **civec,
+                                    double *cival, int ci_orbs, int ci_elec,
+                                    char *file_name, int *orbitals,
+                                    int *electrons, int *nfrzc, int *ndocc,
+                                    int *nactv, int *nfrzv, int *xlvl);
+
 /*
- * read_wavefunction: read a wavefunction.
+ * read_wavefunction: read a wavefunction. Binary (ciwvfcn.bin) and text
+ * (ciwvfcn.dat) files are both accepted.
  */
 int read_wavefunction(struct det *detlist, int ndets, int nroots,
                       double **civec, double *cival, int ci_orbs, int ci_elec,
@@ -22,6 +31,14 @@ int read_wavefunction(struct det *detlist, int ndets, int nroots,
         FILE *fptr = NULL;
         char emsg[100];
         int i, j;
+
+        if (binwf_is_binary(file_name)) {
+                return read_wavefunction_binary(detlist, ndets, nroots, civec,
+                                                cival, ci_orbs, ci_elec,
+                                                file_name, orbitals,
+                                                electrons, nfrzc, ndocc,
+                                                nactv, nfrzv, xlvl);
+        }
         
         /* Open file */
         fptr = fopen(file_name, "r");
@@ -85,3 +102,61 @@ int read_wavefunction(struct det *detlist, int ndets, int nroots,
         fclose(fptr);
         return error;
 }
+
+/*
+ * read_wavefunction_binary: read a binary wavefunction file.
+ */
+static int read_wavefunction_binary(struct det *detlist, int ndets,
+                                    int nroots, double **civec,
+                                    double *cival, int ci_orbs, int ci_elec,
+                                    char *file_name, int *orbitals,
+                                    int *electrons, int *nfrzc, int *ndocc,
+                                    int *nactv, int *nfrzv, int *xlvl)
+{
+        int error = 0;
+        FILE *fptr = NULL;
+        struct binwf_header hdr;
+
+        fptr = binwf_open_read(file_name, &hdr);
+        if (fptr == NULL) {
+                error = 1;
+                error_flag(error, "read_wavefunction");
+                error_message("Could not read binary header.",
+                              "read_wavefunction");
+                return error;
+        }
+        *electrons = hdr.electrons;
+        *orbitals  = hdr.orbitals;
+        *nfrzc = hdr.nfrzc;
+        *ndocc = hdr.ndocc;
+        *nactv = hdr.nactv;
+        *nfrzv = hdr.nfrzv;
+        *xlvl  = hdr.xlvl;
+        if (hdr.elec != ci_elec || hdr.orbs != ci_orbs || hdr.ndets != ndets) {
+                fprintf(stderr, "fl_elec,   elec = %9d, %9d\n", hdr.elec,
+                        ci_elec);
+                fprintf(stderr, "fl_orbs,   orbs = %9d, %9d\n", hdr.orbs,
+                        ci_orbs);
+                fprintf(stderr, "fl_ndets, ndets = %9d, %9d\n", hdr.ndets,
+                        ndets);
+                error = -1;
+                error_flag(error, "read_wavefunction");
+                error_message("Incorrect parameters.", "read_wavefunction");
+                fclose(fptr);
+                return error;
+        }
+        if (hdr.nroots != nroots) {
+                error = -2;
+                error_flag(error, "read_wavefunction");
+                error_message("Incorrect number of roots", "read_wavefunction");
+                fclose(fptr);
+                return error;
+        }
+        error = binwf_read_dets(fptr, detlist, ndets);
+        if (error == 0) {
+                error = binwf_read_vectors(fptr, nroots, ndets, civec, cival);
+        }
+        fclose(fptr);
+        if (error != 0) error_flag(error, "read_wavefunction");
+        return error;
+}
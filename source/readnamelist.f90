@@ -27,8 +27,8 @@ subroutine readnamelist(nmlist, nmlstr, err)
 
   ! .. &dalginfo arguments ..
   integer :: maxiter, krymin, krymax, nroots
-  integer :: prediagr, refdim
-  real*8  :: restol
+  integer :: prediagr, refdim, hcachemb, hcachesp, precond
+  real*8  :: restol, pcshift
 
   ! .. &dysonorb arguments ..
   character*300 :: wvfcn_file0, wvfcn_file1
@@ -38,7 +38,7 @@ subroutine readnamelist(nmlist, nmlstr, err)
   namelist /general/ electrons, orbitals, nfrozen, ndocc, nactive, &
           nfrzvirt, xlevel, printlvl, printwvf
   namelist /dalginfo/ maxiter, krymin, krymax, nroots, prediagr, &
-          restol, refdim
+          restol, refdim, hcachemb, hcachesp, precond, pcshift
   namelist /wavefcn0/ electrons, orbitals, nfrozen, ndocc, nactive, &
           nfrzvirt, xlevel
   namelist /wavefcn1/ electrons, orbitals, nfrozen, ndocc, nactive, &
@@ -83,6 +83,10 @@ subroutine readnamelist(nmlist, nmlstr, err)
           prediagr  =  1
           restol    = 1.0d-5
           refdim    =  3
+          hcachemb  =  0
+          hcachesp  =  0
+          precond   =  0
+          pcshift   = 0.0d0
           open(file = "jayci.in", unit = 10, action = "read", status = "old", &
                   iostat = err)
           if (err .ne. 0) return
@@ -96,6 +100,10 @@ subroutine readnamelist(nmlist, nmlstr, err)
           write(nmlstr(5),9) prediagr
           write(nmlstr(6),8) restol
           write(nmlstr(7),9) refdim
+          write(nmlstr(8),9) hcachemb
+          write(nmlstr(9),9) precond
+          write(nmlstr(10),8) pcshift
+          write(nmlstr(11),9) hcachesp
           
           close(10)
           return
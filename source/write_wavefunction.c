@@ -7,8 +7,18 @@
 #include "errorlib.h"
 #include "ioutil.h"
 #include "binarystr.h"
+#include "binwavefunction.h"
 #include "write_wavefunction.h"
 
+static void write_wavefunction_text(struct det *detlist, int ndets,
+                                    int nroots, double **civec,
+                                    double *cival, int orbs, int ninto,
+                                    int elec, struct binwf_header *hdr);
+
+/*
+ * write_wavefunction: write wavefunction to ciwvfcn.bin. Unless
+ * printwvf = 2 the text file ciwvfcn.dat is also written.
+ */
 void write_wavefunction(struct det *detlist, int ndets, int nroots,
                         double **civec, double *cival, int orbs, int ninto,
                         int elec)
@@ -19,7 +29,7 @@ void write_wavefunction(struct det *detlist, int ndets, int nroots,
         int nfrzncore, ndocc, nactive, nfrznvirt;
         int xlevel;
         int printlvl, printwvf;
-        int i, j;
+        struct binwf_header hdr;
 
         /* Read &general input file to get wavefunction information */
         readgeninput(&electrons, &orbitals, &nfrzncore, &ndocc, &nactive,
@@ -29,6 +39,55 @@ void write_wavefunction(struct det *detlist, int ndets, int nroots,
                 return;
         }
         
+        hdr.electrons = electrons;
+        hdr.orbitals  = orbitals;
+        hdr.elec  = elec;
+        hdr.orbs  = orbs;
+        hdr.ninto = ninto;
+        hdr.ndets = ndets;
+        hdr.nfrzc = nfrzncore;
+        hdr.ndocc = ndocc;
+        hdr.nactv = nactive;
+        hdr.nfrzv = nfrznvirt;
+        hdr.xlvl  = xlevel;
+        hdr.nroots = nroots;
+
+        fptr = binwf_open_write("ciwvfcn.bin", &hdr);
+        if (fptr == NULL){
+                error_message("Could not open ciwvfcn.bin!",
+                              "write_wavefunction");
+                return;
+        }
+        error = binwf_write_dets(fptr, detlist, ndets);
+        if (error == 0) {
+                error = binwf_write_vectors(fptr, nroots, ndets, civec, cival);
+        }
+        error = error + binwf_close_write(fptr, &hdr);
+        if (error != 0) {
+                error_message("Error writing ciwvfcn.bin!",
+                              "write_wavefunction");
+                return;
+        }
+
+        /* Text export */
+        if (printwvf != 2) {
+                write_wavefunction_text(detlist, ndets, nroots, civec, cival,
+                                        orbs, ninto, elec, &hdr);
+        }
+        return;
+}
+
+/*
+ * write_wavefunction_text: write wavefunction to text file ciwvfcn.dat.
+ */
+static void write_wavefunction_text(struct det *detlist, int ndets,
+                                    int nroots, double **civec,
+                                    double *cival, int orbs, int ninto,
+                                    int elec, struct binwf_header *hdr)
+{
+        FILE *fptr = NULL;
+        int i, j;
+
         /* Open file and print wavefunction information */
         fptr = fopen("ciwvfcn.dat", "w");
         if (fptr == NULL){
@@ -36,9 +95,10 @@ void write_wavefunction(struct det *detlist, int ndets, int nroots,
                               "write_wavefunction");
                 return;
         }
-        fprintf(fptr, "%d %d\n", electrons, orbitals);
-        fprintf(fptr, "%d %d %d %d\n", nfrzncore, ndocc, nactive, nfrznvirt);
-        fprintf(fptr, "%d\n", xlevel);
+        fprintf(fptr, "%d %d\n", hdr->electrons, hdr->orbitals);
+        fprintf(fptr, "%d %d %d %d\n", hdr->nfrzc, hdr->ndocc, hdr->nactv,
+                hdr->nfrzv);
+        fprintf(fptr, "%d\n", hdr->xlvl);
         fprintf(fptr, "%d %d %d %d\n\n", elec, orbs, ninto, ndets);
         /* Loop over determinants, printing information. Alpha string is
          * printed first. */